@@ -90,6 +90,8 @@ typedef enum _dw1000_extension_id_t{
     DW1000_PAN,                              //!< Personal area network
     DW1000_PROVISION,                        //!< Provisioning
     DW1000_CIR,                              //!< Channel impulse response 
+    DW1000_TDOA,                             //!< Time difference of arrival
+    DW1000_SLOTRES,                          //!< TDMA slot reservation
     DW1000_APP0 = 1024, 
     DW1000_APP1, 
     DW1000_APP2
@@ -283,9 +285,9 @@ typedef struct _dw1000_dev_instance_t{
     uint16_t my_short_address;     //!< Short address of tag/node
     uint64_t my_long_address;      //!< Long address of tag/node
     uint64_t timestamp;            //!< Timestamp
-    uint64_t rxtimestamp;          //!< Receive timestamp
-    uint64_t txtimestamp;          //!< Transmit timestamp
-    int32_t carrier_integrator;
+    uint64_t rxtimestamp;          //!< Receive timestamp of the last frame received
+    uint64_t txtimestamp;          //!< Transmit timestamp of the last frame sent
+    int32_t carrier_integrator;    //!< Carrier integrator of the last frame received, single buffer mode only
     uint16_t PANID;                //!< personal network inetrface id
     uint16_t slot_id;              //!< Slot id 
     uint16_t cell_id;              //!< Cell id  
@@ -333,6 +335,12 @@ typedef struct _dw1000_dev_instance_t{
 #endif
 #if MYNEWT_VAL(CIR_ENABLED)
     struct _cir_instance_t * cir;                  //!< CIR instance
+#endif
+#if MYNEWT_VAL(TDOA_ENABLED)
+    struct _tdoa_instance_t * tdoa;                //!< TDoA instance
+#endif
+#if MYNEWT_VAL(SLOTRES_ENABLED)
+    struct _slotres_instance_t * slotres;          //!< Slot reservation instance
 #endif
     dw1000_dev_rxdiag_t rxdiag;                    //!< DW1000 receive diagnostics
     dw1000_dev_config_t config;                    //!< DW1000 device configurations  
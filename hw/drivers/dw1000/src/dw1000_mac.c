@@ -1236,6 +1236,10 @@ dw1000_interrupt_ev_cb(struct os_event *ev)
     inst->status.lde_error = (inst->sys_status & SYS_STATUS_LDEDONE) == 0;
     inst->status.overrun_error = (inst->sys_status & SYS_STATUS_RXOVRR) != 0;
 
+    // Snapshot the transmit timestamp once per event, ahead of the receive callbacks that answer it
+    if (inst->sys_status & SYS_STATUS_TXFRS)
+        inst->txtimestamp = dw1000_read_txtime(inst);
+
       // leading edge detection complete
     if((inst->sys_status & SYS_STATUS_RXFCG)){
         STATS_INC(inst->stat, DFR_cnt);
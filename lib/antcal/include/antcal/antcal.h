@@ -0,0 +1,83 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file antcal.h
+ * @author paul kettle
+ * @date 2018
+ * @brief Antenna delay calibration
+ *
+ * @details Collects mean DS-TWR time of flight between the nodes of a calibration set, solves for the antenna delay
+ * error of each node (see antcal_solve.h) and writes the corrected delays of the local node back through uwbcfg,
+ * which persists them. Pairs that do not involve the local node are measured by the other nodes and added with
+ * antcal_add_sample(), e.g. from the shell.
+ */
+
+#ifndef _ANTCAL_H_
+#define _ANTCAL_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <dw1000/dw1000_dev.h>
+#include <antcal/antcal_solve.h>
+
+//! Calibration status parameters
+typedef struct _antcal_status_t{
+    uint16_t selfmalloc:1;      //!< Internal flag for memory garbage collection
+    uint16_t initialized:1;     //!< Instance allocated
+    uint16_t solved:1;          //!< delay[] holds a valid solution
+    uint16_t positions:1;       //!< Every node has a known position
+}antcal_status_t;
+
+//! Calibration set
+typedef struct _antcal_instance_t{
+    antcal_status_t status;                                 //!< Calibration status
+    uint16_t nnodes;                                        //!< Nodes in the set
+    uint16_t npairs;                                        //!< Pairs with measurements
+    uint16_t addr[MYNEWT_VAL(ANTCAL_MAX_NODES)];            //!< Short address of each node
+    uint8_t known[MYNEWT_VAL(ANTCAL_MAX_NODES)];            //!< Set for nodes with a known position
+    float pos[MYNEWT_VAL(ANTCAL_MAX_NODES)][3];             //!< Node positions, m
+    float delay[MYNEWT_VAL(ANTCAL_MAX_NODES)];              //!< Antenna delay correction per node, DTU
+    float rms;                                              //!< Residual of the solution, DTU
+    antcal_pair_t pairs[MYNEWT_VAL(ANTCAL_MAX_NODES) * (MYNEWT_VAL(ANTCAL_MAX_NODES) - 1) / 2];   //!< Measurements
+}antcal_instance_t;
+
+void antcal_pkg_init(void);
+antcal_instance_t * antcal_init(antcal_instance_t * cal);
+void antcal_free(antcal_instance_t * cal);
+int antcal_add_node(antcal_instance_t * cal, uint16_t addr);
+void antcal_set_position(antcal_instance_t * cal, uint16_t idx, float x, float y, float z);
+void antcal_add_sample(antcal_instance_t * cal, uint16_t i, uint16_t j, float tof, uint16_t n);
+uint16_t antcal_measure(dw1000_dev_instance_t * inst, antcal_instance_t * cal, uint16_t peer, uint16_t nsamples);
+bool antcal_solve(antcal_instance_t * cal);
+int antcal_apply(dw1000_dev_instance_t * inst, antcal_instance_t * cal);
+antcal_instance_t * antcal_get_default(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ANTCAL_H_ */
@@ -0,0 +1,72 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file antcal_solve.h
+ * @author paul kettle
+ * @date 2018
+ * @brief Antenna delay least squares solvers
+ *
+ * @details An antenna delay error of e_i on node i, applied equally to transmit and receive, biases every DS-TWR time
+ * of flight between nodes i and j by e_i + e_j. Given mean time of flight for enough pairs of a node set, the errors
+ * are found by least squares:
+ *
+ * - with known positions the true time of flight is subtracted and the linear problem is solved by Gauss-Seidel on
+ *   the normal equations, which scales to large sets;
+ * - with unknown positions, 2D positions and delays are estimated jointly by Gauss-Newton. This needs at least
+ *   3N - 3 pairs, i.e. six or more fully meshed nodes. Six nodes is exactly determined and fits the noise, so use
+ *   seven or more.
+ *
+ * The pair graph must connect every node and contain an odd cycle, otherwise the delays are not observable.
+ * The solvers only depend on libc and can be used on the host.
+ */
+
+#ifndef _ANTCAL_SOLVE_H_
+#define _ANTCAL_SOLVE_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ANTCAL_M_PER_DTU (4.6903e-3f)       //!< Distance travelled in air during one DTU, m
+
+//! Mean time of flight between two nodes of the set
+typedef struct _antcal_pair_t{
+    uint16_t i;                 //!< Index of the first node
+    uint16_t j;                 //!< Index of the second node
+    uint16_t n;                 //!< Number of exchanges averaged
+    float tof;                  //!< Mean time of flight, DTU
+}antcal_pair_t;
+
+bool antcal_solve_known(const antcal_pair_t * pairs, uint16_t npairs, const float (*pos)[3], uint16_t nnodes,
+        float * delay, float * rms);
+bool antcal_solve_unknown(const antcal_pair_t * pairs, uint16_t npairs, uint16_t nnodes,
+        float (*pos)[2], float * delay, float * rms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ANTCAL_SOLVE_H_ */
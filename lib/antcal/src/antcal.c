@@ -0,0 +1,319 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file antcal.c
+ * @author paul kettle
+ * @date 2018
+ * @brief Antenna delay calibration
+ *
+ * @details Measurement uses blocking DS-TWR requests, so antcal_measure() must be called from a task and not while
+ * another ranging service owns the radio.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include <os/os.h>
+
+#include <dw1000/dw1000_dev.h>
+#include <dw1000/dw1000_phy.h>
+#include <rng/rng.h>
+#include <tof/tof.h>
+#include <uwbcfg/uwbcfg.h>
+#include <antcal/antcal.h>
+
+#if MYNEWT_VAL(ANTCAL_ENABLED)
+
+#define ANTCAL_MAX_PAIRS (MYNEWT_VAL(ANTCAL_MAX_NODES) * (MYNEWT_VAL(ANTCAL_MAX_NODES) - 1) / 2)
+
+static antcal_instance_t g_antcal;
+
+#if MYNEWT_VAL(ANTCAL_CLI)
+int antcal_cli_register(void);
+#endif
+
+/**
+ * API to initialise a calibration set.
+ *
+ * @param cal  Pointer to antcal_instance_t, NULL to allocate one.
+ *
+ * @return antcal_instance_t *
+ */
+antcal_instance_t *
+antcal_init(antcal_instance_t * cal){
+    if (cal == NULL){
+        cal = (antcal_instance_t *) malloc(sizeof(antcal_instance_t));
+        assert(cal);
+        memset(cal, 0, sizeof(antcal_instance_t));
+        cal->status.selfmalloc = 1;
+    }else{
+        antcal_status_t status = cal->status;
+        memset(cal, 0, sizeof(antcal_instance_t));
+        cal->status.selfmalloc = status.selfmalloc;
+    }
+    cal->status.initialized = 1;
+    return cal;
+}
+
+/**
+ * API to free a calibration set.
+ *
+ * @param cal  Pointer to antcal_instance_t.
+ *
+ * @return void
+ */
+void
+antcal_free(antcal_instance_t * cal){
+    assert(cal);
+    if (cal->status.selfmalloc)
+        free(cal);
+    else
+        cal->status.initialized = 0;
+}
+
+/**
+ * API to add a node to the set, or find it if already present.
+ *
+ * @param cal   Pointer to antcal_instance_t.
+ * @param addr  Short address of the node.
+ *
+ * @return index of the node, -1 if the set is full
+ */
+int
+antcal_add_node(antcal_instance_t * cal, uint16_t addr){
+    for (uint16_t i = 0; i < cal->nnodes; i++)
+        if (cal->addr[i] == addr)
+            return i;
+    if (cal->nnodes == MYNEWT_VAL(ANTCAL_MAX_NODES))
+        return -1;
+    cal->addr[cal->nnodes] = addr;
+    cal->known[cal->nnodes] = 0;
+    return cal->nnodes++;
+}
+
+/**
+ * API to set the surveyed position of a node.
+ *
+ * @param cal  Pointer to antcal_instance_t.
+ * @param idx  Index of the node.
+ * @param x    Position, m.
+ * @param y    Position, m.
+ * @param z    Position, m.
+ *
+ * @return void
+ */
+void
+antcal_set_position(antcal_instance_t * cal, uint16_t idx, float x, float y, float z){
+    assert(idx < cal->nnodes);
+    cal->pos[idx][0] = x;
+    cal->pos[idx][1] = y;
+    cal->pos[idx][2] = z;
+    cal->known[idx] = 1;
+}
+
+/**
+ * API to add measurements of a pair, merged into the running mean of earlier measurements.
+ *
+ * @param cal  Pointer to antcal_instance_t.
+ * @param i    Index of the first node.
+ * @param j    Index of the second node.
+ * @param tof  Mean time of flight, DTU.
+ * @param n    Number of exchanges behind the mean.
+ *
+ * @return void
+ */
+void
+antcal_add_sample(antcal_instance_t * cal, uint16_t i, uint16_t j, float tof, uint16_t n){
+    assert(i < cal->nnodes && j < cal->nnodes && i != j);
+    if (n == 0)
+        return;
+
+    antcal_pair_t * pair = NULL;
+    for (uint16_t p = 0; p < cal->npairs; p++)
+        if ((cal->pairs[p].i == i && cal->pairs[p].j == j) || (cal->pairs[p].i == j && cal->pairs[p].j == i)){
+            pair = &cal->pairs[p];
+            break;
+        }
+    if (pair == NULL){
+        assert(cal->npairs < ANTCAL_MAX_PAIRS);
+        pair = &cal->pairs[cal->npairs++];
+        pair->i = i;
+        pair->j = j;
+        pair->n = 0;
+        pair->tof = 0;
+    }
+    pair->tof += (tof - pair->tof) * n / (pair->n + n);
+    pair->n += n;
+    cal->status.solved = 0;
+}
+
+/**
+ * Time of flight of the last completed DS-TWR exchange, DTU.
+ */
+static float
+last_tof(dw1000_rng_instance_t * rng){
+#if MYNEWT_VAL(DW1000_RANGE)
+    return dw1000_rng_twr_to_tof(rng->frames[(uint16_t)(rng->idx - 1) % rng->nframes],
+            rng->frames[rng->idx % rng->nframes]);
+#else
+    return dw1000_rng_twr_to_tof(rng, rng->idx);
+#endif
+}
+
+/**
+ * API to measure the pair between the local node and a peer. Both must already be in the set.
+ *
+ * @param inst      Pointer to dw1000_dev_instance_t.
+ * @param cal       Pointer to antcal_instance_t.
+ * @param peer      Short address of the peer.
+ * @param nsamples  Number of DS-TWR exchanges, 0 for ANTCAL_SAMPLES.
+ *
+ * @return number of exchanges that completed
+ */
+uint16_t
+antcal_measure(dw1000_dev_instance_t * inst, antcal_instance_t * cal, uint16_t peer, uint16_t nsamples){
+
+    int i = antcal_add_node(cal, inst->my_short_address);
+    int j = antcal_add_node(cal, peer);
+    uint16_t n = 0;
+    float sum = 0;
+
+    if (i < 0 || j < 0)
+        return 0;
+    if (nsamples == 0)
+        nsamples = MYNEWT_VAL(ANTCAL_SAMPLES);
+
+    dw1000_rng_instance_t * rng = inst->rng;
+    for (uint16_t k = 0; k < nsamples; k++){
+        uint16_t idx = rng->idx;
+        dw1000_rng_request(inst, peer, DWT_DS_TWR);
+        if (inst->status.start_tx_error || inst->status.rx_error || inst->status.rx_timeout_error
+                || rng->idx == idx)
+            continue;
+
+        twr_frame_t * frame = rng->frames[rng->idx % rng->nframes];
+        if ((frame->code != DWT_DS_TWR_FINAL && frame->code != DWT_DS_TWR_END)
+                || (frame->src_address != peer && frame->dst_address != peer))
+            continue;
+        sum += last_tof(rng);
+        n++;
+    }
+    if (n)
+        antcal_add_sample(cal, i, j, sum / n, n);
+    return n;
+}
+
+/**
+ * API to solve for the antenna delay correction of every node in the set. Uses the surveyed positions when every
+ * node has one, otherwise estimates positions jointly in 2D.
+ *
+ * @param cal  Pointer to antcal_instance_t.
+ *
+ * @return true on success
+ */
+bool
+antcal_solve(antcal_instance_t * cal){
+
+    bool known = true;
+    for (uint16_t i = 0; i < cal->nnodes; i++)
+        known &= cal->known[i];
+    cal->status.positions = known;
+
+    if (known){
+        cal->status.solved = antcal_solve_known(cal->pairs, cal->npairs, (const float (*)[3]) cal->pos, cal->nnodes,
+                cal->delay, &cal->rms);
+    }else{
+        float (*pos)[2] = (float (*)[2]) malloc(cal->nnodes * sizeof(*pos));
+        assert(pos);
+        cal->status.solved = antcal_solve_unknown(cal->pairs, cal->npairs, cal->nnodes, pos, cal->delay, &cal->rms);
+        if (cal->status.solved)
+            for (uint16_t i = 0; i < cal->nnodes; i++){
+                cal->pos[i][0] = pos[i][0];
+                cal->pos[i][1] = pos[i][1];
+                cal->pos[i][2] = 0;
+            }
+        free(pos);
+    }
+    return cal->status.solved;
+}
+
+/**
+ * API to apply the solution to the local node. The corrected delays are written to the uwbcfg config, which
+ * persists them, and loaded into the transceiver.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @param cal   Pointer to antcal_instance_t.
+ *
+ * @return 0 on success, OS_EINVAL if there is no solution for the local node, else the conf_save_one() error
+ */
+int
+antcal_apply(dw1000_dev_instance_t * inst, antcal_instance_t * cal){
+
+    if (!cal->status.solved)
+        return OS_EINVAL;
+    for (uint16_t i = 0; i < cal->nnodes; i++){
+        if (cal->addr[i] != inst->my_short_address)
+            continue;
+        int32_t correction = (int32_t) roundf(cal->delay[i]);
+        uint16_t rx_antdly = inst->rx_antenna_delay + correction;
+        uint16_t tx_antdly = inst->tx_antenna_delay + correction;
+
+        int rc = uwbcfg_set_antenna_delays(rx_antdly, tx_antdly);
+        inst->rx_antenna_delay = rx_antdly;
+        inst->tx_antenna_delay = tx_antdly;
+        dw1000_phy_set_rx_antennadelay(inst, inst->rx_antenna_delay);
+        dw1000_phy_set_tx_antennadelay(inst, inst->tx_antenna_delay);
+        return rc;
+    }
+    return OS_EINVAL;
+}
+
+/**
+ * API to get the calibration set used by the shell.
+ *
+ * @return antcal_instance_t *
+ */
+antcal_instance_t *
+antcal_get_default(void){
+    return &g_antcal;
+}
+
+#endif // ANTCAL_ENABLED
+
+/**
+ * API to initialise the antcal package.
+ *
+ * @return void
+ */
+void
+antcal_pkg_init(void){
+
+#if MYNEWT_VAL(ANTCAL_ENABLED)
+    printf("{\"utime\": %lu,\"msg\": \"antcal_pkg_init\"}\n",os_cputime_ticks_to_usecs(os_cputime_get32()));
+    antcal_init(&g_antcal);
+#if MYNEWT_VAL(ANTCAL_CLI)
+    int rc = antcal_cli_register();
+    assert(rc == 0);
+#endif
+#endif
+}
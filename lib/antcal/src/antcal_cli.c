@@ -0,0 +1,132 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file antcal_cli.c
+ * @author paul kettle
+ * @date 2018
+ * @brief Antenna delay calibration shell command
+ *
+ * @details A host drives the calibration: it runs "antcal measure" on each node, collects the printed pairs, feeds
+ * them to one node with "antcal pair", solves there, and pushes each node's correction back with "antcal apply"
+ * or the config shell. Time of flight is printed and parsed in 1/1000 DTU, solved positions are printed in mm.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <dw1000/dw1000_hal.h>
+#include <dw1000/dw1000_dev.h>
+#include <antcal/antcal.h>
+
+#if MYNEWT_VAL(ANTCAL_ENABLED) && MYNEWT_VAL(ANTCAL_CLI)
+
+#include <shell/shell.h>
+#include <console/console.h>
+
+static int antcal_cli_cmd(int argc, char **argv);
+
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+const struct shell_param cmd_antcal_param[] = {
+    {"clear", "clear the calibration set"},
+    {"add", "<addr> add a node"},
+    {"pos", "<addr> <x> <y> <z> set a surveyed position, m"},
+    {"pair", "<addr> <addr> <tof> <n> add a pair measured elsewhere, tof in mDTU"},
+    {"measure", "<addr> [n] range to a peer"},
+    {"solve", "solve and list corrections"},
+    {"apply", "apply and save the local correction"},
+    {NULL,NULL},
+};
+
+const struct shell_cmd_help cmd_antcal_help = {
+	"antcal", "antenna delay calibration", cmd_antcal_param
+};
+#endif
+
+static struct shell_cmd shell_antcal_cmd = {
+    .sc_cmd = "antcal",
+    .sc_cmd_func = antcal_cli_cmd,
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+    &cmd_antcal_help
+#endif
+};
+
+static int
+antcal_cli_cmd(int argc, char **argv)
+{
+    dw1000_dev_instance_t * inst = hal_dw1000_inst(0);
+    antcal_instance_t * cal = antcal_get_default();
+
+    if (argc < 2) {
+        console_printf("Too few args\n");
+        return 0;
+    }
+
+    if (!strcmp(argv[1], "clear")) {
+        antcal_init(cal);
+    } else if (!strcmp(argv[1], "add") && argc >= 3) {
+        console_printf("{\"idx\":%d}\n", antcal_add_node(cal, strtol(argv[2], NULL, 0)));
+    } else if (!strcmp(argv[1], "pos") && argc >= 6) {
+        int i = antcal_add_node(cal, strtol(argv[2], NULL, 0));
+        if (i >= 0)
+            antcal_set_position(cal, i, strtof(argv[3], NULL), strtof(argv[4], NULL), strtof(argv[5], NULL));
+    } else if (!strcmp(argv[1], "pair") && argc >= 6) {
+        int i = antcal_add_node(cal, strtol(argv[2], NULL, 0));
+        int j = antcal_add_node(cal, strtol(argv[3], NULL, 0));
+        if (i >= 0 && j >= 0 && i != j)
+            antcal_add_sample(cal, i, j, strtol(argv[4], NULL, 0) * 1e-3f, strtol(argv[5], NULL, 0));
+    } else if (!strcmp(argv[1], "measure") && argc >= 3) {
+        uint16_t peer = strtol(argv[2], NULL, 0);
+        uint16_t n = antcal_measure(inst, cal, peer, (argc >= 4) ? strtol(argv[3], NULL, 0) : 0);
+        for (uint16_t p = 0; p < cal->npairs; p++) {
+            antcal_pair_t * pair = &cal->pairs[p];
+            if (cal->addr[pair->i] == peer || cal->addr[pair->j] == peer)
+                console_printf("{\"pair\":[\"0x%X\",\"0x%X\"],\"tof\":%ld,\"n\":%d,\"ok\":%d}\n",
+                    cal->addr[pair->i], cal->addr[pair->j], (long)(pair->tof * 1000), pair->n, n);
+        }
+    } else if (!strcmp(argv[1], "solve")) {
+        if (!antcal_solve(cal)) {
+            console_printf("{\"solved\":0}\n");
+            return 0;
+        }
+        for (uint16_t i = 0; i < cal->nnodes; i++)
+            console_printf("{\"addr\":\"0x%X\",\"delay\":%ld,\"pos\":[%ld,%ld,%ld]}\n", cal->addr[i],
+                (long)roundf(cal->delay[i]), (long)(cal->pos[i][0] * 1000), (long)(cal->pos[i][1] * 1000),
+                (long)(cal->pos[i][2] * 1000));
+        console_printf("{\"solved\":1,\"rms\":%ld}\n", (long)(cal->rms * 1000));
+    } else if (!strcmp(argv[1], "apply")) {
+        int rc = antcal_apply(inst, cal);
+        console_printf("{\"rc\":%d,\"rx_antdly\":\"0x%04X\",\"tx_antdly\":\"0x%04X\"}\n", rc,
+            inst->rx_antenna_delay, inst->tx_antenna_delay);
+    } else {
+        console_printf("Unknown cmd\n");
+    }
+    return 0;
+}
+
+int
+antcal_cli_register(void)
+{
+    return shell_cmd_register(&shell_antcal_cmd);
+}
+
+#endif
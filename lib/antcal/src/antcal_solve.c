@@ -0,0 +1,351 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file antcal_solve.c
+ * @author paul kettle
+ * @date 2018
+ * @brief Antenna delay least squares solvers
+ *
+ * @details The known position solver never forms a matrix: the normal equations of b_ij = e_i + e_j are
+ * deg_i * e_i + sum_j e_j = sum_j b_ij, which Gauss-Seidel solves one node at a time from an adjacency list. The
+ * unknown position solver is dense and meant for a handful of nodes.
+ */
+
+#include <string.h>
+#include <math.h>
+#include <antcal/antcal_solve.h>
+
+#define ANTCAL_GS_ITERATIONS 1000       //!< Gauss-Seidel sweep limit
+#define ANTCAL_GS_TOLERANCE 1e-4f       //!< Gauss-Seidel convergence, DTU
+#define ANTCAL_GN_ITERATIONS 50         //!< Gauss-Newton iteration limit
+#define ANTCAL_GN_TOLERANCE 5e-4f       //!< Gauss-Newton convergence, m, about 0.1 DTU
+#define ANTCAL_GN_DAMPING 1e-6f         //!< Levenberg damping relative to the diagonal
+
+static inline uint16_t
+other(const antcal_pair_t * pair, uint16_t i){
+    return (pair->i == i) ? pair->j : pair->i;
+}
+
+/**
+ * Checks that the pair graph is connected and not bipartite, i.e. that e_i + e_j = b_ij has a unique solution.
+ */
+static bool
+observable(const antcal_pair_t * pairs, const uint16_t * start, const uint16_t * adj, uint16_t nnodes){
+
+    int8_t * colour = (int8_t *) malloc(nnodes);
+    uint16_t * queue = (uint16_t *) malloc(nnodes * sizeof(uint16_t));
+    bool odd = false;
+    uint16_t head = 0, tail = 0;
+
+    memset(colour, -1, nnodes);
+    colour[0] = 0;
+    queue[tail++] = 0;
+    while (head < tail){
+        uint16_t i = queue[head++];
+        for (uint16_t k = start[i]; k < start[i + 1]; k++){
+            uint16_t j = other(&pairs[adj[k]], i);
+            if (colour[j] < 0){
+                colour[j] = !colour[i];
+                queue[tail++] = j;
+            }else if (colour[j] == colour[i]){
+                odd = true;
+            }
+        }
+    }
+    free(colour);
+    free(queue);
+    return odd && tail == nnodes;
+}
+
+/**
+ * Solves for antenna delay errors given node positions.
+ *
+ * @param pairs   Measured pairs.
+ * @param npairs  Number of pairs.
+ * @param pos     Node positions, m.
+ * @param nnodes  Number of nodes.
+ * @param delay   Output, delay error of each node in DTU, to be added to both antenna delays.
+ * @param rms     Output, residual of the fit in DTU, may be NULL.
+ *
+ * @return true on success, false if the delays are not observable from the pairs
+ */
+bool
+antcal_solve_known(const antcal_pair_t * pairs, uint16_t npairs, const float (*pos)[3], uint16_t nnodes,
+        float * delay, float * rms){
+
+    if (nnodes < 3 || npairs < nnodes)
+        return false;
+
+    uint16_t * start = (uint16_t *) calloc(nnodes + 1, sizeof(uint16_t));
+    uint16_t * adj = (uint16_t *) malloc(2 * npairs * sizeof(uint16_t));
+    float * b = (float *) malloc(npairs * sizeof(float));
+    bool rc = false;
+
+    if (start == NULL || adj == NULL || b == NULL)
+        goto done;
+
+    for (uint16_t p = 0; p < npairs; p++){
+        const float * pi = pos[pairs[p].i];
+        const float * pj = pos[pairs[p].j];
+        float d = sqrtf((pi[0] - pj[0]) * (pi[0] - pj[0]) + (pi[1] - pj[1]) * (pi[1] - pj[1])
+                + (pi[2] - pj[2]) * (pi[2] - pj[2]));
+        b[p] = pairs[p].tof - d / ANTCAL_M_PER_DTU;
+        start[pairs[p].i + 1]++;
+        start[pairs[p].j + 1]++;
+    }
+    for (uint16_t i = 0; i < nnodes; i++)
+        start[i + 1] += start[i];
+    {
+        uint16_t * fill = (uint16_t *) malloc(nnodes * sizeof(uint16_t));
+        if (fill == NULL)
+            goto done;
+        memcpy(fill, start, nnodes * sizeof(uint16_t));
+        for (uint16_t p = 0; p < npairs; p++){
+            adj[fill[pairs[p].i]++] = p;
+            adj[fill[pairs[p].j]++] = p;
+        }
+        free(fill);
+    }
+
+    if (!observable(pairs, start, adj, nnodes))
+        goto done;
+
+    memset(delay, 0, nnodes * sizeof(float));
+    for (uint16_t it = 0; it < ANTCAL_GS_ITERATIONS; it++){
+        float step = 0;
+        for (uint16_t i = 0; i < nnodes; i++){
+            float sum = 0;
+            for (uint16_t k = start[i]; k < start[i + 1]; k++)
+                sum += b[adj[k]] - delay[other(&pairs[adj[k]], i)];
+            float e = sum / (start[i + 1] - start[i]);
+            step = fmaxf(step, fabsf(e - delay[i]));
+            delay[i] = e;
+        }
+        if (step < ANTCAL_GS_TOLERANCE)
+            break;
+    }
+
+    if (rms){
+        float sum = 0;
+        for (uint16_t p = 0; p < npairs; p++){
+            float r = delay[pairs[p].i] + delay[pairs[p].j] - b[p];
+            sum += r * r;
+        }
+        *rms = sqrtf(sum / npairs);
+    }
+    rc = true;
+done:
+    free(start);
+    free(adj);
+    free(b);
+    return rc;
+}
+
+/**
+ * In-place Cholesky solve of the n x n system A x = b, x returned in b.
+ */
+static bool
+cholesky_solve(float * A, float * b, uint16_t n){
+    for (uint16_t j = 0; j < n; j++){
+        float d = A[j * n + j];
+        for (uint16_t k = 0; k < j; k++)
+            d -= A[j * n + k] * A[j * n + k];
+        if (!(d > 0))
+            return false;
+        d = sqrtf(d);
+        A[j * n + j] = d;
+        for (uint16_t i = j + 1; i < n; i++){
+            float s = A[i * n + j];
+            for (uint16_t k = 0; k < j; k++)
+                s -= A[i * n + k] * A[j * n + k];
+            A[i * n + j] = s / d;
+        }
+    }
+    for (uint16_t i = 0; i < n; i++){
+        float s = b[i];
+        for (uint16_t k = 0; k < i; k++)
+            s -= A[i * n + k] * b[k];
+        b[i] = s / A[i * n + i];
+    }
+    for (int16_t i = n - 1; i >= 0; i--){
+        float s = b[i];
+        for (uint16_t k = i + 1; k < n; k++)
+            s -= A[k * n + i] * b[k];
+        b[i] = s / A[i * n + i];
+    }
+    return true;
+}
+
+/**
+ * Index of a position coordinate in the parameter vector. Node 0 is the origin and node 1 lies on the x axis, so
+ * they contribute one coordinate between them; -1 for fixed coordinates.
+ */
+static inline int16_t
+pos_index(uint16_t i, uint16_t c){
+    if (i == 0 || (i == 1 && c == 1))
+        return -1;
+    return (i == 1) ? 0 : 1 + 2 * (i - 2) + c;
+}
+
+/**
+ * Places the nodes from the measured distances to nodes 0, 1 and 2, ignoring delays.
+ */
+static bool
+initial_positions(const float * dist, uint16_t nnodes, float (*pos)[2]){
+#define D(i,j) dist[(i) * nnodes + (j)]
+    float d01 = D(0,1);
+    if (!(d01 > 0))
+        return false;
+
+    pos[0][0] = pos[0][1] = 0;
+    pos[1][0] = d01;
+    pos[1][1] = 0;
+    for (uint16_t k = 2; k < nnodes; k++){
+        float d0 = D(0,k), d1 = D(1,k);
+        if (!(d0 >= 0 && d1 >= 0))
+            return false;
+        float x = (d0 * d0 - d1 * d1 + d01 * d01) / (2 * d01);
+        float y = sqrtf(fmaxf(d0 * d0 - x * x, 0));
+        pos[k][0] = x;
+        pos[k][1] = y;
+        if (k > 2 && D(2,k) >= 0){
+            float dxp = x - pos[2][0], dyp = y - pos[2][1], dyn = -y - pos[2][1];
+            if (fabsf(sqrtf(dxp * dxp + dyn * dyn) - D(2,k)) < fabsf(sqrtf(dxp * dxp + dyp * dyp) - D(2,k)))
+                pos[k][1] = -y;
+        }
+    }
+    return true;
+#undef D
+}
+
+/**
+ * Solves jointly for 2D node positions and antenna delay errors. Positions are returned in a frame with node 0 at
+ * the origin, node 1 on the positive x axis and node 2 in the upper half plane.
+ *
+ * @param pairs   Measured pairs, including every node paired with nodes 0, 1 and 2.
+ * @param npairs  Number of pairs, at least 3 * nnodes - 3.
+ * @param nnodes  Number of nodes.
+ * @param pos     Output, node positions, m.
+ * @param delay   Output, delay error of each node in DTU, to be added to both antenna delays.
+ * @param rms     Output, residual of the fit in DTU, may be NULL.
+ *
+ * @return true on success, false if the problem is underdetermined or did not converge
+ */
+bool
+antcal_solve_unknown(const antcal_pair_t * pairs, uint16_t npairs, uint16_t nnodes,
+        float (*pos)[2], float * delay, float * rms){
+
+    uint16_t npos = 2 * nnodes - 3;
+    uint16_t n = npos + nnodes;
+    bool rc = false;
+
+    if (nnodes < 3 || npairs < n)
+        return false;
+
+    float * dist = (float *) malloc(nnodes * nnodes * sizeof(float));
+    float * H = (float *) malloc(n * n * sizeof(float));
+    float * g = (float *) malloc(n * sizeof(float));
+    float * e = (float *) calloc(nnodes, sizeof(float));   // delay errors, m
+    if (dist == NULL || H == NULL || g == NULL || e == NULL)
+        goto done;
+
+    for (uint32_t k = 0; k < nnodes * nnodes; k++)
+        dist[k] = -1;
+    for (uint16_t p = 0; p < npairs; p++){
+        dist[pairs[p].i * nnodes + pairs[p].j] = pairs[p].tof * ANTCAL_M_PER_DTU;
+        dist[pairs[p].j * nnodes + pairs[p].i] = pairs[p].tof * ANTCAL_M_PER_DTU;
+    }
+    if (!initial_positions(dist, nnodes, pos))
+        goto done;
+
+    for (uint16_t it = 0; it < ANTCAL_GN_ITERATIONS; it++){
+        memset(H, 0, n * n * sizeof(float));
+        memset(g, 0, n * sizeof(float));
+
+        for (uint16_t p = 0; p < npairs; p++){
+            uint16_t i = pairs[p].i, j = pairs[p].j;
+            float dx = pos[i][0] - pos[j][0];
+            float dy = pos[i][1] - pos[j][1];
+            float d = sqrtf(dx * dx + dy * dy);
+            if (d < 1e-3f)
+                d = 1e-3f;
+            float r = d + e[i] + e[j] - pairs[p].tof * ANTCAL_M_PER_DTU;
+
+            // Sparse Jacobian row: up to four position terms and two delay terms
+            int16_t idx[6] = {pos_index(i,0), pos_index(i,1), pos_index(j,0), pos_index(j,1), npos + i, npos + j};
+            float J[6] = {dx / d, dy / d, -dx / d, -dy / d, 1, 1};
+            for (uint8_t a = 0; a < 6; a++){
+                if (idx[a] < 0)
+                    continue;
+                g[idx[a]] += J[a] * r;
+                for (uint8_t c = 0; c < 6; c++)
+                    if (idx[c] >= 0)
+                        H[idx[a] * n + idx[c]] += J[a] * J[c];
+            }
+        }
+        for (uint16_t k = 0; k < n; k++){
+            H[k * n + k] *= 1 + ANTCAL_GN_DAMPING;
+            g[k] = -g[k];
+        }
+        if (!cholesky_solve(H, g, n))
+            goto done;
+
+        float step = 0;
+        for (uint16_t i = 1; i < nnodes; i++)
+            for (uint16_t c = 0; c < 2; c++){
+                int16_t k = pos_index(i, c);
+                if (k >= 0){
+                    pos[i][c] += g[k];
+                    step = fmaxf(step, fabsf(g[k]));
+                }
+            }
+        for (uint16_t i = 0; i < nnodes; i++){
+            e[i] += g[npos + i];
+            step = fmaxf(step, fabsf(g[npos + i]));
+        }
+        if (step < ANTCAL_GN_TOLERANCE){
+            rc = true;
+            break;
+        }
+    }
+    if (!rc)
+        goto done;
+
+    float sum = 0;
+    for (uint16_t p = 0; p < npairs; p++){
+        uint16_t i = pairs[p].i, j = pairs[p].j;
+        float dx = pos[i][0] - pos[j][0];
+        float dy = pos[i][1] - pos[j][1];
+        float r = sqrtf(dx * dx + dy * dy) + e[i] + e[j] - pairs[p].tof * ANTCAL_M_PER_DTU;
+        sum += r * r;
+    }
+    if (rms)
+        *rms = sqrtf(sum / npairs) / ANTCAL_M_PER_DTU;
+    for (uint16_t i = 0; i < nnodes; i++)
+        delay[i] = e[i] / ANTCAL_M_PER_DTU;
+done:
+    free(dist);
+    free(H);
+    free(g);
+    free(e);
+    return rc;
+}
@@ -0,0 +1,91 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "antcal_test.h"
+
+#define ANTCAL_KNOWN_TEST_NODES 8
+
+static const float known_pos[ANTCAL_KNOWN_TEST_NODES][3] = {
+    {0, 0, 0}, {6.5f, 0, 0.3f}, {6.2f, 5.1f, 1.2f}, {0.4f, 4.8f, 2.1f},
+    {3.1f, 2.2f, 0.8f}, {9.7f, 3.4f, 1.5f}, {2.3f, 8.9f, 0.1f}, {11.2f, 7.6f, 2.4f}
+};
+static const float known_delay[ANTCAL_KNOWN_TEST_NODES] = {12.5f, -8.0f, 3.25f, 0, -15.5f, 7.0f, 21.0f, -2.5f};
+
+static float
+distance(const float * a, const float * b)
+{
+    return sqrtf((a[0] - b[0]) * (a[0] - b[0]) + (a[1] - b[1]) * (a[1] - b[1]) + (a[2] - b[2]) * (a[2] - b[2]));
+}
+
+/* Biased time of flight of the pair, DTU */
+static antcal_pair_t
+pair(uint16_t i, uint16_t j)
+{
+    antcal_pair_t p = {.i = i, .j = j, .n = 100};
+    p.tof = distance(known_pos[i], known_pos[j]) / ANTCAL_M_PER_DTU + known_delay[i] + known_delay[j];
+    return p;
+}
+
+/* Delays recovered from every pair and from a sparse graph, refused when not observable */
+TEST_CASE(antcal_known_test)
+{
+    antcal_pair_t pairs[ANTCAL_KNOWN_TEST_NODES * (ANTCAL_KNOWN_TEST_NODES - 1) / 2];
+    float delay[ANTCAL_KNOWN_TEST_NODES];
+    float rms;
+    uint16_t n = 0;
+
+    /* Every pair */
+    for (uint16_t i = 0; i < ANTCAL_KNOWN_TEST_NODES; i++)
+        for (uint16_t j = i + 1; j < ANTCAL_KNOWN_TEST_NODES; j++)
+            pairs[n++] = pair(i, j);
+    TEST_ASSERT_FATAL(antcal_solve_known(pairs, n, known_pos, ANTCAL_KNOWN_TEST_NODES, delay, &rms));
+    for (uint16_t i = 0; i < ANTCAL_KNOWN_TEST_NODES; i++)
+        TEST_ASSERT(fabsf(delay[i] - known_delay[i]) < 0.01f);
+    TEST_ASSERT(rms < 0.01f);
+
+    /* A ring with one chord, the smallest graph with an odd cycle */
+    n = 0;
+    for (uint16_t i = 0; i < ANTCAL_KNOWN_TEST_NODES; i++)
+        pairs[n++] = pair(i, (i + 1) % ANTCAL_KNOWN_TEST_NODES);
+    pairs[n++] = pair(0, 2);
+    TEST_ASSERT_FATAL(antcal_solve_known(pairs, n, known_pos, ANTCAL_KNOWN_TEST_NODES, delay, NULL));
+    for (uint16_t i = 0; i < ANTCAL_KNOWN_TEST_NODES; i++)
+        TEST_ASSERT(fabsf(delay[i] - known_delay[i]) < 0.01f);
+
+    /* An even ring is bipartite: e_i + d and e_j - d alternate around it and fit as well */
+    n = 0;
+    for (uint16_t i = 0; i < ANTCAL_KNOWN_TEST_NODES; i++)
+        pairs[n++] = pair(i, (i + 1) % ANTCAL_KNOWN_TEST_NODES);
+    pairs[n++] = pair(0, 3);
+    TEST_ASSERT(!antcal_solve_known(pairs, n, known_pos, ANTCAL_KNOWN_TEST_NODES, delay, NULL));
+
+    /* Two triangles with no pair between them */
+    n = 0;
+    pairs[n++] = pair(0, 1);
+    pairs[n++] = pair(1, 2);
+    pairs[n++] = pair(2, 0);
+    pairs[n++] = pair(3, 4);
+    pairs[n++] = pair(4, 5);
+    pairs[n++] = pair(5, 3);
+    TEST_ASSERT(!antcal_solve_known(pairs, n, known_pos, 6, delay, NULL));
+
+    /* Fewer pairs than nodes */
+    TEST_ASSERT(!antcal_solve_known(pairs, 2, known_pos, 3, delay, NULL));
+}
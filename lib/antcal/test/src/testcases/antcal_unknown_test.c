@@ -0,0 +1,68 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "antcal_test.h"
+
+#define ANTCAL_UNKNOWN_TEST_NODES 7
+
+/* Node 0 at the origin, node 1 on the x axis and node 2 in the upper half plane, as the solver returns them */
+static const float unknown_pos[ANTCAL_UNKNOWN_TEST_NODES][2] = {
+    {0, 0}, {7.0f, 0}, {3.2f, 6.1f}, {-2.4f, 4.3f}, {8.8f, 5.5f}, {4.1f, -3.7f}, {1.5f, 2.0f}
+};
+static const float unknown_delay[ANTCAL_UNKNOWN_TEST_NODES] = {10.0f, -6.5f, 4.0f, -12.0f, 2.5f, 18.0f, -3.0f};
+
+static float
+distance(const float * a, const float * b)
+{
+    return sqrtf((a[0] - b[0]) * (a[0] - b[0]) + (a[1] - b[1]) * (a[1] - b[1]));
+}
+
+/* Positions and delays recovered jointly from every pair, refused when underdetermined */
+TEST_CASE(antcal_unknown_test)
+{
+    antcal_pair_t pairs[ANTCAL_UNKNOWN_TEST_NODES * (ANTCAL_UNKNOWN_TEST_NODES - 1) / 2];
+    float pos[ANTCAL_UNKNOWN_TEST_NODES][2];
+    float delay[ANTCAL_UNKNOWN_TEST_NODES];
+    float rms;
+    uint16_t n = 0;
+
+    for (uint16_t i = 0; i < ANTCAL_UNKNOWN_TEST_NODES; i++)
+        for (uint16_t j = i + 1; j < ANTCAL_UNKNOWN_TEST_NODES; j++){
+            pairs[n].i = i;
+            pairs[n].j = j;
+            pairs[n].n = 100;
+            pairs[n].tof = distance(unknown_pos[i], unknown_pos[j]) / ANTCAL_M_PER_DTU
+                    + unknown_delay[i] + unknown_delay[j];
+            n++;
+        }
+
+    TEST_ASSERT_FATAL(antcal_solve_unknown(pairs, n, ANTCAL_UNKNOWN_TEST_NODES, pos, delay, &rms));
+    for (uint16_t i = 0; i < ANTCAL_UNKNOWN_TEST_NODES; i++){
+        TEST_ASSERT(fabsf(delay[i] - unknown_delay[i]) < 0.1f);
+        TEST_ASSERT(fabsf(pos[i][0] - unknown_pos[i][0]) < 0.005f);
+        TEST_ASSERT(fabsf(pos[i][1] - unknown_pos[i][1]) < 0.005f);
+    }
+    TEST_ASSERT(rms < 0.1f);
+
+    /* 3 * nnodes - 3 pairs are needed for 2 * nnodes - 3 coordinates and nnodes delays */
+    TEST_ASSERT(!antcal_solve_unknown(pairs, 3 * ANTCAL_UNKNOWN_TEST_NODES - 4, ANTCAL_UNKNOWN_TEST_NODES,
+            pos, delay, NULL));
+    TEST_ASSERT(!antcal_solve_unknown(pairs, 2, 2, pos, delay, NULL));
+}
@@ -63,6 +63,12 @@ STATS_SECT_START(ccp_stat_section)
     STATS_SECT_ENTRY(tx_relay_ok)
     STATS_SECT_ENTRY(rx_timeout)
     STATS_SECT_ENTRY(reset)
+    STATS_SECT_ENTRY(holdover)
+    STATS_SECT_ENTRY(holdover_lost)
+    STATS_SECT_ENTRY(takeover)
+    STATS_SECT_ENTRY(standby_tx)
+    STATS_SECT_ENTRY(standby_rx)
+    STATS_SECT_ENTRY(relay_hop_limit)
 STATS_SECT_END
 
 //! Timestamps and blink frame format  of ccp frame.
@@ -87,6 +93,26 @@ typedef union {
     uint8_t array[sizeof(struct _ccp_frame_t)];
 }ccp_frame_t;
 
+//! Relayed ccp frame. transmission_timestamp is the master time of the relay transmission and transmission_interval
+//! the master period less the relay delay, as legacy relays send them.
+typedef union {
+    struct _ccp_relay_frame_t{
+        struct _ccp_blink_frame_t;          //!< Low byte of long_address is the slot of the relay
+        uint8_t hops;                       //!< Relays between the clock master and this transmission
+        uint32_t relay_delay;               //!< Master time from the clock master transmission to this one, DTU
+    }__attribute__((__packed__, aligned(1)));
+    uint8_t array[sizeof(struct _ccp_relay_frame_t)];
+}ccp_relay_frame_t;
+
+//! Standby beacon of a backup clock master, sent in the slot of its rank after each ccp frame
+typedef union {
+    struct _ccp_standby_frame_t{
+        struct _ieee_blink_frame_t;         //!< FCNTL_IEEE_BLINK_ANC_64, ccp uuid with the rank in the low byte
+        uint64_t transmission_timestamp;    //!< Transmission timestamp, in the master timebase with WCS
+    }__attribute__((__packed__, aligned(1)));
+    uint8_t array[sizeof(struct _ccp_standby_frame_t)];
+}ccp_standby_frame_t;
+
 //! Status parameters of ccp.
 typedef struct _dw1000_ccp_status_t{
     uint16_t selfmalloc:1;            //!< Internal flag for memory garbage collection 
@@ -96,13 +122,17 @@ typedef struct _dw1000_ccp_status_t{
     uint16_t start_rx_error:1;        //!< Set for start request error
     uint16_t rx_timeout_error:1;      //!< Receive timeout error 
     uint16_t timer_enabled:1;         //!< Indicates timer is enabled 
+    uint16_t holdover:1;              //!< Epoch extrapolated across missed frames, sync degraded
+    uint16_t elected:1;               //!< Master by takeover, timestamps continue the timebase of the lost master
+    uint16_t standby:1;               //!< Standby beacon in flight, or standby window open on the master
 }dw1000_ccp_status_t;
 
 //! Extension ids for services.
 typedef enum _dw1000_ccp_role_t{
     CCP_ROLE_MASTER,                        //!< Clock calibration packet master mode
     CCP_ROLE_SLAVE,                         //!< Clock calibration packet slave mode
-    CCP_ROLE_RELAY                          //!< Clock calibration packet master replay mode
+    CCP_ROLE_RELAY,                         //!< Clock calibration packet master replay mode
+    CCP_ROLE_BACKUP                         //!< Standby clock master, tracks the master and takes over by rank
 }dw1000_ccp_role_t;
 
 //! ccp config parameters.  
@@ -110,11 +140,15 @@ typedef struct _dw1000_ccp_config_t{
     uint16_t postprocess:1;           //!< CCP postprocess
     uint16_t fs_xtalt_autotune:1;     //!< Autotune XTALT to Clock Master
     uint16_t role:4;                  //!< dw1000_ccp_role_t
+    uint16_t rank:4;                  //!< Election rank of a backup, lowest takes over first
     uint32_t tx_holdoff_dly;          //!< Relay nodes first holdoff
     uint32_t tx_guard_dly;            //!< Relay nodes guard delay
-    uint32_t tof_compensation;        //!< TOF relative master TODO: generalise to cascading nodes
+    uint32_t tof_compensation;        //!< TOF from the clock master, DTU, see dw1000_ccp_set_relay_tof for relays
 }dw1000_ccp_config_t;
 
+//! Holdover callback, called in the ccp task each time the epoch is extrapolated across a missed frame
+typedef void (* ccp_holdover_cb_t)(struct _dw1000_dev_instance_t * inst, void * arg);
+
 //! ccp instance parameters.
 typedef struct _dw1000_ccp_instance_t{
     struct _dw1000_dev_instance_t * parent;     //!< Pointer to _dw1000_dev_instance_t
@@ -136,6 +170,18 @@ typedef struct _dw1000_ccp_instance_t{
     uint64_t epoch;
     uint32_t os_epoch;
     uint32_t period;                                //!< Pulse repetition period
+    uint32_t master_period;                         //!< Superframe period of the clock master, dwt usec
+    uint16_t missed;                                //!< Consecutive frames missed in holdover
+    uint32_t os_sync;                               //!< Last frame received or sent, cputime ticks
+    uint32_t standby;                               //!< Rank of the backup heard in the last standby window, as a bit
+    uint8_t hops;                                   //!< Relays between the clock master and the last frame received
+    uint32_t relay_delay;                           //!< Relay delay of the last frame received, DTU
+    uint32_t tof;                                   //!< TOF from the sender of the last frame received, DTU
+#if MYNEWT_VAL(CCP_NUM_RELAYING_ANCHORS) != 0
+    uint32_t relay_tof[MYNEWT_VAL(CCP_NUM_RELAYING_ANCHORS)]; //!< TOF from the relay in each slot, DTU
+#endif
+    ccp_holdover_cb_t holdover_cb;                  //!< Holdover callback
+    void * holdover_arg;                            //!< Argument of the holdover callback
     uint16_t nframes;                               //!< Number of buffers defined to store the data 
     uint16_t idx;                                   //!< Indicates number of DW1000 instances 
     struct hal_timer timer;                         //!< Timer structure
@@ -154,6 +200,10 @@ void dw1000_ccp_free(dw1000_ccp_instance_t * inst);
 void dw1000_ccp_set_postprocess(dw1000_ccp_instance_t * inst, os_event_fn * ccp_postprocess); 
 void dw1000_ccp_start(dw1000_dev_instance_t * inst, dw1000_ccp_role_t role);
 void dw1000_ccp_stop(dw1000_dev_instance_t * inst);
+void dw1000_ccp_set_relay_tof(dw1000_ccp_instance_t * ccp, uint16_t slot, uint32_t tof);
+void dw1000_ccp_set_rank(dw1000_ccp_instance_t * ccp, uint8_t rank);
+void dw1000_ccp_set_holdover_cb(dw1000_ccp_instance_t * ccp, ccp_holdover_cb_t cb, void * arg);
+uint32_t dw1000_ccp_holdover_guard(dw1000_ccp_instance_t * ccp);
 
 #ifdef __cplusplus
 }
@@ -47,6 +47,9 @@
 #if MYNEWT_VAL(WCS_ENABLED)
 #include <wcs/wcs.h>
 #endif
+#if MYNEWT_VAL(TELEMETRY_ENABLED)
+#include <telemetry/telemetry.h>
+#endif
 
 //#define DIAGMSG(s,u) printf(s,u)
 #ifndef DIAGMSG
@@ -103,6 +106,12 @@ STATS_NAME_START(ccp_stat_section)
     STATS_NAME(ccp_stat_section, tx_relay_ok)
     STATS_NAME(ccp_stat_section, rx_timeout)
     STATS_NAME(ccp_stat_section, reset)
+    STATS_NAME(ccp_stat_section, holdover)
+    STATS_NAME(ccp_stat_section, holdover_lost)
+    STATS_NAME(ccp_stat_section, takeover)
+    STATS_NAME(ccp_stat_section, standby_tx)
+    STATS_NAME(ccp_stat_section, standby_rx)
+    STATS_NAME(ccp_stat_section, relay_hop_limit)
 STATS_NAME_END(ccp_stat_section)
 
 
@@ -120,6 +129,13 @@ static void ccp_tasks_init(struct _dw1000_ccp_instance_t * inst);
 static void ccp_timer_irq(void * arg);
 static void ccp_master_timer_ev_cb(struct os_event *ev);
 static void ccp_slave_timer_ev_cb(struct os_event *ev);
+static bool ccp_election(struct _dw1000_dev_instance_t * inst);
+static void ccp_relay(struct _dw1000_dev_instance_t * inst);
+#if MYNEWT_VAL(CCP_MAX_MASTERS) > 1
+static void ccp_standby_send(struct _dw1000_dev_instance_t * inst);
+static void ccp_standby_listen(struct _dw1000_dev_instance_t * inst);
+static bool ccp_standby_rx(struct _dw1000_dev_instance_t * inst);
+#endif
 
 #if !MYNEWT_VAL(WCS_ENABLED)
 static void ccp_postprocess(struct os_event * ev);
@@ -191,6 +207,9 @@ ccp_master_timer_ev_cb(struct os_event *ev) {
         hal_timer_start_at(&ccp->timer, ccp->os_epoch
             + os_cputime_usecs_to_ticks((uint32_t)dw1000_dwt_usecs_to_usecs(ccp->period))
         );
+#if MYNEWT_VAL(CCP_MAX_MASTERS) > 1
+        ccp_standby_listen(inst);
+#endif
     }
 }
 
@@ -218,11 +237,365 @@ usecs_to_response(dw1000_dev_instance_t * inst, int rx_slot, int my_slot)
 }
 
 
+/**
+ * Help function to convert an interval of the master timebase to the local one, with the drift of the published
+ * WCS clock model. Without WCS the interval is returned as is.
+ *
+ * @param inst             Pointer to dw1000_dev_instance_t.
+ * @param master_interval  Interval, DTU.
+ * @return Local interval, DTU
+ */
+static uint64_t
+ccp_local_interval(struct _dw1000_dev_instance_t * inst, uint64_t master_interval){
+#if MYNEWT_VAL(WCS_ENABLED)
+    return master_interval - (((int64_t)master_interval * wcs_model(inst)->drift) >> WCS_DRIFT_Q);
+#else
+    return master_interval;
+#endif
+}
+
+/**
+ * Help function to bridge a missed frame. The epochs advance by one superframe of the clock master, converted to the
+ * local timebase with the last WCS estimate, so that the slave timer and TDMA keep their schedule. After
+ * MYNEWT_VAL(CCP_HOLDOVER_MAX) consecutive misses sync is declared lost and the slave searches for the master again.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return true if the epoch was extrapolated
+ */
+static bool
+ccp_holdover(struct _dw1000_dev_instance_t * inst){
+
+    dw1000_ccp_instance_t * ccp = inst->ccp;
+
+    if (!ccp->status.valid)
+        return false;
+    if (++ccp->missed > MYNEWT_VAL(CCP_HOLDOVER_MAX)){
+        if (ccp->status.holdover)
+            STATS_INC(ccp->stat, holdover_lost);
+        ccp->status.holdover = 0;
+        ccp->status.valid = 0;
+        ccp->missed = 0;
+        return false;
+    }
+    STATS_INC(ccp->stat, holdover);
+
+    uint64_t master_interval = (uint64_t)ccp->master_period << 16;
+    uint64_t local_interval = ccp_local_interval(inst, master_interval);
+    ccp->epoch_master = (ccp->epoch_master + master_interval) & 0x0FFFFFFFFFFUL;
+    ccp->epoch = (ccp->epoch + local_interval) & 0x0FFFFFFFFFFUL;
+    ccp->os_epoch += os_cputime_usecs_to_ticks((uint32_t)dw1000_dwt_usecs_to_usecs(ccp->master_period));
+    ccp->status.holdover = 1;
+
+    if (ccp->holdover_cb)
+        ccp->holdover_cb(inst, ccp->holdover_arg);
+    return true;
+}
+
+/**
+ * API to compute the timing uncertainty accumulated in holdover, for consumers to widen their guard times by.
+ *
+ * @param ccp  Pointer to dw1000_ccp_instance_t.
+ * @return Guard time, usec, 0 when not in holdover
+ */
+uint32_t
+dw1000_ccp_holdover_guard(dw1000_ccp_instance_t * ccp){
+    if (!ccp->status.holdover)
+        return 0;
+    uint64_t elapsed = (uint64_t)ccp->missed * (uint32_t)dw1000_dwt_usecs_to_usecs(ccp->master_period);
+    return (uint32_t)((elapsed * MYNEWT_VAL(CCP_HOLDOVER_DRIFT) + 999999999ULL) / 1000000000ULL);
+}
+
+/**
+ * API to set the callback notified each time the epoch is extrapolated across a missed frame.
+ *
+ * @param ccp  Pointer to dw1000_ccp_instance_t.
+ * @param cb   Callback, NULL for none.
+ * @param arg  Argument of the callback.
+ * @return void
+ */
+void
+dw1000_ccp_set_holdover_cb(dw1000_ccp_instance_t * ccp, ccp_holdover_cb_t cb, void * arg){
+    ccp->holdover_arg = arg;
+    ccp->holdover_cb = cb;
+}
+
+/**
+ * API to set the election rank of a backup clock master. Ranks are unique within a cell and below
+ * MYNEWT_VAL(CCP_MAX_MASTERS); rank 0 takes over first.
+ *
+ * @param ccp   Pointer to dw1000_ccp_instance_t.
+ * @param rank  Election rank.
+ * @return void
+ */
+void
+dw1000_ccp_set_rank(dw1000_ccp_instance_t * ccp, uint8_t rank){
+    assert(rank < MYNEWT_VAL(CCP_MAX_MASTERS));
+    ccp->config.rank = rank;
+}
+
+/**
+ * Help function to make a backup the clock master. With continuity the backup carries on the sequence and, with WCS,
+ * the timebase of the lost master: its first frame goes out a superframe after the last one it bridged, and every
+ * timestamp it sends is converted to the master timebase by its last clock model, so slaves keep their model.
+ * Otherwise it starts a fresh timebase as dw1000_ccp_start does.
+ *
+ * @param inst        Pointer to dw1000_dev_instance_t.
+ * @param continuity  Continue the timebase of the lost master.
+ * @return void
+ */
+static void
+ccp_takeover(struct _dw1000_dev_instance_t * inst, bool continuity){
+
+    dw1000_ccp_instance_t * ccp = inst->ccp;
+    ccp_frame_t * frame = ccp->frames[(ccp->idx)%ccp->nframes];
+
+    STATS_INC(ccp->stat, takeover);
+    os_cputime_timer_stop(&ccp->timer);
+    ccp->period = ccp->master_period;
+
+    if (continuity){
+        frame->transmission_timestamp = ccp->epoch;
+        frame->seq_num += ccp->missed;
+        ccp->missed = 0;
+        ccp->status.holdover = 0;
+        ccp->config.role = CCP_ROLE_MASTER;
+#if MYNEWT_VAL(WCS_ENABLED)
+        ccp->status.elected = 1;
+#endif
+        ccp_timer_init(inst, CCP_ROLE_MASTER);
+    }else
+        dw1000_ccp_start(inst, CCP_ROLE_MASTER);
+}
+
+/**
+ * Help function for the election of a backup after each listen. The master is taken as lost once the backup has
+ * bridged rank + 1 frames in holdover, so the lowest surviving rank takes over first and a higher rank hears it before
+ * its own turn. Without holdover to carry the timebase the election falls back to rank + 2 superframes of silence.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return true if this node took over
+ */
+static bool
+ccp_election(struct _dw1000_dev_instance_t * inst){
+
+    dw1000_ccp_instance_t * ccp = inst->ccp;
+    if (ccp->config.role != CCP_ROLE_BACKUP)
+        return false;
+
+    if (ccp->status.holdover && ccp->missed > ccp->config.rank){
+        ccp_takeover(inst, true);
+        return true;
+    }
+    uint32_t silence = (ccp->config.rank + 2) * (uint32_t)dw1000_dwt_usecs_to_usecs(ccp->master_period);
+    if (!ccp->status.valid && os_cputime_get32() - ccp->os_sync > os_cputime_usecs_to_ticks(silence)){
+        ccp_takeover(inst, false);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * API to set the TOF from the relay in a slot, as measured by ranging between the anchors. A relayed frame is
+ * compensated by the TOF of its last hop only, as each relay already compensates its own.
+ *
+ * @param ccp   Pointer to dw1000_ccp_instance_t.
+ * @param slot  Relay slot, inst->slot_id - 1 of the relay; 0 sets the TOF from the clock master.
+ * @param tof   Time of flight, DTU.
+ * @return void
+ */
+void
+dw1000_ccp_set_relay_tof(dw1000_ccp_instance_t * ccp, uint16_t slot, uint32_t tof){
+    if (slot == 0){
+        ccp->config.tof_compensation = tof;
+        return;
+    }
+#if MYNEWT_VAL(CCP_NUM_RELAYING_ANCHORS) != 0
+    assert(slot <= MYNEWT_VAL(CCP_NUM_RELAYING_ANCHORS));
+    ccp->relay_tof[slot - 1] = tof;
+#else
+    assert(0);
+#endif
+}
+
+/**
+ * Help function to relay the ccp frame just received. Relays transmit in the order of their slots, each at a fixed
+ * offset from the clock master transmission in master time, so the schedule holds whichever earlier slot a relay
+ * hears and however many hops the frame has made. The frame carries the hop count and the relay delay, the master
+ * time elapsed since the clock master transmission, from which the receivers recover the master epoch exactly.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return void
+ */
+static void
+ccp_relay(struct _dw1000_dev_instance_t * inst){
+
+    dw1000_ccp_instance_t * ccp = inst->ccp;
+    ccp_frame_t * frame = ccp->frames[(ccp->idx)%ccp->nframes];
+
+    if (ccp->hops >= MYNEWT_VAL(CCP_RELAY_HOPS_MAX)){
+        STATS_INC(ccp->stat, relay_hop_limit);
+        return;
+    }
+
+    ccp_relay_frame_t tx_frame;
+    memcpy(tx_frame.array, frame->array, sizeof(ccp_blink_frame_t));
+    uint64_t tx_timestamp = ccp->epoch
+            + ccp_local_interval(inst, ((uint64_t)usecs_to_response(inst, 0, inst->slot_id-1)) << 16);
+    tx_timestamp &= 0x0FFFFFFFFFFUL;
+    dw1000_set_delay_start(inst, tx_timestamp);
+
+    /* Need to add antenna delay and tof compensation of the last hop */
+    tx_timestamp += inst->tx_antenna_delay + ccp->tof;
+
+#if MYNEWT_VAL(WCS_ENABLED)
+    tx_frame.transmission_timestamp = wcs_local_to_master(inst, tx_timestamp);
+#else
+    tx_frame.transmission_timestamp = (ccp->epoch_master + tx_timestamp - ccp->epoch) & 0x0FFFFFFFFFFUL;
+#endif
+    tx_frame.long_address = ccp->uuid | (inst->slot_id-1);
+    tx_frame.hops = ccp->hops + 1;
+    tx_frame.relay_delay = (uint32_t)((tx_frame.transmission_timestamp - ccp->epoch_master) & 0x0FFFFFFFFFFUL);
+    tx_frame.transmission_interval = ccp->master_period - (tx_frame.relay_delay >> 16);
+
+    dw1000_write_tx(inst, tx_frame.array, 0, sizeof(ccp_relay_frame_t));
+    dw1000_write_tx_fctrl(inst, sizeof(ccp_relay_frame_t), 0, true); 
+    ccp->status.start_tx_error = dw1000_start_tx(inst).start_tx_error;
+    if (ccp->status.start_tx_error){
+        STATS_INC(ccp->stat, tx_relay_error);
+    } else {
+        STATS_INC(ccp->stat, tx_relay_ok);
+    }
+}
+
+#if MYNEWT_VAL(CCP_MAX_MASTERS) > 1
+/**
+ * Help function for the width of a standby slot.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return Slot width, usec
+ */
+static uint32_t
+ccp_standby_slot(struct _dw1000_dev_instance_t * inst){
+    return (uint32_t)inst->ccp->config.tx_guard_dly
+            + dw1000_phy_frame_duration(&inst->attrib, sizeof(ccp_standby_frame_t));
+}
+
+/**
+ * Help function for the start of the standby slots after the ccp frame, the slot following the last relay.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return Offset from the ccp frame, usec
+ */
+static uint32_t
+ccp_standby_offset(struct _dw1000_dev_instance_t * inst){
+    return usecs_to_response(inst, 0, MYNEWT_VAL(CCP_NUM_RELAYING_ANCHORS) + 1);
+}
+
+/**
+ * Help function for a backup to send its standby beacon, in the slot of its rank after the ccp frame just received.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return void
+ */
+static void
+ccp_standby_send(struct _dw1000_dev_instance_t * inst){
+
+    dw1000_ccp_instance_t * ccp = inst->ccp;
+    uint64_t tx_time = (ccp->epoch + ((uint64_t)ceilf(ccp_standby_offset(inst)
+            + dw1000_usecs_to_dwt_usecs(ccp->config.rank * ccp_standby_slot(inst))) << 16)) & 0x0FFFFFFFFFFUL;
+
+    ccp_standby_frame_t frame = {
+        .fctrl = FCNTL_IEEE_BLINK_ANC_64,
+        .seq_num = ccp->frames[(ccp->idx)%ccp->nframes]->seq_num,
+        .long_address = (ccp->uuid & 0xffffffffffffff00UL) | ccp->config.rank,
+#if MYNEWT_VAL(WCS_ENABLED)
+        .transmission_timestamp = wcs_local_to_master(inst, tx_time + inst->tx_antenna_delay)
+#else
+        .transmission_timestamp = (tx_time + inst->tx_antenna_delay) & 0x0FFFFFFFFFFUL
+#endif
+    };
+
+    os_error_t err = os_sem_pend(&ccp->sem, OS_TIMEOUT_NEVER);
+    assert(err == OS_OK);
+
+    dw1000_write_tx(inst, frame.array, 0, sizeof(ccp_standby_frame_t));
+    dw1000_write_tx_fctrl(inst, sizeof(ccp_standby_frame_t), 0, true);
+    dw1000_set_wait4resp(inst, false);
+    dw1000_set_delay_start(inst, tx_time);
+
+    ccp->status.standby = 1;
+    if (dw1000_start_tx(inst).start_tx_error){
+        ccp->status.standby = 0;
+        STATS_INC(ccp->stat, tx_start_error);
+    }else{
+        err = os_sem_pend(&ccp->sem, OS_TIMEOUT_NEVER); // Wait for completion of transactions
+        assert(err == OS_OK);
+    }
+    err = os_sem_release(&ccp->sem);
+    assert(err == OS_OK);
+}
+
+/**
+ * Help function for the master to listen for the standby beacons of its backups after each ccp frame. The window closes
+ * on the first frame received; the rank of the backup heard, if any, is left in ccp->standby.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return void
+ */
+static void
+ccp_standby_listen(struct _dw1000_dev_instance_t * inst){
+
+    dw1000_ccp_instance_t * ccp = inst->ccp;
+    uint64_t dx_time = ccp->epoch
+            + ((uint64_t)ccp_standby_offset(inst) << 16)
+            - ((uint64_t)ceilf(dw1000_usecs_to_dwt_usecs(dw1000_phy_SHR_duration(&inst->attrib))) << 16);
+    uint32_t timeout = MYNEWT_VAL(CCP_MAX_MASTERS) * ccp_standby_slot(inst) + MYNEWT_VAL(XTALT_GUARD);
+
+    ccp->standby = 0;
+    dw1000_set_rx_timeout(inst, (timeout < 0xffff) ? (uint16_t) timeout : (uint16_t) 0xffff);
+    dw1000_set_delay_start(inst, dx_time & 0x0FFFFFFFFFFUL);
+    ccp->status.standby = 1;
+    dw1000_ccp_listen(inst, DWT_BLOCKING);
+    ccp->status.standby = 0;
+}
+
+/**
+ * Help function for the receive complete callback on the master during its standby window. Any frame closes the
+ * window; a standby beacon for this master records the rank of its sender.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @return true
+ */
+static bool
+ccp_standby_rx(struct _dw1000_dev_instance_t * inst){
+
+    dw1000_ccp_instance_t * ccp = inst->ccp;
+    ccp_standby_frame_t * frame = (ccp_standby_frame_t *) inst->rxbuf;
+
+    if (inst->fctrl_array[0] == FCNTL_IEEE_BLINK_ANC_64 && inst->frame_len == sizeof(ccp_standby_frame_t)
+            && (ccp->uuid & 0xffffffffffffff00UL) == (frame->long_address & 0xffffffffffffff00UL)){
+        uint8_t rank = frame->long_address & 0xff;
+        if (rank < 32)
+            ccp->standby |= 1UL << rank;
+        STATS_INC(ccp->stat, standby_rx);
+    }
+
+    dw1000_stop_rx(inst); //Prevent timeout event
+    ccp->status.standby = 0;
+    if (os_sem_get_count(&ccp->sem) == 0){
+        os_error_t err = os_sem_release(&ccp->sem);
+        assert(err == OS_OK);
+    }
+    return true;
+}
+#endif
+
 /** 
  * The OS scheduler is not accurate enough for the timing requirement of an RTLS system.  
  * Instead, the OS is used to schedule events in advance of the actual event.  
  * The DW1000 delay start mechanism then takes care of the actual event. This removes the non-deterministic 
- * latencies of the OS implementation.  
+ * latencies of the OS implementation. A missed frame is bridged by ccp_holdover, with the receive window
+ * widened by the uncertainty accumulated so far.
  * 
  * @param ev  Pointer to os_events.
  * @return void
@@ -240,25 +613,36 @@ ccp_slave_timer_ev_cb(struct os_event *ev) {
 
     STATS_INC(inst->ccp->stat, slave_cnt);
 
+    uint32_t guard = dw1000_ccp_holdover_guard(ccp);
     uint64_t dx_time = ccp->epoch 
             + ((uint64_t)inst->ccp->period << 16) 
-            - ((uint64_t)ceilf(dw1000_usecs_to_dwt_usecs(dw1000_phy_SHR_duration(&inst->attrib))) << 16);
+            - ((uint64_t)ceilf(dw1000_usecs_to_dwt_usecs(dw1000_phy_SHR_duration(&inst->attrib) + guard)) << 16);
 
-    uint16_t timeout = dw1000_phy_frame_duration(&inst->attrib, sizeof(ccp_blink_frame_t)) 
-                        + MYNEWT_VAL(XTALT_GUARD);
+    uint32_t timeout = dw1000_phy_frame_duration(&inst->attrib, sizeof(ccp_blink_frame_t)) 
+                        + MYNEWT_VAL(XTALT_GUARD) + 2 * guard;
 #if MYNEWT_VAL(CCP_NUM_RELAYING_ANCHORS) != 0
     /* Adjust timeout if we're using cascading ccp in anchors */
     timeout += usecs_to_response(inst, 0, MYNEWT_VAL(CCP_NUM_RELAYING_ANCHORS));
 #endif
-    dw1000_set_rx_timeout(inst, timeout); 
-    dw1000_set_delay_start(inst, dx_time);
+    dw1000_set_rx_timeout(inst, (timeout < 0xffff) ? (uint16_t) timeout : (uint16_t) 0xffff); 
+    dw1000_set_delay_start(inst, dx_time & 0x0FFFFFFFFFFUL);
 
+    uint16_t idx = ccp->idx;
     dw1000_ccp_status_t status = dw1000_ccp_listen(inst, DWT_BLOCKING);
     if(status.start_rx_error){
         /* Sync lost, set a long rx timeout */
         dw1000_set_rx_timeout(inst, (uint16_t) 0xffff);
         dw1000_ccp_listen(inst, DWT_BLOCKING);
     }
+    if (ccp->idx == idx){
+        ccp_holdover(inst);
+        if (ccp_election(inst))
+            return;
+    }
+#if MYNEWT_VAL(CCP_MAX_MASTERS) > 1
+    else if (ccp->config.role == CCP_ROLE_BACKUP)
+        ccp_standby_send(inst);
+#endif
     // Schedule event
     hal_timer_start_at(&ccp->timer, ccp->os_epoch 
         + os_cputime_usecs_to_ticks(
@@ -346,7 +730,7 @@ dw1000_ccp_init(struct _dw1000_dev_instance_t * inst, uint16_t nframes, uint64_t
     }else{
         assert(inst->ccp->nframes == nframes);
     }
-    inst->ccp->period = MYNEWT_VAL(CCP_PERIOD);
+    inst->ccp->period = inst->ccp->master_period = MYNEWT_VAL(CCP_PERIOD);
     inst->ccp->config = (dw1000_ccp_config_t){
         .postprocess = false,
 #if MYNEWT_VAL(FS_XTALT_AUTOTUNE_ENABLED)
@@ -493,6 +877,17 @@ ccp_postprocess(struct os_event * ev){
 
 #if MYNEWT_VAL(CCP_VERBOSE)
     float clock_offset = dw1000_calc_clock_offset_ratio(ccp->parent, frame->carrier_integrator);
+#if MYNEWT_VAL(TELEMETRY_ENABLED)
+    telemetry_ccp_t record = {
+        .utime = os_cputime_ticks_to_usecs(os_cputime_get32()),
+        .seq_num = frame->seq_num,
+        .transmission_timestamp = frame->transmission_timestamp,
+        .delta = delta,
+        .clock_offset = clock_offset
+    };
+    telemetry_write(TELEMETRY_CCP, &record, sizeof(record));
+#else
+    printf("{\"utime\": %lu,\"ccp\":[\"%llX\",\"%llX\"],\"clock_offset\": %lu,\"seq_num\": %d}\n",
         os_cputime_ticks_to_usecs(os_cputime_get32()),   
         frame->transmission_timestamp,
         delta,
@@ -500,6 +895,7 @@ ccp_postprocess(struct os_event * ev){
         frame->seq_num
     );
 #endif
+#endif
 }
 #endif
 
@@ -519,6 +915,10 @@ ccp_postprocess(struct os_event * ev){
 static bool 
 rx_complete_cb(struct _dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs)
 {
+#if MYNEWT_VAL(CCP_MAX_MASTERS) > 1
+    if (inst->ccp->config.role == CCP_ROLE_MASTER && inst->ccp->status.standby)
+        return ccp_standby_rx(inst);
+#endif
     if (inst->fctrl_array[0] != FCNTL_IEEE_BLINK_CCP_64){     
         if(os_sem_get_count(&inst->ccp->sem) == 0){
             dw1000_set_rx_timeout(inst, (uint16_t) 0xffff);
@@ -559,57 +959,56 @@ rx_complete_cb(struct _dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cb
     
     ccp->idx++; // confirmed frame advance  
 
-    ccp->os_epoch = os_cputime_get32();
+    ccp->os_sync = ccp->os_epoch = os_cputime_get32();
     STATS_INC(inst->ccp->stat, rx_complete);
 
     ccp->epoch_master = frame->transmission_timestamp;
     ccp->epoch = frame->reception_timestamp = inst->rxtimestamp;
-    ccp->period = frame->transmission_interval;
+    ccp->period = ccp->master_period = frame->transmission_interval;
     frame->carrier_integrator = inst->carrier_integrator;
     ccp->status.valid |= ccp->idx > 1;
+    ccp->status.holdover = 0;
+    ccp->missed = 0;
 
     /* Compensate if not receiving the master ccp packet directly */
     int rx_slot = (frame->long_address & 0xff);
+    ccp->hops = 0;
+    ccp->relay_delay = 0;
+    ccp->tof = inst->ccp->config.tof_compensation;
     if (rx_slot != 0x00) {
         STATS_INC(inst->ccp->stat, rx_relayed);
-        /* Assume ccp intervals are a multiple of 0x10000 us */
-        uint32_t master_interval = ((frame->transmission_interval/0x10000+1)*0x10000);
-        ccp->epoch_master -= (master_interval - frame->transmission_interval) << 16;
-        ccp->epoch -= (master_interval - frame->transmission_interval) << 16;
-        ccp->os_epoch -= os_cputime_usecs_to_ticks(master_interval - frame->transmission_interval);
-    }
-
-    /* Cascade relay of ccp packet */
-    if (ccp->config.role == CCP_ROLE_RELAY && ccp->status.valid &&
-        rx_slot < (inst->slot_id-1) && inst->slot_id != 0xffff) {
-        ccp_frame_t tx_frame;
-        memcpy(tx_frame.array, frame->array, sizeof(ccp_frame_t));
-        uint64_t tx_timestamp = frame->reception_timestamp + (((uint64_t)usecs_to_response(inst, rx_slot, inst->slot_id-1))<<16);
-        tx_timestamp &= 0x0FFFFFFFFFFUL;
-        dw1000_set_delay_start(inst, tx_timestamp);
-
-        /* Need to add antenna delay and tof compensation */
-        tx_timestamp += inst->tx_antenna_delay + inst->ccp->config.tof_compensation;
-
-#if MYNEWT_VAL(WCS_ENABLED)
-        tx_frame.transmission_timestamp = wcs_local_to_master(inst, tx_timestamp);
+#if MYNEWT_VAL(CCP_NUM_RELAYING_ANCHORS) != 0
+        ccp->tof = (rx_slot <= MYNEWT_VAL(CCP_NUM_RELAYING_ANCHORS)) ? ccp->relay_tof[rx_slot - 1] : 0;
 #else
-        tx_frame.transmission_timestamp = frame->transmission_timestamp + tx_timestamp - frame->reception_timestamp;
+        ccp->tof = 0;
 #endif
-
-        tx_frame.long_address = inst->ccp->uuid | (inst->slot_id-1);
-        tx_frame.transmission_interval = frame->transmission_interval - ((tx_frame.transmission_timestamp - frame->transmission_timestamp)>>16);
-
-        dw1000_write_tx(inst, tx_frame.array, 0, sizeof(ccp_blink_frame_t));
-        dw1000_write_tx_fctrl(inst, sizeof(ccp_blink_frame_t), 0, true); 
-        ccp->status.start_tx_error = dw1000_start_tx(inst).start_tx_error;
-        if (ccp->status.start_tx_error){
-            STATS_INC(inst->ccp->stat, tx_relay_error);
+        if (inst->frame_len >= sizeof(ccp_relay_frame_t)) {
+            /* The relay delay is carried in master time, the epochs move back to the clock master transmission */
+            ccp_relay_frame_t * relay = (ccp_relay_frame_t *) inst->rxbuf;
+            ccp->hops = relay->hops;
+            ccp->relay_delay = relay->relay_delay;
+            ccp->master_period = frame->transmission_interval + (relay->relay_delay >> 16);
+            ccp->epoch_master = (ccp->epoch_master - relay->relay_delay) & 0x0FFFFFFFFFFUL;
+            ccp->epoch = (ccp->epoch - ccp_local_interval(inst, relay->relay_delay)) & 0x0FFFFFFFFFFUL;
+            ccp->os_epoch -= os_cputime_usecs_to_ticks((uint32_t)dw1000_dwt_usecs_to_usecs(relay->relay_delay >> 16));
         } else {
-            STATS_INC(inst->ccp->stat, tx_relay_ok);
+            /* Legacy relay, assume ccp intervals are a multiple of 0x10000 us */
+            uint32_t master_interval = ((frame->transmission_interval/0x10000+1)*0x10000);
+            ccp->master_period = master_interval;
+            ccp->hops = 1;
+            ccp->relay_delay = (master_interval - frame->transmission_interval) << 16;
+            ccp->epoch_master -= (master_interval - frame->transmission_interval) << 16;
+            ccp->epoch -= (master_interval - frame->transmission_interval) << 16;
+            ccp->os_epoch -= os_cputime_usecs_to_ticks(master_interval - frame->transmission_interval);
         }
+        ccp->period = frame->transmission_interval = ccp->master_period;
     }
 
+    /* Cascade relay of ccp packet */
+    if (ccp->config.role == CCP_ROLE_RELAY && ccp->status.valid &&
+        rx_slot < (inst->slot_id-1) && inst->slot_id != 0xffff) 
+        ccp_relay(inst);
+
     if (ccp->config.postprocess && ccp->status.valid) 
         os_eventq_put(os_eventq_dflt_get(), &ccp->callout_postprocess.c_ev);
     
@@ -649,6 +1048,16 @@ rx_complete_cb(struct _dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cb
 static bool 
 ccp_tx_complete_cb(struct _dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs){
 
+#if MYNEWT_VAL(CCP_MAX_MASTERS) > 1
+    if (inst->fctrl_array[0] == FCNTL_IEEE_BLINK_ANC_64 && inst->ccp->status.standby
+            && inst->ccp->config.role == CCP_ROLE_BACKUP){
+        inst->ccp->status.standby = 0;
+        STATS_INC(inst->ccp->stat, standby_tx);
+        os_error_t err = os_sem_release(&inst->ccp->sem);
+        assert(err == OS_OK);
+        return true;
+    }
+#endif
     if (inst->fctrl_array[0] != FCNTL_IEEE_BLINK_CCP_64)
         return false;
 
@@ -659,8 +1068,13 @@ ccp_tx_complete_cb(struct _dw1000_dev_instance_t * inst, dw1000_mac_interface_t
     dw1000_ccp_instance_t * ccp = inst->ccp; 
     ccp_frame_t * frame = ccp->frames[(++ccp->idx)%ccp->nframes];
     
-    ccp->os_epoch = os_cputime_get32();
+    ccp->os_sync = ccp->os_epoch = os_cputime_get32();
     ccp->epoch = frame->transmission_timestamp = dw1000_read_txrawst(inst); 
+#if MYNEWT_VAL(WCS_ENABLED)
+    if (ccp->status.elected)
+        ccp->epoch_master = wcs_local_to_master(inst, frame->transmission_timestamp + ccp->tof);
+    else
+#endif
     ccp->epoch_master = frame->transmission_timestamp;
     ccp->period = frame->transmission_interval;
 
@@ -694,7 +1108,7 @@ ccp_rx_error_cb(struct _dw1000_dev_instance_t * inst, dw1000_mac_interface_t * c
     dw1000_ccp_instance_t * ccp = inst->ccp; 
     STATS_INC(inst->ccp->stat, rx_error);
 
-    if (ccp->config.role == CCP_ROLE_MASTER) 
+    if (ccp->config.role == CCP_ROLE_MASTER && !ccp->status.standby) 
         return false;
 
     // Release semaphore if rxauto enable is not set. 
@@ -743,7 +1157,7 @@ static bool
 ccp_rx_timeout_cb(struct _dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs){
 
     dw1000_ccp_instance_t * ccp = inst->ccp; 
-    if (ccp->config.role == CCP_ROLE_MASTER) 
+    if (ccp->config.role == CCP_ROLE_MASTER && !ccp->status.standby) 
         return false;
 
     if (os_sem_get_count(&ccp->sem) == 0){
@@ -801,8 +1215,12 @@ dw1000_ccp_send(struct _dw1000_dev_instance_t * inst, dw1000_dev_modes_t mode)
     ccp_frame_t * previous_frame = ccp->frames[(uint16_t)(ccp->idx)%ccp->nframes];
     ccp_frame_t * frame = ccp->frames[(ccp->idx+1)%ccp->nframes];
     
+    uint64_t interval = (uint64_t)inst->ccp->period << 16;
+    if (ccp->status.elected)
+        interval = ccp_local_interval(inst, interval);
+
     frame->transmission_timestamp = (previous_frame->transmission_timestamp
-                                    + ((uint64_t)inst->ccp->period << 16)
+                                    + interval
                                     ) & 0x0FFFFFFFFFFUL;
     dw1000_set_delay_start(inst, frame->transmission_timestamp);
     frame->transmission_timestamp += inst->tx_antenna_delay;
@@ -811,13 +1229,21 @@ dw1000_ccp_send(struct _dw1000_dev_instance_t * inst, dw1000_dev_modes_t mode)
     frame->long_address = inst->ccp->uuid;
     frame->transmission_interval = inst->ccp->period;
 
+#if MYNEWT_VAL(WCS_ENABLED)
+    if (ccp->status.elected){
+        ccp_frame_t tx_frame;
+        memcpy(tx_frame.array, frame->array, sizeof(ccp_blink_frame_t));
+        tx_frame.transmission_timestamp = wcs_local_to_master(inst, frame->transmission_timestamp + ccp->tof);
+        dw1000_write_tx(inst, tx_frame.array, 0, sizeof(ccp_blink_frame_t));
+    }else
+#endif
     dw1000_write_tx(inst, frame->array, 0, sizeof(ccp_blink_frame_t));
     dw1000_write_tx_fctrl(inst, sizeof(ccp_blink_frame_t), 0, true); 
     dw1000_set_wait4resp(inst, false);    
     ccp->status.start_tx_error = dw1000_start_tx(inst).start_tx_error;
     if (ccp->status.start_tx_error ){
         STATS_INC(inst->ccp->stat, tx_start_error);
-        previous_frame->transmission_timestamp = (frame->transmission_timestamp + ((uint64_t)inst->ccp->period << 16)) & 0x0FFFFFFFFFFUL;
+        previous_frame->transmission_timestamp = (frame->transmission_timestamp + interval) & 0x0FFFFFFFFFFUL;
         ccp->idx++;
         err =  os_sem_release(&ccp->sem);
         assert(err == OS_OK); 
@@ -856,10 +1282,8 @@ dw1000_ccp_listen(struct _dw1000_dev_instance_t * inst, dw1000_dev_modes_t mode)
 
     STATS_INC(inst->ccp->stat,listen);
 
-    ccp->status = (dw1000_ccp_status_t){
-        .rx_timeout_error = 0,
-        .start_rx_error = 0
-    };
+    ccp->status.rx_timeout_error = 0;
+    ccp->status.start_rx_error = 0;
     ccp->status.start_rx_error = dw1000_start_rx(inst).start_rx_error;
     if (ccp->status.start_rx_error){
         err = os_sem_release(&ccp->sem);
@@ -889,6 +1313,10 @@ dw1000_ccp_start(struct _dw1000_dev_instance_t * inst, dw1000_ccp_role_t role){
     dw1000_ccp_instance_t * ccp = inst->ccp; 
     ccp->idx = 0x0;  
     ccp->status.valid = false;
+    ccp->status.holdover = false;
+    ccp->status.elected = false;
+    ccp->missed = 0;
+    ccp->os_sync = os_cputime_get32();
     ccp_frame_t * frame = ccp->frames[(ccp->idx)%ccp->nframes]; 
     ccp->config.role = role;
 
@@ -24,8 +24,52 @@
 #include <stdio.h>
 #include <cir/cir_encode.h>
 #include <cir/cir.h>
+#if MYNEWT_VAL(TELEMETRY_ENABLED)
+#include <telemetry/telemetry.h>
+#endif
+
+#if MYNEWT_VAL(TELEMETRY_ENABLED)
+/**
+ * Binary encoding of an array of complex samples. The samples are passed by reference and copied straight
+ * into the telemetry ring.
+ *
+ * @param type      TELEMETRY_CIR or TELEMETRY_PMEM.
+ * @param cir       Pointer to cir_instance_t.
+ * @param name      Source name.
+ * @param samples   Sample array.
+ * @param nsize     Number of samples.
+ *
+ * @return void
+ */
+static void
+complex_encode(telemetry_type_t type, cir_instance_t * cir, char * name, struct _cir_complex_t * samples, uint16_t nsize){
+
+    telemetry_cir_t hdr = {
+        .utime = os_cputime_ticks_to_usecs(os_cputime_get32()),
+        .fp_idx = cir->fp_idx,
+        .fp_power = cir->fp_power,
+        .nsize = nsize
+    };
+    strncpy(hdr.name, name, sizeof(hdr.name));
+
+    telemetry_iov_t iov[] = {
+        {.base = &hdr, .len = sizeof(hdr)},
+        {.base = samples, .len = nsize * sizeof(struct _cir_complex_t)}
+    };
+    telemetry_writev(type, iov, sizeof(iov)/sizeof(iov[0]));
+}
+
+void 
+cir_encode(cir_instance_t * cir, char * name, uint16_t nsize){
+    complex_encode(TELEMETRY_CIR, cir, name, cir->cir.array, nsize);
+}
+
+void 
+pmem_encode(cir_instance_t * cir, char * name, uint16_t nsize){
+    complex_encode(TELEMETRY_PMEM, cir, name, cir->pmem.array, nsize);
+}
 
-#if MYNEWT_VAL(CIR_VERBOSE)
+#elif MYNEWT_VAL(CIR_VERBOSE)
 
 #define JSON_BUF_SIZE (1024)
 static char _buf[JSON_BUF_SIZE];
@@ -0,0 +1,61 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file keytab.h
+ * @author paul kettle
+ * @date 2018
+ * @brief Open addressing hash index
+ *
+ * @details Maps keys to indices into an array of entries owned by the caller, which also stores the keys; the table
+ * reads the key of an entry back through a callback. The table is kept at least twice the number of entries, so
+ * linear probing always finds an unused slot, and removal uses backward shift deletion rather than tombstones.
+ */
+
+#ifndef _KEYTAB_H_
+#define _KEYTAB_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define KEYTAB_NONE 0xFFFF          //!< Unused slot, or key not found
+
+//! Returns the key of the entry at index idx
+typedef uint32_t (* keytab_key_t)(const void * arg, uint16_t idx);
+
+typedef struct _keytab_t{
+    uint16_t mask;                  //!< Number of slots - 1
+    uint16_t * slots;               //!< Indices into the entries, KEYTAB_NONE if unused
+    keytab_key_t key;               //!< Key of an entry
+    const void * arg;               //!< Argument of key
+}keytab_t;
+
+uint16_t keytab_nslots(uint16_t cap);
+void keytab_init(keytab_t * tab, uint16_t * slots, uint16_t nslots, keytab_key_t key, const void * arg);
+void keytab_clear(keytab_t * tab);
+uint16_t keytab_find_slot(const keytab_t * tab, uint32_t key);
+uint16_t keytab_lookup(const keytab_t * tab, uint32_t key);
+void keytab_delete_slot(keytab_t * tab, uint16_t slot);
+uint16_t keytab_remove(keytab_t * tab, uint32_t key);
+void keytab_move(keytab_t * tab, uint16_t from, uint16_t to);
+
+#endif
@@ -0,0 +1,56 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file mat.h
+ * @author paul kettle
+ * @date 2018
+ * @brief Small matrix kernels
+ *
+ * @details Row-major float kernels for the normal equations of small least squares problems, n no greater than
+ * MAT_N_MAX. They work in place on caller storage without allocation, and depend only on libc so they also build
+ * on the host.
+ */
+
+#ifndef _MAT_H_
+#define _MAT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MAT_N_MAX 4                 //!< Largest dimension supported
+#define MAT_CHOL_TOL (1e-6f)        //!< Pivot below this fraction of its diagonal element is taken as singular
+
+void mat_zero(float * A, uint16_t n);
+void mat_rank1(float * A, const float * v, float w, uint16_t n);
+bool mat_chol(float * A, uint16_t n);
+void mat_chol_solve(const float * L, float * b, uint16_t n);
+void mat_chol_inv(const float * L, float * Ainv, uint16_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MAT_H_ */
@@ -0,0 +1,92 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file rngfilt.h
+ * @author paul kettle
+ * @date 2018
+ * @brief Per-peer range filter bank
+ *
+ * @details Each peer runs a short median pre-filter followed by a range/range-rate Kalman filter. Measurements whose
+ * innovation falls outside the gate are rejected; a run of rejections restarts the track so a real step in range is
+ * eventually followed. Peers are kept in a fixed table keyed by short address; when the table is full the least
+ * recently updated peer is evicted.
+ */
+
+#ifndef _RNGFILT_H_
+#define _RNGFILT_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <dsp/keytab.h>
+
+#define RNGFILT_MEDIAN_N 5          //!< Median window length
+
+typedef struct _rngfilt_status_t{
+    uint16_t selfmalloc:1;
+    uint16_t initialized:1;
+}rngfilt_status_t;
+
+typedef struct _rngfilt_config_t{
+    float range_variance;           //!< Measurement variance, m^2
+    float accel_variance;           //!< Process noise, acceleration spectral density, m^2/s^3
+    float rate_variance;            //!< Initial range-rate variance, (m/s)^2
+    float gate;                     //!< Innovation gate, standard deviations
+    uint16_t max_rejects;           //!< Consecutive rejections that restart the track
+    uint32_t timeout;               //!< Silence after which the track is restarted, usec
+}rngfilt_config_t;
+
+typedef struct _rngfilt_peer_t{
+    uint16_t addr;                  //!< Short address of the peer
+    uint8_t nwindow;                //!< Samples in the median window
+    uint8_t widx;                   //!< Next window position
+    uint16_t rejects;               //!< Consecutive rejected measurements
+    uint32_t utime;                 //!< Time of the last update, usec
+    float window[RNGFILT_MEDIAN_N]; //!< Median window
+    float x[2];                     //!< State, range (m) and range-rate (m/s)
+    float P[3];                     //!< Covariance, P00 P01 P11
+}rngfilt_peer_t;
+
+typedef struct _rngfilt_result_t{
+    float range;                    //!< Filtered range, m
+    float rate;                     //!< Filtered range-rate, m/s
+    float variance;                 //!< Range variance, m^2
+    bool rejected;                  //!< Measurement failed the innovation gate
+}rngfilt_result_t;
+
+typedef struct _rngfilt_instance_t{
+    rngfilt_status_t status;
+    rngfilt_config_t config;
+    uint16_t npeers;                //!< Peers in use
+    uint16_t cap;                   //!< Maximum number of peers
+    keytab_t tab;                   //!< Hash table of indices into peers[]
+    rngfilt_peer_t peers[];         //!< Peer states, followed by the hash table
+}rngfilt_instance_t;
+
+rngfilt_instance_t * rngfilt_init(rngfilt_instance_t * inst, uint16_t cap, const rngfilt_config_t * config);
+void rngfilt_free(rngfilt_instance_t * inst);
+rngfilt_peer_t * rngfilt_lookup(rngfilt_instance_t * inst, uint16_t addr);
+bool rngfilt_update(rngfilt_instance_t * inst, uint16_t addr, uint32_t utime, float range, rngfilt_result_t * result);
+void rngfilt_remove(rngfilt_instance_t * inst, uint16_t addr);
+
+#endif
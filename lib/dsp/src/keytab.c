@@ -0,0 +1,168 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include <dsp/keytab.h>
+
+/**
+ * Fibonacci hashing: the top half of the product mixes every bit of the key, where the low bits of a 16 bit product
+ * only depend on the low bits of the key.
+ */
+static inline uint16_t
+keytab_hash(const keytab_t * tab, uint32_t key){
+    return (uint16_t)((key * 2654435761u) >> 16) & tab->mask;
+}
+
+/**
+ * Help function to size the table for a number of entries.
+ *
+ * @param cap  Maximum number of entries.
+ *
+ * @return Number of slots, a power of two at least 2 * cap
+ */
+uint16_t
+keytab_nslots(uint16_t cap){
+    uint16_t nslots = 1;
+    while (nslots < 2 * cap)
+        nslots <<= 1;
+    return nslots;
+}
+
+/**
+ * API to initialise an empty table.
+ *
+ * @param tab     Pointer to keytab_t.
+ * @param slots   Slot storage, nslots long.
+ * @param nslots  Number of slots, from keytab_nslots().
+ * @param key     Key of an entry.
+ * @param arg     Argument of key, usually the owner of the entries.
+ *
+ * @return void
+ */
+void
+keytab_init(keytab_t * tab, uint16_t * slots, uint16_t nslots, keytab_key_t key, const void * arg){
+    tab->mask = nslots - 1;
+    tab->slots = slots;
+    tab->key = key;
+    tab->arg = arg;
+    keytab_clear(tab);
+}
+
+/**
+ * API to remove every entry.
+ *
+ * @param tab  Pointer to keytab_t.
+ *
+ * @return void
+ */
+void
+keytab_clear(keytab_t * tab){
+    memset(tab->slots, 0xFF, (tab->mask + 1) * sizeof(uint16_t));
+}
+
+/**
+ * API to find the slot of a key. The slot holds the index of the entry, or KEYTAB_NONE if the key is absent, in which
+ * case the index of a new entry with that key is to be stored there.
+ *
+ * @param tab  Pointer to keytab_t.
+ * @param key  Key.
+ *
+ * @return Slot
+ */
+uint16_t
+keytab_find_slot(const keytab_t * tab, uint32_t key){
+    uint16_t i = keytab_hash(tab, key);
+    while (tab->slots[i] != KEYTAB_NONE && tab->key(tab->arg, tab->slots[i]) != key)
+        i = (i + 1) & tab->mask;
+    return i;
+}
+
+/**
+ * API to look up a key.
+ *
+ * @param tab  Pointer to keytab_t.
+ * @param key  Key.
+ *
+ * @return Index of the entry, KEYTAB_NONE if the key is absent
+ */
+uint16_t
+keytab_lookup(const keytab_t * tab, uint32_t key){
+    return tab->slots[keytab_find_slot(tab, key)];
+}
+
+/**
+ * API to empty a slot, moving back the entries probed past it.
+ *
+ * @param tab   Pointer to keytab_t.
+ * @param slot  Slot, from keytab_find_slot().
+ *
+ * @return void
+ */
+void
+keytab_delete_slot(keytab_t * tab, uint16_t slot){
+    uint16_t i = slot, j = slot;
+    while (1){
+        j = (j + 1) & tab->mask;
+        uint16_t k = tab->slots[j];
+        if (k == KEYTAB_NONE)
+            break;
+        uint16_t h = keytab_hash(tab, tab->key(tab->arg, k));
+        // Move k back unless its home slot lies cyclically in (i, j]
+        bool keep = (i <= j) ? (i < h && h <= j) : (i < h || h <= j);
+        if (!keep){
+            tab->slots[i] = k;
+            i = j;
+        }
+    }
+    tab->slots[i] = KEYTAB_NONE;
+}
+
+/**
+ * API to remove a key.
+ *
+ * @param tab  Pointer to keytab_t.
+ * @param key  Key.
+ *
+ * @return Index of the entry removed, KEYTAB_NONE if the key is absent
+ */
+uint16_t
+keytab_remove(keytab_t * tab, uint32_t key){
+    uint16_t i = keytab_find_slot(tab, key);
+    uint16_t k = tab->slots[i];
+    if (k != KEYTAB_NONE)
+        keytab_delete_slot(tab, i);
+    return k;
+}
+
+/**
+ * API to point the key of an entry at another index, for callers that keep their entries dense. Call before moving
+ * the entry itself, while its key still reads back from index from.
+ *
+ * @param tab   Pointer to keytab_t.
+ * @param from  Current index of the entry.
+ * @param to    New index of the entry.
+ *
+ * @return void
+ */
+void
+keytab_move(keytab_t * tab, uint16_t from, uint16_t to){
+    tab->slots[keytab_find_slot(tab, tab->key(tab->arg, from))] = to;
+}
@@ -0,0 +1,139 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file mat.c
+ * @author paul kettle
+ * @date 2018
+ * @brief Small matrix kernels
+ *
+ * @details Cholesky factorisation works on the lower triangle in place; the upper triangle is left untouched.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+#include <dsp/mat.h>
+
+/**
+ * Clears an n x n matrix.
+ *
+ * @param A  Matrix.
+ * @param n  Dimension.
+ * @return void
+ */
+void
+mat_zero(float * A, uint16_t n){
+    assert(n <= MAT_N_MAX);
+    memset(A, 0, n * n * sizeof(float));
+}
+
+/**
+ * Accumulates a weighted outer product, A += w v v'. Used to build J'WJ one row of J at a time.
+ *
+ * @param A  Symmetric n x n matrix.
+ * @param v  Vector of n.
+ * @param w  Weight.
+ * @param n  Dimension.
+ * @return void
+ */
+void
+mat_rank1(float * A, const float * v, float w, uint16_t n){
+    for (uint16_t i = 0; i < n; i++){
+        float wv = w * v[i];
+        for (uint16_t j = 0; j <= i; j++){
+            A[i * n + j] += wv * v[j];
+            A[j * n + i] = A[i * n + j];
+        }
+    }
+}
+
+/**
+ * In-place Cholesky factorisation A = L L' of a symmetric positive definite matrix, L returned in the lower triangle.
+ *
+ * @param A  Symmetric n x n matrix.
+ * @param n  Dimension.
+ * @return false if A is singular or not positive definite
+ */
+bool
+mat_chol(float * A, uint16_t n){
+    assert(n <= MAT_N_MAX);
+    for (uint16_t j = 0; j < n; j++){
+        float d = A[j * n + j];
+        for (uint16_t k = 0; k < j; k++)
+            d -= A[j * n + k] * A[j * n + k];
+        if (!(d > MAT_CHOL_TOL * A[j * n + j]) || !(d > 0))
+            return false;
+        d = sqrtf(d);
+        A[j * n + j] = d;
+        for (uint16_t i = j + 1; i < n; i++){
+            float s = A[i * n + j];
+            for (uint16_t k = 0; k < j; k++)
+                s -= A[i * n + k] * A[j * n + k];
+            A[i * n + j] = s / d;
+        }
+    }
+    return true;
+}
+
+/**
+ * Solves L L' x = b with the factor from mat_chol, x returned in b.
+ *
+ * @param L  Factor in the lower triangle.
+ * @param b  Right hand side of n.
+ * @param n  Dimension.
+ * @return void
+ */
+void
+mat_chol_solve(const float * L, float * b, uint16_t n){
+    for (uint16_t i = 0; i < n; i++){
+        float s = b[i];
+        for (uint16_t k = 0; k < i; k++)
+            s -= L[i * n + k] * b[k];
+        b[i] = s / L[i * n + i];
+    }
+    for (int16_t i = n - 1; i >= 0; i--){
+        float s = b[i];
+        for (uint16_t k = i + 1; k < n; k++)
+            s -= L[k * n + i] * b[k];
+        b[i] = s / L[i * n + i];
+    }
+}
+
+/**
+ * Inverse of L L' from the factor from mat_chol.
+ *
+ * @param L     Factor in the lower triangle.
+ * @param Ainv  Inverse, n x n, may not alias L.
+ * @param n     Dimension.
+ * @return void
+ */
+void
+mat_chol_inv(const float * L, float * Ainv, uint16_t n){
+    float e[MAT_N_MAX];
+    for (uint16_t j = 0; j < n; j++){
+        memset(e, 0, sizeof(e));
+        e[j] = 1.0f;
+        mat_chol_solve(L, e, n);
+        for (uint16_t i = 0; i < n; i++)
+            Ainv[i * n + j] = e[i];
+    }
+}
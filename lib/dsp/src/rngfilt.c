@@ -0,0 +1,196 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <dsp/rngfilt.h>
+
+static uint32_t
+rngfilt_key(const void * arg, uint16_t idx){
+    return ((const rngfilt_instance_t *) arg)->peers[idx].addr;
+}
+
+rngfilt_instance_t * rngfilt_init(rngfilt_instance_t * inst, uint16_t cap, const rngfilt_config_t * config) {
+
+    uint16_t nslots = keytab_nslots(cap);
+
+    if (inst == NULL){
+        size_t size = sizeof(rngfilt_instance_t) + cap * sizeof(rngfilt_peer_t) + nslots * sizeof(uint16_t);
+        inst = (rngfilt_instance_t *) malloc(size);
+        assert(inst);
+        memset(inst, 0, size);
+        inst->status.selfmalloc = 1;
+    }else{
+        assert(inst->cap == cap);
+    }
+    inst->cap = cap;
+    inst->npeers = 0;
+    keytab_init(&inst->tab, (uint16_t *) &inst->peers[cap], nslots, rngfilt_key, inst);
+    inst->config = *config;
+    inst->status.initialized = 1;
+    return inst;
+}
+
+void rngfilt_free(rngfilt_instance_t * inst){
+    assert(inst);
+    if (inst->status.selfmalloc)
+        free(inst);
+    else
+        inst->status.initialized = 0;
+}
+
+rngfilt_peer_t * rngfilt_lookup(rngfilt_instance_t * inst, uint16_t addr){
+    uint16_t k = keytab_lookup(&inst->tab, addr);
+    return (k == KEYTAB_NONE) ? NULL : &inst->peers[k];
+}
+
+void rngfilt_remove(rngfilt_instance_t * inst, uint16_t addr){
+    uint16_t k = keytab_remove(&inst->tab, addr);
+    if (k == KEYTAB_NONE)
+        return;
+
+    // Keep peers[] dense by moving the last peer into the hole
+    uint16_t last = --inst->npeers;
+    if (k != last){
+        keytab_move(&inst->tab, last, k);
+        inst->peers[k] = inst->peers[last];
+    }
+}
+
+/**
+ * Returns the peer for addr, creating it and evicting the least recently updated peer if the table is full.
+ */
+static rngfilt_peer_t *
+rngfilt_get(rngfilt_instance_t * inst, uint16_t addr, uint32_t utime){
+    uint16_t i = keytab_find_slot(&inst->tab, addr);
+    if (inst->tab.slots[i] != KEYTAB_NONE)
+        return &inst->peers[inst->tab.slots[i]];
+
+    if (inst->npeers == inst->cap){
+        uint16_t oldest = 0;
+        for (uint16_t k = 1; k < inst->npeers; k++)
+            if ((int32_t)(inst->peers[k].utime - inst->peers[oldest].utime) < 0)
+                oldest = k;
+        rngfilt_remove(inst, inst->peers[oldest].addr);
+        i = keytab_find_slot(&inst->tab, addr);
+    }
+    uint16_t k = inst->npeers++;
+    inst->tab.slots[i] = k;
+    memset(&inst->peers[k], 0, sizeof(rngfilt_peer_t));
+    inst->peers[k].addr = addr;
+    inst->peers[k].utime = utime;
+    return &inst->peers[k];
+}
+
+static float
+rngfilt_median(rngfilt_peer_t * peer, float range){
+    float sorted[RNGFILT_MEDIAN_N];
+
+    peer->window[peer->widx] = range;
+    peer->widx = (peer->widx + 1) % RNGFILT_MEDIAN_N;
+    if (peer->nwindow < RNGFILT_MEDIAN_N)
+        peer->nwindow++;
+
+    for (uint8_t i = 0; i < peer->nwindow; i++){
+        float v = peer->window[i];
+        int8_t j = i - 1;
+        while (j >= 0 && sorted[j] > v){
+            sorted[j + 1] = sorted[j];
+            j--;
+        }
+        sorted[j + 1] = v;
+    }
+    uint8_t mid = peer->nwindow / 2;
+    return (peer->nwindow & 1) ? sorted[mid] : 0.5f * (sorted[mid - 1] + sorted[mid]);
+}
+
+static void
+rngfilt_restart(rngfilt_instance_t * inst, rngfilt_peer_t * peer, float range){
+    peer->nwindow = 0;
+    peer->widx = 0;
+    peer->rejects = 0;
+    rngfilt_median(peer, range);
+    peer->x[0] = range;
+    peer->x[1] = 0;
+    peer->P[0] = inst->config.range_variance;
+    peer->P[1] = 0;
+    peer->P[2] = inst->config.rate_variance;
+}
+
+/**
+ * Runs one measurement through the filter of a peer.
+ *
+ * @param inst    Pointer to rngfilt_instance_t.
+ * @param addr    Short address of the peer.
+ * @param utime   Measurement time, usec.
+ * @param range   Measured range, m.
+ * @param result  Filter output, may be NULL.
+ *
+ * @return true if the measurement was accepted
+ */
+bool rngfilt_update(rngfilt_instance_t * inst, uint16_t addr, uint32_t utime, float range, rngfilt_result_t * result){
+
+    rngfilt_peer_t * peer = rngfilt_get(inst, addr, utime);
+    bool accepted = true;
+    uint32_t elapsed = utime - peer->utime;
+
+    if (peer->nwindow == 0 || elapsed > inst->config.timeout){
+        rngfilt_restart(inst, peer, range);
+    }else{
+        float dt = elapsed * 1e-6f;
+        float q = inst->config.accel_variance;
+        float * x = peer->x;
+        float * P = peer->P;
+
+        // Predict, constant velocity model
+        x[0] += dt * x[1];
+        P[0] += dt * (2 * P[1] + dt * P[2]) + q * dt * dt * dt / 3;
+        P[1] += dt * P[2] + q * dt * dt / 2;
+        P[2] += q * dt;
+
+        float z = rngfilt_median(peer, range);
+        float y = z - x[0];
+        float S = P[0] + inst->config.range_variance;
+
+        if (y * y > inst->config.gate * inst->config.gate * S){
+            accepted = false;
+            if (++peer->rejects >= inst->config.max_rejects)
+                rngfilt_restart(inst, peer, range);
+        }else{
+            float K0 = P[0] / S;
+            float K1 = P[1] / S;
+            x[0] += K0 * y;
+            x[1] += K1 * y;
+            P[2] -= K1 * P[1];
+            P[1] -= K0 * P[1];
+            P[0] -= K0 * P[0];
+            peer->rejects = 0;
+        }
+    }
+    peer->utime = utime;
+
+    if (result){
+        result->range = peer->x[0];
+        result->rate = peer->x[1];
+        result->variance = peer->P[0];
+        result->rejected = !accepted;
+    }
+    return accepted;
+}
@@ -0,0 +1,88 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file mlat.h
+ * @author paul kettle
+ * @date 2018
+ * @brief Multilateration position engine
+ *
+ * @details Collects ranges to anchors from the results of an nrng request or from rng records, and solves for the
+ * position of this node with mlat_solve. Anchors are looked up by short address in a table set with mlat_set_anchor;
+ * extended DS frames carry the anchor position and range variance and need no table entry. Each fix starts from the
+ * previous solution, falling back to the closed-form fix when that fails to converge.
+ */
+
+#ifndef _MLAT_H_
+#define _MLAT_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <dw1000/dw1000_dev.h>
+#include <rng/rng_stream.h>
+#include <mlat/mlat_solve.h>
+
+//! Anchor table entry
+typedef struct _mlat_anchor_t{
+    uint16_t addr;                      //!< Short address of the anchor
+    triad_t pos;                        //!< Anchor position, m
+}mlat_anchor_t;
+
+//! Engine status parameters
+typedef struct _mlat_status_t{
+    uint16_t selfmalloc:1;              //!< Internal flag for memory garbage collection
+    uint16_t initialized:1;             //!< Instance allocated
+    uint16_t valid:1;                   //!< Last update produced a solution
+}mlat_status_t;
+
+//! Multilateration engine
+typedef struct _mlat_instance_t{
+    mlat_status_t status;                           //!< Engine status
+    uint16_t dim;                                   //!< Dimension of the fix, 2 or 3
+    uint16_t nanchors;                              //!< Anchors in the table
+    uint16_t nranges;                               //!< Ranges collected for the next fix
+    float variance;                                 //!< Range variance of ranges without one, m^2
+    mlat_solution_t solution;                       //!< Last solution
+    mlat_anchor_t anchors[MYNEWT_VAL(MLAT_MAX_ANCHORS)];   //!< Anchor table
+    mlat_range_t ranges[MYNEWT_VAL(MLAT_MAX_ANCHORS)];     //!< Ranges collected for the next fix
+}mlat_instance_t;
+
+mlat_instance_t * mlat_init(mlat_instance_t * mlat, uint16_t dim);
+void mlat_free(mlat_instance_t * mlat);
+bool mlat_set_anchor(mlat_instance_t * mlat, uint16_t addr, float x, float y, float z);
+const mlat_anchor_t * mlat_anchor(mlat_instance_t * mlat, uint16_t addr);
+void mlat_clear_ranges(mlat_instance_t * mlat);
+bool mlat_add_range(mlat_instance_t * mlat, const triad_t * anchor, float range, float variance);
+uint16_t mlat_add_nrng(mlat_instance_t * mlat, dw1000_dev_instance_t * inst);
+bool mlat_add_record(mlat_instance_t * mlat, const rng_record_t * record);
+const mlat_solution_t * mlat_update(mlat_instance_t * mlat);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MLAT_H_ */
@@ -0,0 +1,81 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file mlat_solve.h
+ * @author paul kettle
+ * @date 2018
+ * @brief Multilateration solver
+ *
+ * @details Position from ranges to anchors at known positions. Without an initial estimate, a closed-form linear
+ * least squares fix is taken from the differences of the squared range equations. It is then refined by weighted
+ * Gauss-Newton on the range residuals, with weights from the range variances. The covariance of the position is
+ * (J'WJ)^-1 at the solution. When no variances are given the weights are unity and the covariance is scaled by the
+ * residual variance.
+ *
+ * In 2D the height of the tag is fixed at pos.z of the solution on input and the ranges stay slant ranges.
+ *
+ * In 3D with anchors in a common plane, the linear fix cannot resolve height. The tag is then placed below the
+ * plane, as for ceiling mounted anchors; pass an initial estimate on the other side otherwise.
+ *
+ * A 2D fix needs three ranges and a 3D fix four, or one fewer from an initial estimate. The solver only depends on
+ * libc and lib/dsp, and builds on the host.
+ */
+
+#ifndef _MLAT_SOLVE_H_
+#define _MLAT_SOLVE_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <dw1000/triad.h>
+
+#define MLAT_ITER_MAX 10                //!< Gauss-Newton iterations
+#define MLAT_TOL (1e-4f)                //!< Convergence threshold on the position step, m
+
+//! Range to one anchor
+typedef struct _mlat_range_t{
+    triad_t anchor;                     //!< Anchor position, m
+    float range;                        //!< Measured range, m
+    float variance;                     //!< Range variance, m^2, 0 if unknown
+}mlat_range_t;
+
+//! Position solution
+typedef struct _mlat_solution_t{
+    triad_t pos;                        //!< Position, m; on input the initial estimate, and the height in 2D
+    float cov[3][3];                    //!< Covariance of pos, m^2; zero for z in 2D
+    float rms;                          //!< Weighted rms range residual, m
+    uint16_t nranges;                   //!< Ranges used
+    uint16_t iterations;                //!< Gauss-Newton iterations run
+}mlat_solution_t;
+
+bool mlat_solve(const mlat_range_t * ranges, uint16_t n, uint16_t dim, bool initial, mlat_solution_t * sol);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MLAT_SOLVE_H_ */
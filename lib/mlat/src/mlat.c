@@ -0,0 +1,243 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file mlat.c
+ * @author paul kettle
+ * @date 2018
+ * @brief Multilateration position engine
+ *
+ * @details Range collection for mlat_solve, see mlat.h.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include <os/os.h>
+
+#include <dw1000/dw1000_dev.h>
+#include <tof/tof.h>
+#include <mlat/mlat.h>
+#if MYNEWT_VAL(NRNG_ENABLED)
+#include <nranges/nranges.h>
+#endif
+
+#if MYNEWT_VAL(MLAT_ENABLED)
+
+/**
+ * API to initialise a multilateration engine.
+ *
+ * @param mlat  Pointer to mlat_instance_t, allocated when NULL.
+ * @param dim   Dimension of the fix, 2 or 3; in 2D the height is MLAT_HEIGHT.
+ *
+ * @return mlat_instance_t*
+ */
+mlat_instance_t *
+mlat_init(mlat_instance_t * mlat, uint16_t dim){
+
+    assert(dim == 2 || dim == 3);
+    if (mlat == NULL){
+        mlat = (mlat_instance_t *) malloc(sizeof(mlat_instance_t));
+        assert(mlat);
+        memset(mlat, 0, sizeof(mlat_instance_t));
+        mlat->status.selfmalloc = 1;
+    }
+    mlat->dim = dim;
+    mlat->nanchors = 0;
+    mlat->nranges = 0;
+    mlat->variance = MYNEWT_VAL(RANGE_VARIANCE);
+    memset(&mlat->solution, 0, sizeof(mlat_solution_t));
+    mlat->solution.pos.z = MYNEWT_VAL(MLAT_HEIGHT);
+    mlat->status.valid = 0;
+    mlat->status.initialized = 1;
+    return mlat;
+}
+
+/**
+ * API to free the allocated resources.
+ *
+ * @param mlat  Pointer to mlat_instance_t.
+ *
+ * @return void
+ */
+void
+mlat_free(mlat_instance_t * mlat){
+    assert(mlat);
+    if (mlat->status.selfmalloc)
+        free(mlat);
+    else
+        mlat->status.initialized = 0;
+}
+
+/**
+ * API to look up an anchor.
+ *
+ * @param mlat  Pointer to mlat_instance_t.
+ * @param addr  Short address of the anchor.
+ *
+ * @return const mlat_anchor_t*, NULL if the anchor is not in the table
+ */
+const mlat_anchor_t *
+mlat_anchor(mlat_instance_t * mlat, uint16_t addr){
+    for (uint16_t i = 0; i < mlat->nanchors; i++)
+        if (mlat->anchors[i].addr == addr)
+            return &mlat->anchors[i];
+    return NULL;
+}
+
+/**
+ * API to add or move an anchor.
+ *
+ * @param mlat  Pointer to mlat_instance_t.
+ * @param addr  Short address of the anchor.
+ * @param x     Position, m.
+ * @param y     Position, m.
+ * @param z     Position, m.
+ *
+ * @return true on success, false if the table is full
+ */
+bool
+mlat_set_anchor(mlat_instance_t * mlat, uint16_t addr, float x, float y, float z){
+
+    mlat_anchor_t * anchor = (mlat_anchor_t *) mlat_anchor(mlat, addr);
+    if (anchor == NULL){
+        if (mlat->nanchors == MYNEWT_VAL(MLAT_MAX_ANCHORS))
+            return false;
+        anchor = &mlat->anchors[mlat->nanchors++];
+        anchor->addr = addr;
+    }
+    anchor->pos.x = x;
+    anchor->pos.y = y;
+    anchor->pos.z = z;
+    return true;
+}
+
+/**
+ * API to drop the ranges collected for the next fix.
+ *
+ * @param mlat  Pointer to mlat_instance_t.
+ *
+ * @return void
+ */
+void
+mlat_clear_ranges(mlat_instance_t * mlat){
+    mlat->nranges = 0;
+}
+
+/**
+ * API to add a range for the next fix.
+ *
+ * @param mlat      Pointer to mlat_instance_t.
+ * @param anchor    Anchor position, m.
+ * @param range     Range, m.
+ * @param variance  Range variance, m^2; 0 for the default of the engine.
+ *
+ * @return true on success, false if the range is invalid or the fix is full
+ */
+bool
+mlat_add_range(mlat_instance_t * mlat, const triad_t * anchor, float range, float variance){
+
+    if (mlat->nranges == MYNEWT_VAL(MLAT_MAX_ANCHORS) || !isfinite(range) || range < 0)
+        return false;
+    mlat_range_t * r = &mlat->ranges[mlat->nranges++];
+    r->anchor = *anchor;
+    r->range = range;
+    r->variance = (variance > 0) ? variance : mlat->variance;
+    return true;
+}
+
+#if MYNEWT_VAL(NRNG_ENABLED)
+/**
+ * API to add the ranges of the last nrng request. Extended DS frames carrying a variance supply the anchor position;
+ * other responders are looked up in the anchor table and skipped if absent.
+ *
+ * @param mlat  Pointer to mlat_instance_t.
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ *
+ * @return Ranges added
+ */
+uint16_t
+mlat_add_nrng(mlat_instance_t * mlat, dw1000_dev_instance_t * inst){
+
+    assert(inst->nrng);
+    uint16_t nadded = 0;
+    for (uint16_t row = 0; row <= inst->nrng->nnodes; row++){
+        int32_t tof_ps;
+        nrng_frame_t * frame = dw1000_nrng_result(inst, row, &tof_ps);
+        if (frame == NULL)
+            continue;
+        float range = tof_ps_to_mm(tof_ps) * 1e-3f;
+#if MYNEWT_VAL(TWR_DS_EXT_NRNG_ENABLED)
+        if (frame->code == DWT_DS_TWR_NRNG_EXT_FINAL && frame->spherical_variance.range > 0){
+            nadded += mlat_add_range(mlat, &frame->cartesian, range, frame->spherical_variance.range);
+            continue;
+        }
+#endif
+        const mlat_anchor_t * anchor = mlat_anchor(mlat, frame->dst_address);
+        if (anchor)
+            nadded += mlat_add_range(mlat, &anchor->pos, range, 0);
+    }
+    return nadded;
+}
+#endif
+
+/**
+ * API to add a range from the result stream. The peer is looked up in the anchor table.
+ *
+ * @param mlat    Pointer to mlat_instance_t.
+ * @param record  Range record.
+ *
+ * @return true on success, false if the peer is not an anchor or the fix is full
+ */
+bool
+mlat_add_record(mlat_instance_t * mlat, const rng_record_t * record){
+
+    const mlat_anchor_t * anchor = mlat_anchor(mlat, record->peer);
+    if (anchor == NULL)
+        return false;
+    return mlat_add_range(mlat, &anchor->pos, record->range * 1e-3f, 0);
+}
+
+/**
+ * API to solve for the position from the ranges collected, and clear them. The fix starts from the last solution
+ * and falls back to the closed-form fix.
+ *
+ * @param mlat  Pointer to mlat_instance_t.
+ *
+ * @return const mlat_solution_t*, NULL if there is no solution
+ */
+const mlat_solution_t *
+mlat_update(mlat_instance_t * mlat){
+
+    mlat_solution_t sol = mlat->solution;
+    bool valid = (mlat->status.valid && mlat_solve(mlat->ranges, mlat->nranges, mlat->dim, true, &sol))
+              || mlat_solve(mlat->ranges, mlat->nranges, mlat->dim, false, &sol);
+
+    mlat->nranges = 0;
+    mlat->status.valid = valid;
+    if (!valid)
+        return NULL;
+    mlat->solution = sol;
+    return &mlat->solution;
+}
+
+#endif // MLAT_ENABLED
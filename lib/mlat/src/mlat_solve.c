@@ -0,0 +1,232 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file mlat_solve.c
+ * @author paul kettle
+ * @date 2018
+ * @brief Multilateration solver
+ *
+ * @details The normal equations are at most 3 x 3 and are built a range at a time with the lib/dsp matrix kernels,
+ * so a solve costs O(n) in single precision with no allocation.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+#include <dsp/mat.h>
+#include <mlat/mlat_solve.h>
+
+#define MLAT_PLANAR (1e-2f)     //!< Anchor height spread, as a power ratio to the horizontal, below which they are planar
+
+static inline bool
+valid(const mlat_range_t * r){
+    return isfinite(r->range) && r->range >= 0 && !(r->variance < 0);
+}
+
+static inline float
+weight(const mlat_range_t * r){
+    return (r->variance > 0) ? 1.0f / r->variance : 1.0f;
+}
+
+/**
+ * Closed-form fix from the squared range equations less their mean, 2 (a_i - a) p = |a_i|^2 - r_i^2 - mean,
+ * solved by linear least squares. In 2D pos->z is held fixed.
+ */
+static bool
+linear_fix(const mlat_range_t * ranges, uint16_t n, uint16_t dim, triad_t * pos){
+
+    float abar[3] = {0}, kbar = 0;
+    uint16_t m = 0;
+    for (uint16_t i = 0; i < n; i++){
+        const mlat_range_t * r = &ranges[i];
+        if (!valid(r))
+            continue;
+        for (uint16_t c = 0; c < 3; c++)
+            abar[c] += r->anchor.array[c];
+        kbar += r->anchor.x * r->anchor.x + r->anchor.y * r->anchor.y + r->anchor.z * r->anchor.z
+                - r->range * r->range;
+        m++;
+    }
+    if (m < dim + 1)
+        return false;
+    for (uint16_t c = 0; c < 3; c++)
+        abar[c] /= m;
+    kbar /= m;
+
+    float A[3 * 3], b[3] = {0}, v[3];
+    mat_zero(A, dim);
+    for (uint16_t i = 0; i < n; i++){
+        const mlat_range_t * r = &ranges[i];
+        if (!valid(r))
+            continue;
+        float rhs = r->anchor.x * r->anchor.x + r->anchor.y * r->anchor.y + r->anchor.z * r->anchor.z
+                - r->range * r->range - kbar;
+        if (dim == 2)
+            rhs -= 2 * (r->anchor.z - abar[2]) * pos->z;
+        for (uint16_t c = 0; c < dim; c++){
+            v[c] = 2 * (r->anchor.array[c] - abar[c]);
+            b[c] += v[c] * rhs;
+        }
+        mat_rank1(A, v, 1.0f, dim);
+    }
+    if (dim == 3 && A[2 * 3 + 2] < MLAT_PLANAR * 0.5f * (A[0] + A[1 * 3 + 1]))
+        return false;   // Height unresolved, see planar_fix
+    if (!mat_chol(A, dim))
+        return false;
+    mat_chol_solve(A, b, dim);
+    for (uint16_t c = 0; c < dim; c++)
+        pos->array[c] = b[c];
+    return true;
+}
+
+/**
+ * Closed-form fix for 3D with the anchors in a horizontal plane: 2D fix in the plane, then the height below it
+ * that best fits the ranges.
+ */
+static bool
+planar_fix(const mlat_range_t * ranges, uint16_t n, triad_t * pos){
+
+    float zbar = 0;
+    uint16_t m = 0;
+    for (uint16_t i = 0; i < n; i++)
+        if (valid(&ranges[i])){
+            zbar += ranges[i].anchor.z;
+            m++;
+        }
+    if (m == 0)
+        return false;
+    pos->z = zbar /= m;
+    if (!linear_fix(ranges, n, 2, pos))
+        return false;
+
+    float h2 = 0;
+    for (uint16_t i = 0; i < n; i++){
+        const mlat_range_t * r = &ranges[i];
+        if (!valid(r))
+            continue;
+        float dx = pos->x - r->anchor.x, dy = pos->y - r->anchor.y;
+        h2 += r->range * r->range - dx * dx - dy * dy;
+    }
+    pos->z = zbar - sqrtf(fmaxf(h2 / m, 0));
+    return true;
+}
+
+/**
+ * Builds the normal equations J'WJ and J'We of the range residuals at pos.
+ *
+ * @return Ranges used
+ */
+static uint16_t
+normal_equations(const mlat_range_t * ranges, uint16_t n, uint16_t dim, const triad_t * pos,
+        float * A, float * g, float * wsse, float * wsum){
+
+    uint16_t m = 0;
+    float u[3];
+    mat_zero(A, dim);
+    memset(g, 0, dim * sizeof(float));
+    *wsse = *wsum = 0;
+
+    for (uint16_t i = 0; i < n; i++){
+        const mlat_range_t * r = &ranges[i];
+        if (!valid(r))
+            continue;
+        float dx = pos->x - r->anchor.x, dy = pos->y - r->anchor.y, dz = pos->z - r->anchor.z;
+        float d = sqrtf(dx * dx + dy * dy + dz * dz);
+        if (d < MLAT_TOL)
+            continue;   // On top of the anchor, no direction
+        u[0] = dx / d; u[1] = dy / d; u[2] = dz / d;
+        float w = weight(r), e = r->range - d;
+        mat_rank1(A, u, w, dim);
+        for (uint16_t c = 0; c < dim; c++)
+            g[c] += w * u[c] * e;
+        *wsse += w * e * e;
+        *wsum += w;
+        m++;
+    }
+    return m;
+}
+
+/**
+ * API to compute a position from ranges to anchors.
+ *
+ * @param ranges   Ranges; entries with a negative or non-finite range or a negative variance are skipped.
+ * @param n        Number of ranges.
+ * @param dim      2 or 3.
+ * @param initial  Start from sol->pos instead of the closed-form fix.
+ * @param sol      Solution; sol->pos.z is the height of the tag in 2D.
+ *
+ * @return true on success, sol is only written on success
+ */
+bool
+mlat_solve(const mlat_range_t * ranges, uint16_t n, uint16_t dim, bool initial, mlat_solution_t * sol){
+
+    assert(dim == 2 || dim == 3);
+    triad_t pos = sol->pos;
+
+    if (!initial){
+        if (!linear_fix(ranges, n, dim, &pos)
+                && !(dim == 3 && planar_fix(ranges, n, &pos)))
+            return false;
+    }
+
+    float A[3 * 3], g[3], wsse, wsum;
+    uint16_t m = 0, it;
+    for (it = 0; it < MLAT_ITER_MAX; it++){
+        m = normal_equations(ranges, n, dim, &pos, A, g, &wsse, &wsum);
+        if (m < dim || !mat_chol(A, dim))
+            return false;
+        mat_chol_solve(A, g, dim);
+        float step = 0;
+        for (uint16_t c = 0; c < dim; c++){
+            pos.array[c] += g[c];
+            step += g[c] * g[c];
+        }
+        if (!isfinite(step))
+            return false;
+        if (step < MLAT_TOL * MLAT_TOL){
+            it++;
+            break;
+        }
+    }
+
+    m = normal_equations(ranges, n, dim, &pos, A, g, &wsse, &wsum);
+    if (m < dim || !mat_chol(A, dim))
+        return false;
+
+    float cov[3 * 3];
+    mat_chol_inv(A, cov, dim);
+    bool absolute = true;
+    for (uint16_t i = 0; i < n; i++)
+        if (valid(&ranges[i]) && !(ranges[i].variance > 0))
+            absolute = false;
+    float scale = (!absolute && m > dim) ? wsse / (m - dim) : 1.0f;
+
+    memset(sol->cov, 0, sizeof(sol->cov));
+    for (uint16_t i = 0; i < dim; i++)
+        for (uint16_t j = 0; j < dim; j++)
+            sol->cov[i][j] = scale * cov[i * dim + j];
+    sol->pos = pos;
+    sol->rms = sqrtf(wsse / wsum);
+    sol->nranges = m;
+    sol->iterations = it;
+    return true;
+}
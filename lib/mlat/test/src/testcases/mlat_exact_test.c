@@ -0,0 +1,89 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "mlat_test.h"
+
+#define MLAT_EXACT_TEST_ANCHORS 5
+
+static void
+ranges_to(mlat_range_t * ranges, const float (*anchors)[3], uint16_t n, const triad_t * tag)
+{
+    for (uint16_t i = 0; i < n; i++){
+        for (uint16_t c = 0; c < 3; c++)
+            ranges[i].anchor.array[c] = anchors[i][c];
+        float dx = tag->x - anchors[i][0], dy = tag->y - anchors[i][1], dz = tag->z - anchors[i][2];
+        ranges[i].range = sqrtf(dx * dx + dy * dy + dz * dz);
+        ranges[i].variance = 0;
+    }
+}
+
+/* Noise free ranges give back the tag position, from the closed-form fix and from an initial estimate */
+TEST_CASE(mlat_exact_test)
+{
+    static const float spread[MLAT_EXACT_TEST_ANCHORS][3] = {
+        {0, 0, 0.5f}, {10.0f, 0, 2.8f}, {10.0f, 8.0f, 0.3f}, {0, 8.0f, 2.2f}, {5.0f, 4.0f, 3.0f}
+    };
+    static const float ceiling[MLAT_EXACT_TEST_ANCHORS][3] = {
+        {0, 0, 3.0f}, {10.0f, 0, 3.0f}, {10.0f, 8.0f, 3.0f}, {0, 8.0f, 3.0f}, {4.0f, 5.0f, 3.0f}
+    };
+    mlat_range_t ranges[MLAT_EXACT_TEST_ANCHORS];
+    mlat_solution_t sol;
+    triad_t tag = {.x = 3.7f, .y = 5.2f, .z = 1.1f};
+
+    /* 2D, height of the tag given */
+    ranges_to(ranges, spread, 3, &tag);
+    memset(&sol, 0, sizeof(sol));
+    sol.pos.z = tag.z;
+    TEST_ASSERT_FATAL(mlat_solve(ranges, 3, 2, false, &sol));
+    TEST_ASSERT(fabsf(sol.pos.x - tag.x) < 1e-3f);
+    TEST_ASSERT(fabsf(sol.pos.y - tag.y) < 1e-3f);
+    TEST_ASSERT(sol.pos.z == tag.z);
+    TEST_ASSERT(sol.cov[2][2] == 0);
+    TEST_ASSERT(sol.nranges == 3);
+
+    /* 3D, anchors at different heights */
+    ranges_to(ranges, spread, MLAT_EXACT_TEST_ANCHORS, &tag);
+    memset(&sol, 0, sizeof(sol));
+    TEST_ASSERT_FATAL(mlat_solve(ranges, MLAT_EXACT_TEST_ANCHORS, 3, false, &sol));
+    for (uint16_t c = 0; c < 3; c++)
+        TEST_ASSERT(fabsf(sol.pos.array[c] - tag.array[c]) < 1e-3f);
+    TEST_ASSERT(sol.rms < 1e-3f);
+
+    /* 3D from an initial estimate, one range fewer */
+    memset(&sol, 0, sizeof(sol));
+    sol.pos.x = 4.5f; sol.pos.y = 4.5f; sol.pos.z = 1.5f;
+    TEST_ASSERT_FATAL(mlat_solve(ranges, 3, 3, true, &sol));
+    for (uint16_t c = 0; c < 3; c++)
+        TEST_ASSERT(fabsf(sol.pos.array[c] - tag.array[c]) < 1e-3f);
+
+    /* 3D, coplanar ceiling anchors: the tag is placed below the plane */
+    ranges_to(ranges, ceiling, MLAT_EXACT_TEST_ANCHORS, &tag);
+    memset(&sol, 0, sizeof(sol));
+    TEST_ASSERT_FATAL(mlat_solve(ranges, MLAT_EXACT_TEST_ANCHORS, 3, false, &sol));
+    for (uint16_t c = 0; c < 3; c++)
+        TEST_ASSERT(fabsf(sol.pos.array[c] - tag.array[c]) < 1e-3f);
+
+    /* Too few ranges, and an invalid range that leaves too few */
+    memset(&sol, 0, sizeof(sol));
+    TEST_ASSERT(!mlat_solve(ranges, 2, 3, false, &sol));
+    ranges_to(ranges, spread, 3, &tag);
+    ranges[1].range = -1;
+    TEST_ASSERT(!mlat_solve(ranges, 3, 2, false, &sol));
+}
@@ -0,0 +1,118 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "mlat_test.h"
+
+#define MLAT_NOISE_TEST_ANCHORS 6
+#define MLAT_NOISE_TEST_TRIALS 500
+#define MLAT_NOISE_TEST_SIGMA 0.1f
+
+static uint32_t state = 0x9E3779B9;
+
+/* Standard normal sample, Box-Muller over xorshift32 */
+static float
+gauss(void)
+{
+    float u[2];
+    for (uint16_t k = 0; k < 2; k++){
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        u[k] = ((state >> 8) + 0.5f) / (1u << 24);
+    }
+    return sqrtf(-2 * logf(u[0])) * cosf(2 * (float)M_PI * u[1]);
+}
+
+/* Normalised squared error of the solution against its covariance, chi-square with 3 degrees of freedom */
+static float
+nees(const mlat_solution_t * sol, const triad_t * tag)
+{
+    float e[3], A[3][3];
+    for (uint16_t c = 0; c < 3; c++)
+        e[c] = sol->pos.array[c] - tag->array[c];
+    memcpy(A, sol->cov, sizeof(A));
+    /* Solve cov x = e by Gaussian elimination, cov is symmetric positive definite */
+    for (uint16_t k = 0; k < 3; k++)
+        for (uint16_t i = k + 1; i < 3; i++){
+            float f = A[i][k] / A[k][k];
+            for (uint16_t j = k; j < 3; j++)
+                A[i][j] -= f * A[k][j];
+            e[i] -= f * e[k];
+        }
+    float x[3], q = 0;
+    for (int16_t i = 2; i >= 0; i--){
+        x[i] = e[i];
+        for (uint16_t j = i + 1; j < 3; j++)
+            x[i] -= A[i][j] * x[j];
+        x[i] /= A[i][i];
+    }
+    for (uint16_t c = 0; c < 3; c++)
+        q += (sol->pos.array[c] - tag->array[c]) * x[c];
+    return q;
+}
+
+/* Noisy ranges: the solution is unbiased and its covariance matches the spread of the error */
+TEST_CASE(mlat_noise_test)
+{
+    static const float anchors[MLAT_NOISE_TEST_ANCHORS][3] = {
+        {0, 0, 0.5f}, {10.0f, 0, 2.8f}, {10.0f, 8.0f, 0.3f}, {0, 8.0f, 2.2f}, {5.0f, -2.0f, 3.0f}, {5.0f, 10.0f, 1.0f}
+    };
+    const triad_t tag = {.x = 3.7f, .y = 5.2f, .z = 1.1f};
+    mlat_range_t ranges[MLAT_NOISE_TEST_ANCHORS];
+    mlat_solution_t sol;
+    float bias[3] = {0}, q = 0, err2 = 0, trace = 0;
+
+    for (uint16_t t = 0; t < MLAT_NOISE_TEST_TRIALS; t++){
+        for (uint16_t i = 0; i < MLAT_NOISE_TEST_ANCHORS; i++){
+            float d2 = 0;
+            for (uint16_t c = 0; c < 3; c++){
+                ranges[i].anchor.array[c] = anchors[i][c];
+                d2 += (tag.array[c] - anchors[i][c]) * (tag.array[c] - anchors[i][c]);
+            }
+            ranges[i].range = sqrtf(d2) + MLAT_NOISE_TEST_SIGMA * gauss();
+            ranges[i].variance = MLAT_NOISE_TEST_SIGMA * MLAT_NOISE_TEST_SIGMA;
+        }
+
+        /* Known variances, absolute covariance */
+        memset(&sol, 0, sizeof(sol));
+        TEST_ASSERT_FATAL(mlat_solve(ranges, MLAT_NOISE_TEST_ANCHORS, 3, false, &sol));
+        for (uint16_t c = 0; c < 3; c++)
+            bias[c] += sol.pos.array[c] - tag.array[c];
+        q += nees(&sol, &tag);
+
+        /* Unknown variances, covariance scaled by the residual variance */
+        for (uint16_t i = 0; i < MLAT_NOISE_TEST_ANCHORS; i++)
+            ranges[i].variance = 0;
+        memset(&sol, 0, sizeof(sol));
+        TEST_ASSERT_FATAL(mlat_solve(ranges, MLAT_NOISE_TEST_ANCHORS, 3, false, &sol));
+        for (uint16_t c = 0; c < 3; c++){
+            err2 += (sol.pos.array[c] - tag.array[c]) * (sol.pos.array[c] - tag.array[c]);
+            trace += sol.cov[c][c];
+        }
+    }
+
+    for (uint16_t c = 0; c < 3; c++)
+        TEST_ASSERT(fabsf(bias[c] / MLAT_NOISE_TEST_TRIALS) < 0.02f);
+    /* Mean NEES of a consistent estimator is the dimension */
+    q /= MLAT_NOISE_TEST_TRIALS;
+    TEST_ASSERT(q > 2.5f && q < 3.5f);
+    /* The residual variance only has three degrees of freedom, so compare the means */
+    TEST_ASSERT(trace / err2 > 0.7f && trace / err2 < 1.4f);
+}
@@ -32,6 +32,7 @@ extern "C" {
 #include <hal/hal_spi.h>
 #include <dw1000/dw1000_regs.h>
 #include <dw1000/dw1000_dev.h>
+#include <dw1000/dw1000_mac.h>
 #include <dw1000/dw1000_ftypes.h>
 #include <dw1000/triad.h>
 
@@ -39,6 +40,9 @@ extern "C" {
 #include <rng/rng.h>
 #include <rng/slots.h>
 #endif
+#if MYNEWT_VAL(NRNG_TIMEOUT_ENABLED)
+#include <rng/rng_timeout.h>
+#endif
 
 #define FCNTL_IEEE_N_RANGES_16 0x88C1
 #define FRAMES_PER_RANGE       2
@@ -59,7 +63,8 @@ typedef enum _dw1000_nrng_modes_t{
     DWT_DS_TWR_NRNG_EXT_T1,
     DWT_DS_TWR_NRNG_EXT_T2,
     DWT_DS_TWR_NRNG_EXT_FINAL,
-    DWT_DS_TWR_NRNG_EXT_END
+    DWT_DS_TWR_NRNG_EXT_END,
+    DWT_NRNG_REPORT                 //!< Aggregated ranges from the initiator, see nranges/nrng_report.h
 }dw1000_nrng_modes_t;
 
 typedef enum _dw1000_nrng_device_type_t{
@@ -76,6 +81,9 @@ typedef union {
     uint8_t array[sizeof(struct _nrng_request_frame_t)]; //!< Array of size nrng request frame
 } nrng_request_frame_t;
 
+//! Longest slot map that fits after a request frame within a 127 byte frame, including the CRC
+#define NRNG_SLOT_MAP_MAX (127 - 2 - sizeof(nrng_request_frame_t))
+
 //! N-Ranges response frame
 typedef union {
     struct _nrng_response_frame_t{
@@ -128,12 +136,38 @@ typedef struct _dw1000_nrng_instance_t{
     struct os_sem sem;
     uint16_t idx;
     struct _dw1000_dev_instance_t * parent;
+#if MYNEWT_VAL(NRNG_TIMEOUT_ENABLED)
+    rng_timeout_t timeout;              //!< Turnaround window of the first response slot
+    rng_timeout_acct_t timeout_acct;    //!< Adaptive timeout in flight and totals
+#endif
+#if MYNEWT_VAL(NRNG_REPORT_ENABLED)
+    void (* report_cb)(struct _dw1000_dev_instance_t *, const struct _nrng_report_frame_t *, void *); //!< Report receive callback
+    void * report_arg;                  //!< Argument of report_cb
+    uint16_t report_pending;            //!< Report frame in flight
+#endif
     nrng_frame_t *frames[][FRAMES_PER_RANGE];
 }dw1000_nrng_instance_t;
 
+/**
+ * Carrier integrator of the frame being received. The MAC snapshots it in single buffer mode; with double buffering
+ * it is read from the receiver.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ *
+ * @return int32_t
+ */
+static inline int32_t
+dw1000_nrng_carrier_integrator(dw1000_dev_instance_t * inst){
+    return (inst->config.dblbuffon_enabled) ? dw1000_read_carrier_integrator(inst) : inst->carrier_integrator;
+}
+
 dw1000_nrng_instance_t * dw1000_nrng_init(dw1000_dev_instance_t * inst, dw1000_rng_config_t * config, dw1000_nrng_device_type_t type, uint16_t nframes, uint16_t nnodes);
 dw1000_dev_status_t dw1000_nrng_request_delay_start(dw1000_dev_instance_t * inst, uint16_t dst_address, uint64_t delay, dw1000_nrng_modes_t code, uint16_t start_slot_id, uint16_t end_slot_id);
 dw1000_dev_status_t dw1000_nrng_request(dw1000_dev_instance_t * inst, uint16_t dst_address, dw1000_nrng_modes_t code, uint16_t start_slot_id, uint16_t end_slot_id);
+dw1000_dev_status_t dw1000_nrng_request_map(dw1000_dev_instance_t * inst, uint16_t dst_address, dw1000_nrng_modes_t code, const uint16_t * slot_ids, uint16_t nslots);
+dw1000_nrng_instance_t * dw1000_nrng_reserve(dw1000_dev_instance_t * inst, uint16_t nnodes);
+int32_t dw1000_nrng_twr_to_tof_ps(struct _dw1000_dev_instance_t * inst, nrng_frame_t *first_frame, nrng_frame_t *final_frame);
+nrng_frame_t * dw1000_nrng_result(dw1000_dev_instance_t * inst, uint16_t row, int32_t * tof_ps);
 float dw1000_nrng_twr_to_tof_frames(struct _dw1000_dev_instance_t * inst, nrng_frame_t *first_frame, nrng_frame_t *final_frame);
 void dw1000_nrng_set_frames(dw1000_dev_instance_t* inst, uint16_t nframes);
 dw1000_dev_status_t dw1000_nrng_config(struct _dw1000_dev_instance_t* inst, dw1000_rng_config_t * config);
@@ -0,0 +1,90 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file nrng_report.h
+ * @author paul kettle
+ * @date 2018
+ * @brief Aggregated nrng report frame
+ *
+ * @details Once an nrng request completes the ranges exist only in the frames of the initiator. A report frame carries
+ * all of them to the responders in one broadcast: each entry is the responder address and its time of flight as an
+ * unsigned 16-bit count of DTU (15.65 ps, 4.7 mm), covering 0 to 307 m. A frame holds up to NRNG_REPORT_NENTRIES
+ * entries; larger sets are sent as consecutive frames. Receivers are handed each frame through the callback set with
+ * dw1000_nrng_report_set_cb.
+ */
+
+#ifndef _NRNG_REPORT_H_
+#define _NRNG_REPORT_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <nranges/nranges.h>
+
+#define NRNG_REPORT_TOF_INVALID 0xFFFF      //!< Time of flight of an entry out of range
+
+//! Report entry
+typedef struct _nrng_report_entry_t{
+    uint16_t addr;                          //!< Short address of the responder
+    uint16_t tof;                           //!< Time of flight, DTU
+}__attribute__((__packed__,aligned(1))) nrng_report_entry_t;
+
+//! Report frame
+typedef struct _nrng_report_frame_t{
+    struct _ieee_rng_request_frame_t;       //!< seq_num is that of the reported request, code DWT_NRNG_REPORT
+    uint8_t nentries;                       //!< Entries in this frame
+    nrng_report_entry_t entries[];          //!< Entries
+}__attribute__((__packed__,aligned(1))) nrng_report_frame_t;
+
+//! Entries that fit in a 127 byte frame, including the CRC
+#define NRNG_REPORT_NENTRIES ((127 - 2 - sizeof(nrng_report_frame_t)) / sizeof(nrng_report_entry_t))
+
+//! Receive callback, called in the MAC context with the report frame in the receive buffer
+typedef void (* nrng_report_cb_t)(dw1000_dev_instance_t * inst, const nrng_report_frame_t * report, void * arg);
+
+//! Airtime of reporting a set of ranges
+typedef struct _nrng_report_airtime_t{
+    uint16_t nnodes;                        //!< Ranges reported
+    uint16_t nframes;                       //!< Aggregated report frames
+    uint32_t aggregated;                    //!< Airtime of the aggregated report, usec
+    uint32_t per_pair;                      //!< Airtime of one report frame per range, usec
+}nrng_report_airtime_t;
+
+void dw1000_nrng_report_init(dw1000_dev_instance_t * inst);
+dw1000_dev_status_t dw1000_nrng_report(dw1000_dev_instance_t * inst, uint16_t dst_address);
+void dw1000_nrng_report_set_cb(dw1000_dev_instance_t * inst, nrng_report_cb_t cb, void * arg);
+bool dw1000_nrng_report_rx(dw1000_dev_instance_t * inst);
+bool dw1000_nrng_report_tx(dw1000_dev_instance_t * inst);
+uint16_t nrng_report_tof(int32_t tof_ps);
+nrng_report_airtime_t dw1000_nrng_report_airtime(dw1000_dev_instance_t * inst, uint16_t nnodes);
+void dw1000_nrng_report_bench(dw1000_dev_instance_t * inst);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _NRNG_REPORT_H_ */
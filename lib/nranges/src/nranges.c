@@ -34,6 +34,7 @@
 #include <dw1000/dw1000_ftypes.h>
 #include <nranges/nranges.h>
 #include <rng/rng.h>
+#include <tof/tof.h>
 #if MYNEWT_VAL(TWR_DS_NRNG_ENABLED)
 #include <twr_ds_nrng/twr_ds_nrng.h>
 #endif
@@ -53,10 +54,16 @@
 #if MYNEWT_VAL(NRNG_VERBOSE)
 #include <nranges/nrng_encode.h>
 #endif
+#if MYNEWT_VAL(NRNG_REPORT_ENABLED)
+#include <nranges/nrng_report.h>
+#endif
 
 static bool reset_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t *);
 static bool rx_complete_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t *);
 static bool rx_timeout_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t *);
+#if MYNEWT_VAL(NRNG_REPORT_ENABLED)
+static bool tx_complete_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t *);
+#endif
 #if MYNEWT_VAL(NRNG_VERBOSE)
 static bool complete_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs);
 #endif
@@ -77,6 +84,7 @@ STATS_SECT_START(nrng_stat_section)
     STATS_SECT_ENTRY(start_tx_error_cb)
     STATS_SECT_ENTRY(rx_unsolicited)
     STATS_SECT_ENTRY(reset)
+    STATS_SECT_ENTRY(map_error)
 STATS_SECT_END
 
 STATS_NAME_START(nrng_stat_section)
@@ -89,6 +97,7 @@ STATS_NAME_START(nrng_stat_section)
     STATS_NAME(nrng_stat_section, start_tx_error_cb)
     STATS_NAME(nrng_stat_section, rx_unsolicited)
     STATS_NAME(nrng_stat_section, reset)
+    STATS_NAME(nrng_stat_section, map_error)
 STATS_NAME_END(nrng_stat_section)
 
 static STATS_SECT_DECL(nrng_stat_section) g_stat; //!< Stats instance
@@ -97,6 +106,9 @@ static dw1000_mac_interface_t g_cbs = {
     .id = DW1000_NRNG,
     .rx_complete_cb = rx_complete_cb,
     .rx_timeout_cb = rx_timeout_cb,
+#if MYNEWT_VAL(NRNG_REPORT_ENABLED)
+    .tx_complete_cb = tx_complete_cb,
+#endif
 #if MYNEWT_VAL(NRNG_VERBOSE)
             .complete_cb  = complete_cb,
 #endif
@@ -134,6 +146,13 @@ dw1000_nrng_init(dw1000_dev_instance_t * inst, dw1000_rng_config_t* config, dw10
                     STATS_NAME_INIT_PARMS(nrng_stat_section)
             );
     rc |= stats_register("nrng", STATS_HDR(g_stat));
+#if MYNEWT_VAL(NRNG_TIMEOUT_ENABLED)
+    rng_timeout_init(&nrng->timeout);
+    rc |= rng_timeout_acct_init(&nrng->timeout_acct, "nrng_timeout");
+#endif
+#if MYNEWT_VAL(NRNG_REPORT_ENABLED)
+    dw1000_nrng_report_init(inst);
+#endif
 
     return nrng;
 }
@@ -178,6 +197,45 @@ dw1000_nrng_set_frames(dw1000_dev_instance_t * inst, uint16_t nframes){
             }
 }
 
+/**
+ * API to size the frame table for requests to nnodes responders. Responses are stored by their 1-based slot position,
+ * so nnodes + 1 pairs of frames are kept. The instance is reallocated when it is too small, so this must not be
+ * called while a request is in flight, and pointers to inst->nrng are stale afterwards.
+ *
+ * @param inst    Pointer to dw1000_dev_instance_t.
+ * @param nnodes  Number of responders.
+ *
+ * @return dw1000_nrng_instance_t*
+ */
+dw1000_nrng_instance_t *
+dw1000_nrng_reserve(dw1000_dev_instance_t * inst, uint16_t nnodes){
+    assert(inst);
+    dw1000_nrng_instance_t * nrng = inst->nrng;
+    uint16_t nframes = (nnodes + 1) * FRAMES_PER_RANGE;
+
+    if (nframes <= nrng->nframes)
+        return nrng;
+    assert(nrng->status.selfmalloc);
+    assert(os_sem_get_count(&nrng->sem) == 1);
+
+    nrng = (dw1000_nrng_instance_t *) realloc(nrng, sizeof(dw1000_nrng_instance_t) + nframes * sizeof(nrng_frame_t*));
+    assert(nrng);
+    nrng_frame_t default_frame = {
+        .PANID = 0xDECA,
+        .fctrl = FCNTL_IEEE_N_RANGES_16,
+        .code = DWT_DS_TWR_NRNG_INVALID
+    };
+    for (uint16_t i = nrng->nframes/FRAMES_PER_RANGE; i < nframes/FRAMES_PER_RANGE; i++)
+        for(uint16_t j =0; j < FRAMES_PER_RANGE; j++){
+            nrng->frames[i][j] = (nrng_frame_t*)malloc(sizeof(nrng_frame_t));
+            assert(nrng->frames[i][j]);
+            memcpy(nrng->frames[i][j], &default_frame, sizeof(nrng_frame_t));
+        }
+    nrng->nframes = nframes;
+    inst->nrng = nrng;
+    return nrng;
+}
+
 /**
  * API to configure dw1000 to start transmission after certain delay.
  *
@@ -242,6 +300,9 @@ void dw1000_nrng_pkg_init(void){
     dw1000_nrng_init(inst, &g_config, (dw1000_nrng_device_type_t)MYNEWT_VAL(NRNG_DEVICE_TYPE), MYNEWT_VAL(NRNG_NFRAMES), MYNEWT_VAL(NRNG_NNODES));
     dw1000_nrng_set_frames(inst, MYNEWT_VAL(NRNG_NFRAMES));
     dw1000_mac_append_interface(hal_dw1000_inst(0), &g_cbs);
+#if MYNEWT_VAL(NRNG_REPORT_ENABLED) && MYNEWT_VAL(NRNG_REPORT_BENCH)
+    dw1000_nrng_report_bench(inst);
+#endif
 }
 
 dw1000_dev_status_t 
@@ -270,6 +331,57 @@ usecs_to_response(dw1000_dev_instance_t * inst, uint16_t slot_id, dw1000_rng_con
     return ret;
 }
 
+/**
+ * Sends the request frame already written to the tx buffer and waits for the responses of nrng->nnodes slots.
+ *
+ * @param inst       Pointer to dw1000_dev_instance_t.
+ * @param config     Configuration of the ranging mode.
+ * @param frame_len  Length of the request frame, excluding the CRC.
+ *
+ * @return dw1000_dev_status_t
+ */
+static dw1000_dev_status_t
+nrng_request_start(dw1000_dev_instance_t * inst, dw1000_rng_config_t * config, uint16_t frame_len){
+
+    dw1000_nrng_instance_t * nrng = inst->nrng;
+
+    dw1000_write_tx_fctrl(inst, frame_len, 0, true);
+    dw1000_set_wait4resp(inst, true);
+
+    uint16_t timeout =  config->tx_holdoff_delay        // Remote side turn arround time.
+                        + usecs_to_response(inst,       // Aggregated timeout of all responses
+                            nrng->nnodes,               // no. of expected frames
+                            config,                    
+                            dw1000_phy_frame_duration(&inst->attrib, sizeof(nrng_response_frame_t)) // in usec
+                        );
+#if MYNEWT_VAL(NRNG_TIMEOUT_ENABLED)
+    // The slot train is fixed, only the turnaround to the first slot adapts
+    timeout = rng_timeout_select(&nrng->timeout, &nrng->timeout_acct, timeout, timeout - config->tx_holdoff_delay);
+#endif
+    dw1000_set_rx_timeout(inst, timeout);
+
+    if (nrng->control.delay_start_enabled)
+       dw1000_set_delay_start(inst, nrng->delay); 
+    
+    dw1000_set_dblrxbuff(inst, true);  
+    
+    if (dw1000_start_tx(inst).start_tx_error && inst->status.rx_timeout_error == 0){
+        STATS_INC(g_stat, start_tx_error_cb);
+            os_sem_release(&nrng->sem);
+    }
+    os_error_t err = os_sem_pend(&nrng->sem, OS_TIMEOUT_NEVER); // Wait for completion of transactions
+    assert(err == OS_OK);
+    err = os_sem_release(&nrng->sem);
+    assert(err == OS_OK);
+
+    dw1000_set_dblrxbuff(inst, false);
+
+#if MYNEWT_VAL(NRNG_REPORT_ENABLED) && MYNEWT_VAL(NRNG_REPORT_AUTO)
+    dw1000_nrng_report(inst, BROADCAST_ADDRESS);
+#endif
+    return inst->status;
+}
+
 dw1000_dev_status_t
 dw1000_nrng_request(dw1000_dev_instance_t * inst, uint16_t dst_address, dw1000_nrng_modes_t code, uint16_t slot_mask, uint16_t cell_id){
 
@@ -300,34 +412,85 @@ dw1000_nrng_request(dw1000_dev_instance_t * inst, uint16_t dst_address, dw1000_n
     nrng->nnodes = calc_nbits(slot_mask); // Number of nodes involved in request
 
     dw1000_write_tx(inst, frame->array, 0, sizeof(nrng_request_frame_t));
-    dw1000_write_tx_fctrl(inst, sizeof(nrng_request_frame_t), 0, true);
-    dw1000_set_wait4resp(inst, true);
+    return nrng_request_start(inst, config, sizeof(nrng_request_frame_t));
+}
 
-    uint16_t timeout =  config->tx_holdoff_delay        // Remote side turn arround time.
-                        + usecs_to_response(inst,       // Aggregated timeout of all responses
-                            nrng->nnodes,               // no. of expected frames
-                            config,                    
-                            dw1000_phy_frame_duration(&inst->attrib, sizeof(nrng_response_frame_t)) // in usec
-                        );
-    dw1000_set_rx_timeout(inst, timeout);
+/**
+ * Help function to calculate the longest slot map a request can carry. The responder schedules its response
+ * tx_holdoff_delay after the RMARKER of the request, so the map must fit the holdoff left once the responder has
+ * processed the nominal request, NRNG_MAP_PROCESSING past its end.
+ *
+ * @param inst    Pointer to dw1000_dev_instance_t.
+ * @param config  Configuration of the ranging mode.
+ *
+ * @return Largest map, bytes
+ */
+static uint16_t
+nrng_map_limit(dw1000_dev_instance_t * inst, dw1000_rng_config_t * config){
+    uint32_t processing = dw1000_phy_frame_duration(&inst->attrib, sizeof(nrng_request_frame_t))
+            - dw1000_phy_SHR_duration(&inst->attrib) + MYNEWT_VAL(NRNG_MAP_PROCESSING);
+    uint32_t slack = (config->tx_holdoff_delay > processing) ? config->tx_holdoff_delay - processing : 0;
+    uint16_t fit = (uint16_t)(slack / (8 * inst->attrib.Tdsym));
+    return (fit < NRNG_SLOT_MAP_MAX) ? fit : NRNG_SLOT_MAP_MAX;
+}
 
-    if (nrng->control.delay_start_enabled)
-       dw1000_set_delay_start(inst, nrng->delay); 
-    
-    dw1000_set_dblrxbuff(inst, true);  
-    
-    if (dw1000_start_tx(inst).start_tx_error && inst->status.rx_timeout_error == 0){
-        STATS_INC(g_stat, start_tx_error_cb);
-            os_sem_release(&nrng->sem);
+/**
+ * API to request ranging with an arbitrary set of slots. The slots are sent as a slot_map_t after the request frame,
+ * as a bitmap or a list of offsets whichever is shorter, so a single request can address far more responders than
+ * the 30 bits of slot_payload_t; 128 slots fit in at most 18 bytes when they span no more than 128 ids. Each
+ * responder answers in the slot given by its position within the map. The frame table is grown to the number of
+ * slots if needed, see dw1000_nrng_reserve.
+ *
+ * The request is not sent, and start_tx_error is set in the status returned, when the mode is not DWT_SS_TWR_NRNG,
+ * the slot ids are not ascending, there are more than 255 of them, or their map does not fit the responder holdoff,
+ * see nrng_map_limit.
+ *
+ * @param inst          Pointer to dw1000_dev_instance_t.
+ * @param dst_address   Address of the receiver, usually BROADCAST_ADDRESS.
+ * @param code          Ranging mode, only DWT_SS_TWR_NRNG responders decode slot maps.
+ * @param slot_ids      Ascending slot ids of the responders, the lowest no greater than 255.
+ * @param nslots        Number of slot ids.
+ *
+ * @return dw1000_dev_status_t
+ */
+dw1000_dev_status_t
+dw1000_nrng_request_map(dw1000_dev_instance_t * inst, uint16_t dst_address, dw1000_nrng_modes_t code, const uint16_t * slot_ids, uint16_t nslots){
+
+    // This function executes on the device that initiates a request
+    assert(inst->nrng);
+    dw1000_rng_config_t * config = dw1000_nrng_get_config(inst, code);
+    uint8_t map[NRNG_SLOT_MAP_MAX];
+    uint16_t map_len = 0;
+
+    // Position is returned in nrng_response_frame_t.slot_id
+    if (code == DWT_SS_TWR_NRNG && nslots <= UINT8_MAX)
+        map_len = slot_map_encode(slot_ids, nslots, map, nrng_map_limit(inst, config));
+    if (map_len == 0){
+        STATS_INC(g_stat, map_error);
+        inst->status.start_tx_error = 1;
+        return inst->status;
     }
-    err = os_sem_pend(&nrng->sem, OS_TIMEOUT_NEVER); // Wait for completion of transactions
-    assert(err == OS_OK);
-    err = os_sem_release(&nrng->sem);
+
+    dw1000_nrng_reserve(inst, nslots);
+    dw1000_nrng_instance_t * nrng = inst->nrng;
+    os_error_t err = os_sem_pend(&nrng->sem,  OS_TIMEOUT_NEVER);
     assert(err == OS_OK);
 
-    dw1000_set_dblrxbuff(inst, false);
-    
-    return inst->status;
+    STATS_INC(g_stat, nrng_request);
+
+    nrng_request_frame_t * frame = (nrng_request_frame_t *) nrng->frames[0][FIRST_FRAME_IDX];
+
+    frame->seq_num = nrng->seq_num++;
+    inst->nrng->code = frame->code = code;
+    frame->src_address = inst->my_short_address;
+    frame->dst_address = dst_address;
+    frame->ptype = PTYPE_MAP;
+    frame->bitfield = 0;
+    nrng->nnodes = nslots;
+
+    dw1000_write_tx(inst, frame->array, 0, sizeof(nrng_request_frame_t));
+    dw1000_write_tx(inst, map, sizeof(nrng_request_frame_t), map_len);
+    return nrng_request_start(inst, config, sizeof(nrng_request_frame_t) + map_len);
 }
 
 /**
@@ -380,6 +543,27 @@ reset_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs){
        return false;
 }
 
+#if MYNEWT_VAL(NRNG_TIMEOUT_ENABLED)
+/**
+ * Records the turnaround of the first response to a request, less the spacing of the slots before it.
+ *
+ * @param inst   Pointer to dw1000_dev_instance_t.
+ * @param frame  Response frame.
+ *
+ * @return void
+ */
+static void
+nrng_turnaround(dw1000_dev_instance_t * inst, nrng_frame_t * frame){
+    dw1000_nrng_instance_t * nrng = inst->nrng;
+    dw1000_rng_config_t * config = dw1000_nrng_get_config(inst, nrng->code - 1);
+    uint32_t interval = (uint32_t)inst->rxtimestamp - (uint32_t)inst->txtimestamp;
+    int32_t turnaround = (int32_t) dw1000_dwt_usecs_to_usecs(interval >> 16)
+            - (int32_t) usecs_to_response(inst, frame->slot_id, config,
+                dw1000_phy_frame_duration(&inst->attrib, sizeof(nrng_response_frame_t)));
+    rng_timeout_sample(&nrng->timeout, &nrng->timeout_acct, (turnaround > 0) ? turnaround : 0);
+}
+#endif
+
 /** 
  * API for timeout of rng interface
  *
@@ -388,7 +572,11 @@ reset_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs){
  */
 static bool
 rx_timeout_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs){
-    
+
+#if MYNEWT_VAL(NRNG_TIMEOUT_ENABLED)
+    if (inst->nrng->device_type == DWT_NRNG_INITIATOR)
+        rng_timeout_expired(&inst->nrng->timeout, &inst->nrng->timeout_acct);
+#endif
     if(os_sem_get_count(&inst->nrng->sem) == 0 && inst->nrng->device_type != DWT_NRNG_INITIATOR){
         os_error_t err = os_sem_release(&inst->nrng->sem);
         assert(err == OS_OK);
@@ -398,6 +586,22 @@ rx_timeout_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs){
     else
        return false;
 }
+#if MYNEWT_VAL(NRNG_REPORT_ENABLED)
+/**
+ * API for transmit complete callback, ends the transmission of a report frame.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ *
+ * @return true if a report frame was sent
+ */
+static bool
+tx_complete_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs){
+    if(inst->fctrl != FCNTL_IEEE_N_RANGES_16)
+        return false;
+    return dw1000_nrng_report_tx(inst);
+}
+#endif
+
 /**
  * API for receive complete callback.
  *
@@ -413,6 +617,10 @@ rx_complete_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs){
    
     dw1000_nrng_instance_t * nrng = inst->nrng;
 
+#if MYNEWT_VAL(NRNG_REPORT_ENABLED)
+    if (dw1000_nrng_report_rx(inst))
+        return true;
+#endif
     if(os_sem_get_count(&nrng->sem) == 1){ // unsolicited inbound
         STATS_INC(g_stat, rx_unsolicited);
         return false;
@@ -430,6 +638,11 @@ rx_complete_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs){
     }
 
     inst->nrng->code = frame->code;
+#if MYNEWT_VAL(NRNG_TIMEOUT_ENABLED)
+    if (nrng->timeout_acct.armed && inst->frame_len >= sizeof(nrng_response_frame_t) && (frame->code == DWT_SS_TWR_NRNG_T1
+            || frame->code == DWT_DS_TWR_NRNG_T1 || frame->code == DWT_DS_TWR_NRNG_EXT_T1))
+        nrng_turnaround(inst, frame);
+#endif
     switch(inst->nrng->code) {
         case DWT_SS_TWR_NRNG ... DWT_DS_TWR_NRNG_EXT_END:
             STATS_INC(g_stat, rx_complete);
@@ -442,40 +655,93 @@ rx_complete_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs){
 
 
 
-float
-dw1000_nrng_twr_to_tof_frames(struct _dw1000_dev_instance_t * inst, nrng_frame_t *first_frame, nrng_frame_t *final_frame){
-    float ToF = 0;
-    uint64_t T1R, T1r, T2R, T2r;
-    int64_t nom,denom;
+/**
+ * API to calculate time of flight from a pair of nrng frames.
+ *
+ * @param inst         Pointer to dw1000_dev_instance_t.
+ * @param first_frame  Pointer to the first nrng frame.
+ * @param final_frame  Pointer to the final nrng frame.
+ *
+ * @return Time of flight in picoseconds
+ */
+int32_t
+dw1000_nrng_twr_to_tof_ps(struct _dw1000_dev_instance_t * inst, nrng_frame_t *first_frame, nrng_frame_t *final_frame){
+
+    assert(first_frame != NULL);
+    assert(final_frame != NULL);
+    tof_exchange_t first = {
+        .round = tof_interval32(first_frame->response_timestamp, first_frame->request_timestamp),
+        .reply = tof_interval32(first_frame->transmission_timestamp, first_frame->reception_timestamp)
+    };
 
     switch(final_frame->code){
         case DWT_DS_TWR_NRNG ... DWT_DS_TWR_NRNG_END:
-        case DWT_DS_TWR_NRNG_EXT ... DWT_DS_TWR_NRNG_EXT_END:
-            assert(first_frame != NULL);
-            assert(final_frame != NULL);
-            T1R = (first_frame->response_timestamp - first_frame->request_timestamp);
-            T1r = (first_frame->transmission_timestamp  - first_frame->reception_timestamp);
-            T2R = (final_frame->response_timestamp - final_frame->request_timestamp);
-            T2r = (final_frame->transmission_timestamp - final_frame->reception_timestamp);
-            nom = T1R * T2R  - T1r * T2r;
-            denom = T1R + T2R  + T1r + T2r;
-            ToF = (float) (nom) / denom;
-            break;
-        case DWT_SS_TWR_NRNG ... DWT_SS_TWR_NRNG_FINAL:{
-            assert(first_frame != NULL);
+        case DWT_DS_TWR_NRNG_EXT ... DWT_DS_TWR_NRNG_EXT_END:{
+            tof_exchange_t second = {
+                .round = tof_interval32(final_frame->response_timestamp, final_frame->request_timestamp),
+                .reply = tof_interval32(final_frame->transmission_timestamp, final_frame->reception_timestamp)
+            };
+            return tof_ds_ps(&first, &second);
+            }
+        case DWT_SS_TWR_NRNG ... DWT_SS_TWR_NRNG_FINAL:
 #if MYNEWT_VAL(WCS_ENABLED)
-            ToF = ((first_frame->response_timestamp - first_frame->request_timestamp)
-                    -  (first_frame->transmission_timestamp - first_frame->reception_timestamp))/2.;
+            return tof_ss_ps(&first, 0);
 #else
-            float skew = dw1000_calc_clock_offset_ratio(inst, first_frame->carrier_integrator);
-            ToF = ((first_frame->response_timestamp - first_frame->request_timestamp)
-                    -  (first_frame->transmission_timestamp - first_frame->reception_timestamp) * (1 - skew))/2.;
+            return tof_ss_ps(&first, tof_skew_to_q31(dw1000_calc_clock_offset_ratio(inst, first_frame->carrier_integrator)));
 #endif
-            break;
-            }
         default: break;
     }
-    return ToF;
+    return 0;
+}
+
+/**
+ * API to fetch the result of one responder to the last request. A row holds a result only if its final frame carries
+ * a final code and the sequence number of the last request, so rows left over from earlier requests are skipped.
+ * Single sided rows run from 1 to nnodes and keep the final frame first; double sided rows run from 0 to nnodes - 1
+ * and keep it second. Callers scan rows 0 to nnodes.
+ *
+ * @param inst    Pointer to dw1000_dev_instance_t.
+ * @param row     Row of nrng->frames.
+ * @param tof_ps  Time of flight, psec, may be NULL.
+ *
+ * @return Final frame, whose dst_address is the responder; NULL if the row holds no result
+ */
+nrng_frame_t *
+dw1000_nrng_result(dw1000_dev_instance_t * inst, uint16_t row, int32_t * tof_ps){
+    dw1000_nrng_instance_t * nrng = inst->nrng;
+    if (row >= nrng->nframes/FRAMES_PER_RANGE)
+        return NULL;
+
+    nrng_frame_t * first = nrng->frames[row][FIRST_FRAME_IDX];
+    nrng_frame_t * second = nrng->frames[row][SECOND_FRAME_IDX];
+    uint8_t seq_num = nrng->seq_num - 1;
+
+    if (first->code == DWT_SS_TWR_NRNG_FINAL && first->seq_num == seq_num){
+        if (tof_ps)
+            *tof_ps = dw1000_nrng_twr_to_tof_ps(inst, first, first);
+        return first;
+    }
+    if ((second->code == DWT_DS_TWR_NRNG_FINAL || second->code == DWT_DS_TWR_NRNG_EXT_FINAL)
+            && first->seq_num == (uint8_t)(seq_num + 1)){
+        if (tof_ps)
+            *tof_ps = dw1000_nrng_twr_to_tof_ps(inst, first, second);
+        return second;
+    }
+    return NULL;
+}
+
+/**
+ * API to calculate time of flight from a pair of nrng frames.
+ *
+ * @param inst         Pointer to dw1000_dev_instance_t.
+ * @param first_frame  Pointer to the first nrng frame.
+ * @param final_frame  Pointer to the final nrng frame.
+ *
+ * @return Time of flight in float
+ */
+float
+dw1000_nrng_twr_to_tof_frames(struct _dw1000_dev_instance_t * inst, nrng_frame_t *first_frame, nrng_frame_t *final_frame){
+    return dw1000_nrng_twr_to_tof_ps(inst, first_frame, final_frame) / TOF_PS_PER_DTU;
 }
 
 
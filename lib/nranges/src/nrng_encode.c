@@ -25,6 +25,9 @@
 #include <rng/rng.h>
 #include <dw1000/dw1000_mac.h>
 #include <nranges/nrng_encode.h>
+#if MYNEWT_VAL(TELEMETRY_ENABLED)
+#include <telemetry/telemetry.h>
+#endif
 
 #if MYNEWT_VAL(NRNG_VERBOSE)
 
@@ -45,12 +48,23 @@ nrng_encode(dw1000_nrng_instance_t * nrng) {
     uint16_t slot_idx = frame->slot_id;
         
     if (frame->code ==  DWT_SS_TWR_NRNG_T1) {
+#if MYNEWT_VAL(TELEMETRY_ENABLED)
+        telemetry_nrng_t record = {
+            .utime = os_cputime_ticks_to_usecs(os_cputime_get32()),
+            .slot_id = slot_idx,
+            .seq_num = frame->seq_num,
+            .reception_timestamp = frame->reception_timestamp,
+            .transmission_timestamp = frame->transmission_timestamp
+        };
+        telemetry_write(TELEMETRY_NRNG, &record, sizeof(record));
+#else
         printf("{\"utime\": %lu,\"slot_id\": [%u,%u],\"reception\": \"%lX\",\"transmission\": \"%lX\"}\n",
             os_cputime_ticks_to_usecs(os_cputime_get32()),
             slot_idx, frame->seq_num,
             frame->reception_timestamp,
             frame->transmission_timestamp
             );
+#endif
     }
 }
 
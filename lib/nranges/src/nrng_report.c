@@ -0,0 +1,295 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file nrng_report.c
+ * @author paul kettle
+ * @date 2018
+ * @brief Aggregated nrng report frame
+ *
+ * @details The report is built from the results of the last request, see dw1000_nrng_result.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <os/os.h>
+
+#include <dw1000/dw1000_dev.h>
+#include <dw1000/dw1000_mac.h>
+#include <dw1000/dw1000_phy.h>
+#include <nranges/nranges.h>
+#include <nranges/nrng_report.h>
+#include <tof/tof.h>
+
+#if MYNEWT_VAL(NRNG_REPORT_ENABLED)
+
+STATS_SECT_START(nrng_report_stat_section)
+    STATS_SECT_ENTRY(tx)
+    STATS_SECT_ENTRY(tx_error)
+    STATS_SECT_ENTRY(entries)
+    STATS_SECT_ENTRY(rx)
+    STATS_SECT_ENTRY(rejected)
+STATS_SECT_END
+
+STATS_NAME_START(nrng_report_stat_section)
+    STATS_NAME(nrng_report_stat_section, tx)
+    STATS_NAME(nrng_report_stat_section, tx_error)
+    STATS_NAME(nrng_report_stat_section, entries)
+    STATS_NAME(nrng_report_stat_section, rx)
+    STATS_NAME(nrng_report_stat_section, rejected)
+STATS_NAME_END(nrng_report_stat_section)
+
+static STATS_SECT_DECL(nrng_report_stat_section) g_stat; //!< Stats instance
+static bool g_stat_registered;
+
+/**
+ * API to initialise the report state of an nrng instance.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ *
+ * @return void
+ */
+void
+dw1000_nrng_report_init(dw1000_dev_instance_t * inst){
+    assert(inst->nrng);
+    inst->nrng->report_cb = NULL;
+    inst->nrng->report_arg = NULL;
+    inst->nrng->report_pending = 0;
+
+    if (g_stat_registered)
+        return;
+    int rc = stats_init(
+                STATS_HDR(g_stat),
+                STATS_SIZE_INIT_PARMS(g_stat, STATS_SIZE_32),
+                STATS_NAME_INIT_PARMS(nrng_report_stat_section)
+            );
+    rc |= stats_register("nrng_report", STATS_HDR(g_stat));
+    assert(rc == 0);
+    g_stat_registered = true;
+}
+
+/**
+ * Help function to convert a time of flight to a report entry.
+ *
+ * @param tof_ps  Time of flight, psec.
+ *
+ * @return Time of flight in DTU, 0 if negative, NRNG_REPORT_TOF_INVALID if out of range
+ */
+uint16_t
+nrng_report_tof(int32_t tof_ps){
+    if (tof_ps <= 0)
+        return 0;
+    int32_t dtu = tof_ps_to_dtu(tof_ps);
+    return (dtu < NRNG_REPORT_TOF_INVALID) ? (uint16_t)dtu : NRNG_REPORT_TOF_INVALID;
+}
+
+/**
+ * API to send the ranges of the last request to the responders. Called by the initiator once dw1000_nrng_request
+ * returns; sends as many frames as the ranges need and returns once the last one is out.
+ *
+ * @param inst         Pointer to dw1000_dev_instance_t.
+ * @param dst_address  Destination, usually BROADCAST_ADDRESS.
+ *
+ * @return dw1000_dev_status_t
+ */
+dw1000_dev_status_t
+dw1000_nrng_report(dw1000_dev_instance_t * inst, uint16_t dst_address){
+
+    assert(inst->nrng);
+    dw1000_nrng_instance_t * nrng = inst->nrng;
+    uint8_t buf[sizeof(nrng_report_frame_t) + NRNG_REPORT_NENTRIES * sizeof(nrng_report_entry_t)];
+    nrng_report_frame_t * report = (nrng_report_frame_t *) buf;
+    uint16_t nrows = nrng->nframes/FRAMES_PER_RANGE;
+    uint16_t last = (nrng->nnodes < nrows) ? nrng->nnodes : nrows - 1;
+    uint16_t row = 0;
+
+    while (row <= last){
+        report->nentries = 0;
+        for (; row <= last && report->nentries < NRNG_REPORT_NENTRIES; row++){
+            int32_t tof_ps;
+            nrng_frame_t * frame = dw1000_nrng_result(inst, row, &tof_ps);
+            if (frame == NULL)
+                continue;
+            report->entries[report->nentries].addr = frame->dst_address;
+            report->entries[report->nentries].tof = nrng_report_tof(tof_ps);
+            report->nentries++;
+        }
+        if (report->nentries == 0)
+            break;
+
+        os_error_t err = os_sem_pend(&nrng->sem, OS_TIMEOUT_NEVER);
+        assert(err == OS_OK);
+
+        report->fctrl = FCNTL_IEEE_N_RANGES_16;
+        report->seq_num = nrng->seq_num - 1;
+        report->PANID = 0xDECA;
+        report->dst_address = dst_address;
+        report->src_address = inst->my_short_address;
+        report->code = DWT_NRNG_REPORT;
+
+        uint16_t len = sizeof(nrng_report_frame_t) + report->nentries * sizeof(nrng_report_entry_t);
+        dw1000_write_tx(inst, buf, 0, len);
+        dw1000_write_tx_fctrl(inst, len, 0, true);
+        dw1000_set_wait4resp(inst, false);
+
+        nrng->report_pending = 1;
+        if (dw1000_start_tx(inst).start_tx_error){
+            nrng->report_pending = 0;
+            STATS_INC(g_stat, tx_error);
+            os_sem_release(&nrng->sem);
+            break;
+        }
+        err = os_sem_pend(&nrng->sem, OS_TIMEOUT_NEVER); // Wait for the frame to go out
+        assert(err == OS_OK);
+        err = os_sem_release(&nrng->sem);
+        assert(err == OS_OK);
+
+        STATS_INC(g_stat, tx);
+        STATS_INCN(g_stat, entries, report->nentries);
+    }
+    return inst->status;
+}
+
+/**
+ * API to set the callback receiving report frames.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @param cb    Callback, NULL to drop reports.
+ * @param arg   Argument of the callback.
+ *
+ * @return void
+ */
+void
+dw1000_nrng_report_set_cb(dw1000_dev_instance_t * inst, nrng_report_cb_t cb, void * arg){
+    assert(inst->nrng);
+    inst->nrng->report_arg = arg;
+    inst->nrng->report_cb = cb;
+}
+
+/**
+ * API for the nrng receive complete callback. A responder listening for a request ends its listen on a report.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ *
+ * @return true if the frame was a report
+ */
+bool
+dw1000_nrng_report_rx(dw1000_dev_instance_t * inst){
+
+    dw1000_nrng_instance_t * nrng = inst->nrng;
+    nrng_report_frame_t * report = (nrng_report_frame_t *) inst->rxbuf;
+
+    if (inst->frame_len < sizeof(nrng_report_frame_t) || report->code != DWT_NRNG_REPORT)
+        return false;
+    if (report->dst_address != inst->my_short_address && report->dst_address != BROADCAST_ADDRESS)
+        return true;
+    if (inst->frame_len < sizeof(nrng_report_frame_t) + report->nentries * sizeof(nrng_report_entry_t)){
+        STATS_INC(g_stat, rejected);
+        return true;
+    }
+
+    STATS_INC(g_stat, rx);
+    if (nrng->report_cb)
+        nrng->report_cb(inst, report, nrng->report_arg);
+
+    if (nrng->device_type == DWT_NRNG_RESPONDER && os_sem_get_count(&nrng->sem) == 0){
+        os_error_t err = os_sem_release(&nrng->sem);
+        assert(err == OS_OK);
+    }
+    return true;
+}
+
+/**
+ * API for the nrng transmit complete callback.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ *
+ * @return true if a report frame was sent
+ */
+bool
+dw1000_nrng_report_tx(dw1000_dev_instance_t * inst){
+
+    dw1000_nrng_instance_t * nrng = inst->nrng;
+    if (nrng->report_pending == 0)
+        return false;
+
+    nrng->report_pending = 0;
+    os_error_t err = os_sem_release(&nrng->sem);
+    assert(err == OS_OK);
+    return true;
+}
+
+/**
+ * API to compute the airtime of reporting nnodes ranges, as aggregated frames and as one frame per range, with the
+ * frames of each separated by the nrng tx_guard_delay.
+ *
+ * @param inst    Pointer to dw1000_dev_instance_t.
+ * @param nnodes  Ranges reported.
+ *
+ * @return nrng_report_airtime_t
+ */
+nrng_report_airtime_t
+dw1000_nrng_report_airtime(dw1000_dev_instance_t * inst, uint16_t nnodes){
+
+    uint32_t guard = (uint32_t) dw1000_dwt_usecs_to_usecs(inst->nrng->config.tx_guard_delay);
+    nrng_report_airtime_t airtime = {
+        .nnodes = nnodes,
+        .nframes = (nnodes + NRNG_REPORT_NENTRIES - 1) / NRNG_REPORT_NENTRIES
+    };
+    if (nnodes == 0)
+        return airtime;
+
+    uint16_t remaining = nnodes;
+    for (uint16_t i = 0; i < airtime.nframes; i++){
+        uint16_t n = (remaining < NRNG_REPORT_NENTRIES) ? remaining : NRNG_REPORT_NENTRIES;
+        airtime.aggregated += dw1000_phy_frame_duration(&inst->attrib, sizeof(nrng_report_frame_t) + n * sizeof(nrng_report_entry_t));
+        remaining -= n;
+    }
+    airtime.aggregated += (airtime.nframes - 1) * guard;
+    airtime.per_pair = nnodes * (uint32_t) dw1000_phy_frame_duration(&inst->attrib, sizeof(nrng_report_frame_t) + sizeof(nrng_report_entry_t))
+                     + (nnodes - 1) * guard;
+    return airtime;
+}
+
+/**
+ * API to print the airtime of aggregated and per-pair reports for a range of set sizes, with the current PHY
+ * configuration. One JSON line per set size.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ *
+ * @return void
+ */
+void
+dw1000_nrng_report_bench(dw1000_dev_instance_t * inst){
+
+    static const uint16_t nnodes[] = {1, 4, 8, 16, 32, 64, 128};
+
+    for (uint16_t i = 0; i < sizeof(nnodes)/sizeof(nnodes[0]); i++){
+        nrng_report_airtime_t airtime = dw1000_nrng_report_airtime(inst, nnodes[i]);
+        printf("{\"utime\": %lu,\"msg\": \"nrng_report_airtime\",\"nnodes\": %u,\"nframes\": %u,"
+            "\"aggregated\": %lu,\"per_pair\": %lu}\n",
+            os_cputime_ticks_to_usecs(os_cputime_get32()), airtime.nnodes, airtime.nframes,
+            airtime.aggregated, airtime.per_pair);
+    }
+}
+
+#endif // NRNG_REPORT_ENABLED
@@ -26,6 +26,9 @@
  * @brief Ranging
  * 
  * @details This is the range base class which utilises the functions to do ranging services using multiple nodes.
+ * Each round gives every node a slot at a fixed offset on the DW1000 timebase. The rounds run in their own task,
+ * which arms each request with delayed transmission as soon as the previous exchange completes, so exchanges run
+ * back-to-back without waiting on an OS timer between nodes. Exchanges are sequential: rng keeps one in flight.
  */
 
 #ifndef _DW1000_RANGE_H_
@@ -42,7 +45,10 @@ extern "C" {
 #include <dw1000/dw1000_regs.h>
 #include <dw1000/dw1000_dev.h>
 #include <dw1000/dw1000_ftypes.h>
-#include <dw1000/dw1000_rng.h>
+#include <rng/rng.h>
+#if MYNEWT_VAL(RNG_CACHE_ENABLED)
+#include <rng/rng_cache.h>
+#endif
 
 //! Range configuration parameters
 typedef struct _dw1000_range_config_t{
@@ -63,30 +69,53 @@ typedef struct _dw1000_range_status_t{
     uint16_t timer_enabled:1;             //!< Indicates timer is enabled
 }dw1000_range_status_t;
 
+//! State of a single exchange within a round
+typedef enum _dw1000_range_state_t{
+    RANGE_IDLE = 0,                       //!< Not scheduled in this round
+    RANGE_SCHEDULED,                      //!< Request queued for delayed transmission
+    RANGE_COMPLETE,                       //!< Final frame exchanged
+    RANGE_FAILED,                         //!< Timeout, error or missed transmission slot
+    RANGE_SKIPPED,                        //!< Peer reported dead by the rng peer statistics
+}dw1000_range_state_t;
+
+//! Per responder exchange
+typedef struct _dw1000_range_exchange_t{
+    uint64_t tx_time;                     //!< Scheduled request transmission time, DTU
+    uint16_t addr;                        //!< Short address of the responder
+    uint16_t frame_idx;                   //!< rng frame holding the result when complete
+#if MYNEWT_VAL(RNG_CACHE_ENABLED)
+    rng_result_t * result;                //!< Cached result when complete, survives the frame ring
+#endif
+    dw1000_range_state_t state:8;         //!< Exchange state
+    uint8_t late;                         //!< Request missed its slot and the round was rebased
+}dw1000_range_exchange_t;
+
 //! Structure of DW1000 range instance
 typedef struct _dw1000_range_instance_t{
     struct _dw1000_dev_instance_t * parent;  //!< Device instance structure
     dw1000_range_status_t status;            //!< DW1000 range status
     dw1000_range_config_t config;            //!< DW1000 configuration
+    dw1000_mac_interface_t cbs;              //!< MAC interface callbacks
     os_event_fn *postprocess;                //!< An event of os   
-    struct os_sem sem;                       //!< os_semaphore
-    uint32_t period;                         //!< Range period
-    uint8_t idx;                             //!< Index of nodes
+    uint32_t period;                         //!< Round period, usec
+    uint32_t slot_period;                    //!< Spacing between exchange starts, usec
+    uint64_t epoch;                          //!< Scheduled start of the current round, DTU
+    uint16_t idx;                            //!< Index of the exchange in flight
     uint16_t nnodes;                         //!< NUmber of nodes to range with
     uint16_t *node_addr;                     //!< Address of each node
     uint16_t rng_idx_cnt;                    //!< To keep track of number of nodes ranged with
     uint16_t *rng_idx_list;                  //!< list of reserved addresses
     uint16_t pp_idx_cnt;                     //!< To keep track of number of nodes ranged with
     uint16_t *pp_idx_list;                   //!< list of reserved addresses
-    uint16_t var_mem_block[];                //!< Dynamic memory block  
+    dw1000_range_exchange_t exchanges[];     //!< Per node exchange state, followed by the index lists
 }dw1000_range_instance_t;
 
 dw1000_range_instance_t * dw1000_range_init(dw1000_dev_instance_t * inst, uint16_t nnodes, uint16_t node_addr[]);
 void dw1000_range_free(dw1000_dev_instance_t * inst);
-void dw1000_range_set_ext_callbacks(dw1000_dev_instance_t * inst, dw1000_extension_callbacks_t range_cbs);
 void dw1000_range_set_postprocess(dw1000_dev_instance_t * inst, os_event_fn * range_postprocess); 
 void dw1000_range_start(dw1000_dev_instance_t * inst, dw1000_rng_modes_t code);
 void dw1000_range_stop(dw1000_dev_instance_t * inst);
+uint32_t dw1000_range_slot_period(dw1000_dev_instance_t * inst, dw1000_rng_modes_t code);
 void dw1000_rng_reset_frames(dw1000_dev_instance_t * inst, twr_frame_t twr[], uint16_t nframes);
 void dw1000_range_reset_nodes(dw1000_dev_instance_t * inst, uint16_t node_addr[], uint16_t nnodes);
 void dw1000_range_set_nodes(dw1000_dev_instance_t * inst, uint16_t node_addr[], uint16_t nnodes);
@@ -45,24 +45,63 @@
 #include <dw1000/dw1000_ftypes.h>
 
 #if MYNEWT_VAL(DW1000_RANGE)
+#include <rng/rng.h>
 #include <range/dw1000_range.h>
 
+#define RANGE_ALLOC_SIZE(nnodes) (sizeof(dw1000_range_instance_t) + \
+        (nnodes) * (sizeof(dw1000_range_exchange_t) + 3 * sizeof(uint16_t)))
+
 static void postprocess(struct os_event * ev);
-static bool range_complete_cb(dw1000_dev_instance_t * inst);
-static bool range_error_cb(dw1000_dev_instance_t * inst);
-static bool range_tx_complete_cb(dw1000_dev_instance_t* inst);
+static bool complete_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs);
+static bool error_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs);
 static struct os_callout range_callout_timer;
 static struct os_callout range_callout_postprocess;
+static struct os_eventq range_eventq;
+static struct os_task range_task_str;
+static os_stack_t range_task_stack[DW1000_DEV_TASK_STACK_SZ]
+    __attribute__((aligned(OS_STACK_ALIGNMENT)));
 
 /**
- * API to start ranging by sending the range request to the node_addr[] sequentially.
- * This function is called by the range_callout_timer callout from default queue.
+ * Points the node address and index lists at the storage following the exchange array.
  *
- * @param ev   Pointer to os_events.
+ * @param range   Pointer to dw1000_range_instance_t.
+ * @param nnodes  Number of nodes the block was allocated for.
  *
  * @return void
  */
+static void
+range_set_lists(dw1000_range_instance_t * range, uint16_t nnodes){
+    range->node_addr = (uint16_t *) &range->exchanges[nnodes];
+    range->rng_idx_list = &range->node_addr[nnodes];
+    range->pp_idx_list = &range->rng_idx_list[nnodes];
+}
+
+/**
+ * Returns the exchange currently waiting on the radio, if any.
+ *
+ * @param range  Pointer to dw1000_range_instance_t.
+ *
+ * @return dw1000_range_exchange_t*, NULL when no exchange is in flight
+ */
+static dw1000_range_exchange_t *
+range_current(dw1000_range_instance_t * range){
+    if (range->status.started == 0 || range->idx >= range->nnodes)
+        return NULL;
+    dw1000_range_exchange_t * ex = &range->exchanges[range->idx];
+    return (ex->state == RANGE_SCHEDULED) ? ex : NULL;
+}
 
+/**
+ * Round event. Gives each live node a slot at epoch + n * slot_period and requests its exchange with delayed
+ * transmission at the start of the slot. rng keeps one exchange in flight, so each request is written and armed as
+ * soon as the previous exchange completes, ahead of its slot. An exchange that misses its slot is marked failed
+ * and the rest of the round is rebased on the current time.
+ * This function is called by the range_callout_timer callout from the range task, which blocks for the round.
+ *
+ * @param ev   Pointer to os_events.
+ *
+ * @return void
+ */
 static void
 range_timer_ev_cb(struct os_event *ev) {
     assert(ev != NULL);
@@ -73,13 +112,84 @@ range_timer_ev_cb(struct os_event *ev) {
     
     assert(range->node_addr != NULL);
     assert(range->nnodes > 0);
-    
-    os_error_t err = os_sem_pend(&inst->range->sem,  OS_TIMEOUT_NEVER);
-    assert(err == OS_OK);
- 
-    dw1000_rng_request(inst, range->node_addr[range->idx++%range->nnodes], range->config.code);
 
     os_callout_reset(&range_callout_timer, OS_TICKS_PER_SEC * (range->period - MYNEWT_VAL(OS_LATENCY)) * 1e-6 );
+
+    uint64_t slot = (uint64_t) range->slot_period << 16;
+    uint64_t lead = (uint64_t) MYNEWT_VAL(RANGE_SCHED_LEAD) << 16;
+
+    for (uint16_t i = 0; i < range->nnodes; i++){
+        range->exchanges[i].state = RANGE_IDLE;
+        range->exchanges[i].late = 0;
+    }
+    range->rng_idx_cnt = 0;
+    range->status.start_tx_error = 0;
+    range->epoch = (dw1000_read_systime(inst) + lead) & 0xFFFFFFFFFFULL;
+
+    uint16_t n = 0;
+    for (range->idx = 0; range->idx < range->nnodes && range->status.started; range->idx++){
+        dw1000_range_exchange_t * ex = &range->exchanges[range->idx];
+
+#if MYNEWT_VAL(RNG_PEERS_ENABLED)
+        // Dead peers give their slot to the next node, they are retried every RNG_PEERS_RETRY
+        if (!rng_peers_alive(inst->rng->peers, ex->addr, os_cputime_ticks_to_usecs(os_cputime_get32()))){
+            ex->state = RANGE_SKIPPED;
+            continue;
+        }
+#endif
+        ex->tx_time = (range->epoch + n++ * slot) & 0xFFFFFFFFFFULL;
+        ex->state = RANGE_SCHEDULED;
+
+        if (dw1000_rng_request_delay_start(inst, ex->addr, ex->tx_time, range->config.code).start_tx_error){
+            ex->late = 1;
+            range->status.start_tx_error = 1;
+            range->epoch = (dw1000_read_systime(inst) + lead - n * slot) & 0xFFFFFFFFFFULL;
+        }
+        if (ex->state == RANGE_SCHEDULED)
+            ex->state = RANGE_FAILED;
+    }
+
+    if (range->config.postprocess){
+        uint16_t *temp;
+        temp = range->rng_idx_list;
+        range->rng_idx_list = range->pp_idx_list;
+        range->pp_idx_list = temp;
+        range->pp_idx_cnt = range->rng_idx_cnt;
+        range->rng_idx_cnt = 0;
+        os_eventq_put(os_eventq_dflt_get(), &range_callout_postprocess.c_ev);
+    }
+}
+
+static void
+range_task(void *arg)
+{
+    while (1) {
+        os_eventq_run(&range_eventq);
+    }
+}
+
+/**
+ * API to initialise the task running the rounds, below the priority of the dw1000 interrupt task that completes the
+ * exchanges. The default eventq is left free while a round blocks.
+ *
+ * @param inst   Pointer to dw1000_dev_instance_t.
+ *
+ * @return void
+ */
+static void
+range_task_init(dw1000_dev_instance_t *inst)
+{
+    /* Check if the task is already initiated */
+    if (!os_eventq_inited(&range_eventq))
+    {
+        os_eventq_init(&range_eventq);
+        os_task_init(&range_task_str, "dw1000_range",
+                     range_task,
+                     NULL,
+                     inst->task_prio + 0x5, OS_WAIT_FOREVER,
+                     range_task_stack,
+                     DW1000_DEV_TASK_STACK_SZ);
+    }
 }
 
 /**
@@ -94,89 +204,65 @@ static void
 range_timer_init(dw1000_dev_instance_t *inst) {
     assert(inst);
     assert(inst->range);
-    os_callout_init(&range_callout_timer, os_eventq_dflt_get(), range_timer_ev_cb, (void *) inst);
+    range_task_init(inst);
+    os_callout_init(&range_callout_timer, &range_eventq, range_timer_ev_cb, (void *) inst);
     os_callout_reset(&range_callout_timer, OS_TICKS_PER_SEC/100);
     dw1000_range_instance_t * range = inst->range; 
     range->status.timer_enabled = true;
 }
 
 /**
- * API to check for the type of packet received.
- * If the packet is of ranging type, then it calls range_postprocess by pushing into the event queue.
- * else the extension_cb->next function is called.
+ * API for the completion callback of the twr modules. Marks the exchange in flight as complete and records the rng
+ * frame holding its result.
  *
  * @param inst   Pointer to dw1000_dev_instance_t. 
+ * @param cbs    Pointer to dw1000_mac_interface_t.
  *
  * @return bool
  */
-
-static bool range_complete_cb(dw1000_dev_instance_t *inst){
-    if(inst->fctrl != FCNTL_IEEE_RANGE_16){
+static bool
+complete_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs){
+    if(inst->fctrl != FCNTL_IEEE_RANGE_16)
         return false;
-    }
-    assert(inst);
-    assert(inst->range);
-    dw1000_range_instance_t *range = inst->range;
-    if(range->status.started == 1){
-        range->rng_idx_list[(range->rng_idx_cnt++)%range->nnodes] = ((inst->rng->idx)%inst->rng->nframes);
-        if(range->config.postprocess && ((range->idx%range->nnodes) == 0)){
-            uint16_t *temp;
-            temp = range->rng_idx_list;
-            range->rng_idx_list = range->pp_idx_list;
-            range->pp_idx_list = temp;
-            range->pp_idx_cnt = range->rng_idx_cnt;
-            range->rng_idx_cnt = 0;
-            os_eventq_put(os_eventq_dflt_get(), &range_callout_postprocess.c_ev);
-        }
-    }
-    return true;
-}
 
-/**
- * This is an internal static function called when an error occured in the receiving the correct range packet.
- * If the error occured during the range process then, then range postprocess is pushed into the event queue 
- * else the extension_cb->next function is called.
- *
- * @param inst   Pointer to dw1000_dev_instance_t. 
- *
- * @return bool
- */
+    dw1000_range_instance_t * range = inst->range;
+    dw1000_range_exchange_t * ex = range_current(range);
+    if (ex == NULL)
+        return false;
 
-static bool range_error_cb(dw1000_dev_instance_t *inst){
-    assert(inst);
-    if(inst->fctrl != FCNTL_IEEE_RANGE_16){
+    dw1000_rng_instance_t * rng = inst->rng;
+    uint16_t idx = rng->idx % rng->nframes;
+    twr_frame_t * frame = rng->frames[idx];
+    if (frame->src_address != ex->addr && frame->dst_address != ex->addr)
         return false;
-    }
-    assert(inst->range);
-    dw1000_range_instance_t *range = inst->range;
-    if(range->status.started == 1){
-        if(range->config.postprocess && ((range->idx%range->nnodes) == 0)){
-            uint16_t *temp;
-            temp = range->rng_idx_list;
-            range->rng_idx_list = range->pp_idx_list;
-            range->pp_idx_list = temp;
-            range->pp_idx_cnt = range->rng_idx_cnt;
-            range->rng_idx_cnt = 0;
-            os_eventq_put(os_eventq_dflt_get(), &range_callout_postprocess.c_ev);
-        }
-    }
-    return true;
+
+    ex->frame_idx = idx;
+#if MYNEWT_VAL(RNG_CACHE_ENABLED)
+    ex->result = rng_cache_find(rng->cache, ex->addr, frame->seq_num - (frame->code != DWT_SS_TWR_FINAL));
+#endif
+    ex->state = RANGE_COMPLETE;
+    range->rng_idx_list[range->rng_idx_cnt++ % range->nnodes] = idx;
+    return false;
 }
 
 /**
- * API for range transmit complete callback.
+ * This is an internal static function called on a receive timeout, receive error or reset of the rng interface.
+ * The exchange in flight, if any, is marked as failed; the round continues with the next node.
  *
  * @param inst   Pointer to dw1000_dev_instance_t. 
+ * @param cbs    Pointer to dw1000_mac_interface_t.
  *
  * @return bool
  */
-
 static bool
-range_tx_complete_cb(dw1000_dev_instance_t* inst){
-    if(inst->fctrl != FCNTL_IEEE_RANGE_16){
+error_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs){
+    if(inst->fctrl != FCNTL_IEEE_RANGE_16)
         return false;
-    }
-    return true;
+
+    dw1000_range_exchange_t * ex = range_current(inst->range);
+    if (ex != NULL)
+        ex->state = RANGE_FAILED;
+    return false;
 }
 
 /**
@@ -205,21 +291,47 @@ static void range_reg_postprocess(dw1000_dev_instance_t * inst, os_event_fn * rn
  */
 
 static void postprocess(struct os_event * ev){
-	assert(ev != NULL);
-	assert(ev->ev_arg != NULL);
-
-        dw1000_dev_instance_t * inst = (dw1000_dev_instance_t *)ev->ev_arg;
-        dw1000_range_instance_t *range = inst->range;
-        
-        if(range->postprocess != NULL)
-            range->postprocess(ev);
-        
-        for(uint16_t i = 0 ; i < inst->range->nnodes ; i++)
-            os_sem_release(&range->sem);
+    assert(ev != NULL);
+    assert(ev->ev_arg != NULL);
+
+    dw1000_dev_instance_t * inst = (dw1000_dev_instance_t *)ev->ev_arg;
+    dw1000_range_instance_t *range = inst->range;
+
+    if(range->postprocess != NULL)
+        range->postprocess(ev);
+}
+
+/**
+ * API to compute the spacing between the start of consecutive exchanges in a round: every frame of the exchange
+ * plus its turnaround, and a guard band covering the MAC task latency after completion.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @param code  Ranging mode.
+ *
+ * @return Slot period in usec
+ */
+uint32_t
+dw1000_range_slot_period(dw1000_dev_instance_t * inst, dw1000_rng_modes_t code){
+    dw1000_rng_config_t * config = dw1000_rng_get_config(inst, code);
+    uint16_t nframes = 4;
+    uint16_t nlen = sizeof(twr_frame_final_t);
+
+    switch (code){
+        case DWT_SS_TWR:
+            nframes = 3;
+            break;
+        case DWT_DS_TWR_EXT:
+            nlen = sizeof(twr_frame_t);
+            break;
+        default:
+            break;
+    }
+    return nframes * (dw1000_phy_frame_duration(&inst->attrib, nlen) + config->tx_holdoff_delay)
+            + MYNEWT_VAL(RANGE_SLOT_GUARD);
 }
 
 /**
- * API to initialise various parameters of range instance like status bits, semaphores,callbacks, ext_callbacks, postprocess. 
+ * API to initialise various parameters of range instance like status bits, callbacks and postprocess. 
  *
  * @param inst       Pointer to dw1000_dev_instance_t. 
  * @param nnodes     Number of nodes to range with.
@@ -230,12 +342,10 @@ static void postprocess(struct os_event * ev){
 dw1000_range_instance_t * 
 dw1000_range_init(dw1000_dev_instance_t * inst, uint16_t nnodes, uint16_t node_addr[]){
     assert(inst);
-    dw1000_extension_callbacks_t range_cbs;
     if (inst->range == NULL ) {
-        inst->range = (dw1000_range_instance_t *) malloc(sizeof(dw1000_range_instance_t) + 
-        nnodes * sizeof(uint16_t) + nnodes * sizeof(uint16_t) + nnodes * sizeof(uint16_t)); 
+        inst->range = (dw1000_range_instance_t *) malloc(RANGE_ALLOC_SIZE(nnodes)); 
         assert(inst->range);
-        memset(inst->range, 0, sizeof(dw1000_range_instance_t));
+        memset(inst->range, 0, RANGE_ALLOC_SIZE(nnodes));
         inst->range->status.selfmalloc = 1;
         inst->range->nnodes = nnodes;
         inst->range->idx = 0;
@@ -246,29 +356,27 @@ dw1000_range_init(dw1000_dev_instance_t * inst, uint16_t nnodes, uint16_t node_a
         assert(inst->range->nnodes == nnodes);
     }
 
-    os_error_t err = os_sem_init(&inst->range->sem, inst->range->nnodes);
-    assert(err == OS_OK);
     inst->range->parent = inst;
     inst->range->period = MYNEWT_VAL(RANGE_PERIOD);
     inst->range->config = (dw1000_range_config_t){
         .postprocess = false,
         .code = DWT_DS_TWR,
     };
+    inst->range->slot_period = dw1000_range_slot_period(inst, inst->range->config.code);
 
-    inst->range->node_addr = &inst->range->var_mem_block[0];
-    inst->range->rng_idx_list = &inst->range->var_mem_block[nnodes];
-    inst->range->pp_idx_list = &inst->range->var_mem_block[nnodes + nnodes];
-
+    range_set_lists(inst->range, nnodes);
     dw1000_range_set_nodes(inst, node_addr, nnodes);
 
-    range_cbs.rx_complete_cb = range_complete_cb;
-    range_cbs.tx_complete_cb = range_tx_complete_cb;
-    range_cbs.rx_timeout_cb =range_error_cb;
-    range_cbs.rx_error_cb = range_error_cb;
-    range_cbs.tx_error_cb = range_error_cb;
-    dw1000_range_set_ext_callbacks(inst, range_cbs);
+    inst->range->cbs = (dw1000_mac_interface_t){
+        .id = DW1000_RANGE,
+        .complete_cb = complete_cb,
+        .rx_timeout_cb = error_cb,
+        .rx_error_cb = error_cb,
+        .reset_cb = error_cb
+    };
+    dw1000_mac_append_interface(inst, &inst->range->cbs);
  
-   range_reg_postprocess(inst, &postprocess);
+    range_reg_postprocess(inst, &postprocess);
 
     inst->range->status.initialized = 1;
     return inst->range;
@@ -283,28 +391,18 @@ dw1000_range_init(dw1000_dev_instance_t * inst, uint16_t nnodes, uint16_t node_a
 void 
 dw1000_range_free(dw1000_dev_instance_t *inst){
     assert(inst);
-    dw1000_remove_extension_callbacks(inst, DW1000_RANGE);
-    if (inst->range->status.selfmalloc)
+    if (inst->range->status.started)
+        dw1000_range_stop(inst);
+    dw1000_mac_remove_interface(inst, DW1000_RANGE);
+    if (inst->range->status.selfmalloc){
         free(inst->range);
-    else{
+        inst->range = NULL;
+    }else{
         inst->range->status.initialized = 0;
         inst->range->status.started = 0;
     }
 }
 
-/**
- * APi to register the extension call backs of ranging with the inst->extension_cb. 
- *
- * @param inst                                Pointer to dw1000_range_instance_t.
- * @param dw1000_remove_extension_callbacks   Set of extension type call backs.
- * @return void
- */
-void dw1000_range_set_ext_callbacks(dw1000_dev_instance_t * inst, dw1000_extension_callbacks_t range_cbs){
-    assert(inst);
-    range_cbs.id = DW1000_RANGE;
-    dw1000_add_extension_callbacks(inst, range_cbs);
-}
-
 /**
  * API to register range post process.
  *
@@ -335,12 +433,13 @@ dw1000_range_start(dw1000_dev_instance_t * inst, dw1000_rng_modes_t code){
     dw1000_range_instance_t * range = inst->range; 
     range->status.valid = false;
     range->config.code = code;
+    range->slot_period = dw1000_range_slot_period(inst, code);
     range->status.started = 1;
     range_timer_init(inst);
 }
 
 /**
- * API to stop the ranging. 
+ * API to stop the ranging. The round in progress ends after the exchange in flight.
  *
  * @param inst        Pointer to dw1000_range_instance_t.
  * @return void
@@ -354,7 +453,7 @@ dw1000_range_stop(dw1000_dev_instance_t * inst){
 }
 
 /**
- * API to initialise the range->node_addr pointer with the array of node addresses.
+ * API to set the node addresses of the exchanges.
  *
  * @param inst         Pointer to dw1000_range_instance_t.
  * @param node_add[]   Pointer to the array of node addresses.
@@ -366,13 +465,18 @@ dw1000_range_set_nodes(dw1000_dev_instance_t *inst, uint16_t node_addr[], uint16
 {
     assert(inst);
     assert(inst->range);
-    for(uint16_t i = 0;i < nnodes;i++)
+    for(uint16_t i = 0;i < nnodes;i++){
         inst->range->node_addr[i] = node_addr[i];
+        inst->range->exchanges[i] = (dw1000_range_exchange_t){
+            .addr = node_addr[i],
+            .state = RANGE_IDLE
+        };
+    }
 }
 
 /**
  * API to reallocate the memory for storing the node addresses based on the nnodes param.
- * Initialises the range structure with the default values.
+ * Initialises the range structure with the default values. Must not be called while a round is in progress.
  *
  * @param inst          Pointer to dw1000_range_instance_t.
  * @param node_addr[]   Pointer to the list of node addresses.
@@ -386,22 +490,19 @@ dw1000_range_reset_nodes(dw1000_dev_instance_t * inst, uint16_t node_addr[], uin
     assert(inst->range);
     
     if(nnodes > inst->range->nnodes){
-        inst->range = (dw1000_range_instance_t *)realloc(inst->range, sizeof(dw1000_range_instance_t) + 
-        nnodes * sizeof(uint16_t) + nnodes * sizeof(uint16_t) + nnodes * sizeof(uint16_t));
+        // The interface is embedded in the instance and must be relinked if realloc moves it
+        dw1000_mac_remove_interface(inst, DW1000_RANGE);
+        inst->range = (dw1000_range_instance_t *)realloc(inst->range, RANGE_ALLOC_SIZE(nnodes));
         assert(inst->range);
-
-        inst->range->node_addr = &inst->range->var_mem_block[0];
-        inst->range->rng_idx_list = &inst->range->var_mem_block[nnodes];
-        inst->range->pp_idx_list = &inst->range->var_mem_block[nnodes + nnodes];
+        dw1000_mac_append_interface(inst, &inst->range->cbs);
     }
     inst->range->idx = 0;
     inst->range->nnodes = nnodes;
     inst->range->rng_idx_cnt = 0;
     inst->range->pp_idx_cnt = 0;
 
+    range_set_lists(inst->range, nnodes);
     dw1000_range_set_nodes(inst, node_addr, nnodes);
-    os_error_t err = os_sem_init(&inst->range->sem, inst->rng->nframes/2);
-    assert(err == OS_OK);
 }
 
 /**
@@ -48,6 +48,15 @@ extern "C" {
 #include <dw1000/triad.h>
 #include <stats/stats.h>
 #include <rng/slots.h>
+#if MYNEWT_VAL(RNG_STREAM_ENABLED)
+#include <rng/rng_stream.h>
+#endif
+#if MYNEWT_VAL(RNG_PEERS_ENABLED)
+#include <rng/rng_peers.h>
+#endif
+#if MYNEWT_VAL(RNG_FILTER_ENABLED)
+#include <dsp/rngfilt.h>
+#endif
 
 STATS_SECT_START(rng_stat_section)
     STATS_SECT_ENTRY(rng_request)
@@ -71,6 +80,20 @@ typedef struct _dw1000_rng_config_t{
    uint16_t bias_correction:1;       //!< Enable range bias correction polynomial
 }dw1000_rng_config_t;
 
+#define RNG_BIAS_LUT_SIZE 17                //!< Entries in the range bias correction table
+
+//! Range bias correction table, bias against received signal level.
+typedef struct _dw1000_rng_bias_lut_t{
+    int16_t pr_max;                         //!< Signal level of the first entry, dBm Q8
+    uint16_t step;                          //!< Signal level decrease between entries, dB Q8
+    int16_t pr_ref;                         //!< Estimated signal level at 1 m, dBm Q8
+    uint8_t prf;                            //!< PRF the table was built for
+    uint8_t channel;                        //!< Channel the table was built for
+    uint8_t nsize:7;                        //!< Entries in use
+    uint8_t calibrated:1;                   //!< Loaded from calibration data, not rebuilt on config change
+    int16_t bias[RNG_BIAS_LUT_SIZE];        //!< Range bias, mm
+}dw1000_rng_bias_lut_t;
+
 //! Range control parameters.
 typedef struct _dw1000_rng_control_t{
     uint16_t delay_start_enabled:1;  //!< Set for enabling delayed start
@@ -120,6 +143,8 @@ typedef struct _twr_data_t{
                 triad_t spherical_variance;         //!< Measurement variance triad 
                 triad_t cartesian;                  //!< Position triad local coordinates
           //      triad_t cartesian_variance;       //!< Position estimated variance triad 
+                float filtered_range;               //!< Range of the peer filter on the initiator, m
+                float filtered_variance;            //!< Variance of filtered_range, -1 when not filtered
 }twr_data_t;
 
 //! TWR frame format
@@ -151,10 +176,27 @@ typedef struct _dw1000_rng_instance_t{
     dw1000_rng_status_t status;             //!< Structure of range status
     uint16_t idx;                           //!< Indicates number of instances for the chosen bsp
     uint16_t nframes;                       //!< Number of buffers defined to store the ranging data
+    dw1000_rng_bias_lut_t bias;             //!< Range bias correction table
+#if MYNEWT_VAL(RNG_STREAM_ENABLED)
+    rng_stream_t * stream;                  //!< Range result stream
+#endif
+#if MYNEWT_VAL(RNG_PEERS_ENABLED)
+    rng_peers_t * peers;                    //!< Per-peer ranging statistics
+#endif
+#if MYNEWT_VAL(RNG_CACHE_ENABLED)
+    struct _rng_cache_t * cache;            //!< Results by peer and sequence number, see rng/rng_cache.h
+#endif
+#if MYNEWT_VAL(RNG_PAYLOAD_ENABLED)
+    struct _rng_payload_t * payload;        //!< Application payload, see rng/rng_payload.h
+#endif
+#if MYNEWT_VAL(RNG_FILTER_ENABLED)
+    rngfilt_instance_t * filter;            //!< Per-peer range filter bank
+#endif
     twr_frame_t * frames[];                 //!< Pointer to twr buffers
 }dw1000_rng_instance_t; 
 
 void rng_pkg_init(void);
+int rng_cli_register(void);
 dw1000_rng_instance_t * dw1000_rng_init(dw1000_dev_instance_t * inst, dw1000_rng_config_t * config, uint16_t nframes);
 void dw1000_rng_free(dw1000_rng_instance_t * inst);
 dw1000_dev_status_t dw1000_rng_config(dw1000_dev_instance_t * inst, dw1000_rng_config_t * config);
@@ -162,10 +204,13 @@ dw1000_dev_status_t dw1000_rng_request(dw1000_dev_instance_t * inst, uint16_t ds
 dw1000_dev_status_t dw1000_rng_listen(dw1000_dev_instance_t * inst, dw1000_dev_modes_t mode);
 dw1000_dev_status_t dw1000_rng_request_delay_start(dw1000_dev_instance_t * inst, uint16_t dst_address, uint64_t delay, dw1000_rng_modes_t protocal);
 dw1000_rng_config_t * dw1000_rng_get_config(dw1000_dev_instance_t * inst, dw1000_rng_modes_t code);
+void dw1000_rng_write_tx(dw1000_dev_instance_t * inst, twr_frame_t * frame, uint16_t len);
 void dw1000_rng_set_frames(dw1000_dev_instance_t * inst, twr_frame_t twr[], uint16_t nframes);
 #if MYNEWT_VAL(DW1000_RANGE)
+int32_t dw1000_rng_twr_to_tof_ps(twr_frame_t *fframe, twr_frame_t *nframe);
 float dw1000_rng_twr_to_tof(twr_frame_t *fframe, twr_frame_t *nframe);
 #else
+int32_t dw1000_rng_twr_to_tof_ps(dw1000_rng_instance_t * rng, uint16_t idx);
 float dw1000_rng_twr_to_tof(dw1000_rng_instance_t * rng, uint16_t idx);
 #endif
 float dw1000_rng_tof_to_meters(float ToF); 
@@ -173,6 +218,10 @@ float dw1000_rng_tof_to_meters(float ToF);
 
 float dw1000_rng_path_loss(float Pt, float G, float fc, float R);
 float dw1000_rng_bias_correction(dw1000_dev_instance_t * inst, float Pr);
+void dw1000_rng_bias_lut_build(dw1000_dev_instance_t * inst);
+void dw1000_rng_bias_lut_load(dw1000_dev_instance_t * inst, int16_t pr_max, uint16_t step, const int16_t bias[], uint8_t nsize);
+int16_t dw1000_rng_rx_level(dw1000_dev_instance_t * inst, int32_t range);
+int16_t dw1000_rng_bias_mm(dw1000_dev_instance_t * inst, int16_t pr);
 uint32_t dw1000_rng_twr_to_tof_sym(twr_frame_t twr[], dw1000_rng_modes_t code);
 
 #ifdef __cplusplus
@@ -0,0 +1,100 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file rng_cache.h
+ * @author paul kettle
+ * @date 2018
+ * @brief Ranging result cache
+ *
+ * @details The rng frame ring remains the working storage of the exchange in flight; it advances on every received
+ * frame, so the frames of an exchange are overwritten a few frames later. The cache keeps a copy of the first and final
+ * frames of each exchange once it completes, keyed by peer address and the sequence number of its request, so that its
+ * result can still be read after the ring has moved on. One exchange is in flight at a time, initiated or responded to:
+ * while it is pending, rng drops the ranging frames of any other (peer, seq_num) rather than let them overwrite the
+ * ring. Lookup is a hash probe, see dsp/keytab; when the cache is full the oldest entry that is not pending is
+ * reused.
+ */
+
+#ifndef _RNG_CACHE_H_
+#define _RNG_CACHE_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <rng/rng.h>
+#include <dsp/keytab.h>
+
+//! Result state
+typedef enum _rng_result_state_t{
+    RNG_RESULT_FREE = 0,                    //!< Not in use
+    RNG_RESULT_PENDING,                     //!< Exchange in flight
+    RNG_RESULT_COMPLETE,                    //!< Final frame exchanged, frames valid
+    RNG_RESULT_FAILED,                      //!< Timeout or error
+}rng_result_state_t;
+
+//! Cached result of one exchange
+typedef struct _rng_result_t{
+    uint16_t addr;                          //!< Short address of the peer
+    uint8_t seq_num;                        //!< Sequence number of the request
+    rng_result_state_t state:8;             //!< Result state
+    uint32_t utime;                         //!< Time of the last state change, usec
+    uint32_t age;                           //!< Allocation order, for reuse
+    twr_frame_t first;                      //!< First frame of the exchange, valid when complete
+    twr_frame_t final;                      //!< Final frame of the exchange, valid when complete
+}rng_result_t;
+
+//! Cache status parameters
+typedef struct _rng_cache_status_t{
+    uint16_t selfmalloc:1;                  //!< Internal flag for memory garbage collection
+    uint16_t initialized:1;                 //!< Instance allocated
+}rng_cache_status_t;
+
+//! Result cache
+typedef struct _rng_cache_t{
+    rng_cache_status_t status;              //!< Cache status
+    uint16_t nresults;                      //!< Cache size
+    uint32_t age;                           //!< Entries allocated, free running
+    rng_result_t * current;                 //!< Exchange in flight on this node, initiated or responded to
+    keytab_t tab;                           //!< Hash table of indices into results[]
+    rng_result_t results[];                 //!< Entries, followed by the hash table
+}rng_cache_t;
+
+rng_cache_t * rng_cache_init(rng_cache_t * cache, uint16_t nresults);
+void rng_cache_free(rng_cache_t * cache);
+rng_result_t * rng_cache_open(rng_cache_t * cache, uint16_t addr, uint8_t seq_num, uint32_t utime);
+rng_result_t * rng_cache_find(rng_cache_t * cache, uint16_t addr, uint8_t seq_num);
+void rng_cache_complete(rng_cache_t * cache, rng_result_t * result, const twr_frame_t * first,
+        const twr_frame_t * final, uint32_t utime);
+void rng_cache_fail(rng_cache_t * cache, rng_result_t * result, uint32_t utime);
+void rng_cache_release(rng_cache_t * cache, rng_result_t * result);
+int32_t dw1000_rng_result_tof_ps(dw1000_rng_instance_t * rng, const rng_result_t * result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RNG_CACHE_H_ */
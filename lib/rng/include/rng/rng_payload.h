@@ -0,0 +1,99 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file rng_payload.h
+ * @author paul kettle
+ * @date 2018
+ * @brief Application payload carried by ranging frames
+ *
+ * @details An application queues a payload with rng_payload_send(); it is appended to the next ranging frame of any
+ * mode written with dw1000_rng_write_tx() to the given peer, or to any peer for BROADCAST_ADDRESS. The receiving side
+ * recognises the payload as bytes past the nominal length of the frame code, hands them to the registered callback
+ * from the MAC task and strips them before the twr modules see the frame.
+ *
+ * Size limits. Every payload byte adds 8 * Tdsym to the frame, about 1.18 usec at 6.8 Mbps and 9.4 usec at 850 kbps
+ * with Reed-Solomon coding. The receive timeout of every frame other than a request is computed by the other side for
+ * the nominal frame length, plus the rx_timeout_period of the ranging mode; the payload must fit that slack or the
+ * receiver times out mid-frame. With the default 16 usec rx_timeout_period this is 13 bytes at 6.8 Mbps and 1 byte at 850 kbps;
+ * raise the rx_timeout_period of the mode (TWR_*_RX_TIMEOUT) for larger payloads. Requests are received without a
+ * timeout, but the responder schedules its response tx_holdoff_delay after the start of the request, so the payload of
+ * a request must fit the holdoff left once the responder has processed the nominal request, RNG_PAYLOAD_PROCESSING
+ * past its end. A payload that does not fit a frame is held for a later one, see rng_payload_limit().
+ */
+
+#ifndef _RNG_PAYLOAD_H_
+#define _RNG_PAYLOAD_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stats/stats.h>
+#include <rng/rng.h>
+
+STATS_SECT_START(rng_payload_stat_section)
+    STATS_SECT_ENTRY(tx)
+    STATS_SECT_ENTRY(rx)
+    STATS_SECT_ENTRY(held)
+    STATS_SECT_ENTRY(rejected)
+STATS_SECT_END
+
+//! Receive callback, called from the MAC task
+typedef void (*rng_payload_cb_t)(dw1000_dev_instance_t * inst, uint16_t src_address, uint16_t code,
+        const uint8_t * data, uint16_t len, void * arg);
+
+//! Payload status parameters
+typedef struct _rng_payload_status_t{
+    uint16_t selfmalloc:1;                  //!< Internal flag for memory garbage collection
+    uint16_t initialized:1;                 //!< Instance allocated
+}rng_payload_status_t;
+
+//! Outgoing payload and receive callback
+typedef struct _rng_payload_t{
+    rng_payload_status_t status;                        //!< Payload status
+    STATS_SECT_DECL(rng_payload_stat_section) stat;     //!< Payload statistics
+    uint16_t dst_address;                               //!< Peer the payload is for, BROADCAST_ADDRESS for any
+    volatile uint16_t len;                              //!< Queued bytes, 0 when none
+    rng_payload_cb_t rx_cb;                             //!< Receive callback
+    void * rx_arg;                                      //!< Receive callback argument
+    uint8_t data[MYNEWT_VAL(RNG_PAYLOAD_MAX)];          //!< Queued bytes
+}rng_payload_t;
+
+rng_payload_t * rng_payload_init(rng_payload_t * payload, const char * name);
+void rng_payload_free(rng_payload_t * payload);
+void rng_payload_set_cb(rng_payload_t * payload, rng_payload_cb_t cb, void * arg);
+int rng_payload_send(rng_payload_t * payload, uint16_t dst_address, const void * data, uint16_t len);
+void rng_payload_cancel(rng_payload_t * payload);
+uint16_t rng_payload_frame_len(uint16_t code);
+uint16_t rng_payload_limit(dw1000_dev_instance_t * inst, uint16_t code);
+uint16_t rng_payload_attach(dw1000_dev_instance_t * inst, twr_frame_t * frame, uint16_t len);
+void rng_payload_strip(dw1000_dev_instance_t * inst);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RNG_PAYLOAD_H_ */
@@ -0,0 +1,132 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file rng_peers.h
+ * @author paul kettle
+ * @date 2018
+ * @brief Per-peer ranging statistics
+ *
+ * @details Tracks the health of every peer this node initiates ranging with: attempts, outcomes, exchange duration and
+ * the signal quality of the last success. Peers are kept in a bounded table keyed by short address; when it is full
+ * the least recently active peer is evicted. A peer that fails RNG_PEERS_DEAD_FAILS exchanges in a row is reported
+ * dead, and only offered to the scheduler again once every RNG_PEERS_RETRY usec.
+ */
+
+#ifndef _RNG_PEERS_H_
+#define _RNG_PEERS_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stats/stats.h>
+#include <dsp/keytab.h>
+#if MYNEWT_VAL(RNG_TIMEOUT_ENABLED)
+#include <rng/rng_timeout.h>
+#endif
+
+#define RNG_PEERS_NONE 0xFFFF               //!< No exchange in flight
+#define RNG_PEERS_RSSI_INVALID INT16_MIN    //!< rssi/fppl value when rx diagnostics are disabled
+
+STATS_SECT_START(rng_peers_stat_section)
+    STATS_SECT_ENTRY(attempts)
+    STATS_SECT_ENTRY(successes)
+    STATS_SECT_ENTRY(timeouts)
+    STATS_SECT_ENTRY(rx_errors)
+    STATS_SECT_ENTRY(tx_errors)
+    STATS_SECT_ENTRY(dead)
+    STATS_SECT_ENTRY(skipped)
+    STATS_SECT_ENTRY(evictions)
+STATS_SECT_END
+
+//! Outcome of a failed exchange
+typedef enum _rng_peer_fail_t{
+    RNG_PEER_TIMEOUT,                       //!< No response
+    RNG_PEER_RX_ERROR,                      //!< Response received in error
+    RNG_PEER_TX_ERROR,                      //!< Request not transmitted
+}rng_peer_fail_t;
+
+//! Statistics of one peer
+typedef struct _rng_peer_stats_t{
+    uint16_t addr;                          //!< Short address of the peer
+    uint16_t fails;                         //!< Consecutive failed exchanges
+    uint32_t attempts;                      //!< Exchanges initiated
+    uint32_t successes;                     //!< Exchanges completed
+    uint32_t timeouts;                      //!< Exchanges ended by a receive timeout
+    uint32_t rx_errors;                     //!< Exchanges ended by a receive error
+    uint32_t tx_errors;                     //!< Requests that failed to transmit
+    uint32_t utime;                         //!< Last attempt, usec
+    uint32_t last_success;                  //!< Last success, usec
+    float turnaround;                       //!< Mean exchange duration, request to completion, usec
+    float turnaround_m2;                    //!< Sum of squared deviations of the exchange duration, usec^2
+    int16_t rssi;                           //!< Received signal level of the last success, cdBm
+    int16_t fppl;                           //!< First path power level of the last success, cdBm
+    uint8_t los;                            //!< Line-of-sight estimate of the last success, 0 (NLOS) to 255 (LOS)
+#if MYNEWT_VAL(RNG_TIMEOUT_ENABLED)
+    rng_timeout_t timeout;                  //!< Response turnaround window, sets the adaptive timeout
+#endif
+}rng_peer_stats_t;
+
+//! Table status parameters
+typedef struct _rng_peers_status_t{
+    uint16_t selfmalloc:1;                  //!< Internal flag for memory garbage collection
+    uint16_t initialized:1;                 //!< Instance allocated
+}rng_peers_status_t;
+
+//! Per-peer statistics table
+typedef struct _rng_peers_t{
+    rng_peers_status_t status;                      //!< Table status
+    STATS_SECT_DECL(rng_peers_stat_section) stat;   //!< Totals across peers
+    uint16_t npeers;                                //!< Peers in use
+    uint16_t cap;                                   //!< Maximum number of peers
+    uint16_t pending;                               //!< Peer of the exchange in flight, RNG_PEERS_NONE if none
+    uint32_t t0;                                    //!< Start of the exchange in flight, usec
+#if MYNEWT_VAL(RNG_TIMEOUT_ENABLED)
+    rng_timeout_acct_t timeout;                     //!< Adaptive timeout in flight and totals
+#endif
+    keytab_t tab;                                   //!< Hash table of indices into peers[]
+    rng_peer_stats_t peers[];                       //!< Peer statistics, followed by the hash table
+}rng_peers_t;
+
+rng_peers_t * rng_peers_init(rng_peers_t * peers, uint16_t cap, const char * name);
+void rng_peers_free(rng_peers_t * peers);
+void rng_peers_clear(rng_peers_t * peers);
+rng_peer_stats_t * rng_peers_lookup(rng_peers_t * peers, uint16_t addr);
+void rng_peers_start(rng_peers_t * peers, uint16_t addr, uint32_t utime);
+void rng_peers_success(rng_peers_t * peers, uint16_t addr, uint32_t utime, int16_t rssi, int16_t fppl, uint8_t los);
+void rng_peers_fail(rng_peers_t * peers, rng_peer_fail_t reason);
+bool rng_peers_alive(rng_peers_t * peers, uint16_t addr, uint32_t utime);
+bool rng_peers_dead(const rng_peer_stats_t * peer);
+#if MYNEWT_VAL(RNG_TIMEOUT_ENABLED)
+uint16_t rng_peers_rx_timeout(rng_peers_t * peers, uint16_t nominal, uint16_t fixed);
+void rng_peers_response(rng_peers_t * peers, uint16_t addr, uint16_t turnaround);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RNG_PEERS_H_ */
@@ -0,0 +1,98 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file rng_stream.h
+ * @author paul kettle
+ * @date 2018
+ * @brief Range result stream
+ *
+ * @details Single producer, multiple consumer ring of compact range records. The producer (the MAC task of the device)
+ * never blocks; each subscriber keeps its own read index and is told how many records it lost when it falls more than a
+ * ring behind.
+ */
+
+#ifndef _RNG_STREAM_H_
+#define _RNG_STREAM_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <os/os.h>
+#include <os/queue.h>
+
+#define RNG_STREAM_RSSI_INVALID INT16_MIN   //!< rssi/fppl value when rx diagnostics are disabled
+
+//! Compact range record
+typedef struct _rng_record_t{
+    uint32_t utime;                 //!< Completion time, usec
+    uint16_t peer;                  //!< Short address of the remote node
+    uint8_t seq_num;                //!< Sequence number of the final frame
+    uint8_t code;                   //!< Ranging mode of the final frame
+    int32_t tof;                    //!< Time of flight, ps
+    int32_t range;                  //!< Range, mm
+    int16_t rssi;                   //!< Received signal level, cdBm
+    int16_t fppl;                   //!< First path power level, cdBm
+    uint8_t los;                    //!< Line-of-sight estimate, 0 (NLOS) to 255 (LOS)
+}rng_record_t;
+
+//! Stream subscriber
+typedef struct _rng_subscriber_t{
+    SLIST_ENTRY(_rng_subscriber_t) next;    //!< Next subscriber
+    uint32_t tail;                          //!< Read index, free running
+    uint32_t drops;                         //!< Records overwritten before this subscriber read them
+    struct os_eventq * eventq;              //!< Optional queue notified on publish
+    struct os_event event;                  //!< Notification event
+}rng_subscriber_t;
+
+//! Stream status parameters
+typedef struct _rng_stream_status_t{
+    uint16_t selfmalloc:1;          //!< Internal flag for memory garbage collection
+    uint16_t initialized:1;         //!< Instance allocated
+}rng_stream_status_t;
+
+//! Range result stream
+typedef struct _rng_stream_t{
+    rng_stream_status_t status;                     //!< Stream status
+    volatile uint32_t head;                         //!< Records committed, free running
+    volatile uint32_t reserve;                      //!< Records claimed by the producer, free running
+    uint16_t mask;                                  //!< nrecords - 1
+    SLIST_HEAD(, _rng_subscriber_t) subscribers;    //!< Registered subscribers
+    rng_record_t records[];                         //!< Ring storage
+}rng_stream_t;
+
+rng_stream_t * rng_stream_init(rng_stream_t * stream, uint16_t nrecords);
+void rng_stream_free(rng_stream_t * stream);
+void rng_stream_publish(rng_stream_t * stream, const rng_record_t * record);
+void rng_stream_subscribe(rng_stream_t * stream, rng_subscriber_t * sub, struct os_eventq * eventq, os_event_fn * cb, void * arg);
+void rng_stream_unsubscribe(rng_stream_t * stream, rng_subscriber_t * sub);
+bool rng_stream_read(rng_stream_t * stream, rng_subscriber_t * sub, rng_record_t * record);
+uint32_t rng_stream_pending(rng_stream_t * stream, rng_subscriber_t * sub);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RNG_STREAM_H_ */
@@ -0,0 +1,87 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file rng_timeout.h
+ * @author paul kettle
+ * @date 2018
+ * @brief Adaptive receive timeouts
+ *
+ * @details The response timeout of a request is normally the static rx_timeout_period plus tx_holdoff_delay of the
+ * ranging mode. Instead, the turnaround of each responder, request transmission to response reception, is kept over a
+ * window of recent exchanges and the timeout is set to a percentile of that window plus a margin. Every timeout that
+ * expires doubles the next one, up to RNG_TIMEOUT_MAX, so a responder slower than its window is found again; a
+ * response resets the backoff. Until RNG_TIMEOUT_MIN_SAMPLES turnarounds are known the static timeout is used.
+ *
+ * Receiver-on time is only saved when a timeout expires, a response ends reception either way; saved_usec counts the
+ * difference to the static timeout over expired timeouts.
+ */
+
+#ifndef _RNG_TIMEOUT_H_
+#define _RNG_TIMEOUT_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stats/stats.h>
+
+STATS_SECT_START(rng_timeout_stat_section)
+    STATS_SECT_ENTRY(adaptive)
+    STATS_SECT_ENTRY(nominal)
+    STATS_SECT_ENTRY(extended)
+    STATS_SECT_ENTRY(expired)
+    STATS_SECT_ENTRY(backoffs)
+    STATS_SECT_ENTRY(saved_usec)
+STATS_SECT_END
+
+//! Turnaround window of one responder
+typedef struct _rng_timeout_t{
+    uint16_t window[MYNEWT_VAL(RNG_TIMEOUT_WINDOW)];    //!< Recent turnarounds, usec
+    uint8_t head;                                       //!< Next sample in window[]
+    uint8_t nsamples;                                   //!< Samples in window[]
+    uint8_t backoff;                                    //!< Timeouts expired since the last response
+}rng_timeout_t;
+
+//! Timeout in flight and totals
+typedef struct _rng_timeout_acct_t{
+    STATS_SECT_DECL(rng_timeout_stat_section) stat;     //!< Totals
+    uint16_t nominal;                                   //!< Static timeout of the request in flight, usec
+    uint16_t applied;                                   //!< Timeout applied to the request in flight, usec
+    bool armed;                                         //!< Waiting for the response of the request in flight
+}rng_timeout_acct_t;
+
+int rng_timeout_acct_init(rng_timeout_acct_t * acct, const char * name);
+void rng_timeout_init(rng_timeout_t * est);
+uint16_t rng_timeout_percentile(const rng_timeout_t * est);
+uint16_t rng_timeout_select(rng_timeout_t * est, rng_timeout_acct_t * acct, uint16_t nominal, uint16_t fixed);
+void rng_timeout_sample(rng_timeout_t * est, rng_timeout_acct_t * acct, uint16_t turnaround);
+void rng_timeout_expired(rng_timeout_t * est, rng_timeout_acct_t * acct);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RNG_TIMEOUT_H_ */
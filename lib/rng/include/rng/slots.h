@@ -45,7 +45,8 @@ typedef enum _slot_mode_t{
 typedef enum _spot_ptype_t{     
     PTYPE_CELL=0,           //!< Cell network
     PTYPE_BITFIELD,       //!< single cell network
-    PTYPE_RANGE           //!< specify slots as a range
+    PTYPE_RANGE,          //!< specify slots as a range
+    PTYPE_MAP             //!< slots listed in a slot_map_t following the request
 }spot_ptype_t;
 
 typedef struct _slot_payload_t{
@@ -63,10 +64,28 @@ typedef struct _slot_payload_t{
     };
 }slot_payload_t;
 
+typedef enum _slot_map_format_t{
+    SLOT_MAP_BITMAP=0,      //!< data is a bitmap, bit k of byte j is slot base + 8j + k
+    SLOT_MAP_LIST           //!< data is an ascending list of slot offsets from base, one byte each
+}slot_map_format_t;
+
+//! Compressed slot map, addresses slots beyond the 30 bits of slot_payload_t
+typedef struct _slot_map_t{
+    uint8_t base;               //!< lowest slot id in the map
+    uint8_t format:1;           //!< slot_map_format_t
+    uint8_t len:7;              //!< length of data in bytes
+    uint8_t data[];             //!< bitmap or list
+}__attribute__((__packed__)) slot_map_t;
+
+#define SLOT_MAP_DATA_MAX 0x7F  //!< longest data field of a slot map
+
 
 uint32_t calc_nbits(uint32_t bitfield);
 uint32_t calc_slot_idx(uint32_t bitfield);
 uint32_t calc_nslots(uint32_t nslots_mask, uint32_t slot, slot_mode_t mode);
+uint16_t slot_map_encode(const uint16_t * slot_ids, uint16_t nslots, uint8_t * buf, uint16_t size);
+uint16_t slot_map_count(const uint8_t * buf, uint16_t size);
+uint16_t slot_map_position(const uint8_t * buf, uint16_t size, uint16_t slot_id);
 
 #ifdef __cplusplus
 }
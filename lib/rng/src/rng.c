@@ -46,12 +46,18 @@
 #include <dw1000/dw1000_phy.h>
 #include <dw1000/dw1000_ftypes.h>
 #include <dw1000/dw1000_stats.h>
-#include <dsp/polyval.h>
+#include <tof/tof.h>
 
 #if MYNEWT_VAL(RNG_ENABLED)
 #include <rng/rng.h>
 #include <rng/rng_encode.h>
 #endif
+#if MYNEWT_VAL(RNG_CACHE_ENABLED)
+#include <rng/rng_cache.h>
+#endif
+#if MYNEWT_VAL(RNG_PAYLOAD_ENABLED)
+#include <rng/rng_payload.h>
+#endif
 #if MYNEWT_VAL(TWR_DS_EXT_ENABLED)
 #include <twr_ds_ext/twr_ds_ext.h>
 #endif
@@ -80,6 +86,9 @@ STATS_NAME_START(rng_stat_section)
     STATS_NAME(rng_stat_section, reset)
 STATS_NAME_END(rng_stat_section)
 
+#define RNG_COMPLETE_CB (MYNEWT_VAL(RNG_VERBOSE) || MYNEWT_VAL(RNG_STREAM_ENABLED) || MYNEWT_VAL(RNG_FILTER_ENABLED) \
+        || MYNEWT_VAL(RNG_PEERS_ENABLED) || MYNEWT_VAL(RNG_CACHE_ENABLED))
+
 //#define DIAGMSG(s,u) printf(s,u)
 #ifndef DIAGMSG
 #define DIAGMSG(s,u)
@@ -89,32 +98,49 @@ static bool rx_complete_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t
 static bool tx_complete_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs);
 static bool reset_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs);
 static bool rx_timeout_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs);
-#if MYNEWT_VAL(RNG_VERBOSE)
+#if MYNEWT_VAL(RNG_PEERS_ENABLED) || MYNEWT_VAL(RNG_CACHE_ENABLED)
+static bool rx_error_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs);
+#endif
+#if MYNEWT_VAL(RNG_CACHE_ENABLED)
+static void rng_cache_abort(dw1000_dev_instance_t * inst);
+static bool rng_cache_admit(rng_cache_t * cache, twr_frame_t * frame);
+#endif
+#if RNG_COMPLETE_CB
 static bool complete_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs);
 #endif
 
-/*
-% From APS011 Table 2 
-rls = [-61,-63,-65,-67,-69,-71,-73,-75,-77,-79,-81,-83,-85,-87,-89,-91,-93];
-bias = [-11,-10.4,-10.0,-9.3,-8.2,-6.9,-5.1,-2.7,0,2.1,3.5,4.2,4.9,6.2,7.1,7.6,8.1]./100;
-p=polyfit(rls,bias,3) 
-mat2c(p,'rng_bias_poly_PRF64')
-bias = [-19.8,-18.7,-17.9,-16.3,-14.3,-12.7,-10.9,-8.4,-5.9,-3.1,0,3.6,6.5,8.4,9.7,10.6,11.0]./100;
-p=polyfit(rls,bias,3) 
-mat2c(p,'rng_bias_poly_PRF16')
-*/
-static float rng_bias_poly_PRF64[] ={
-     	1.404476e-03, 3.208478e-01, 2.349322e+01, 5.470342e+02, 
-     	};
-static float rng_bias_poly_PRF16[] ={
-     	1.754924e-05, 4.106182e-03, 3.061584e-01, 7.189425e+00, 
-     	};
+/**
+ * Range bias against received signal level, from APS011 Table 2. Entries run from -61 dBm down to -93 dBm in 2 dB
+ * steps and are in mm.
+ */
+static const int16_t rng_bias_PRF64[RNG_BIAS_LUT_SIZE] = {
+    -110, -104, -100, -93, -82, -69, -51, -27, 0, 21, 35, 42, 49, 62, 71, 76, 81
+};
+static const int16_t rng_bias_PRF16[RNG_BIAS_LUT_SIZE] = {
+    -198, -187, -179, -163, -143, -127, -109, -84, -59, -31, 0, 36, 65, 84, 97, 106, 110
+};
+
+//! log2(1 + k/16) in Q16, for the fixed-point path loss estimate
+static const uint16_t g_log2_q16[17] = {
+    0, 5732, 11136, 16248, 21098, 25711, 30109, 34312, 38336, 42196, 45904, 49472, 52911, 56229, 59434, 62534, 65535
+};
 
 static dw1000_rng_config_t g_config = {
     .tx_holdoff_delay = MYNEWT_VAL(RNG_TX_HOLDOFF),       // Send Time delay in usec.
     .rx_timeout_period = MYNEWT_VAL(RNG_RX_TIMEOUT)       // Receive response timeout in usec
 };
 
+#if MYNEWT_VAL(RNG_FILTER_ENABLED)
+static rngfilt_config_t g_filter_config = {
+    .range_variance = MYNEWT_VAL(RANGE_VARIANCE),
+    .accel_variance = MYNEWT_VAL(RNG_FILTER_ACCEL_VARIANCE),
+    .rate_variance = MYNEWT_VAL(RNG_FILTER_RATE_VARIANCE),
+    .gate = MYNEWT_VAL(RNG_FILTER_GATE),
+    .max_rejects = MYNEWT_VAL(RNG_FILTER_MAX_REJECTS),
+    .timeout = MYNEWT_VAL(RNG_FILTER_TIMEOUT)
+};
+#endif
+
 #if MYNEWT_VAL(DW1000_DEVICE_0)
 static twr_frame_t g_twr_0[] = {
     [0] = {
@@ -184,7 +210,10 @@ static dw1000_mac_interface_t g_cbs[] = {
             .rx_complete_cb = rx_complete_cb,
             .tx_complete_cb = tx_complete_cb,
             .rx_timeout_cb = rx_timeout_cb,
-#if MYNEWT_VAL(RNG_VERBOSE)
+#if MYNEWT_VAL(RNG_PEERS_ENABLED) || MYNEWT_VAL(RNG_CACHE_ENABLED)
+            .rx_error_cb = rx_error_cb,
+#endif
+#if RNG_COMPLETE_CB
             .complete_cb  = complete_cb,
 #endif
             .reset_cb = reset_cb
@@ -195,7 +224,10 @@ static dw1000_mac_interface_t g_cbs[] = {
             .rx_complete_cb = rx_complete_cb,
             .tx_complete_cb = tx_complete_cb,
             .rx_timeout_cb = rx_timeout_cb,
-#if MYNEWT_VAL(RNG_VERBOSE)
+#if MYNEWT_VAL(RNG_PEERS_ENABLED) || MYNEWT_VAL(RNG_CACHE_ENABLED)
+            .rx_error_cb = rx_error_cb,
+#endif
+#if RNG_COMPLETE_CB
             .complete_cb  = complete_cb,
 #endif
             .reset_cb = reset_cb
@@ -207,7 +239,10 @@ static dw1000_mac_interface_t g_cbs[] = {
             .rx_complete_cb = rx_complete_cb,
             .tx_complete_cb = tx_complete_cb,
             .rx_timeout_cb = rx_timeout_cb,
-#if MYNEWT_VAL(RNG_VERBOSE)
+#if MYNEWT_VAL(RNG_PEERS_ENABLED) || MYNEWT_VAL(RNG_CACHE_ENABLED)
+            .rx_error_cb = rx_error_cb,
+#endif
+#if RNG_COMPLETE_CB
             .complete_cb  = complete_cb,
 #endif
             .reset_cb = reset_cb
@@ -248,6 +283,37 @@ dw1000_rng_init(dw1000_dev_instance_t * inst, dw1000_rng_config_t * config, uint
         .delay_start_enabled = 0,
     };
     inst->rng->idx = 0xFFFF;
+    if (!inst->rng->bias.calibrated)
+        dw1000_rng_bias_lut_build(inst);
+#if MYNEWT_VAL(RNG_STREAM_ENABLED)
+    if (inst->rng->stream == NULL)
+        inst->rng->stream = rng_stream_init(NULL, MYNEWT_VAL(RNG_STREAM_SIZE));
+#endif
+#if MYNEWT_VAL(RNG_PAYLOAD_ENABLED)
+    if (inst->rng->payload == NULL){
+        static const char * payload_names[] = {"rng_payload", "rng1_payload", "rng2_payload"};
+        inst->rng->payload = rng_payload_init(NULL, payload_names[inst->idx % 3]);
+    }
+#endif
+#if MYNEWT_VAL(RNG_CACHE_ENABLED)
+    if (inst->rng->cache == NULL)
+        inst->rng->cache = rng_cache_init(NULL, MYNEWT_VAL(RNG_CACHE_SIZE));
+#endif
+#if MYNEWT_VAL(RNG_PEERS_ENABLED)
+    if (inst->rng->peers == NULL){
+        static const char * names[] = {"rng_peers", "rng1_peers", "rng2_peers"};
+        inst->rng->peers = rng_peers_init(NULL, MYNEWT_VAL(RNG_PEERS_NPEERS), names[inst->idx % 3]);
+#if MYNEWT_VAL(RNG_TIMEOUT_ENABLED)
+        static const char * timeout_names[] = {"rng_timeout", "rng1_timeout", "rng2_timeout"};
+        int rc = rng_timeout_acct_init(&inst->rng->peers->timeout, timeout_names[inst->idx % 3]);
+        assert(rc == 0);
+#endif
+    }
+#endif
+#if MYNEWT_VAL(RNG_FILTER_ENABLED)
+    if (inst->rng->filter == NULL)
+        inst->rng->filter = rngfilt_init(NULL, MYNEWT_VAL(RNG_FILTER_NPEERS), &g_filter_config);
+#endif
     inst->rng->status.initialized = 1;
     
     int rc = stats_init(
@@ -280,6 +346,30 @@ void
 dw1000_rng_free(dw1000_rng_instance_t * inst){
    
     assert(inst);  
+#if MYNEWT_VAL(RNG_STREAM_ENABLED)
+    if (inst->stream){
+        rng_stream_free(inst->stream);
+        inst->stream = NULL;
+    }
+#endif
+#if MYNEWT_VAL(RNG_FILTER_ENABLED)
+    if (inst->filter){
+        rngfilt_free(inst->filter);
+        inst->filter = NULL;
+    }
+#endif
+#if MYNEWT_VAL(RNG_PAYLOAD_ENABLED)
+    if (inst->payload){
+        rng_payload_free(inst->payload);
+        inst->payload = NULL;
+    }
+#endif
+#if MYNEWT_VAL(RNG_CACHE_ENABLED)
+    if (inst->cache){
+        rng_cache_free(inst->cache);
+        inst->cache = NULL;
+    }
+#endif
     if (inst->status.selfmalloc)
         free(inst);
     else
@@ -313,7 +403,8 @@ void rng_pkg_init(void){
     dw1000_rng_set_frames(hal_dw1000_inst(2), g_twr_2, sizeof(g_twr_2)/sizeof(twr_frame_t));
     dw1000_mac_append_interface(hal_dw1000_inst(2), &g_cbs[2]);
 #endif
-  
+    int rc = rng_cli_register();
+    assert(rc == 0);
 }
 
 /**
@@ -387,6 +478,26 @@ dw1000_rng_get_config(dw1000_dev_instance_t * inst, dw1000_rng_modes_t code){
     return config;
 }
 
+/**
+ * API to write a ranging frame to the transmit buffer and set its length, appending the queued application payload
+ * when it is for the peer of the frame.
+ *
+ * @param inst   Pointer to dw1000_dev_instance_t.
+ * @param frame  Frame to transmit.
+ * @param len    Frame length for its code.
+ *
+ * @return void
+ */
+void
+dw1000_rng_write_tx(dw1000_dev_instance_t * inst, twr_frame_t * frame, uint16_t len){
+    uint16_t payload_len = 0;
+#if MYNEWT_VAL(RNG_PAYLOAD_ENABLED)
+    payload_len = rng_payload_attach(inst, frame, len);
+#endif
+    dw1000_write_tx(inst, frame->array, 0, len);
+    dw1000_write_tx_fctrl(inst, len + payload_len, 0, true);
+}
+
 /**
  * API to initialise range request.
  *
@@ -424,14 +535,24 @@ dw1000_rng_request(dw1000_dev_instance_t * inst, uint16_t dst_address, dw1000_rn
 #if MYNEWT_VAL(CIR_ENABLED)   
     cir_enable(inst->cir, true);
 #endif 
+#if MYNEWT_VAL(RNG_PEERS_ENABLED)
+    rng_peers_start(rng->peers, dst_address, os_cputime_ticks_to_usecs(os_cputime_get32()));
+#endif
+#if MYNEWT_VAL(RNG_CACHE_ENABLED)
+    rng->cache->current = rng_cache_open(rng->cache, dst_address, frame->seq_num,
+            os_cputime_ticks_to_usecs(os_cputime_get32()));
+#endif
 
-    dw1000_write_tx(inst, frame->array, 0, sizeof(ieee_rng_request_frame_t));
-    dw1000_write_tx_fctrl(inst, sizeof(ieee_rng_request_frame_t), 0, true); 
+    dw1000_rng_write_tx(inst, frame, sizeof(ieee_rng_request_frame_t));
     dw1000_set_wait4resp(inst, true);    
    // dw1000_set_wait4resp_delay(inst, config->tx_holdoff_delay - dw1000_phy_SHR_duration(&inst->attrib));
     uint16_t timeout = dw1000_phy_frame_duration(&inst->attrib, sizeof(ieee_rng_response_frame_t)) 
                     + config->rx_timeout_period // At least 2 * ToF, 1us ~= 300m
                     + config->tx_holdoff_delay;
+#if MYNEWT_VAL(RNG_TIMEOUT_ENABLED)
+    timeout = rng_peers_rx_timeout(rng->peers, timeout,
+                    dw1000_phy_frame_duration(&inst->attrib, sizeof(ieee_rng_response_frame_t)));
+#endif
 
     dw1000_set_rx_timeout(inst, timeout); 
    
@@ -439,6 +560,12 @@ dw1000_rng_request(dw1000_dev_instance_t * inst, uint16_t dst_address, dw1000_rn
         dw1000_set_delay_start(inst, rng->delay);
 
     if (dw1000_start_tx(inst).start_tx_error && inst->status.rx_timeout_error == 0){
+#if MYNEWT_VAL(RNG_PEERS_ENABLED)
+        rng_peers_fail(rng->peers, RNG_PEER_TX_ERROR);
+#endif
+#if MYNEWT_VAL(RNG_CACHE_ENABLED)
+        rng_cache_abort(inst);
+#endif
         os_sem_release(&inst->rng->sem);
         STATS_INC(inst->rng->stat, tx_error);
     }
@@ -463,6 +590,10 @@ dw1000_rng_listen(dw1000_dev_instance_t * inst, dw1000_dev_modes_t mode){
 
     os_error_t err = os_sem_pend(&inst->rng->sem,  OS_TIMEOUT_NEVER);
     assert(err == OS_OK);
+#if MYNEWT_VAL(RNG_CACHE_ENABLED)
+    // An exchange still pending ended on a path that did not report it, e.g. a start tx error
+    rng_cache_abort(inst);
+#endif
 
     // Download the Preamble memory on the response    
 #if MYNEWT_VAL(PMEM_ENABLED)   
@@ -534,27 +665,145 @@ dw1000_rng_path_loss(float Pt, float G, float fc, float R){
 }
 
 /**
- * API for bias correction polynomial.
+ * API to build the range bias correction table for the configured PRF and channel. Called from dw1000_rng_init()
+ * and again by dw1000_rng_bias_mm() whenever the PRF or channel has changed, unless calibration data was loaded.
+ *
+ * @param inst   Pointer to dw1000_dev_instance_t.
+ *
+ * @return void
+ */
+void
+dw1000_rng_bias_lut_build(dw1000_dev_instance_t * inst){
+    dw1000_rng_bias_lut_t * lut = &inst->rng->bias;
+    float fc;
+
+    switch(inst->config.channel){
+        case 1: fc = 3494.4e6f; break;
+        case 3: fc = 4492.8e6f; break;
+        case 2:
+        case 4: fc = 3993.6e6f; break;
+        default: fc = 6489.6e6f; break;
+    }
+    // Free space signal level at 1 m, the range dependent term is added per frame in fixed point
+    float pr = MYNEWT_VAL(DW1000_DEVICE_TX_PWR) + 2 * MYNEWT_VAL(DW1000_DEVICE_ANT_GAIN)
+                + 20 * log10f(299792458.0f / 1.000293f / (4 * M_PI * fc));
+
+    memcpy(lut->bias, (inst->config.prf == DWT_PRF_16M) ? rng_bias_PRF16 : rng_bias_PRF64, sizeof(lut->bias));
+    lut->pr_max = -61 * 256;
+    lut->step = 2 * 256;
+    lut->pr_ref = (int16_t) lroundf(pr * 256);
+    lut->nsize = RNG_BIAS_LUT_SIZE;
+    lut->prf = inst->config.prf;
+    lut->channel = inst->config.channel;
+    lut->calibrated = 0;
+}
+
+/**
+ * API to replace the range bias correction table with calibration data.
+ *
+ * @param inst    Pointer to dw1000_dev_instance_t.
+ * @param pr_max  Signal level of the first entry, dBm Q8.
+ * @param step    Signal level decrease between entries, dB Q8.
+ * @param bias    Range bias of each entry, mm.
+ * @param nsize   Number of entries, at most RNG_BIAS_LUT_SIZE.
+ *
+ * @return void
+ */
+void
+dw1000_rng_bias_lut_load(dw1000_dev_instance_t * inst, int16_t pr_max, uint16_t step, const int16_t bias[], uint8_t nsize){
+    dw1000_rng_bias_lut_t * lut = &inst->rng->bias;
+
+    assert(nsize >= 2 && nsize <= RNG_BIAS_LUT_SIZE && step > 0);
+    if (!lut->nsize)
+        dw1000_rng_bias_lut_build(inst);     // for pr_ref
+    memcpy(lut->bias, bias, nsize * sizeof(int16_t));
+    lut->pr_max = pr_max;
+    lut->step = step;
+    lut->nsize = nsize;
+    lut->calibrated = 1;
+}
+
+/**
+ * log2(x) in Q16 for x > 0, piecewise linear between 16 points per octave.
+ */
+static inline uint32_t
+log2_q16(uint32_t x){
+    uint8_t n = 31 - __builtin_clz(x);
+    uint32_t m = ((n >= 20) ? x >> (n - 20) : x << (20 - n)) - (1ul << 20);     // fraction, Q20
+    uint8_t k = m >> 16;
+    return ((uint32_t)n << 16) + g_log2_q16[k] + (((uint32_t)(g_log2_q16[k + 1] - g_log2_q16[k]) * (m & 0xFFFF)) >> 16);
+}
+
+/**
+ * API to estimate the received signal level from range with the free space path loss model, in fixed point.
+ *
+ * @param inst   Pointer to dw1000_dev_instance_t.
+ * @param range  Range, mm.
+ *
+ * @return signal level, dBm Q8
+ */
+int16_t
+dw1000_rng_rx_level(dw1000_dev_instance_t * inst, int32_t range){
+    if (range < 1)
+        range = 1;
+    // 20 * log10(R) = 20 * log10(2) * log2(R), 20 * log10(2) = 1541 in Q8; less 60 dB for mm to m
+    int32_t loss = (int32_t)((log2_q16(range) * 1541u) >> 16) - 60 * 256;
+    int32_t pr = inst->rng->bias.pr_ref - loss;
+    return (pr < INT16_MIN) ? INT16_MIN : (pr > INT16_MAX) ? INT16_MAX : pr;
+}
+
+/**
+ * API to look up the range bias for a received signal level, interpolated linearly and clamped to the table.
+ *
+ * @param inst   Pointer to dw1000_dev_instance_t.
+ * @param pr     Received signal level, dBm Q8.
+ *
+ * @return range bias, mm
+ */
+int16_t
+dw1000_rng_bias_mm(dw1000_dev_instance_t * inst, int16_t pr){
+    dw1000_rng_bias_lut_t * lut = &inst->rng->bias;
+
+    if (!lut->calibrated && (lut->prf != inst->config.prf || lut->channel != inst->config.channel))
+        dw1000_rng_bias_lut_build(inst);
+
+    int32_t pos = lut->pr_max - pr;
+    if (pos <= 0)
+        return lut->bias[0];
+    uint16_t k = pos / lut->step;
+    if (k >= lut->nsize - 1)
+        return lut->bias[lut->nsize - 1];
+    int32_t frac = pos - k * lut->step;
+    return lut->bias[k] + (lut->bias[k + 1] - lut->bias[k]) * frac / lut->step;
+}
+
+/**
+ * API for range bias correction.
  *
  * @param inst   Pointer to dw1000_dev_instance_t.
- * @param pr     Variable that calculates range path loss.
+ * @param Pr     Received signal level, dBm.
  *
- * @return Bias value
+ * @return Bias value, m
  */
 float 
 dw1000_rng_bias_correction(dw1000_dev_instance_t * inst, float Pr){
-    float bias;
-    switch(inst->config.prf){
-        case DWT_PRF_16M:
-            bias = polyval(rng_bias_poly_PRF16, Pr, sizeof(rng_bias_poly_PRF16)/sizeof(float));
-            break;
-        case DWT_PRF_64M:
-            bias = polyval(rng_bias_poly_PRF64, Pr, sizeof(rng_bias_poly_PRF64)/sizeof(float));
-            break;
-        default:
-            assert(0);
-    }
-    return bias;
+    return dw1000_rng_bias_mm(inst, (int16_t) fmaxf(fminf(Pr * 256, INT16_MAX), INT16_MIN)) * 1e-3f;
+}
+
+/**
+ * Builds the round/reply intervals of a ranging frame. Frames carry the lower 32-bits of each timestamp,
+ * intervals are therefore formed modulo 2^32.
+ *
+ * @param frame  Pointer to twr frame.
+ *
+ * @return tof_exchange_t
+ */
+static inline tof_exchange_t
+twr_exchange(const twr_frame_t * frame){
+    return (tof_exchange_t){
+        .round = tof_interval32(frame->response_timestamp, frame->request_timestamp),
+        .reply = tof_interval32(frame->transmission_timestamp, frame->reception_timestamp)
+    };
 }
 
 #if MYNEWT_VAL(DW1000_RANGE)
@@ -562,92 +811,126 @@ dw1000_rng_bias_correction(dw1000_dev_instance_t * inst, float Pr){
 /**
  * API to calculate time of flight based on type of ranging.
  *
- * @param fframe   Pointer to the first twr frame. 
+ * @param fframe   Pointer to the first twr frame.
  * @param nframe   Poinetr to the second twr frame.
  *
- * @return Time of flight in float
+ * @return Time of flight in picoseconds
  */
-float
-dw1000_rng_twr_to_tof(twr_frame_t *fframe, twr_frame_t *nframe){
-    float ToF = 0;
-    uint64_t T1R, T1r, T2R, T2r;
-    int64_t nom,denom;
-
+int32_t
+dw1000_rng_twr_to_tof_ps(twr_frame_t *fframe, twr_frame_t *nframe){
     assert(fframe != NULL);
     assert(nframe != NULL);
 
-    twr_frame_t * first_frame = fframe;
-    twr_frame_t * frame = nframe;
+    tof_exchange_t first = twr_exchange(fframe);
+    tof_exchange_t second = twr_exchange(nframe);
 
-    switch(frame->code){
+    switch(nframe->code){
         case DWT_SS_TWR ... DWT_SS_TWR_END:
-            ToF = ((first_frame->response_timestamp - first_frame->request_timestamp)
-                    -  (first_frame->transmission_timestamp - first_frame->reception_timestamp))/2.;
-        break;
+            return tof_ss_ps(&first, 0);
         case DWT_DS_TWR ... DWT_DS_TWR_END:
         case DWT_DS_TWR_EXT ... DWT_DS_TWR_EXT_END:
-            T1R = (first_frame->response_timestamp - first_frame->request_timestamp);
-            T1r = (first_frame->transmission_timestamp  - first_frame->reception_timestamp);
-            T2R = (frame->response_timestamp - frame->request_timestamp);
-            T2r = (frame->transmission_timestamp - frame->reception_timestamp);
-            nom = T1R * T2R  - T1r * T2r;
-            denom = T1R + T2R  + T1r + T2r;
-            ToF = (float) (nom) / denom;
-            break;
+            return tof_ds_ps(&first, &second);
         default: break;
     }
-    return ToF;
+    return 0;
 }
-#else
 
 /**
  * API to calculate time of flight based on type of ranging.
  *
- * @param rng  Pointer to dw1000_rng_instance_t.
+ * @param fframe   Pointer to the first twr frame.
+ * @param nframe   Poinetr to the second twr frame.
  *
  * @return Time of flight in float
  */
-float 
-dw1000_rng_twr_to_tof(dw1000_rng_instance_t * rng, uint16_t idx){
-
-    float ToF = 0;
-    uint64_t T1R, T1r, T2R, T2r;
-    int64_t nom,denom;
-
-    dw1000_dev_instance_t * inst = rng->parent;
+float
+dw1000_rng_twr_to_tof(twr_frame_t *fframe, twr_frame_t *nframe){
+    return dw1000_rng_twr_to_tof_ps(fframe, nframe) / TOF_PS_PER_DTU;
+}
+#else
 
-    twr_frame_t * first_frame = rng->frames[(uint16_t)(idx-1)%rng->nframes];
-    twr_frame_t * frame = rng->frames[(idx)%rng->nframes];
+/**
+ * Time of flight of an exchange from its first and final frames.
+ *
+ * @param inst         Pointer to dw1000_dev_instance_t.
+ * @param first_frame  First frame of the exchange.
+ * @param frame        Final frame of the exchange.
+ *
+ * @return Time of flight in picoseconds
+ */
+static int32_t
+frames_tof_ps(dw1000_dev_instance_t * inst, const twr_frame_t * first_frame, const twr_frame_t * frame){
 
     switch(frame->code){
         case DWT_SS_TWR ... DWT_SS_TWR_END:{
+            tof_exchange_t ex = twr_exchange(frame);
 #if MYNEWT_VAL(WCS_ENABLED)
             wcs_instance_t * wcs = inst->ccp->wcs;
             float skew = wcs->skew;
 #else
             float skew = dw1000_calc_clock_offset_ratio(inst, first_frame->carrier_integrator);
 #endif
-            ToF = ((frame->response_timestamp - frame->request_timestamp) 
-                    -  (frame->transmission_timestamp - frame->reception_timestamp) * (1.0f - skew))/2.;
+            return tof_ss_ps(&ex, tof_skew_to_q31(skew));
             }
-        break;
         case DWT_DS_TWR ... DWT_DS_TWR_END:
-        case DWT_DS_TWR_EXT ... DWT_DS_TWR_EXT_END:
-            T1R = (first_frame->response_timestamp - first_frame->request_timestamp); 
-            T1r = (first_frame->transmission_timestamp  - first_frame->reception_timestamp);         
-            T2R = (frame->response_timestamp - frame->request_timestamp); 
-            T2r = (frame->transmission_timestamp - frame->reception_timestamp); 
-            nom = T1R * T2R  - T1r * T2r;
-            denom = T1R + T2R  + T1r + T2r;
-            ToF = (float) (nom) / denom; 
-            break;
-        default: break;       
+        case DWT_DS_TWR_EXT ... DWT_DS_TWR_EXT_END:{
+            tof_exchange_t first = twr_exchange(first_frame);
+            tof_exchange_t second = twr_exchange(frame);
+            return tof_ds_ps(&first, &second);
+            }
+        default: break;
     }
-    return ToF;
+    return 0;
+}
+
+/**
+ * API to calculate time of flight based on type of ranging.
+ *
+ * @param rng  Pointer to dw1000_rng_instance_t.
+ * @param idx  Index of the final frame of the exchange.
+ *
+ * @return Time of flight in picoseconds
+ */
+int32_t
+dw1000_rng_twr_to_tof_ps(dw1000_rng_instance_t * rng, uint16_t idx){
+    return frames_tof_ps(rng->parent, rng->frames[(uint16_t)(idx-1)%rng->nframes], rng->frames[(idx)%rng->nframes]);
+}
+/**
+ * API to calculate time of flight based on type of ranging.
+ *
+ * @param rng  Pointer to dw1000_rng_instance_t.
+ * @param idx  Index of the final frame of the exchange.
+ *
+ * @return Time of flight in float
+ */
+float 
+dw1000_rng_twr_to_tof(dw1000_rng_instance_t * rng, uint16_t idx){
+    return dw1000_rng_twr_to_tof_ps(rng, idx) / TOF_PS_PER_DTU;
 }
 #endif
 
 
+#if MYNEWT_VAL(RNG_CACHE_ENABLED)
+/**
+ * API to calculate time of flight from the frames kept by a cached result.
+ *
+ * @param rng     Pointer to dw1000_rng_instance_t.
+ * @param result  Pointer to rng_result_t.
+ *
+ * @return Time of flight in picoseconds, 0 if the result is not complete
+ */
+int32_t
+dw1000_rng_result_tof_ps(dw1000_rng_instance_t * rng, const rng_result_t * result){
+    if (result->state != RNG_RESULT_COMPLETE)
+        return 0;
+#if MYNEWT_VAL(DW1000_RANGE)
+    return dw1000_rng_twr_to_tof_ps((twr_frame_t *) &result->first, (twr_frame_t *) &result->final);
+#else
+    return frames_tof_ps(rng->parent, &result->first, &result->final);
+#endif
+}
+#endif
+
 /**
  * API to calculate range in meters from time-of-flight based on type of ranging.
  *
@@ -671,24 +954,18 @@ dw1000_rng_tof_to_meters(float ToF) {
  */
 uint32_t 
 dw1000_rng_twr_to_tof_sym(twr_frame_t twr[], dw1000_rng_modes_t code){
-    uint32_t ToF = 0;
-    uint64_t T1R, T1r, T2R, T2r;
+    tof_exchange_t first = twr_exchange(&twr[0]);
 
     switch(code){
         case DWT_SS_TWR:
-            ToF = ((twr[0].response_timestamp - twr[0].request_timestamp) 
-                    -  (twr[0].transmission_timestamp - twr[0].reception_timestamp))/2.; 
-        break;
-        case DWT_DS_TWR:
-            T1R = (twr[0].response_timestamp - twr[0].request_timestamp); 
-            T1r = (twr[0].transmission_timestamp  - twr[0].reception_timestamp);         
-            T2R = (twr[1].response_timestamp - twr[1].request_timestamp); 
-            T2r = (twr[1].transmission_timestamp  - twr[1].reception_timestamp); 
-            ToF = (T1R - T1r + T2R - T2r) >> 2;  
-        break;
-        default: break;       
+            return tof_ps_to_dtu(tof_ss_ps(&first, 0));
+        case DWT_DS_TWR:{
+            tof_exchange_t second = twr_exchange(&twr[1]);
+            return tof_ps_to_dtu(tof_ds_sym_ps(&first, &second));
+            }
+        default: break;
     }
-    return ToF;
+    return 0;
 }
 
 
@@ -702,6 +979,12 @@ dw1000_rng_twr_to_tof_sym(twr_frame_t twr[], dw1000_rng_modes_t code){
 static bool 
 rx_timeout_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs){
 
+#if MYNEWT_VAL(RNG_PEERS_ENABLED)
+    rng_peers_fail(inst->rng->peers, RNG_PEER_TIMEOUT);
+#endif
+#if MYNEWT_VAL(RNG_CACHE_ENABLED)
+    rng_cache_abort(inst);
+#endif
     if(os_sem_get_count(&inst->rng->sem) == 0){
         os_error_t err = os_sem_release(&inst->rng->sem);
         assert(err == OS_OK);
@@ -712,6 +995,26 @@ rx_timeout_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs){
         return false;
 }
 
+#if MYNEWT_VAL(RNG_PEERS_ENABLED) || MYNEWT_VAL(RNG_CACHE_ENABLED)
+/**
+ * API for receive error callback. Only records the failure against the peer, the twr modules handle the error.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ *
+ * @return false
+ */
+static bool
+rx_error_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs){
+#if MYNEWT_VAL(RNG_PEERS_ENABLED)
+    rng_peers_fail(inst->rng->peers, RNG_PEER_RX_ERROR);
+#endif
+#if MYNEWT_VAL(RNG_CACHE_ENABLED)
+    rng_cache_abort(inst);
+#endif
+    return false;
+}
+#endif
+
 /** 
  * API for reset_cb of rng interface
  *
@@ -721,6 +1024,12 @@ rx_timeout_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs){
 static bool
 reset_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs){
 
+#if MYNEWT_VAL(RNG_PEERS_ENABLED)
+    rng_peers_fail(inst->rng->peers, RNG_PEER_RX_ERROR);
+#endif
+#if MYNEWT_VAL(RNG_CACHE_ENABLED)
+    rng_cache_abort(inst);
+#endif
     if(os_sem_get_count(&inst->rng->sem) == 0){
         os_error_t err = os_sem_release(&inst->rng->sem);  
         assert(err == OS_OK);
@@ -751,6 +1060,9 @@ rx_complete_cb(struct _dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cb
         return false;
     }
 
+#if MYNEWT_VAL(RNG_PAYLOAD_ENABLED)
+    rng_payload_strip(inst);
+#endif
     dw1000_rng_instance_t * rng = inst->rng; 
     twr_frame_t * frame = rng->frames[(rng->idx+1)%rng->nframes]; // speculative frame advance
     
@@ -768,8 +1080,30 @@ rx_complete_cb(struct _dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cb
                     dw1000_start_rx(inst);
                 return true;
             }else{
+#if MYNEWT_VAL(RNG_CACHE_ENABLED)
+                if (!rng_cache_admit(rng->cache, frame)){
+                    // Frame of another exchange, the ring is still in use by the one in flight
+                    STATS_INC(inst->rng->stat, rx_unsolicited);
+                    if(!inst->config.dblbuffon_enabled || !inst->config.rxauto_enable)
+                        dw1000_start_rx(inst);
+                    return true;
+                }
+#endif
                 STATS_INC(inst->rng->stat, rx_complete); 
                 rng->idx++;     // confirmed frame advance  
+#if MYNEWT_VAL(RNG_CACHE_ENABLED)
+                if (frame->code == DWT_SS_TWR || frame->code == DWT_DS_TWR || frame->code == DWT_DS_TWR_EXT)
+                    rng->cache->current = rng_cache_open(rng->cache, frame->src_address, frame->seq_num,
+                        os_cputime_ticks_to_usecs(os_cputime_get32()));
+#endif
+#if MYNEWT_VAL(RNG_TIMEOUT_ENABLED)
+                if (frame->code == DWT_SS_TWR_T1 || frame->code == DWT_DS_TWR_T1 || frame->code == DWT_DS_TWR_EXT_T1){
+                    // Request tx time from the MAC snapshot, taken ahead of the rx callbacks
+                    uint32_t turnaround = (uint32_t)inst->rxtimestamp - (uint32_t)inst->txtimestamp;
+                    rng_peers_response(rng->peers, frame->src_address,
+                        (uint16_t) dw1000_dwt_usecs_to_usecs(turnaround >> 16));
+                }
+#endif
                 return false;   // Allow sub extensions to handle event
             }
             break;
@@ -815,17 +1149,296 @@ complete_ev_cb(struct os_event *ev) {
     rng_encode(inst->rng);
 }
 
-
 struct os_callout rng_callout;
+#endif
+
+#if MYNEWT_VAL(RNG_STREAM_ENABLED) || MYNEWT_VAL(RNG_FILTER_ENABLED) || MYNEWT_VAL(RNG_PEERS_ENABLED)
+/**
+ * Returns the time of flight of the exchange ending with the current frame.
+ *
+ * @param rng  Pointer to dw1000_rng_instance_t.
+ *
+ * @return Time of flight in picoseconds
+ */
+static int32_t
+final_tof_ps(dw1000_rng_instance_t * rng){
+#if MYNEWT_VAL(DW1000_RANGE)
+    return dw1000_rng_twr_to_tof_ps(rng->frames[(uint16_t)(rng->idx-1)%rng->nframes], rng->frames[(rng->idx)%rng->nframes]);
+#else
+    return dw1000_rng_twr_to_tof_ps(rng, rng->idx);
+#endif
+}
+#endif
+
+#if MYNEWT_VAL(RNG_STREAM_ENABLED) || MYNEWT_VAL(RNG_FILTER_ENABLED) || MYNEWT_VAL(RNG_PEERS_ENABLED) \
+        || MYNEWT_VAL(RNG_CACHE_ENABLED)
+/**
+ * Returns true when the frame completes an exchange.
+ */
+static inline bool
+is_final(twr_frame_t * frame){
+    switch(frame->code){
+        case DWT_SS_TWR_FINAL:
+        case DWT_DS_TWR_FINAL:
+        case DWT_DS_TWR_EXT_FINAL:
+            return true;
+        default:
+            return false;
+    }
+}
+#endif
+
+#if MYNEWT_VAL(RNG_FILTER_ENABLED)
+/**
+ * Returns true when this node initiated the exchange the final frame completes. The initiator sends the single
+ * sided final frame and receives the double sided ones.
+ */
+static inline bool
+is_initiator(dw1000_dev_instance_t * inst, twr_frame_t * frame){
+    bool sent = frame->src_address == inst->my_short_address;
+    return (frame->code == DWT_SS_TWR_FINAL) ? sent : !sent;
+}
+
+/**
+ * Returns the range of the exchange ending with the current frame, bias corrected when enabled. The extended
+ * double sided final frame carries the range the responder computed and corrected in twr_ds_ext.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ *
+ * @return Range, m
+ */
+static float
+final_range(dw1000_dev_instance_t * inst){
+
+    dw1000_rng_instance_t * rng = inst->rng;
+    twr_frame_t * frame = rng->frames[(rng->idx)%rng->nframes];
+
+    if (frame->code == DWT_DS_TWR_EXT_FINAL)
+        return frame->spherical.range;
+
+    int32_t range = tof_ps_to_mm(final_tof_ps(rng));
+#if MYNEWT_VAL(DW1000_BIAS_CORRECTION_ENABLED)
+    if (inst->config.bias_correction_enable)
+        range -= 2 * dw1000_rng_bias_mm(inst, dw1000_rng_rx_level(inst, range));
+#endif
+    return range * 1e-3f;
+}
+
+/**
+ * Runs the completed range through the filter of the peer, on the initiator only, and reports the filtered range
+ * and its variance in filtered_range and filtered_variance of the final frame; the measured range is left as is.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ *
+ * @return void
+ */
+static void
+rng_filter(dw1000_dev_instance_t * inst){
+
+    dw1000_rng_instance_t * rng = inst->rng;
+    twr_frame_t * frame = rng->frames[(rng->idx)%rng->nframes];
+    rngfilt_result_t result;
+
+    if (!is_final(frame))
+        return;
+    if (!is_initiator(inst, frame))
+        return;
+
+    uint16_t peer = (frame->src_address == inst->my_short_address) ? frame->dst_address : frame->src_address;
+    rngfilt_update(rng->filter, peer, os_cputime_ticks_to_usecs(os_cputime_get32()), final_range(inst), &result);
+    frame->filtered_range = result.range;
+    frame->filtered_variance = result.variance;
+}
+#endif
+
+#if MYNEWT_VAL(RNG_CACHE_ENABLED)
+/**
+ * Returns the sequence number of the request of the exchange the frame belongs to. The double sided modes send their
+ * second round trip with the next sequence number.
+ *
+ * @param frame  Pointer to twr_frame_t.
+ *
+ * @return Sequence number of the request
+ */
+static uint8_t
+rng_cache_seq_num(twr_frame_t * frame){
+    switch(frame->code){
+        case DWT_DS_TWR_T2:
+        case DWT_DS_TWR_FINAL:
+        case DWT_DS_TWR_EXT_T2:
+        case DWT_DS_TWR_EXT_FINAL:
+            return frame->seq_num - 1;
+        default:
+            return frame->seq_num;
+    }
+}
+
+/**
+ * Returns true when a received frame may use the frame ring: no exchange is in flight on this node, or the frame
+ * belongs to the one that is. Frames of any other exchange would overwrite the timestamps of the exchange in flight.
+ *
+ * @param cache  Pointer to rng_cache_t.
+ * @param frame  Received frame.
+ *
+ * @return bool
+ */
+static bool
+rng_cache_admit(rng_cache_t * cache, twr_frame_t * frame){
+    rng_result_t * current = cache->current;
+    if (current == NULL || current->state != RNG_RESULT_PENDING)
+        return true;
+    return current->addr == frame->src_address && current->seq_num == rng_cache_seq_num(frame);
+}
+
+/**
+ * Marks the cached result of the exchange in flight on this node failed, if there is one.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ *
+ * @return void
+ */
+static void
+rng_cache_abort(dw1000_dev_instance_t * inst){
+    rng_cache_t * cache = inst->rng->cache;
+    if (cache->current)
+        rng_cache_fail(cache, cache->current, os_cputime_ticks_to_usecs(os_cputime_get32()));
+}
+
+/**
+ * Copies the frames of the completed exchange from the frame ring into the cache, opening an entry if it was lost to
+ * reuse.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ *
+ * @return void
+ */
+static void
+rng_cache_commit(dw1000_dev_instance_t * inst){
+
+    dw1000_rng_instance_t * rng = inst->rng;
+    twr_frame_t * frame = rng->frames[(rng->idx)%rng->nframes];
+    twr_frame_t * first_frame = rng->frames[(uint16_t)(rng->idx-1)%rng->nframes];
+    uint32_t utime = os_cputime_ticks_to_usecs(os_cputime_get32());
+
+    if (!is_final(frame))
+        return;
+
+    uint16_t peer = (frame->src_address == inst->my_short_address) ? frame->dst_address : frame->src_address;
+    uint8_t seq_num = rng_cache_seq_num(frame);
+    rng_result_t * result = rng_cache_find(rng->cache, peer, seq_num);
+    if (result == NULL)
+        result = rng_cache_open(rng->cache, peer, seq_num, utime);
+    rng_cache_complete(rng->cache, result, first_frame, frame, utime);
+}
+
+#endif
+
+#if MYNEWT_VAL(RNG_PEERS_ENABLED)
+/**
+ * Records a completed exchange against the peer, with the signal quality of the final frame.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ *
+ * @return void
+ */
+static void
+rng_peers_complete(dw1000_dev_instance_t * inst){
+
+    dw1000_rng_instance_t * rng = inst->rng;
+    twr_frame_t * frame = rng->frames[(rng->idx)%rng->nframes];
+    int16_t rssi = RNG_PEERS_RSSI_INVALID, fppl = RNG_PEERS_RSSI_INVALID;
+    uint8_t los = 0;
+
+    if (!is_final(frame))
+        return;
+
+    if (inst->config.rxdiag_enable){
+        float frssi = dw1000_get_rssi(inst);
+        float ffppl = dw1000_get_fppl(inst);
+        if (isfinite(frssi) && isfinite(ffppl)){
+            rssi = (int16_t) (frssi * 100);
+            fppl = (int16_t) (ffppl * 100);
+            los = (uint8_t) (dw1000_estimate_los(frssi, ffppl) * 255);
+        }
+    }
+    rng_peers_success(rng->peers, (frame->src_address == inst->my_short_address) ? frame->dst_address : frame->src_address,
+            os_cputime_ticks_to_usecs(os_cputime_get32()), rssi, fppl, los);
+}
+#endif
+
+#if MYNEWT_VAL(RNG_STREAM_ENABLED)
+/**
+ * Condenses the final frame of a completed exchange into a range record and publishes it.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ *
+ * @return void
+ */
+static void
+rng_publish(dw1000_dev_instance_t * inst){
+
+    dw1000_rng_instance_t * rng = inst->rng;
+    twr_frame_t * frame = rng->frames[(rng->idx)%rng->nframes];
+
+    if (!is_final(frame))
+        return;
+
+    rng_record_t record = {
+        .utime = os_cputime_ticks_to_usecs(os_cputime_get32()),
+        .peer = (frame->src_address == inst->my_short_address) ? frame->dst_address : frame->src_address,
+        .seq_num = frame->seq_num,
+        .code = frame->code,
+        .rssi = RNG_STREAM_RSSI_INVALID,
+        .fppl = RNG_STREAM_RSSI_INVALID
+    };
+    record.tof = final_tof_ps(rng);
+    record.range = tof_ps_to_mm(record.tof);
+
+    if (inst->config.rxdiag_enable){
+        float rssi = dw1000_get_rssi(inst);
+        float fppl = dw1000_get_fppl(inst);
+        if (isfinite(rssi) && isfinite(fppl)){
+            record.rssi = (int16_t) (rssi * 100);
+            record.fppl = (int16_t) (fppl * 100);
+            record.los = (uint8_t) (dw1000_estimate_los(rssi, fppl) * 255);
+        }
+    }
+    rng_stream_publish(rng->stream, &record);
+}
+#endif
+
+#if RNG_COMPLETE_CB
+/**
+ * API for range complete callback. Filters and publishes the result and schedules the verbose output.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ *
+ * @return false, other interfaces may also act on completion
+ */
 static bool
 complete_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs){
         if (inst->fctrl != FCNTL_IEEE_RANGE_16)
         return false;
 
-        os_callout_init(&rng_callout, os_eventq_dflt_get(), complete_ev_cb, inst);
-        os_eventq_put(os_eventq_dflt_get(), &rng_callout.c_ev);
+#if MYNEWT_VAL(RNG_CACHE_ENABLED)
+        rng_cache_commit(inst);
+#endif
+#if MYNEWT_VAL(RNG_PEERS_ENABLED)
+        rng_peers_complete(inst);
+#endif
+#if MYNEWT_VAL(RNG_FILTER_ENABLED)
+        rng_filter(inst);
+#endif
+#if MYNEWT_VAL(RNG_STREAM_ENABLED)
+        rng_publish(inst);
+#endif
+#if MYNEWT_VAL(RNG_VERBOSE)
+        // Re-initialising the event while it is still queued would corrupt the default eventq
+        if (!OS_EVENT_QUEUED(&rng_callout.c_ev)){
+            os_callout_init(&rng_callout, os_eventq_dflt_get(), complete_ev_cb, inst);
+            os_eventq_put(os_eventq_dflt_get(), &rng_callout.c_ev);
+        }
+#endif
         return false;
 }
-
-
-#endif
\ No newline at end of file
+#endif
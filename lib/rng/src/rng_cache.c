@@ -0,0 +1,227 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file rng_cache.c
+ * @author paul kettle
+ * @date 2018
+ * @brief Ranging result cache
+ *
+ * @details Entries are opened from the requesting task and from the MAC task, so the table is only modified inside a
+ * critical section. Allocation scans the cache, which is small, for a free or the oldest reusable entry.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <os/os.h>
+
+#include <rng/rng_cache.h>
+
+#if MYNEWT_VAL(RNG_CACHE_ENABLED)
+
+static inline uint32_t
+rng_cache_key(uint16_t addr, uint8_t seq_num){
+    return ((uint32_t)seq_num << 16) | addr;
+}
+
+static uint32_t
+rng_cache_entry_key(const void * arg, uint16_t idx){
+    const rng_result_t * result = &((const rng_cache_t *) arg)->results[idx];
+    return rng_cache_key(result->addr, result->seq_num);
+}
+
+static void
+rng_cache_unlink(rng_cache_t * cache, rng_result_t * result){
+    if (result->state == RNG_RESULT_FREE)
+        return;
+    keytab_remove(&cache->tab, rng_cache_key(result->addr, result->seq_num));
+    result->state = RNG_RESULT_FREE;
+    if (cache->current == result)
+        cache->current = NULL;
+}
+
+/**
+ * API to initialise a result cache.
+ *
+ * @param cache     Pointer to rng_cache_t, allocated when NULL.
+ * @param nresults  Number of entries.
+ *
+ * @return rng_cache_t*
+ */
+rng_cache_t *
+rng_cache_init(rng_cache_t * cache, uint16_t nresults){
+
+    uint16_t nslots = keytab_nslots(nresults);
+
+    if (cache == NULL){
+        size_t size = sizeof(rng_cache_t) + nresults * sizeof(rng_result_t) + nslots * sizeof(uint16_t);
+        cache = (rng_cache_t *) malloc(size);
+        assert(cache);
+        memset(cache, 0, size);
+        cache->status.selfmalloc = 1;
+    }else{
+        assert(cache->nresults == nresults);
+    }
+    cache->nresults = nresults;
+    cache->current = NULL;
+    keytab_init(&cache->tab, (uint16_t *) &cache->results[nresults], nslots, rng_cache_entry_key, cache);
+    for (uint16_t k = 0; k < nresults; k++)
+        cache->results[k].state = RNG_RESULT_FREE;
+    cache->status.initialized = 1;
+    return cache;
+}
+
+/**
+ * API to free the allocated resources.
+ *
+ * @param cache  Pointer to rng_cache_t.
+ *
+ * @return void
+ */
+void
+rng_cache_free(rng_cache_t * cache){
+    assert(cache);
+    if (cache->status.selfmalloc)
+        free(cache);
+    else
+        cache->status.initialized = 0;
+}
+
+/**
+ * API to open the entry of a new exchange. An existing entry with the same key is restarted; otherwise a free entry is
+ * used, or failing that the oldest entry that is not pending, or the oldest entry.
+ *
+ * @param cache    Pointer to rng_cache_t.
+ * @param addr     Short address of the peer.
+ * @param seq_num  Sequence number of the request.
+ * @param utime    Current time, usec.
+ *
+ * @return rng_result_t*
+ */
+rng_result_t *
+rng_cache_open(rng_cache_t * cache, uint16_t addr, uint8_t seq_num, uint32_t utime){
+
+    os_sr_t sr;
+    OS_ENTER_CRITICAL(sr);
+    uint16_t i = keytab_find_slot(&cache->tab, rng_cache_key(addr, seq_num));
+    rng_result_t * result;
+
+    if (cache->tab.slots[i] != KEYTAB_NONE){
+        result = &cache->results[cache->tab.slots[i]];
+    }else{
+        uint16_t best = 0;
+        for (uint16_t k = 0; k < cache->nresults; k++){
+            rng_result_t * s = &cache->results[k];
+            rng_result_t * b = &cache->results[best];
+            if (s->state == RNG_RESULT_FREE){
+                best = k;
+                break;
+            }
+            if ((s->state != RNG_RESULT_PENDING && b->state == RNG_RESULT_PENDING)
+                    || ((s->state == RNG_RESULT_PENDING) == (b->state == RNG_RESULT_PENDING)
+                    && (int32_t)(s->age - b->age) < 0))
+                best = k;
+        }
+        result = &cache->results[best];
+        rng_cache_unlink(cache, result);
+        result->addr = addr;
+        result->seq_num = seq_num;
+        cache->tab.slots[keytab_find_slot(&cache->tab, rng_cache_key(addr, seq_num))] = best;
+    }
+    result->state = RNG_RESULT_PENDING;
+    result->utime = utime;
+    result->age = cache->age++;
+    OS_EXIT_CRITICAL(sr);
+    return result;
+}
+
+/**
+ * API to find the entry of an exchange.
+ *
+ * @param cache    Pointer to rng_cache_t.
+ * @param addr     Short address of the peer.
+ * @param seq_num  Sequence number of the request.
+ *
+ * @return rng_result_t*, NULL if there is none
+ */
+rng_result_t *
+rng_cache_find(rng_cache_t * cache, uint16_t addr, uint8_t seq_num){
+    uint16_t k = keytab_lookup(&cache->tab, rng_cache_key(addr, seq_num));
+    return (k == KEYTAB_NONE) ? NULL : &cache->results[k];
+}
+
+/**
+ * API to complete an entry, keeping a copy of the frames of the exchange.
+ *
+ * @param cache   Pointer to rng_cache_t.
+ * @param result  Pointer to rng_result_t.
+ * @param first   First frame of the exchange.
+ * @param final   Final frame of the exchange.
+ * @param utime   Current time, usec.
+ *
+ * @return void
+ */
+void
+rng_cache_complete(rng_cache_t * cache, rng_result_t * result, const twr_frame_t * first,
+        const twr_frame_t * final, uint32_t utime){
+    memcpy(&result->first, first, sizeof(twr_frame_t));
+    memcpy(&result->final, final, sizeof(twr_frame_t));
+    result->utime = utime;
+    result->state = RNG_RESULT_COMPLETE;
+    if (cache->current == result)
+        cache->current = NULL;
+}
+
+/**
+ * API to mark an entry failed.
+ *
+ * @param cache   Pointer to rng_cache_t.
+ * @param result  Pointer to rng_result_t.
+ * @param utime   Current time, usec.
+ *
+ * @return void
+ */
+void
+rng_cache_fail(rng_cache_t * cache, rng_result_t * result, uint32_t utime){
+    result->utime = utime;
+    result->state = RNG_RESULT_FAILED;
+    if (cache->current == result)
+        cache->current = NULL;
+}
+
+/**
+ * API to return an entry to the cache.
+ *
+ * @param cache   Pointer to rng_cache_t.
+ * @param result  Pointer to rng_result_t.
+ *
+ * @return void
+ */
+void
+rng_cache_release(rng_cache_t * cache, rng_result_t * result){
+    os_sr_t sr;
+    OS_ENTER_CRITICAL(sr);
+    rng_cache_unlink(cache, result);
+    OS_EXIT_CRITICAL(sr);
+}
+
+#endif // RNG_CACHE_ENABLED
@@ -0,0 +1,117 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file rng_cli.c
+ * @author paul kettle
+ * @date 2018
+ * @brief Ranging shell command
+ *
+ * @details Lists the per-peer ranging statistics, one JSON line per peer.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <os/os.h>
+#include <dw1000/dw1000_hal.h>
+#include <dw1000/dw1000_dev.h>
+#include <rng/rng.h>
+
+#if MYNEWT_VAL(RNG_PEERS_ENABLED) && MYNEWT_VAL(RNG_PEERS_CLI)
+
+#include <shell/shell.h>
+#include <console/console.h>
+
+static int rng_cli_cmd(int argc, char **argv);
+
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+const struct shell_param cmd_rng_param[] = {
+    {"peers", "[instance] list per-peer statistics"},
+    {"clear", "[instance] forget all peers"},
+    {NULL,NULL},
+};
+
+const struct shell_cmd_help cmd_rng_help = {
+	"rng", "ranging statistics", cmd_rng_param
+};
+#endif
+
+static struct shell_cmd shell_rng_cmd = {
+    .sc_cmd = "rng",
+    .sc_cmd_func = rng_cli_cmd,
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+    &cmd_rng_help
+#endif
+};
+
+static void
+rng_cli_peers(rng_peers_t * peers){
+    uint32_t utime = os_cputime_ticks_to_usecs(os_cputime_get32());
+
+    for (uint16_t k = 0; k < peers->npeers; k++){
+        rng_peer_stats_t peer = peers->peers[k];
+        float sd = (peer.successes > 1) ? sqrtf(peer.turnaround_m2 / (peer.successes - 1)) : 0;
+
+        console_printf("{\"addr\":\"0x%X\",\"attempts\":%lu,\"successes\":%lu,\"timeouts\":%lu,\"rx_errors\":%lu,"
+            "\"tx_errors\":%lu,\"fails\":%u,\"dead\":%d,\"age\":%lu,\"turnaround\":[%lu,%lu],"
+            "\"rssi\":%d,\"fppl\":%d,\"los\":%u}\n",
+            peer.addr, peer.attempts, peer.successes, peer.timeouts, peer.rx_errors, peer.tx_errors, peer.fails,
+            rng_peers_dead(&peer), (peer.successes) ? utime - peer.last_success : 0,
+            (uint32_t)peer.turnaround, (uint32_t)sd, peer.rssi, peer.fppl, peer.los);
+    }
+}
+
+static int
+rng_cli_cmd(int argc, char **argv)
+{
+    if (argc < 2) {
+        console_printf("Too few args\n");
+        return 0;
+    }
+    dw1000_dev_instance_t * inst = hal_dw1000_inst((argc < 3) ? 0 : strtol(argv[2], NULL, 0));
+    if (inst->rng == NULL || inst->rng->peers == NULL) {
+        console_printf("No rng instance\n");
+        return 0;
+    }
+
+    if (!strcmp(argv[1], "peers")) {
+        rng_cli_peers(inst->rng->peers);
+    } else if (!strcmp(argv[1], "clear")) {
+        rng_peers_clear(inst->rng->peers);
+    } else {
+        console_printf("Unknown cmd\n");
+    }
+    return 0;
+}
+
+#endif
+
+int
+rng_cli_register(void)
+{
+#if MYNEWT_VAL(RNG_PEERS_ENABLED) && MYNEWT_VAL(RNG_PEERS_CLI)
+    return shell_cmd_register(&shell_rng_cmd);
+#else
+    return 0;
+#endif
+}
@@ -26,12 +26,68 @@
 #include <dw1000/dw1000_mac.h>
 #include <rng/rng_encode.h>
 
+#if MYNEWT_VAL(TELEMETRY_ENABLED)
+#include <telemetry/telemetry.h>
+#endif
+
 #if MYNEWT_VAL(RNG_VERBOSE)
 
+/**
+ * Emits one range either as a binary telemetry record or as a JSON line.
+ *
+ * @param frame           Final frame of the exchange.
+ * @param time_of_flight  Time of flight, DTU.
+ * @param range           Range, m.
+ * @param azimuth         Azimuth, rad, JSON output only.
+ * @param has_azimuth     Azimuth is printed, JSON output only.
+ *
+ * @return void
+ */
+static void
+rng_emit(twr_frame_t * frame, float time_of_flight, float range, float azimuth, bool has_azimuth){
+
+    uint32_t utime = os_cputime_ticks_to_usecs(os_cputime_get32());
+    uint32_t res_req = frame->response_timestamp - frame->request_timestamp;
+    uint32_t rec_tra = frame->transmission_timestamp - frame->reception_timestamp;
+
+#if MYNEWT_VAL(TELEMETRY_ENABLED)
+    telemetry_rng_t record = {
+        .utime = utime,
+        .code = frame->code,
+        .seq_num = frame->seq_num,
+        .tof = time_of_flight,
+        .range = range,
+        .res_req = res_req,
+        .rec_tra = rec_tra
+    };
+    telemetry_write(TELEMETRY_RNG, &record, sizeof(record));
+#else
+    if (!has_azimuth)
+        printf("{\"utime\": %lu,\"tof\": %lu,\"range\": %lu,\"res_req\": \"%lX\","
+                " \"rec_tra\": \"%lX\"}\n",
+                utime,
+                *(uint32_t *)(&time_of_flight), 
+                *(uint32_t *)(&range),
+                res_req,
+                rec_tra
+        );
+    else
+        printf("{\"utime\": %lu,\"tof\": %lu,\"range\": %lu,\"azimuth\": %lu,\"res_req\":\"%lX\","
+                " \"rec_tra\": \"%lX\"}\n",
+                utime,
+                *(uint32_t *)(&time_of_flight), 
+                *(uint32_t *)(&range),
+                *(uint32_t *)(&azimuth),
+                res_req,
+                rec_tra
+        );
+#endif
+}
+
 /*! 
  * @fn rng_encodestruct os_event * ev)
  *
- * @brief JSON encoding of range
+ * @brief JSON or binary encoding of range
  * 
  * input parameters
  * @param inst - struct os_event *  
@@ -46,47 +102,19 @@ rng_encode(dw1000_rng_instance_t * rng) {
 
     if (frame->code == DWT_SS_TWR_FINAL) {
         float time_of_flight = (float) dw1000_rng_twr_to_tof(rng, idx);
-        float range = dw1000_rng_tof_to_meters(time_of_flight);
-        printf("{\"utime\": %lu,\"tof\": %lu,\"range\": %lu,\"res_req\": \"%lX\","
-                " \"rec_tra\": \"%lX\"}\n",
-                os_cputime_ticks_to_usecs(os_cputime_get32()),
-                *(uint32_t *)(&time_of_flight), 
-                *(uint32_t *)(&range),
-                (frame->response_timestamp - frame->request_timestamp),
-                (frame->transmission_timestamp - frame->reception_timestamp)
-        );
+        rng_emit(frame, time_of_flight, dw1000_rng_tof_to_meters(time_of_flight), 0, false);
         frame->code = DWT_SS_TWR_END;
     }
     else if (frame->code == DWT_DS_TWR_FINAL) {
         float time_of_flight = dw1000_rng_twr_to_tof(rng, idx);
-        float range = dw1000_rng_tof_to_meters(time_of_flight);
-        printf("{\"utime\": %lu,\"tof\": %lu,\"range\": %lu,\"azimuth\": %lu,\"res_req\":\"%lX\","
-                " \"rec_tra\": \"%lX\"}\n",
-                os_cputime_ticks_to_usecs(os_cputime_get32()), 
-                *(uint32_t *)(&time_of_flight), 
-                *(uint32_t *)(&range),
-                *(uint32_t *)(&frame->spherical.azimuth),
-                (frame->response_timestamp - frame->request_timestamp),
-                (frame->transmission_timestamp - frame->reception_timestamp)
-        );
+        rng_emit(frame, time_of_flight, dw1000_rng_tof_to_meters(time_of_flight), frame->spherical.azimuth, true);
         frame->code = DWT_DS_TWR_END;
     } 
     else if (frame->code == DWT_DS_TWR_EXT_FINAL) {
         float time_of_flight = dw1000_rng_twr_to_tof(rng, idx);
-        printf("{\"utime\": %lu,\"tof\": %lu,\"range\": %lu,\"azimuth\": %lu,\"res_req\":\"%lX\","
-                " \"rec_tra\": \"%lX\"}\n",
-                os_cputime_ticks_to_usecs(os_cputime_get32()), 
-                *(uint32_t *)(&time_of_flight), 
-                *(uint32_t *)(&frame->spherical.range),
-                *(uint32_t *)(&frame->spherical.azimuth),
-                (frame->response_timestamp - frame->request_timestamp),
-                (frame->transmission_timestamp - frame->reception_timestamp)
-        );
+        rng_emit(frame, time_of_flight, frame->spherical.range, frame->spherical.azimuth, true);
         frame->code = DWT_DS_TWR_END;
     } 
 }
 
 #endif
-
-
-
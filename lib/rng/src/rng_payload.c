@@ -0,0 +1,299 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file rng_payload.c
+ * @author paul kettle
+ * @date 2018
+ * @brief Application payload carried by ranging frames
+ *
+ * @details One payload is queued at a time. The application writes data[] before len, and the MAC task only reads
+ * data[] while len is set, so no lock is needed between rng_payload_send() and rng_payload_attach().
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <os/os.h>
+
+#include <dw1000/dw1000_dev.h>
+#include <dw1000/dw1000_mac.h>
+#include <dw1000/dw1000_phy.h>
+#include <rng/rng_payload.h>
+
+#if MYNEWT_VAL(RNG_PAYLOAD_ENABLED)
+
+#define RNG_PAYLOAD_FRAME_MAX (127 - 2)     //!< Standard frame, less the CRC
+
+STATS_NAME_START(rng_payload_stat_section)
+    STATS_NAME(rng_payload_stat_section, tx)
+    STATS_NAME(rng_payload_stat_section, rx)
+    STATS_NAME(rng_payload_stat_section, held)
+    STATS_NAME(rng_payload_stat_section, rejected)
+STATS_NAME_END(rng_payload_stat_section)
+
+/**
+ * API to initialise the payload of a ranging instance.
+ *
+ * @param payload  Pointer to rng_payload_t, allocated when NULL.
+ * @param name     Name the statistics are registered under with the stats module, NULL to not register.
+ *
+ * @return rng_payload_t*
+ */
+rng_payload_t *
+rng_payload_init(rng_payload_t * payload, const char * name){
+
+    if (payload == NULL){
+        payload = (rng_payload_t *) malloc(sizeof(rng_payload_t));
+        assert(payload);
+        memset(payload, 0, sizeof(rng_payload_t));
+        payload->status.selfmalloc = 1;
+    }
+    payload->len = 0;
+
+    int rc = stats_init(
+                    STATS_HDR(payload->stat),
+                    STATS_SIZE_INIT_PARMS(payload->stat, STATS_SIZE_32),
+                    STATS_NAME_INIT_PARMS(rng_payload_stat_section)
+            );
+    if (name)
+        rc |= stats_register(name, STATS_HDR(payload->stat));
+    assert(rc == 0);
+
+    payload->status.initialized = 1;
+    return payload;
+}
+
+/**
+ * API to free the allocated resources.
+ *
+ * @param payload  Pointer to rng_payload_t.
+ *
+ * @return void
+ */
+void
+rng_payload_free(rng_payload_t * payload){
+    assert(payload);
+    if (payload->status.selfmalloc)
+        free(payload);
+    else
+        payload->status.initialized = 0;
+}
+
+/**
+ * API to register the receive callback. The callback runs in the MAC task and must not block.
+ *
+ * @param payload  Pointer to rng_payload_t.
+ * @param cb       Receive callback, NULL to discard received payloads.
+ * @param arg      Callback argument.
+ *
+ * @return void
+ */
+void
+rng_payload_set_cb(rng_payload_t * payload, rng_payload_cb_t cb, void * arg){
+    os_sr_t sr;
+    OS_ENTER_CRITICAL(sr);
+    payload->rx_cb = cb;
+    payload->rx_arg = arg;
+    OS_EXIT_CRITICAL(sr);
+}
+
+/**
+ * API to queue a payload for the next ranging frame to a peer.
+ *
+ * @param payload      Pointer to rng_payload_t.
+ * @param dst_address  Short address of the peer, BROADCAST_ADDRESS for the next ranging frame to any peer.
+ * @param data         Payload.
+ * @param len          Payload length, at most RNG_PAYLOAD_MAX.
+ *
+ * @return OS_OK, OS_EINVAL if the payload is too long, OS_EBUSY if a payload is still queued
+ */
+int
+rng_payload_send(rng_payload_t * payload, uint16_t dst_address, const void * data, uint16_t len){
+
+    if (len == 0 || len > MYNEWT_VAL(RNG_PAYLOAD_MAX)){
+        STATS_INC(payload->stat, rejected);
+        return OS_EINVAL;
+    }
+    if (payload->len)
+        return OS_EBUSY;
+
+    memcpy(payload->data, data, len);
+    payload->dst_address = dst_address;
+    payload->len = len;
+    return OS_OK;
+}
+
+/**
+ * API to drop the queued payload.
+ *
+ * @param payload  Pointer to rng_payload_t.
+ *
+ * @return void
+ */
+void
+rng_payload_cancel(rng_payload_t * payload){
+    payload->len = 0;
+}
+
+/**
+ * API to look up the nominal length of a ranging frame.
+ *
+ * @param code  Frame code.
+ *
+ * @return Frame length less the CRC, 0 if the code does not carry a payload
+ */
+uint16_t
+rng_payload_frame_len(uint16_t code){
+    switch (code){
+        case DWT_SS_TWR:
+        case DWT_DS_TWR:
+        case DWT_DS_TWR_EXT:
+            return sizeof(ieee_rng_request_frame_t);
+        case DWT_SS_TWR_T1:
+        case DWT_DS_TWR_T1:
+        case DWT_DS_TWR_EXT_T1:
+            return sizeof(ieee_rng_response_frame_t);
+        case DWT_SS_TWR_FINAL:
+        case DWT_DS_TWR_T2:
+        case DWT_DS_TWR_FINAL:
+            return sizeof(twr_frame_final_t);
+        case DWT_DS_TWR_EXT_T2:
+        case DWT_DS_TWR_EXT_FINAL:
+            return sizeof(twr_frame_t);
+        default:
+            return 0;
+    }
+}
+
+/**
+ * API to calculate the largest payload a frame can carry: the space left in a standard frame and the bytes that fit in
+ * the slack of the receiver. For a request that is the tx_holdoff_delay of the ranging mode less the time the responder
+ * needs for the nominal request, RNG_PAYLOAD_PROCESSING past its end; for other frames, which the other side receives
+ * with a timeout, it is the rx_timeout_period of the ranging mode.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @param code  Frame code.
+ *
+ * @return Payload limit in bytes
+ */
+uint16_t
+rng_payload_limit(dw1000_dev_instance_t * inst, uint16_t code){
+
+    uint16_t nominal = rng_payload_frame_len(code);
+    if (nominal == 0)
+        return 0;
+
+    uint16_t limit = RNG_PAYLOAD_FRAME_MAX - nominal;
+    if (limit > MYNEWT_VAL(RNG_PAYLOAD_MAX))
+        limit = MYNEWT_VAL(RNG_PAYLOAD_MAX);
+
+    dw1000_rng_modes_t mode;
+    switch (code){
+        case DWT_SS_TWR:
+        case DWT_DS_TWR:
+        case DWT_DS_TWR_EXT:
+            mode = code;
+            break;
+        case DWT_SS_TWR_T1 ... DWT_SS_TWR_END:
+            mode = DWT_SS_TWR;
+            break;
+        case DWT_DS_TWR_T1 ... DWT_DS_TWR_END:
+            mode = DWT_DS_TWR;
+            break;
+        default:
+            mode = DWT_DS_TWR_EXT;
+            break;
+    }
+    dw1000_rng_config_t * config = dw1000_rng_get_config(inst, mode);
+    uint32_t slack = config->rx_timeout_period;
+    if (code == mode){
+        // The response is scheduled tx_holdoff_delay after the RMARKER of the request, at the end of its SHR
+        uint32_t processing = dw1000_phy_frame_duration(&inst->attrib, nominal)
+                - dw1000_phy_SHR_duration(&inst->attrib) + MYNEWT_VAL(RNG_PAYLOAD_PROCESSING);
+        slack = (config->tx_holdoff_delay > processing) ? config->tx_holdoff_delay - processing : 0;
+    }
+    uint16_t fit = (uint16_t)(slack / (8 * inst->attrib.Tdsym));
+    return (fit < limit) ? fit : limit;
+}
+
+/**
+ * API to append the queued payload to a frame, if it is for the peer of the frame and fits. Called by
+ * dw1000_rng_write_tx() before the frame control is written.
+ *
+ * @param inst   Pointer to dw1000_dev_instance_t.
+ * @param frame  Frame about to be transmitted.
+ * @param len    Nominal frame length, the payload is written at this offset of the transmit buffer.
+ *
+ * @return Number of payload bytes appended
+ */
+uint16_t
+rng_payload_attach(dw1000_dev_instance_t * inst, twr_frame_t * frame, uint16_t len){
+
+    rng_payload_t * payload = inst->rng->payload;
+    uint16_t n = payload->len;
+
+    if (n == 0 || len != rng_payload_frame_len(frame->code))
+        return 0;
+    if (payload->dst_address != BROADCAST_ADDRESS && payload->dst_address != frame->dst_address)
+        return 0;
+    if (n > rng_payload_limit(inst, frame->code)){
+        STATS_INC(payload->stat, held);
+        return 0;
+    }
+
+    dw1000_write_tx(inst, payload->data, len, n);
+    payload->len = 0;
+    STATS_INC(payload->stat, tx);
+    return n;
+}
+
+/**
+ * API to hand the payload of a received frame to the receive callback and strip it from the frame. Called from the
+ * rng receive callback, ahead of the twr modules.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ *
+ * @return void
+ */
+void
+rng_payload_strip(dw1000_dev_instance_t * inst){
+
+    rng_payload_t * payload = inst->rng->payload;
+    twr_frame_t * frame = (twr_frame_t *) inst->rxbuf;
+
+    if (inst->frame_len < sizeof(ieee_rng_request_frame_t))
+        return;
+    uint16_t nominal = rng_payload_frame_len(frame->code);
+    if (nominal == 0 || inst->frame_len <= nominal)
+        return;
+
+    uint16_t n = inst->frame_len - nominal;
+    inst->frame_len = nominal;
+    if (frame->dst_address != inst->my_short_address && frame->dst_address != BROADCAST_ADDRESS)
+        return;
+
+    STATS_INC(payload->stat, rx);
+    if (payload->rx_cb)
+        payload->rx_cb(inst, frame->src_address, frame->code, &inst->rxbuf[nominal], n, payload->rx_arg);
+}
+
+#endif // RNG_PAYLOAD_ENABLED
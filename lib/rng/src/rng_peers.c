@@ -0,0 +1,345 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file rng_peers.c
+ * @author paul kettle
+ * @date 2018
+ * @brief Per-peer ranging statistics
+ *
+ * @details Peers are only added by rng_peers_start(), from the task issuing the request; the MAC callbacks update the
+ * peer of the exchange in flight, which is never evicted. The hash table holds indices into peers[] and is kept at
+ * least twice the size of the peer cap, see dsp/keytab.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <os/os.h>
+
+#include <rng/rng_peers.h>
+
+#if MYNEWT_VAL(RNG_PEERS_ENABLED)
+
+STATS_NAME_START(rng_peers_stat_section)
+    STATS_NAME(rng_peers_stat_section, attempts)
+    STATS_NAME(rng_peers_stat_section, successes)
+    STATS_NAME(rng_peers_stat_section, timeouts)
+    STATS_NAME(rng_peers_stat_section, rx_errors)
+    STATS_NAME(rng_peers_stat_section, tx_errors)
+    STATS_NAME(rng_peers_stat_section, dead)
+    STATS_NAME(rng_peers_stat_section, skipped)
+    STATS_NAME(rng_peers_stat_section, evictions)
+STATS_NAME_END(rng_peers_stat_section)
+
+static uint32_t
+rng_peers_key(const void * arg, uint16_t idx){
+    return ((const rng_peers_t *) arg)->peers[idx].addr;
+}
+
+/**
+ * Removes the peer at index k, keeping peers[] dense.
+ */
+static void
+rng_peers_remove(rng_peers_t * peers, uint16_t k){
+    keytab_remove(&peers->tab, peers->peers[k].addr);
+    uint16_t last = --peers->npeers;
+    if (k != last){
+        keytab_move(&peers->tab, last, k);
+        peers->peers[k] = peers->peers[last];
+    }
+}
+
+/**
+ * API to initialise a per-peer statistics table.
+ *
+ * @param peers  Pointer to rng_peers_t, allocated when NULL.
+ * @param cap    Maximum number of peers.
+ * @param name   Name the totals are registered under with the stats module, NULL to not register.
+ *
+ * @return rng_peers_t*
+ */
+rng_peers_t *
+rng_peers_init(rng_peers_t * peers, uint16_t cap, const char * name){
+
+    uint16_t nslots = keytab_nslots(cap);
+
+    if (peers == NULL){
+        size_t size = sizeof(rng_peers_t) + cap * sizeof(rng_peer_stats_t) + nslots * sizeof(uint16_t);
+        peers = (rng_peers_t *) malloc(size);
+        assert(peers);
+        memset(peers, 0, size);
+        peers->status.selfmalloc = 1;
+    }else{
+        assert(peers->cap == cap);
+    }
+    peers->cap = cap;
+    keytab_init(&peers->tab, (uint16_t *) &peers->peers[cap], nslots, rng_peers_key, peers);
+    rng_peers_clear(peers);
+
+    int rc = stats_init(
+                    STATS_HDR(peers->stat),
+                    STATS_SIZE_INIT_PARMS(peers->stat, STATS_SIZE_32),
+                    STATS_NAME_INIT_PARMS(rng_peers_stat_section)
+            );
+    if (name)
+        rc |= stats_register(name, STATS_HDR(peers->stat));
+    assert(rc == 0);
+
+    peers->status.initialized = 1;
+    return peers;
+}
+
+/**
+ * API to free the allocated resources.
+ *
+ * @param peers  Pointer to rng_peers_t.
+ *
+ * @return void
+ */
+void
+rng_peers_free(rng_peers_t * peers){
+    assert(peers);
+    if (peers->status.selfmalloc)
+        free(peers);
+    else
+        peers->status.initialized = 0;
+}
+
+/**
+ * API to forget all peers.
+ *
+ * @param peers  Pointer to rng_peers_t.
+ *
+ * @return void
+ */
+void
+rng_peers_clear(rng_peers_t * peers){
+    os_sr_t sr;
+    OS_ENTER_CRITICAL(sr);
+    peers->npeers = 0;
+    peers->pending = RNG_PEERS_NONE;
+    keytab_clear(&peers->tab);
+    OS_EXIT_CRITICAL(sr);
+}
+
+/**
+ * API to look up the statistics of a peer.
+ *
+ * @param peers  Pointer to rng_peers_t.
+ * @param addr   Short address of the peer.
+ *
+ * @return rng_peer_stats_t*, NULL if the peer is not tracked
+ */
+rng_peer_stats_t *
+rng_peers_lookup(rng_peers_t * peers, uint16_t addr){
+    uint16_t k = keytab_lookup(&peers->tab, addr);
+    return (k == KEYTAB_NONE) ? NULL : &peers->peers[k];
+}
+
+/**
+ * API to record the start of an exchange with a peer, adding the peer if needed.
+ *
+ * @param peers  Pointer to rng_peers_t.
+ * @param addr   Short address of the peer.
+ * @param utime  Current time, usec.
+ *
+ * @return void
+ */
+void
+rng_peers_start(rng_peers_t * peers, uint16_t addr, uint32_t utime){
+
+    os_sr_t sr;
+    OS_ENTER_CRITICAL(sr);
+    uint16_t i = keytab_find_slot(&peers->tab, addr);
+    if (peers->tab.slots[i] == KEYTAB_NONE){
+        if (peers->npeers == peers->cap){
+            uint16_t oldest = 0;
+            for (uint16_t k = 1; k < peers->npeers; k++)
+                if ((int32_t)(peers->peers[k].utime - peers->peers[oldest].utime) < 0)
+                    oldest = k;
+            rng_peers_remove(peers, oldest);
+            STATS_INC(peers->stat, evictions);
+            i = keytab_find_slot(&peers->tab, addr);
+        }
+        uint16_t k = peers->npeers++;
+        peers->tab.slots[i] = k;
+        memset(&peers->peers[k], 0, sizeof(rng_peer_stats_t));
+        peers->peers[k].addr = addr;
+    }
+    rng_peer_stats_t * peer = &peers->peers[peers->tab.slots[i]];
+    peer->attempts++;
+    peer->utime = utime;
+    peers->pending = addr;
+    peers->t0 = utime;
+    OS_EXIT_CRITICAL(sr);
+    STATS_INC(peers->stat, attempts);
+}
+
+/**
+ * API to record the completion of the exchange in flight.
+ *
+ * @param peers  Pointer to rng_peers_t.
+ * @param addr   Short address of the peer in the final frame.
+ * @param utime  Current time, usec.
+ * @param rssi   Received signal level, cdBm.
+ * @param fppl   First path power level, cdBm.
+ * @param los    Line-of-sight estimate, 0 (NLOS) to 255 (LOS).
+ *
+ * @return void
+ */
+void
+rng_peers_success(rng_peers_t * peers, uint16_t addr, uint32_t utime, int16_t rssi, int16_t fppl, uint8_t los){
+
+    if (peers->pending == RNG_PEERS_NONE || peers->pending != addr)
+        return;
+    rng_peer_stats_t * peer = rng_peers_lookup(peers, addr);
+    peers->pending = RNG_PEERS_NONE;
+    if (peer == NULL)
+        return;
+
+    // Welford update of the exchange duration
+    float x = (float)(utime - peers->t0);
+    peer->successes++;
+    float delta = x - peer->turnaround;
+    peer->turnaround += delta / peer->successes;
+    peer->turnaround_m2 += delta * (x - peer->turnaround);
+
+    peer->fails = 0;
+    peer->last_success = utime;
+    peer->rssi = rssi;
+    peer->fppl = fppl;
+    peer->los = los;
+    STATS_INC(peers->stat, successes);
+}
+
+/**
+ * API to record the failure of the exchange in flight.
+ *
+ * @param peers   Pointer to rng_peers_t.
+ * @param reason  Outcome of the exchange.
+ *
+ * @return void
+ */
+void
+rng_peers_fail(rng_peers_t * peers, rng_peer_fail_t reason){
+
+    if (peers->pending == RNG_PEERS_NONE){
+#if MYNEWT_VAL(RNG_TIMEOUT_ENABLED)
+        peers->timeout.armed = false;
+#endif
+        return;
+    }
+    rng_peer_stats_t * peer = rng_peers_lookup(peers, peers->pending);
+    peers->pending = RNG_PEERS_NONE;
+#if MYNEWT_VAL(RNG_TIMEOUT_ENABLED)
+    if (reason == RNG_PEER_TIMEOUT)
+        rng_timeout_expired((peer) ? &peer->timeout : NULL, &peers->timeout);
+    else
+        peers->timeout.armed = false;
+#endif
+    if (peer == NULL)
+        return;
+
+    switch (reason){
+        case RNG_PEER_TIMEOUT:
+            peer->timeouts++;
+            STATS_INC(peers->stat, timeouts);
+            break;
+        case RNG_PEER_RX_ERROR:
+            peer->rx_errors++;
+            STATS_INC(peers->stat, rx_errors);
+            break;
+        case RNG_PEER_TX_ERROR:
+            peer->tx_errors++;
+            STATS_INC(peers->stat, tx_errors);
+            break;
+    }
+    if (++peer->fails == MYNEWT_VAL(RNG_PEERS_DEAD_FAILS))
+        STATS_INC(peers->stat, dead);
+}
+
+/**
+ * API to test whether a peer failed too many exchanges in a row.
+ *
+ * @param peer  Pointer to rng_peer_stats_t.
+ *
+ * @return true if the peer is dead
+ */
+bool
+rng_peers_dead(const rng_peer_stats_t * peer){
+    return peer->fails >= MYNEWT_VAL(RNG_PEERS_DEAD_FAILS);
+}
+
+/**
+ * API for schedulers to decide whether to spend airtime on a peer. Unknown and live peers are always offered; a dead
+ * peer is offered once RNG_PEERS_RETRY usec have passed since it was last tried.
+ *
+ * @param peers  Pointer to rng_peers_t.
+ * @param addr   Short address of the peer.
+ * @param utime  Current time, usec.
+ *
+ * @return true if the peer should be ranged with
+ */
+bool
+rng_peers_alive(rng_peers_t * peers, uint16_t addr, uint32_t utime){
+    rng_peer_stats_t * peer = rng_peers_lookup(peers, addr);
+    if (peer == NULL || !rng_peers_dead(peer) || utime - peer->utime >= MYNEWT_VAL(RNG_PEERS_RETRY))
+        return true;
+    STATS_INC(peers->stat, skipped);
+    return false;
+}
+
+#if MYNEWT_VAL(RNG_TIMEOUT_ENABLED)
+/**
+ * API to select the response timeout of the exchange in flight, from the turnarounds of its peer.
+ *
+ * @param peers    Pointer to rng_peers_t.
+ * @param nominal  Static timeout of the ranging mode, usec.
+ * @param fixed    Response frame duration, usec.
+ *
+ * @return Timeout in usec
+ */
+uint16_t
+rng_peers_rx_timeout(rng_peers_t * peers, uint16_t nominal, uint16_t fixed){
+    rng_peer_stats_t * peer = (peers->pending == RNG_PEERS_NONE) ? NULL : rng_peers_lookup(peers, peers->pending);
+    return rng_timeout_select((peer) ? &peer->timeout : NULL, &peers->timeout, nominal, fixed);
+}
+
+/**
+ * API to record the turnaround of the response to the exchange in flight.
+ *
+ * @param peers       Pointer to rng_peers_t.
+ * @param addr        Short address of the responder.
+ * @param turnaround  Request transmission to response reception, usec.
+ *
+ * @return void
+ */
+void
+rng_peers_response(rng_peers_t * peers, uint16_t addr, uint16_t turnaround){
+    if (peers->pending == RNG_PEERS_NONE || peers->pending != addr || !peers->timeout.armed)
+        return;
+    rng_peer_stats_t * peer = rng_peers_lookup(peers, addr);
+    rng_timeout_sample((peer) ? &peer->timeout : NULL, &peers->timeout, turnaround);
+}
+#endif
+
+#endif // RNG_PEERS_ENABLED
@@ -0,0 +1,211 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file rng_stream.c
+ * @author paul kettle
+ * @date 2018
+ * @brief Range result stream
+ *
+ * @details The producer first advances reserve, writes the slot and then advances head. A reader copies a slot and
+ * then checks reserve; if the producer has claimed that slot again in the meantime the copy is discarded and counted
+ * as a drop. Neither side takes a lock, so a stalled consumer can never hold up the MAC task.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <os/os.h>
+
+#include <rng/rng_stream.h>
+
+#if MYNEWT_VAL(RNG_STREAM_ENABLED)
+
+/**
+ * API to initialise a range result stream.
+ *
+ * @param stream    Pointer to rng_stream_t, allocated when NULL.
+ * @param nrecords  Ring size, must be a power of two.
+ *
+ * @return rng_stream_t*
+ */
+rng_stream_t *
+rng_stream_init(rng_stream_t * stream, uint16_t nrecords){
+
+    assert(nrecords && (nrecords & (nrecords - 1)) == 0);
+
+    if (stream == NULL){
+        stream = (rng_stream_t *) malloc(sizeof(rng_stream_t) + nrecords * sizeof(rng_record_t));
+        assert(stream);
+        memset(stream, 0, sizeof(rng_stream_t) + nrecords * sizeof(rng_record_t));
+        stream->status.selfmalloc = 1;
+    }
+    stream->mask = nrecords - 1;
+    stream->head = stream->reserve = 0;
+    SLIST_INIT(&stream->subscribers);
+    stream->status.initialized = 1;
+    return stream;
+}
+
+/**
+ * API to free the allocated resources.
+ *
+ * @param stream  Pointer to rng_stream_t.
+ *
+ * @return void
+ */
+void
+rng_stream_free(rng_stream_t * stream){
+    assert(stream);
+    if (stream->status.selfmalloc)
+        free(stream);
+    else
+        stream->status.initialized = 0;
+}
+
+/**
+ * API to append a record to the stream. Must only be called from a single task, normally the MAC task of the device.
+ * Subscribers with an event queue are notified; the event is not re-queued while still pending.
+ *
+ * @param stream  Pointer to rng_stream_t.
+ * @param record  Record to copy into the ring.
+ *
+ * @return void
+ */
+void
+rng_stream_publish(rng_stream_t * stream, const rng_record_t * record){
+
+    uint32_t head = stream->head;
+
+    stream->reserve = head + 1;
+    __sync_synchronize();
+    stream->records[head & stream->mask] = *record;
+    __sync_synchronize();
+    stream->head = head + 1;
+
+    rng_subscriber_t * sub;
+    os_sr_t sr;
+    OS_ENTER_CRITICAL(sr);
+    SLIST_FOREACH(sub, &stream->subscribers, next){
+        if (sub->eventq)
+            os_eventq_put(sub->eventq, &sub->event);
+    }
+    OS_EXIT_CRITICAL(sr);
+}
+
+/**
+ * API to register a subscriber. The subscriber only sees records published after this call.
+ *
+ * @param stream  Pointer to rng_stream_t.
+ * @param sub     Pointer to caller owned rng_subscriber_t.
+ * @param eventq  Queue to notify on publish, NULL to poll.
+ * @param cb      Event callback, ignored when eventq is NULL.
+ * @param arg     Event argument.
+ *
+ * @return void
+ */
+void
+rng_stream_subscribe(rng_stream_t * stream, rng_subscriber_t * sub, struct os_eventq * eventq, os_event_fn * cb, void * arg){
+
+    assert(stream);
+    assert(sub);
+
+    memset(sub, 0, sizeof(rng_subscriber_t));
+    sub->eventq = eventq;
+    sub->event.ev_cb = cb;
+    sub->event.ev_arg = arg;
+
+    os_sr_t sr;
+    OS_ENTER_CRITICAL(sr);
+    sub->tail = stream->head;
+    SLIST_INSERT_HEAD(&stream->subscribers, sub, next);
+    OS_EXIT_CRITICAL(sr);
+}
+
+/**
+ * API to remove a subscriber.
+ *
+ * @param stream  Pointer to rng_stream_t.
+ * @param sub     Pointer to rng_subscriber_t.
+ *
+ * @return void
+ */
+void
+rng_stream_unsubscribe(rng_stream_t * stream, rng_subscriber_t * sub){
+
+    os_sr_t sr;
+    OS_ENTER_CRITICAL(sr);
+    SLIST_REMOVE(&stream->subscribers, sub, _rng_subscriber_t, next);
+    OS_EXIT_CRITICAL(sr);
+    if (sub->eventq)
+        os_eventq_remove(sub->eventq, &sub->event);
+}
+
+/**
+ * API to read the next record for a subscriber. Records overwritten before they could be read are skipped and added
+ * to sub->drops.
+ *
+ * @param stream  Pointer to rng_stream_t.
+ * @param sub     Pointer to rng_subscriber_t.
+ * @param record  Destination of the record.
+ *
+ * @return true if a record was returned, false when the subscriber is up to date
+ */
+bool
+rng_stream_read(rng_stream_t * stream, rng_subscriber_t * sub, rng_record_t * record){
+
+    uint32_t size = (uint32_t) stream->mask + 1;
+
+    while (sub->tail != stream->head){
+        uint32_t head = stream->head;
+        if (head - sub->tail > size){
+            sub->drops += head - sub->tail - size;
+            sub->tail = head - size;
+        }
+        __sync_synchronize();
+        *record = stream->records[sub->tail & stream->mask];
+        __sync_synchronize();
+        if (stream->reserve - sub->tail > size){
+            // Slot reclaimed by the producer during the copy
+            sub->drops++;
+            sub->tail++;
+            continue;
+        }
+        sub->tail++;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * API to query the number of records waiting for a subscriber, including any that will be reported as drops.
+ *
+ * @param stream  Pointer to rng_stream_t.
+ * @param sub     Pointer to rng_subscriber_t.
+ *
+ * @return Number of records
+ */
+uint32_t
+rng_stream_pending(rng_stream_t * stream, rng_subscriber_t * sub){
+    return stream->head - sub->tail;
+}
+
+#endif // RNG_STREAM_ENABLED
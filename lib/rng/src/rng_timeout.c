@@ -0,0 +1,189 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file rng_timeout.c
+ * @author paul kettle
+ * @date 2018
+ * @brief Adaptive receive timeouts
+ *
+ * @details Shared by rng (one window per peer, see rng_peers) and nranges (one window for the first response slot).
+ * The window is small, so the percentile is taken by sorting a copy at request time rather than maintaining an
+ * order statistic on every sample from the MAC callbacks.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <os/os.h>
+
+#include <rng/rng_timeout.h>
+
+#if MYNEWT_VAL(RNG_TIMEOUT_ENABLED) || MYNEWT_VAL(NRNG_TIMEOUT_ENABLED)
+
+STATS_NAME_START(rng_timeout_stat_section)
+    STATS_NAME(rng_timeout_stat_section, adaptive)
+    STATS_NAME(rng_timeout_stat_section, nominal)
+    STATS_NAME(rng_timeout_stat_section, extended)
+    STATS_NAME(rng_timeout_stat_section, expired)
+    STATS_NAME(rng_timeout_stat_section, backoffs)
+    STATS_NAME(rng_timeout_stat_section, saved_usec)
+STATS_NAME_END(rng_timeout_stat_section)
+
+/**
+ * API to initialise the timeout accounting of a ranging instance.
+ *
+ * @param acct  Pointer to rng_timeout_acct_t.
+ * @param name  Name the totals are registered under with the stats module, NULL to not register.
+ *
+ * @return 0 on success
+ */
+int
+rng_timeout_acct_init(rng_timeout_acct_t * acct, const char * name){
+    acct->armed = false;
+    int rc = stats_init(
+                    STATS_HDR(acct->stat),
+                    STATS_SIZE_INIT_PARMS(acct->stat, STATS_SIZE_32),
+                    STATS_NAME_INIT_PARMS(rng_timeout_stat_section)
+            );
+    if (name)
+        rc |= stats_register(name, STATS_HDR(acct->stat));
+    return rc;
+}
+
+/**
+ * API to forget the turnarounds of a responder.
+ *
+ * @param est  Pointer to rng_timeout_t.
+ *
+ * @return void
+ */
+void
+rng_timeout_init(rng_timeout_t * est){
+    memset(est, 0, sizeof(rng_timeout_t));
+}
+
+/**
+ * API to read the RNG_TIMEOUT_PERCENTILE turnaround of the window.
+ *
+ * @param est  Pointer to rng_timeout_t.
+ *
+ * @return Turnaround in usec, 0 if the window is empty
+ */
+uint16_t
+rng_timeout_percentile(const rng_timeout_t * est){
+
+    uint16_t sorted[MYNEWT_VAL(RNG_TIMEOUT_WINDOW)];
+    uint16_t n = est->nsamples;
+    if (n == 0)
+        return 0;
+
+    for (uint16_t i = 0; i < n; i++){
+        uint16_t x = est->window[i];
+        uint16_t j = i;
+        for (; j > 0 && sorted[j - 1] > x; j--)
+            sorted[j] = sorted[j - 1];
+        sorted[j] = x;
+    }
+    uint16_t k = (n * MYNEWT_VAL(RNG_TIMEOUT_PERCENTILE) + 99) / 100;
+    return sorted[(k > 0) ? k - 1 : 0];
+}
+
+/**
+ * API to select the timeout of a request. The adaptive timeout replaces the variable part of the static one, the
+ * fixed part (response frame durations, slot spacing) is added back.
+ *
+ * @param est      Pointer to rng_timeout_t of the responder, NULL if it is not tracked.
+ * @param acct     Pointer to rng_timeout_acct_t.
+ * @param nominal  Static timeout, usec.
+ * @param fixed    Part of the timeout that does not depend on the responder turnaround, usec.
+ *
+ * @return Timeout in usec
+ */
+uint16_t
+rng_timeout_select(rng_timeout_t * est, rng_timeout_acct_t * acct, uint16_t nominal, uint16_t fixed){
+
+    uint32_t timeout = nominal;
+    uint32_t cap = (nominal > MYNEWT_VAL(RNG_TIMEOUT_MAX)) ? nominal : MYNEWT_VAL(RNG_TIMEOUT_MAX);
+
+    if (est && est->nsamples >= MYNEWT_VAL(RNG_TIMEOUT_MIN_SAMPLES)){
+        timeout = (uint32_t)fixed + rng_timeout_percentile(est) + MYNEWT_VAL(RNG_TIMEOUT_MARGIN);
+        STATS_INC(acct->stat, adaptive);
+    }else{
+        STATS_INC(acct->stat, nominal);
+    }
+    if (est)
+        timeout <<= est->backoff;
+    if (timeout > cap)
+        timeout = cap;
+    if (timeout > nominal)
+        STATS_INC(acct->stat, extended);
+
+    acct->nominal = nominal;
+    acct->applied = timeout;
+    acct->armed = true;
+    return timeout;
+}
+
+/**
+ * API to record the turnaround of a response to the request in flight.
+ *
+ * @param est         Pointer to rng_timeout_t of the responder, NULL if it is not tracked.
+ * @param acct        Pointer to rng_timeout_acct_t.
+ * @param turnaround  Request transmission to response reception, usec.
+ *
+ * @return void
+ */
+void
+rng_timeout_sample(rng_timeout_t * est, rng_timeout_acct_t * acct, uint16_t turnaround){
+    acct->armed = false;
+    if (est == NULL)
+        return;
+    est->window[est->head] = turnaround;
+    est->head = (est->head + 1) % MYNEWT_VAL(RNG_TIMEOUT_WINDOW);
+    if (est->nsamples < MYNEWT_VAL(RNG_TIMEOUT_WINDOW))
+        est->nsamples++;
+    est->backoff = 0;
+}
+
+/**
+ * API to record the expiry of the timeout in flight.
+ *
+ * @param est   Pointer to rng_timeout_t of the responder, NULL if it is not tracked.
+ * @param acct  Pointer to rng_timeout_acct_t.
+ *
+ * @return void
+ */
+void
+rng_timeout_expired(rng_timeout_t * est, rng_timeout_acct_t * acct){
+    if (!acct->armed)
+        return;
+    acct->armed = false;
+    STATS_INC(acct->stat, expired);
+    if (acct->applied < acct->nominal)
+        STATS_INCN(acct->stat, saved_usec, acct->nominal - acct->applied);
+    if (est && est->backoff < MYNEWT_VAL(RNG_TIMEOUT_BACKOFF_MAX)){
+        est->backoff++;
+        STATS_INC(acct->stat, backoffs);
+    }
+}
+
+#endif
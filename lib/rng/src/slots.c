@@ -93,3 +93,103 @@ uint32_t calc_nslots(uint32_t nslots_mask, uint32_t n, uint8_t mode) {
 
 
 
+
+
+/**
+ * Help function to encode a set of slots as a slot_map_t, choosing whichever of a bitmap or a list is shorter.
+ * A bitmap costs one byte per 8 slots of span, a list one byte per slot, so dense sets are sent as bitmaps
+ * and sparse ones as lists.
+ *
+ * @param slot_ids  ascending slot ids, lowest no greater than 255
+ * @param nslots    number of slot ids
+ * @param buf       output buffer
+ * @param size      size of buf
+ * @return length of the map in bytes, 0 if the ids are not ascending or the set cannot be encoded within size
+ */
+uint16_t slot_map_encode(const uint16_t * slot_ids, uint16_t nslots, uint8_t * buf, uint16_t size) {
+
+    if (nslots == 0 || slot_ids[0] > UINT8_MAX)
+        return 0;
+    // A bitmap would fold duplicates and reorder the slots, losing the positions the responders answer in
+    for (uint16_t i = 1; i < nslots; i++)
+        if (slot_ids[i] <= slot_ids[i - 1])
+            return 0;
+
+    uint16_t base = slot_ids[0];
+    uint16_t span = slot_ids[nslots - 1] - base + 1;
+    uint16_t bitmap_len = (span + 7) / 8;
+    uint16_t list_len = (span <= UINT8_MAX + 1) ? nslots : UINT16_MAX;
+    uint16_t len = (bitmap_len <= list_len) ? bitmap_len : list_len;
+
+    if (len > SLOT_MAP_DATA_MAX || sizeof(slot_map_t) + len > size)
+        return 0;
+
+    slot_map_t * map = (slot_map_t *) buf;
+    map->base = base;
+    map->len = len;
+    if (len == bitmap_len){
+        map->format = SLOT_MAP_BITMAP;
+        memset(map->data, 0, len);
+        for (uint16_t i = 0; i < nslots; i++){
+            uint16_t offset = slot_ids[i] - base;
+            map->data[offset / 8] |= 1 << (offset % 8);
+        }
+    }else{
+        map->format = SLOT_MAP_LIST;
+        for (uint16_t i = 0; i < nslots; i++)
+            map->data[i] = slot_ids[i] - base;
+    }
+    return sizeof(slot_map_t) + len;
+}
+
+/**
+ * Help function to count the slots within a slot map
+ *
+ * @param buf   slot map
+ * @param size  bytes available at buf
+ * @return number of slots, 0 if the map is truncated
+ */
+uint16_t slot_map_count(const uint8_t * buf, uint16_t size) {
+
+    const slot_map_t * map = (const slot_map_t *) buf;
+    if (size < sizeof(slot_map_t) || size < sizeof(slot_map_t) + map->len)
+        return 0;
+    if (map->format == SLOT_MAP_LIST)
+        return map->len;
+
+    uint16_t count = 0;
+    for (uint16_t j = 0; j < map->len; j++)
+        count += calc_nbits(map->data[j]);
+    return count;
+}
+
+/**
+ * Help function to calculate the numerical ordering of a slot within a slot map. The ordering counts from 1,
+ * as calc_nslots does in SLOT_POSITION mode.
+ *
+ * @param buf      slot map
+ * @param size     bytes available at buf
+ * @param slot_id  slot of interest
+ * @return position of the slot within the map, 0 if the slot is not in the map
+ */
+uint16_t slot_map_position(const uint8_t * buf, uint16_t size, uint16_t slot_id) {
+
+    const slot_map_t * map = (const slot_map_t *) buf;
+    if (size < sizeof(slot_map_t) || size < sizeof(slot_map_t) + map->len || slot_id < map->base)
+        return 0;
+
+    uint16_t offset = slot_id - map->base;
+    if (map->format == SLOT_MAP_LIST){
+        for (uint16_t i = 0; i < map->len && map->data[i] <= offset; i++)
+            if (map->data[i] == offset)
+                return i + 1;
+        return 0;
+    }
+
+    if (offset / 8 >= map->len || !(map->data[offset / 8] & (1 << (offset % 8))))
+        return 0;
+    uint16_t position = calc_nbits(map->data[offset / 8] & ((2 << (offset % 8)) - 1));
+    for (uint16_t j = 0; j < offset / 8; j++)
+        position += calc_nbits(map->data[j]);
+    return position;
+}
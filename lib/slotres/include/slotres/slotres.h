@@ -0,0 +1,173 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file slotres.h
+ * @author paul kettle
+ * @date 2018
+ * @brief Over the air TDMA slot reservation
+ *
+ * @details Nodes reserve TDMA slots of the CCP superframe from the master according to their traffic, instead of a
+ * slot fixed at provisioning. Two slots follow the CCP frame every superframe:
+ *  - the map slot, where the master broadcasts the slot map, see slotres_map.h, and acknowledges the request it
+ *    received in the previous superframe;
+ *  - the request slot, where nodes send requests to acquire, change, renew or release their slots. Requests
+ *    contend for the slot; a node that does not see its address acknowledged in the next map backs off.
+ * The reservable slots follow. A node runs the slot callback in its granted slots, only in superframes whose map it
+ * received, so a node that lost track of the map keeps off slots that may have been granted to another node.
+ *
+ * Nodes are identified by their short address, as assigned by PAN; start the service once it is known.
+ */
+
+#ifndef _SLOTRES_H_
+#define _SLOTRES_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <dw1000/dw1000_dev.h>
+#include <dw1000/dw1000_ftypes.h>
+#include <stats/stats.h>
+#include <slotres/slotres_map.h>
+
+#define FCNTL_IEEE_SLOTRES_16   0x8845      //!< Slot reservation frame control
+#define SLOTRES_MAP_ENTRIES     36          //!< Slot map entries that fit a 127 byte frame
+
+STATS_SECT_START(slotres_stat_section)
+    STATS_SECT_ENTRY(map_tx)
+    STATS_SECT_ENTRY(map_rx)
+    STATS_SECT_ENTRY(map_missed)
+    STATS_SECT_ENTRY(request_tx)
+    STATS_SECT_ENTRY(request_rx)
+    STATS_SECT_ENTRY(request_ack)
+    STATS_SECT_ENTRY(request_full)
+    STATS_SECT_ENTRY(grant_change)
+    STATS_SECT_ENTRY(slot_skipped)
+    STATS_SECT_ENTRY(busy)
+    STATS_SECT_ENTRY(tx_start_error)
+    STATS_SECT_ENTRY(rx_start_error)
+    STATS_SECT_ENTRY(rx_timeout)
+    STATS_SECT_ENTRY(reset)
+STATS_SECT_END
+
+//! Roles of the service
+typedef enum _slotres_role_t{
+    SLOTRES_ROLE_NODE,                      //!< Request slots and use those granted
+    SLOTRES_ROLE_MASTER                     //!< Arbitrate and broadcast the slot map, on the CCP master
+}slotres_role_t;
+
+//! Slot reservation frame codes
+typedef enum _slotres_code_t{
+    SLOTRES_CODE_INVALID = 0,               //!< Invalid
+    SLOTRES_CODE_MAP,                       //!< Slot map
+    SLOTRES_CODE_REQUEST                    //!< Slot request
+}slotres_code_t;
+
+//! Slot request frame
+typedef union{
+    struct _slotres_request_frame_t{
+        struct _ieee_std_frame_t;
+        uint8_t demand;                     //!< Slots per superframe, 0 releases the lease
+        uint16_t lease;                     //!< Lease, superframes
+    }__attribute__((__packed__, aligned(1)));
+    uint8_t array[sizeof(struct _slotres_request_frame_t)];
+}slotres_request_frame_t;
+
+//! Slot map frame, sent with nentries entries only
+typedef union{
+    struct _slotres_map_frame_t{
+        struct _ieee_std_frame_t;
+        uint8_t version;                    //!< Version of the map
+        uint16_t ack;                       //!< Node whose request was processed, SLOTRES_ADDR_NONE if none
+        uint16_t first;                     //!< First reservable slot
+        uint8_t nentries;                   //!< Number of entries
+        slotres_entry_t entries[SLOTRES_MAP_ENTRIES];   //!< Entries, in slot order
+    }__attribute__((__packed__, aligned(1)));
+    uint8_t array[sizeof(struct _slotres_map_frame_t)];
+}slotres_map_frame_t;
+
+//! Callback of a granted slot, in the tdma task
+typedef void (* slotres_slot_cb_t)(struct _dw1000_dev_instance_t * inst, uint16_t idx, void * arg);
+
+//! Status parameters
+typedef struct _slotres_status_t{
+    uint16_t selfmalloc:1;                  //!< Internal flag for memory garbage collection
+    uint16_t initialized:1;                 //!< Instance allocated
+    uint16_t started:1;                     //!< Map and request slots assigned
+    uint16_t start_tx_error:1;              //!< Set for start transmit error
+    uint16_t start_rx_error:1;              //!< Set for start receive error
+    uint16_t tx_pending:1;                  //!< Map or request in flight
+    uint16_t listening:1;                   //!< Map or request receive window open
+    uint16_t request_received:1;            //!< Master, request awaiting the next map
+    uint16_t map_received:1;                //!< Node, map awaiting the request slot
+    uint16_t synced:1;                      //!< Node, map of this superframe received
+}slotres_status_t;
+
+//! Config parameters
+typedef struct _slotres_config_t{
+    uint16_t role:1;                        //!< slotres_role_t
+    uint16_t map_slot;                      //!< Slot of the map
+    uint16_t request_slot;                  //!< Slot of the requests
+    uint16_t first;                         //!< First reservable slot
+    uint16_t nslots;                        //!< Reservable slots, 0 for all the slots from first
+    uint16_t lease;                         //!< Lease of the node, superframes
+    uint16_t tx_holdoff;                    //!< Transmission from the slot start, usec
+    uint16_t rx_timeout;                    //!< Receive window past tx_holdoff, usec
+}slotres_config_t;
+
+//! Slot reservation instance
+typedef struct _slotres_instance_t{
+    struct _dw1000_dev_instance_t * parent;     //!< Pointer to _dw1000_dev_instance_t
+    STATS_SECT_DECL(slotres_stat_section) stat; //!< Stats instance
+    dw1000_mac_interface_t cbs;                 //!< MAC Layer Callbacks
+    struct os_sem sem;                          //!< Held while a frame or a receive window is in flight
+    slotres_status_t status;                    //!< Status
+    slotres_config_t config;                    //!< Config
+    slotres_slot_cb_t slot_cb;                  //!< Callback of the granted slots
+    void * slot_arg;                            //!< Argument of slot_cb
+    uint8_t seq_num;                            //!< Sequence number of the next frame
+    uint16_t ack;                               //!< Master, node to acknowledge in the next map
+    slotres_request_frame_t request;            //!< Master, request received
+    slotres_map_frame_t frame;                  //!< Map sent or received
+    slotres_node_t node;                        //!< Node, reservation state
+    uint16_t slot;                              //!< Node, first TDMA slot assigned to slot_cb
+    uint8_t granted;                            //!< Node, TDMA slots assigned to slot_cb
+    slotres_map_t map;                          //!< Master, slot map and lease table; must be last
+}slotres_instance_t;
+
+void slotres_pkg_init(void);
+slotres_instance_t * dw1000_slotres_init(dw1000_dev_instance_t * inst, uint16_t nleases);
+void dw1000_slotres_free(slotres_instance_t * slotres);
+void dw1000_slotres_set_slot_cb(slotres_instance_t * slotres, slotres_slot_cb_t slot_cb, void * arg);
+void dw1000_slotres_set_demand(slotres_instance_t * slotres, uint8_t demand);
+void dw1000_slotres_start(dw1000_dev_instance_t * inst, slotres_role_t role);
+void dw1000_slotres_stop(dw1000_dev_instance_t * inst);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SLOTRES_H_ */
@@ -0,0 +1,113 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file slotres_map.h
+ * @author paul kettle
+ * @date 2018
+ * @brief TDMA slot reservation, arbitration and slot map
+ *
+ * @details The master keeps a lease per node: the slots per superframe the node asks for and the superframes left
+ * before the lease expires. The reservable slots are shared max-min fair: every node gets its demand when the sum
+ * fits, otherwise nodes asking for less than an equal share keep their demand and the rest split what remains. The
+ * grants are laid out as contiguous runs in lease table order, so the slot map is a list of (address, count) entries
+ * from the first reservable slot, 3 bytes per node. A node finds its run by summing the counts before its entry; a
+ * node with a lease but no slots, when there are more nodes than slots, has an entry with a zero count.
+ *
+ * The node side keeps the demand of the node, tracks its grant from each map and decides when to request: when the
+ * demand differs from the one the master acknowledged, when the lease is about to expire or is missing from the map,
+ * and after a request that was not acknowledged, with a random exponential backoff since requests contend for a
+ * single slot. A demand of zero releases the lease.
+ *
+ * This file and slotres_map.c depend only on libc so they also build on the host.
+ */
+
+#ifndef _SLOTRES_MAP_H_
+#define _SLOTRES_MAP_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SLOTRES_ADDR_NONE       0xFFFF          //!< Free lease, no acknowledgement
+#define SLOTRES_BACKOFF_MAX     5               //!< Backoff window limit, 2^5 superframes
+
+//! Slot map entry, as sent over the air
+typedef struct _slotres_entry_t{
+    uint16_t addr;                      //!< Short address of the node
+    uint8_t count;                      //!< Slots granted, following those of the previous entries
+}__attribute__((__packed__, aligned(1))) slotres_entry_t;
+
+//! Lease of a node on the master
+typedef struct _slotres_lease_t{
+    uint16_t addr;                      //!< Short address of the node, SLOTRES_ADDR_NONE when free
+    uint8_t demand;                     //!< Slots per superframe requested
+    uint8_t granted;                    //!< Slots per superframe granted
+    uint16_t expiry;                    //!< Superframes left on the lease
+}slotres_lease_t;
+
+//! Slot map of the master
+typedef struct _slotres_map_t{
+    uint16_t first;                     //!< First reservable slot
+    uint16_t nslots;                    //!< Reservable slots
+    uint16_t demand;                    //!< Sum of the demands
+    uint8_t version;                    //!< Incremented on each change of the grants
+    uint16_t nleases;                   //!< Size of the lease table
+    slotres_lease_t leases[];           //!< Lease table
+}slotres_map_t;
+
+//! Reservation state of a node
+typedef struct _slotres_node_t{
+    uint16_t addr;                      //!< Short address of the node
+    uint8_t demand;                     //!< Slots per superframe wanted
+    uint16_t lease;                     //!< Lease requested, superframes
+    uint16_t slot;                      //!< First granted slot
+    uint8_t granted;                    //!< Slots granted by the last map
+    uint8_t acked;                      //!< Demand acknowledged by the master
+    uint8_t sent;                       //!< Demand of the request in flight
+    uint8_t version;                    //!< Version of the last map
+    uint16_t remaining;                 //!< Superframes left on the lease
+    uint8_t backoff;                    //!< Superframes before the next request may be sent
+    uint8_t attempts;                   //!< Requests not acknowledged
+    uint8_t pending:1;                  //!< Request sent, awaiting the next map
+    uint8_t synced:1;                   //!< A map has been received
+    uint32_t rand;                      //!< Backoff generator state
+}slotres_node_t;
+
+void slotres_map_init(slotres_map_t * map, uint16_t first, uint16_t nslots, uint16_t nleases);
+bool slotres_map_request(slotres_map_t * map, uint16_t addr, uint8_t demand, uint16_t lease);
+void slotres_map_tick(slotres_map_t * map);
+uint16_t slotres_map_encode(const slotres_map_t * map, slotres_entry_t * entries, uint16_t max);
+
+void slotres_node_init(slotres_node_t * node, uint16_t addr, uint16_t lease);
+bool slotres_node_map(slotres_node_t * node, uint8_t version, uint16_t ack, uint16_t first,
+        const slotres_entry_t * entries, uint16_t nentries);
+bool slotres_node_tick(slotres_node_t * node);
+uint8_t slotres_demand(uint32_t rate, uint32_t period);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SLOTRES_MAP_H_ */
@@ -0,0 +1,677 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file slotres.c
+ * @author paul kettle
+ * @date 2018
+ * @brief Over the air TDMA slot reservation
+ *
+ * @details The MAC callbacks only copy the frames received; the master processes the request of a superframe in the
+ * map slot of the next one, and a node applies the map of a superframe in its request slot, both in the tdma task,
+ * where the granted TDMA slots are reassigned. Frames are sent tx_holdoff usec into their slot, and receive windows
+ * open at the slot start, from the superframe epoch of ccp.
+ */
+
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+#include <os/os.h>
+
+#include <dw1000/dw1000_dev.h>
+#include <dw1000/dw1000_mac.h>
+#include <dw1000/dw1000_ftypes.h>
+#include <dw1000/dw1000_hal.h>
+#include <ccp/ccp.h>
+#include <tdma/tdma.h>
+#include <slotres/slotres.h>
+
+#if MYNEWT_VAL(SLOTRES_ENABLED)
+
+STATS_NAME_START(slotres_stat_section)
+    STATS_NAME(slotres_stat_section, map_tx)
+    STATS_NAME(slotres_stat_section, map_rx)
+    STATS_NAME(slotres_stat_section, map_missed)
+    STATS_NAME(slotres_stat_section, request_tx)
+    STATS_NAME(slotres_stat_section, request_rx)
+    STATS_NAME(slotres_stat_section, request_ack)
+    STATS_NAME(slotres_stat_section, request_full)
+    STATS_NAME(slotres_stat_section, grant_change)
+    STATS_NAME(slotres_stat_section, slot_skipped)
+    STATS_NAME(slotres_stat_section, busy)
+    STATS_NAME(slotres_stat_section, tx_start_error)
+    STATS_NAME(slotres_stat_section, rx_start_error)
+    STATS_NAME(slotres_stat_section, rx_timeout)
+    STATS_NAME(slotres_stat_section, reset)
+STATS_NAME_END(slotres_stat_section)
+
+#define SLOTRES_MAP_FRAME_LEN(n) (offsetof(struct _slotres_map_frame_t, entries) + (n) * sizeof(slotres_entry_t))
+
+static bool tx_complete_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs);
+static bool rx_complete_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs);
+static bool rx_timeout_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs);
+static bool rx_error_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs);
+static bool reset_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs);
+static void slotres_map_ev_cb(struct os_event * ev);
+static void slotres_request_ev_cb(struct os_event * ev);
+static void slotres_slot_ev_cb(struct os_event * ev);
+
+/**
+ * API to initialise the slot reservation service.
+ *
+ * @param inst     Pointer to dw1000_dev_instance_t.
+ * @param nleases  Size of the lease table of the master, at most SLOTRES_MAP_ENTRIES.
+ *
+ * @return slotres_instance_t*
+ */
+slotres_instance_t *
+dw1000_slotres_init(dw1000_dev_instance_t * inst, uint16_t nleases){
+
+    assert(inst);
+    assert(nleases <= SLOTRES_MAP_ENTRIES);
+
+    if (inst->slotres == NULL){
+        size_t size = sizeof(slotres_instance_t) + nleases * sizeof(slotres_lease_t);
+        inst->slotres = (slotres_instance_t *) malloc(size);
+        assert(inst->slotres);
+        memset(inst->slotres, 0, size);
+        inst->slotres->status.selfmalloc = 1;
+    }else{
+        assert(inst->slotres->map.nleases == nleases);
+    }
+    slotres_instance_t * slotres = inst->slotres;
+    slotres->parent = inst;
+    slotres->config = (slotres_config_t){
+        .role = SLOTRES_ROLE_NODE,
+        .map_slot = MYNEWT_VAL(SLOTRES_MAP_SLOT),
+        .request_slot = MYNEWT_VAL(SLOTRES_REQUEST_SLOT),
+        .first = MYNEWT_VAL(SLOTRES_FIRST_SLOT),
+        .nslots = MYNEWT_VAL(SLOTRES_NSLOTS),
+        .lease = MYNEWT_VAL(SLOTRES_LEASE),
+        .tx_holdoff = MYNEWT_VAL(SLOTRES_TX_HOLDOFF),
+        .rx_timeout = MYNEWT_VAL(SLOTRES_RX_TIMEOUT),
+    };
+    slotres_map_init(&slotres->map, slotres->config.first, 0, nleases);
+    slotres_node_init(&slotres->node, inst->my_short_address, slotres->config.lease);
+    slotres->ack = SLOTRES_ADDR_NONE;
+
+    os_error_t err = os_sem_init(&slotres->sem, 0x1);
+    assert(err == OS_OK);
+
+    slotres->cbs = (dw1000_mac_interface_t){
+        .id = DW1000_SLOTRES,
+        .tx_complete_cb = tx_complete_cb,
+        .rx_complete_cb = rx_complete_cb,
+        .rx_timeout_cb = rx_timeout_cb,
+        .rx_error_cb = rx_error_cb,
+        .reset_cb = reset_cb
+    };
+    dw1000_mac_append_interface(inst, &slotres->cbs);
+
+    int rc = stats_init(
+        STATS_HDR(slotres->stat),
+        STATS_SIZE_INIT_PARMS(slotres->stat, STATS_SIZE_32),
+        STATS_NAME_INIT_PARMS(slotres_stat_section));
+    assert(rc == 0);
+#if  MYNEWT_VAL(DW1000_DEVICE_0) && !MYNEWT_VAL(DW1000_DEVICE_1)
+    rc = stats_register("slotres", STATS_HDR(slotres->stat));
+#elif  MYNEWT_VAL(DW1000_DEVICE_0) && MYNEWT_VAL(DW1000_DEVICE_1)
+    if (inst->idx == 0)
+        rc |= stats_register("slotres0", STATS_HDR(slotres->stat));
+    else
+        rc |= stats_register("slotres1", STATS_HDR(slotres->stat));
+#endif
+    assert(rc == 0);
+
+    slotres->status.initialized = 1;
+    return slotres;
+}
+
+/**
+ * API to free the allocated resources.
+ *
+ * @param slotres  Pointer to slotres_instance_t.
+ *
+ * @return void
+ */
+void
+dw1000_slotres_free(slotres_instance_t * slotres){
+    assert(slotres);
+    dw1000_slotres_stop(slotres->parent);
+    dw1000_mac_remove_interface(slotres->parent, DW1000_SLOTRES);
+    if (slotres->status.selfmalloc){
+        slotres->parent->slotres = NULL;
+        free(slotres);
+    }else
+        slotres->status.initialized = 0;
+}
+
+/**
+ * API to initialise the package.
+ *
+ * @return void
+ */
+void
+slotres_pkg_init(void){
+
+    printf("{\"utime\": %lu,\"msg\": \"slotres_pkg_init\"}\n",os_cputime_ticks_to_usecs(os_cputime_get32()));
+
+#if MYNEWT_VAL(DW1000_DEVICE_0)
+    dw1000_slotres_init(hal_dw1000_inst(0), MYNEWT_VAL(SLOTRES_MAX_NODES));
+#endif
+#if MYNEWT_VAL(DW1000_DEVICE_1)
+    dw1000_slotres_init(hal_dw1000_inst(1), MYNEWT_VAL(SLOTRES_MAX_NODES));
+#endif
+#if MYNEWT_VAL(DW1000_DEVICE_2)
+    dw1000_slotres_init(hal_dw1000_inst(2), MYNEWT_VAL(SLOTRES_MAX_NODES));
+#endif
+}
+
+/**
+ * API to set the callback of the granted slots. It runs in the tdma task at the start of each granted slot.
+ *
+ * @param slotres  Pointer to slotres_instance_t.
+ * @param slot_cb  Callback, NULL for none.
+ * @param arg      Argument of the callback.
+ *
+ * @return void
+ */
+void
+dw1000_slotres_set_slot_cb(slotres_instance_t * slotres, slotres_slot_cb_t slot_cb, void * arg){
+    slotres->slot_arg = arg;
+    slotres->slot_cb = slot_cb;
+}
+
+/**
+ * API to set the slots per superframe a node wants, see slotres_demand to derive it from a rate. The node requests
+ * the change in the next request slot it may use; a demand of zero releases the slots of the node.
+ *
+ * @param slotres  Pointer to slotres_instance_t.
+ * @param demand   Slots per superframe.
+ *
+ * @return void
+ */
+void
+dw1000_slotres_set_demand(slotres_instance_t * slotres, uint8_t demand){
+    slotres->node.demand = demand;
+}
+
+/**
+ * Help function for the local time of the start of a slot in the current superframe.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @param idx   Slot number.
+ *
+ * @return Slot start, DTU
+ */
+static uint64_t
+slotres_slot_start(dw1000_dev_instance_t * inst, uint16_t idx){
+    tdma_instance_t * tdma = inst->tdma;
+    return inst->ccp->epoch + ((uint64_t)idx * ((uint64_t)tdma->period << 16)) / tdma->nslots;
+}
+
+/**
+ * Help function to send a frame at a given time, with no response expected. Releases the semaphore on failure.
+ *
+ * @param inst     Pointer to dw1000_dev_instance_t.
+ * @param frame    Frame.
+ * @param len      Frame length.
+ * @param dx_time  Transmission time, DTU.
+ *
+ * @return true if the transmission was started
+ */
+static bool
+slotres_send(dw1000_dev_instance_t * inst, uint8_t * frame, uint16_t len, uint64_t dx_time){
+
+    slotres_instance_t * slotres = inst->slotres;
+    dw1000_write_tx(inst, frame, 0, len);
+    dw1000_write_tx_fctrl(inst, len, 0, false);
+    dw1000_set_wait4resp(inst, false);
+    dw1000_set_delay_start(inst, dx_time);
+
+    slotres->status.tx_pending = 1;
+    slotres->status.start_tx_error = dw1000_start_tx(inst).start_tx_error;
+    if (slotres->status.start_tx_error){
+        slotres->status.tx_pending = 0;
+        STATS_INC(slotres->stat, tx_start_error);
+        os_error_t err = os_sem_release(&slotres->sem);
+        assert(err == OS_OK);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Help function to open a receive window at a given time. Releases the semaphore on failure.
+ *
+ * @param inst     Pointer to dw1000_dev_instance_t.
+ * @param dx_time  Window start, DTU.
+ * @param timeout  Window length, usec.
+ *
+ * @return true if the window was opened
+ */
+static bool
+slotres_listen(dw1000_dev_instance_t * inst, uint64_t dx_time, uint16_t timeout){
+
+    slotres_instance_t * slotres = inst->slotres;
+    dw1000_set_delay_start(inst, dx_time);
+    dw1000_set_rx_timeout(inst, timeout);
+
+    slotres->status.listening = 1;
+    slotres->status.start_rx_error = dw1000_start_rx(inst).start_rx_error;
+    if (slotres->status.start_rx_error){
+        slotres->status.listening = 0;
+        STATS_INC(slotres->stat, rx_start_error);
+        os_error_t err = os_sem_release(&slotres->sem);
+        assert(err == OS_OK);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Help function to move the slot callback to the slots of the last map on a node.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ *
+ * @return void
+ */
+static void
+slotres_reassign(dw1000_dev_instance_t * inst){
+
+    slotres_instance_t * slotres = inst->slotres;
+    tdma_instance_t * tdma = inst->tdma;
+
+    for (uint16_t i = 0; i < slotres->granted; i++)
+        tdma_release_slot(tdma, slotres->slot + i);
+    slotres->slot = slotres->node.slot;
+    slotres->granted = slotres->node.granted;
+    for (uint16_t i = 0; i < slotres->granted; i++){
+        if (slotres->slot + i >= tdma->nslots)
+            break;
+        tdma_assign_slot(tdma, slotres_slot_ev_cb, slotres->slot + i, (void *) slotres);
+    }
+    STATS_INC(slotres->stat, grant_change);
+}
+
+/**
+ * Map slot event. The master processes the request of the previous superframe and sends the map; a node listens
+ * for it.
+ *
+ * @param ev  Pointer to os_event, argument tdma_slot_t.
+ *
+ * @return void
+ */
+static void
+slotres_map_ev_cb(struct os_event * ev){
+    assert(ev != NULL);
+    assert(ev->ev_arg != NULL);
+
+    tdma_slot_t * slot = (tdma_slot_t *) ev->ev_arg;
+    slotres_instance_t * slotres = (slotres_instance_t *) slot->arg;
+    dw1000_dev_instance_t * inst = slotres->parent;
+
+    slotres->status.synced = 0;
+    if (!slotres->status.started)
+        return;
+    if (os_sem_get_count(&slotres->sem) == 0){
+        STATS_INC(slotres->stat, busy);
+        return;
+    }
+    os_error_t err = os_sem_pend(&slotres->sem, OS_TIMEOUT_NEVER);
+    assert(err == OS_OK);
+
+    uint64_t dx_time = slotres_slot_start(inst, slot->idx);
+    if (slotres->config.role == SLOTRES_ROLE_NODE){
+        slotres_listen(inst, dx_time, slotres->config.tx_holdoff + slotres->config.rx_timeout);
+        return;
+    }
+
+    slotres->ack = SLOTRES_ADDR_NONE;
+    if (slotres->status.request_received){
+        slotres_request_frame_t * request = &slotres->request;
+        if (slotres_map_request(&slotres->map, request->src_address, request->demand, request->lease)){
+            slotres->ack = request->src_address;
+            STATS_INC(slotres->stat, request_ack);
+        }else
+            STATS_INC(slotres->stat, request_full);
+        slotres->status.request_received = 0;
+    }
+    slotres_map_tick(&slotres->map);
+
+    slotres_map_frame_t * frame = &slotres->frame;
+    frame->fctrl = FCNTL_IEEE_SLOTRES_16;
+    frame->seq_num = slotres->seq_num++;
+    frame->PANID = inst->PANID;
+    frame->dst_address = 0xffff;
+    frame->src_address = inst->my_short_address;
+    frame->code = SLOTRES_CODE_MAP;
+    frame->version = slotres->map.version;
+    frame->ack = slotres->ack;
+    frame->first = slotres->map.first;
+    frame->nentries = slotres_map_encode(&slotres->map, frame->entries, SLOTRES_MAP_ENTRIES);
+
+    dx_time += (uint64_t)slotres->config.tx_holdoff << 16;
+    if (slotres_send(inst, frame->array, SLOTRES_MAP_FRAME_LEN(frame->nentries), dx_time))
+        STATS_INC(slotres->stat, map_tx);
+}
+
+/**
+ * Request slot event. The master listens for a request; a node applies the map of the superframe and sends a
+ * request when slotres_node_tick decides so.
+ *
+ * @param ev  Pointer to os_event, argument tdma_slot_t.
+ *
+ * @return void
+ */
+static void
+slotres_request_ev_cb(struct os_event * ev){
+    assert(ev != NULL);
+    assert(ev->ev_arg != NULL);
+
+    tdma_slot_t * slot = (tdma_slot_t *) ev->ev_arg;
+    slotres_instance_t * slotres = (slotres_instance_t *) slot->arg;
+    dw1000_dev_instance_t * inst = slotres->parent;
+
+    if (!slotres->status.started)
+        return;
+
+    if (slotres->config.role == SLOTRES_ROLE_NODE){
+        if (slotres->status.map_received){
+            slotres_map_frame_t * frame = &slotres->frame;
+            slotres->status.map_received = 0;
+            if (slotres_node_map(&slotres->node, frame->version, frame->ack, frame->first,
+                    frame->entries, frame->nentries))
+                slotres_reassign(inst);
+            slotres->status.synced = 1;
+        }else
+            STATS_INC(slotres->stat, map_missed);
+        if (!slotres_node_tick(&slotres->node))
+            return;
+    }
+
+    if (os_sem_get_count(&slotres->sem) == 0){
+        STATS_INC(slotres->stat, busy);
+        return;
+    }
+    os_error_t err = os_sem_pend(&slotres->sem, OS_TIMEOUT_NEVER);
+    assert(err == OS_OK);
+
+    uint64_t dx_time = slotres_slot_start(inst, slot->idx);
+    if (slotres->config.role == SLOTRES_ROLE_MASTER){
+        slotres_listen(inst, dx_time, slotres->config.tx_holdoff + slotres->config.rx_timeout);
+        return;
+    }
+
+    slotres_request_frame_t request = {
+        .fctrl = FCNTL_IEEE_SLOTRES_16,
+        .seq_num = slotres->seq_num++,
+        .PANID = inst->PANID,
+        .dst_address = slotres->frame.src_address,
+        .src_address = inst->my_short_address,
+        .code = SLOTRES_CODE_REQUEST,
+        .demand = slotres->node.sent,
+        .lease = slotres->node.lease
+    };
+    dx_time += (uint64_t)slotres->config.tx_holdoff << 16;
+    if (slotres_send(inst, request.array, sizeof(slotres_request_frame_t), dx_time))
+        STATS_INC(slotres->stat, request_tx);
+}
+
+/**
+ * Granted slot event, runs the slot callback if the map of the superframe was received.
+ *
+ * @param ev  Pointer to os_event, argument tdma_slot_t.
+ *
+ * @return void
+ */
+static void
+slotres_slot_ev_cb(struct os_event * ev){
+    assert(ev != NULL);
+    assert(ev->ev_arg != NULL);
+
+    tdma_slot_t * slot = (tdma_slot_t *) ev->ev_arg;
+    slotres_instance_t * slotres = (slotres_instance_t *) slot->arg;
+
+    if (!slotres->status.synced){
+        STATS_INC(slotres->stat, slot_skipped);
+        return;
+    }
+    if (slotres->slot_cb)
+        slotres->slot_cb(slotres->parent, slot->idx, slotres->slot_arg);
+}
+
+/**
+ * API to start the service. The map and request slots are assigned in the tdma instance, and the reservable slots
+ * are those from config.first to the end of the superframe, or config.nslots of them. A node starts with the demand
+ * set by dw1000_slotres_set_demand and the short address it has at this point.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @param role  slotres_role_t.
+ *
+ * @return void
+ */
+void
+dw1000_slotres_start(dw1000_dev_instance_t * inst, slotres_role_t role){
+
+    slotres_instance_t * slotres = inst->slotres;
+    tdma_instance_t * tdma = inst->tdma;
+    assert(slotres);
+    assert(tdma);
+    assert(slotres->config.map_slot < slotres->config.first);
+    assert(slotres->config.request_slot < slotres->config.first);
+    assert(slotres->config.first < tdma->nslots);
+
+    if (slotres->status.started)
+        dw1000_slotres_stop(inst);
+
+    slotres->config.role = role;
+    uint16_t nslots = tdma->nslots - slotres->config.first;
+    if (slotres->config.nslots && slotres->config.nslots < nslots)
+        nslots = slotres->config.nslots;
+
+    if (role == SLOTRES_ROLE_MASTER){
+        slotres_map_init(&slotres->map, slotres->config.first, nslots, slotres->map.nleases);
+        slotres->ack = SLOTRES_ADDR_NONE;
+    }else{
+        uint8_t demand = slotres->node.demand;
+        slotres_node_init(&slotres->node, inst->my_short_address, slotres->config.lease);
+        slotres->node.demand = demand;
+    }
+    slotres->status.request_received = 0;
+    slotres->status.map_received = 0;
+    slotres->status.synced = 0;
+    slotres->status.started = 1;
+
+    tdma_assign_slot(tdma, slotres_map_ev_cb, slotres->config.map_slot, (void *) slotres);
+    tdma_assign_slot(tdma, slotres_request_ev_cb, slotres->config.request_slot, (void *) slotres);
+}
+
+/**
+ * API to stop the service and release its TDMA slots. The lease of a node is left to expire on the master; set a
+ * demand of zero and wait for the grant to go before stopping to release it at once.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ *
+ * @return void
+ */
+void
+dw1000_slotres_stop(dw1000_dev_instance_t * inst){
+
+    slotres_instance_t * slotres = inst->slotres;
+    tdma_instance_t * tdma = inst->tdma;
+    assert(slotres);
+
+    if (!slotres->status.started)
+        return;
+    slotres->status.started = 0;
+    slotres->status.synced = 0;
+
+    if (tdma){
+        tdma_release_slot(tdma, slotres->config.map_slot);
+        tdma_release_slot(tdma, slotres->config.request_slot);
+        for (uint16_t i = 0; i < slotres->granted; i++)
+            tdma_release_slot(tdma, slotres->slot + i);
+    }
+    slotres->granted = 0;
+
+    if (slotres->status.listening){
+        dw1000_stop_rx(inst);
+        slotres->status.listening = 0;
+        if (os_sem_get_count(&slotres->sem) == 0){
+            os_error_t err = os_sem_release(&slotres->sem);
+            assert(err == OS_OK);
+        }
+    }
+}
+
+/**
+ * API for the transmit complete callback, ends a map or a request.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @param cbs   Pointer to dw1000_mac_interface_t.
+ *
+ * @return true if a map or a request was sent
+ */
+static bool
+tx_complete_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs){
+
+    slotres_instance_t * slotres = inst->slotres;
+    if (!slotres->status.tx_pending)
+        return false;
+
+    slotres->status.tx_pending = 0;
+    os_error_t err = os_sem_release(&slotres->sem);
+    assert(err == OS_OK);
+    return true;
+}
+
+/**
+ * API for the receive complete callback. The master keeps the first request of the window and a node the map;
+ * either closes the window.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @param cbs   Pointer to dw1000_mac_interface_t.
+ *
+ * @return true if the frame was a slot reservation frame
+ */
+static bool
+rx_complete_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs){
+
+    slotres_instance_t * slotres = inst->slotres;
+    if (inst->fctrl != FCNTL_IEEE_SLOTRES_16)
+        return false;
+    if (!slotres->status.listening)
+        return true;
+
+    ieee_std_frame_t * std = (ieee_std_frame_t *) inst->rxbuf;
+    if (slotres->config.role == SLOTRES_ROLE_MASTER){
+        if (std->code != SLOTRES_CODE_REQUEST || inst->frame_len < sizeof(slotres_request_frame_t))
+            return true;
+        if (!slotres->status.request_received){
+            memcpy(slotres->request.array, inst->rxbuf, sizeof(slotres_request_frame_t));
+            slotres->status.request_received = 1;
+        }
+        STATS_INC(slotres->stat, request_rx);
+    }else{
+        slotres_map_frame_t * frame = (slotres_map_frame_t *) inst->rxbuf;
+        if (std->code != SLOTRES_CODE_MAP || inst->frame_len < SLOTRES_MAP_FRAME_LEN(0)
+                || frame->nentries > SLOTRES_MAP_ENTRIES || inst->frame_len < SLOTRES_MAP_FRAME_LEN(frame->nentries))
+            return true;
+        memcpy(slotres->frame.array, inst->rxbuf, SLOTRES_MAP_FRAME_LEN(frame->nentries));
+        slotres->status.map_received = 1;
+        STATS_INC(slotres->stat, map_rx);
+    }
+
+    slotres->status.listening = 0;
+    os_error_t err = os_sem_release(&slotres->sem);
+    assert(err == OS_OK);
+    return true;
+}
+
+/**
+ * API for the receive timeout callback, closes a receive window.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @param cbs   Pointer to dw1000_mac_interface_t.
+ *
+ * @return true if a receive window was closed
+ */
+static bool
+rx_timeout_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs){
+
+    slotres_instance_t * slotres = inst->slotres;
+    if (!slotres->status.listening)
+        return false;
+
+    slotres->status.listening = 0;
+    STATS_INC(slotres->stat, rx_timeout);
+    os_error_t err = os_sem_release(&slotres->sem);
+    assert(err == OS_OK);
+    return true;
+}
+
+/**
+ * API for the receive error callback, closes a receive window. Colliding requests end up here.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @param cbs   Pointer to dw1000_mac_interface_t.
+ *
+ * @return true if a receive window was closed
+ */
+static bool
+rx_error_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs){
+
+    slotres_instance_t * slotres = inst->slotres;
+    if (!slotres->status.listening)
+        return false;
+
+    slotres->status.listening = 0;
+    os_error_t err = os_sem_release(&slotres->sem);
+    assert(err == OS_OK);
+    return true;
+}
+
+/**
+ * API for the reset callback, ends a frame or a receive window in flight.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @param cbs   Pointer to dw1000_mac_interface_t.
+ *
+ * @return true if the service was reset
+ */
+static bool
+reset_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs){
+
+    slotres_instance_t * slotres = inst->slotres;
+    if (os_sem_get_count(&slotres->sem) == 0){
+        slotres->status.tx_pending = 0;
+        slotres->status.listening = 0;
+        os_error_t err = os_sem_release(&slotres->sem);
+        assert(err == OS_OK);
+        STATS_INC(slotres->stat, reset);
+        return true;
+    }
+    return false;
+}
+
+#endif // SLOTRES_ENABLED
@@ -0,0 +1,358 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file slotres_map.c
+ * @author paul kettle
+ * @date 2018
+ * @brief TDMA slot reservation, arbitration and slot map
+ *
+ * @details The max-min fair share is found as the largest cap c for which the sum of min(demand, c) fits the
+ * reservable slots; the slots left under that cap go one each to the nodes asking for more, in lease table order.
+ */
+
+#include <string.h>
+#include <slotres/slotres_map.h>
+
+static uint16_t
+slotres_map_fill(const slotres_map_t * map, uint8_t cap){
+    uint16_t sum = 0;
+    for (uint16_t i = 0; i < map->nleases; i++){
+        const slotres_lease_t * lease = &map->leases[i];
+        if (lease->addr != SLOTRES_ADDR_NONE)
+            sum += (lease->demand < cap) ? lease->demand : cap;
+    }
+    return sum;
+}
+
+/**
+ * Help function to share the reservable slots between the leases. Increments the version when a grant changes.
+ *
+ * @param map  Pointer to slotres_map_t.
+ *
+ * @return true if a grant changed
+ */
+static bool
+slotres_map_arbitrate(slotres_map_t * map){
+
+    uint8_t cap = UINT8_MAX;
+    if (slotres_map_fill(map, cap) > map->nslots){
+        uint8_t lo = 0, hi = UINT8_MAX;
+        while (lo < hi){
+            uint8_t mid = lo + (hi - lo + 1) / 2;
+            if (slotres_map_fill(map, mid) <= map->nslots)
+                lo = mid;
+            else
+                hi = mid - 1;
+        }
+        cap = lo;
+    }
+    uint16_t spare = map->nslots - slotres_map_fill(map, cap);
+
+    bool changed = false;
+    map->demand = 0;
+    for (uint16_t i = 0; i < map->nleases; i++){
+        slotres_lease_t * lease = &map->leases[i];
+        uint8_t granted = 0;
+        if (lease->addr != SLOTRES_ADDR_NONE){
+            map->demand += lease->demand;
+            granted = (lease->demand < cap) ? lease->demand : cap;
+            if (lease->demand > cap && spare){
+                granted++;
+                spare--;
+            }
+        }
+        changed |= granted != lease->granted;
+        lease->granted = granted;
+    }
+    if (changed)
+        map->version++;
+    return changed;
+}
+
+/**
+ * API to reset the slot map with no leases.
+ *
+ * @param map      Pointer to slotres_map_t, with room for nleases leases.
+ * @param first    First reservable slot.
+ * @param nslots   Reservable slots.
+ * @param nleases  Size of the lease table.
+ *
+ * @return void
+ */
+void
+slotres_map_init(slotres_map_t * map, uint16_t first, uint16_t nslots, uint16_t nleases){
+    map->first = first;
+    map->nslots = nslots;
+    map->demand = 0;
+    map->version = 0;
+    map->nleases = nleases;
+    for (uint16_t i = 0; i < nleases; i++){
+        map->leases[i].addr = SLOTRES_ADDR_NONE;
+        map->leases[i].demand = 0;
+        map->leases[i].granted = 0;
+        map->leases[i].expiry = 0;
+    }
+}
+
+/**
+ * API to process a request of a node, renewing its lease with the demand given. A demand of zero releases the lease.
+ *
+ * @param map     Pointer to slotres_map_t.
+ * @param addr    Short address of the node.
+ * @param demand  Slots per superframe requested.
+ * @param lease   Lease requested, superframes; 0 for a lease that does not expire.
+ *
+ * @return true if the request is granted, false if the lease table is full
+ */
+bool
+slotres_map_request(slotres_map_t * map, uint16_t addr, uint8_t demand, uint16_t lease){
+
+    if (addr == SLOTRES_ADDR_NONE)
+        return false;
+
+    slotres_lease_t * entry = NULL;
+    slotres_lease_t * free = NULL;
+    for (uint16_t i = 0; i < map->nleases; i++){
+        if (map->leases[i].addr == addr){
+            entry = &map->leases[i];
+            break;
+        }
+        if (free == NULL && map->leases[i].addr == SLOTRES_ADDR_NONE)
+            free = &map->leases[i];
+    }
+
+    if (demand == 0){
+        if (entry){
+            entry->addr = SLOTRES_ADDR_NONE;
+            entry->demand = 0;
+            // The entries after it move up even when no grant changes
+            if (!slotres_map_arbitrate(map))
+                map->version++;
+        }
+        return true;
+    }
+    if (entry == NULL){
+        if (free == NULL)
+            return false;
+        entry = free;
+        entry->addr = addr;
+        entry->granted = 0;
+        entry->demand = demand;
+        entry->expiry = lease;
+        // A new entry with no slots still shows in the map
+        if (!slotres_map_arbitrate(map))
+            map->version++;
+        return true;
+    }
+    entry->expiry = lease;
+    if (entry->demand != demand){
+        entry->demand = demand;
+        slotres_map_arbitrate(map);
+    }
+    return true;
+}
+
+/**
+ * API to age the leases by one superframe, releasing those that expire.
+ *
+ * @param map  Pointer to slotres_map_t.
+ *
+ * @return void
+ */
+void
+slotres_map_tick(slotres_map_t * map){
+
+    bool expired = false;
+    for (uint16_t i = 0; i < map->nleases; i++){
+        slotres_lease_t * lease = &map->leases[i];
+        if (lease->addr == SLOTRES_ADDR_NONE || lease->expiry == 0)
+            continue;
+        if (--lease->expiry == 0){
+            lease->addr = SLOTRES_ADDR_NONE;
+            lease->demand = 0;
+            expired = true;
+        }
+    }
+    if (expired && !slotres_map_arbitrate(map))
+        map->version++;
+}
+
+/**
+ * API to encode the slot map, one entry per lease in table order.
+ *
+ * @param map      Pointer to slotres_map_t.
+ * @param entries  Entries to fill.
+ * @param max      Size of entries.
+ *
+ * @return Entries filled
+ */
+uint16_t
+slotres_map_encode(const slotres_map_t * map, slotres_entry_t * entries, uint16_t max){
+    uint16_t n = 0;
+    for (uint16_t i = 0; i < map->nleases && n < max; i++){
+        const slotres_lease_t * lease = &map->leases[i];
+        if (lease->addr == SLOTRES_ADDR_NONE)
+            continue;
+        entries[n].addr = lease->addr;
+        entries[n].count = lease->granted;
+        n++;
+    }
+    return n;
+}
+
+static uint32_t
+slotres_rand(slotres_node_t * node){
+    // xorshift32
+    uint32_t x = node->rand;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return node->rand = x;
+}
+
+static void
+slotres_node_backoff(slotres_node_t * node){
+    if (node->attempts < UINT8_MAX)
+        node->attempts++;
+    uint8_t exp = (node->attempts < SLOTRES_BACKOFF_MAX) ? node->attempts : SLOTRES_BACKOFF_MAX;
+    node->backoff = slotres_rand(node) % (1u << exp);
+}
+
+/**
+ * API to reset the reservation state of a node, with no demand.
+ *
+ * @param node   Pointer to slotres_node_t.
+ * @param addr   Short address of the node.
+ * @param lease  Lease to request, superframes; 0 for a lease that does not expire.
+ *
+ * @return void
+ */
+void
+slotres_node_init(slotres_node_t * node, uint16_t addr, uint16_t lease){
+    memset(node, 0, sizeof(slotres_node_t));
+    node->addr = addr;
+    node->lease = lease;
+    // Seeded from the address so that nodes colliding once back off differently
+    node->rand = ((uint32_t)addr * 2654435761u) | 1;
+}
+
+/**
+ * API to update the node with a received slot map.
+ *
+ * @param node      Pointer to slotres_node_t.
+ * @param version   Version of the map.
+ * @param ack       Address of the node whose request the master processed since the previous map.
+ * @param first     First reservable slot.
+ * @param entries   Entries of the map.
+ * @param nentries  Number of entries.
+ *
+ * @return true if the slots granted to the node changed
+ */
+bool
+slotres_node_map(slotres_node_t * node, uint8_t version, uint16_t ack, uint16_t first,
+        const slotres_entry_t * entries, uint16_t nentries){
+
+    if (node->pending){
+        node->pending = 0;
+        if (ack == node->addr){
+            node->acked = node->sent;
+            node->remaining = node->lease;
+            node->attempts = 0;
+            node->backoff = 0;
+        }else{
+            slotres_node_backoff(node);
+        }
+    }
+
+    bool found = false;
+    uint16_t slot = first;
+    uint8_t granted = 0;
+    for (uint16_t i = 0; i < nentries; i++){
+        if (entries[i].addr == node->addr){
+            granted = entries[i].count;
+            found = true;
+            break;
+        }
+        slot += entries[i].count;
+    }
+    // The master lost the lease, restarted or expired it
+    if (!found && node->acked){
+        node->acked = 0;
+        node->remaining = 0;
+    }
+
+    bool changed = granted != node->granted || (granted && slot != node->slot);
+    node->granted = granted;
+    node->slot = granted ? slot : 0;
+    node->version = version;
+    node->synced = 1;
+    return changed;
+}
+
+/**
+ * API to age the lease of the node by one superframe and decide whether to send a request in this superframe.
+ * Call once per superframe, after the map of the superframe if any.
+ *
+ * @param node  Pointer to slotres_node_t.
+ *
+ * @return true if a request with node->demand is to be sent
+ */
+bool
+slotres_node_tick(slotres_node_t * node){
+
+    // The lease ran out without a renewal reaching the master
+    if (node->remaining && --node->remaining == 0)
+        node->acked = 0;
+    // The map that acknowledges the request was missed
+    if (node->pending){
+        node->pending = 0;
+        slotres_node_backoff(node);
+    }
+    if (!node->synced)
+        return false;
+    if (node->backoff){
+        node->backoff--;
+        return false;
+    }
+
+    bool renew = node->acked && node->lease && node->remaining <= (node->lease >> 2) + 1;
+    if (node->demand == node->acked && !renew)
+        return false;
+
+    node->sent = node->demand;
+    node->pending = 1;
+    return true;
+}
+
+/**
+ * API to convert a rate of slot uses to a demand.
+ *
+ * @param rate    Slot uses per second.
+ * @param period  Superframe period, usec.
+ *
+ * @return Slots per superframe, saturated at UINT8_MAX
+ */
+uint8_t
+slotres_demand(uint32_t rate, uint32_t period){
+    uint64_t demand = ((uint64_t)rate * period + 999999) / 1000000;
+    return (demand > UINT8_MAX) ? UINT8_MAX : (uint8_t)demand;
+}
@@ -0,0 +1,125 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "slotres_test.h"
+
+#define SLOTRES_MAP_TEST_LEASES 4
+
+static struct {
+    slotres_map_t map;
+    slotres_lease_t leases[SLOTRES_MAP_TEST_LEASES];
+} test;
+
+static uint8_t
+granted(uint16_t addr)
+{
+    for (uint16_t i = 0; i < test.map.nleases; i++)
+        if (test.map.leases[i].addr == addr)
+            return test.map.leases[i].granted;
+    return 0;
+}
+
+static uint16_t
+total(void)
+{
+    uint16_t sum = 0;
+    for (uint16_t i = 0; i < test.map.nleases; i++){
+        TEST_ASSERT(test.map.leases[i].granted <= test.map.leases[i].demand);
+        sum += test.map.leases[i].granted;
+    }
+    return sum;
+}
+
+/* Max-min fair arbitration, release, expiry and encoding of the slot map */
+TEST_CASE(slotres_map_test)
+{
+    slotres_entry_t entries[SLOTRES_MAP_TEST_LEASES];
+    uint8_t version;
+
+    slotres_map_init(&test.map, 3, 10, SLOTRES_MAP_TEST_LEASES);
+    TEST_ASSERT(slotres_map_encode(&test.map, entries, SLOTRES_MAP_TEST_LEASES) == 0);
+
+    /* Demand fits */
+    TEST_ASSERT(slotres_map_request(&test.map, 0x1001, 2, 0));
+    TEST_ASSERT(slotres_map_request(&test.map, 0x1002, 3, 0));
+    TEST_ASSERT(granted(0x1001) == 2 && granted(0x1002) == 3);
+    TEST_ASSERT(test.map.version == 2);
+
+    /* Oversubscribed, the small demands keep theirs */
+    TEST_ASSERT(slotres_map_request(&test.map, 0x1003, 10, 0));
+    TEST_ASSERT(granted(0x1001) == 2 && granted(0x1002) == 3 && granted(0x1003) == 5);
+    TEST_ASSERT(total() == 10);
+
+    /* Share of 2, the 2 slots left go in table order */
+    TEST_ASSERT(slotres_map_request(&test.map, 0x1004, 4, 0));
+    TEST_ASSERT(granted(0x1001) == 2 && granted(0x1002) == 3 && granted(0x1003) == 3 && granted(0x1004) == 2);
+    TEST_ASSERT(total() == 10);
+    TEST_ASSERT(test.map.demand == 19);
+
+    /* Table full */
+    version = test.map.version;
+    TEST_ASSERT(!slotres_map_request(&test.map, 0x1005, 1, 0));
+    TEST_ASSERT(test.map.version == version);
+
+    /* Renewal with the same demand leaves the map unchanged */
+    TEST_ASSERT(slotres_map_request(&test.map, 0x1001, 2, 0));
+    TEST_ASSERT(test.map.version == version);
+
+    /* Release, the rest share its slots */
+    TEST_ASSERT(slotres_map_request(&test.map, 0x1002, 0, 0));
+    TEST_ASSERT(test.map.version != version);
+    TEST_ASSERT(granted(0x1001) == 2 && granted(0x1003) == 4 && granted(0x1004) == 4);
+    TEST_ASSERT(total() == 10);
+
+    /* Entries in table order, runs follow each other */
+    TEST_ASSERT_FATAL(slotres_map_encode(&test.map, entries, SLOTRES_MAP_TEST_LEASES) == 3);
+    TEST_ASSERT(entries[0].addr == 0x1001 && entries[0].count == 2);
+    TEST_ASSERT(entries[1].addr == 0x1003 && entries[1].count == 4);
+    TEST_ASSERT(entries[2].addr == 0x1004 && entries[2].count == 4);
+
+    /* The freed entry is reused, more nodes than slots leaves some with none */
+    slotres_map_init(&test.map, 3, 3, SLOTRES_MAP_TEST_LEASES);
+    for (uint16_t i = 0; i < SLOTRES_MAP_TEST_LEASES; i++)
+        TEST_ASSERT(slotres_map_request(&test.map, 0x2000 + i, 1, 0));
+    TEST_ASSERT(total() == 3 && granted(0x2003) == 0);
+    TEST_ASSERT(slotres_map_encode(&test.map, entries, SLOTRES_MAP_TEST_LEASES) == 4);
+    TEST_ASSERT(entries[3].addr == 0x2003 && entries[3].count == 0);
+
+    /* Expiry */
+    slotres_map_init(&test.map, 3, 10, SLOTRES_MAP_TEST_LEASES);
+    TEST_ASSERT(slotres_map_request(&test.map, 0x1001, 4, 2));
+    TEST_ASSERT(slotres_map_request(&test.map, 0x1002, 4, 0));
+    slotres_map_tick(&test.map);
+    TEST_ASSERT(granted(0x1001) == 4);
+    TEST_ASSERT(slotres_map_request(&test.map, 0x1001, 4, 2));
+    slotres_map_tick(&test.map);
+    TEST_ASSERT(granted(0x1001) == 4);
+    version = test.map.version;
+    slotres_map_tick(&test.map);
+    TEST_ASSERT(granted(0x1001) == 0 && granted(0x1002) == 4);
+    TEST_ASSERT(test.map.version != version);
+    TEST_ASSERT(slotres_map_encode(&test.map, entries, SLOTRES_MAP_TEST_LEASES) == 1);
+
+    /* Demand from a rate */
+    TEST_ASSERT(slotres_demand(0, 1000000) == 0);
+    TEST_ASSERT(slotres_demand(10, 1000000) == 10);
+    TEST_ASSERT(slotres_demand(1, 1048576) == 2);
+    TEST_ASSERT(slotres_demand(1000, 1000000) == UINT8_MAX);
+}
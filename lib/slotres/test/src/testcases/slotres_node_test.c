@@ -0,0 +1,156 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "slotres_test.h"
+
+#define SLOTRES_NODE_TEST_NODES 8
+#define SLOTRES_NODE_TEST_FIRST 3
+#define SLOTRES_NODE_TEST_SLOTS 13
+#define SLOTRES_NODE_TEST_LEASE 16
+
+static struct {
+    slotres_map_t map;
+    slotres_lease_t leases[SLOTRES_NODE_TEST_NODES];
+} test;
+
+static slotres_node_t nodes[SLOTRES_NODE_TEST_NODES];
+static uint16_t ack;
+
+/*
+ * One superframe: the map in its slot, then the requests contending for the request slot. A request gets through
+ * only when a single node sends, as a collision is lost. Nodes in lost are out of range of the master.
+ */
+static void
+superframe(uint32_t lost)
+{
+    slotres_entry_t entries[SLOTRES_NODE_TEST_NODES];
+    uint16_t sender = SLOTRES_ADDR_NONE;
+    uint16_t senders = 0;
+
+    slotres_map_tick(&test.map);
+    uint16_t n = slotres_map_encode(&test.map, entries, SLOTRES_NODE_TEST_NODES);
+    for (uint16_t i = 0; i < SLOTRES_NODE_TEST_NODES; i++){
+        if (!(lost & (1 << i)))
+            slotres_node_map(&nodes[i], test.map.version, ack, test.map.first, entries, n);
+    }
+    ack = SLOTRES_ADDR_NONE;
+    for (uint16_t i = 0; i < SLOTRES_NODE_TEST_NODES; i++){
+        if (slotres_node_tick(&nodes[i]) && !(lost & (1 << i))){
+            sender = i;
+            senders++;
+        }
+    }
+    if (senders == 1 && slotres_map_request(&test.map, nodes[sender].addr, nodes[sender].demand, nodes[sender].lease))
+        ack = nodes[sender].addr;
+}
+
+/* Runs until every node has its demand acknowledged, returns the superframes it took */
+static uint16_t
+settle(uint16_t max)
+{
+    for (uint16_t k = 1; k <= max; k++){
+        superframe(0);
+        bool settled = true;
+        for (uint16_t i = 0; i < SLOTRES_NODE_TEST_NODES; i++)
+            settled &= nodes[i].acked == nodes[i].demand && !nodes[i].pending;
+        if (settled)
+            return k;
+    }
+    return 0;
+}
+
+/* The runs of the nodes are those of the master and do not overlap */
+static void
+check(void)
+{
+    uint8_t used[SLOTRES_NODE_TEST_SLOTS] = {0};
+    for (uint16_t i = 0; i < SLOTRES_NODE_TEST_NODES; i++){
+        TEST_ASSERT(nodes[i].granted <= nodes[i].demand);
+        for (uint16_t j = 0; j < nodes[i].granted; j++){
+            uint16_t slot = nodes[i].slot + j;
+            TEST_ASSERT_FATAL(slot >= SLOTRES_NODE_TEST_FIRST && slot < SLOTRES_NODE_TEST_FIRST + SLOTRES_NODE_TEST_SLOTS);
+            TEST_ASSERT(used[slot - SLOTRES_NODE_TEST_FIRST]++ == 0);
+        }
+    }
+}
+
+/* Nodes contending for the request slot acquire, renew, change and release their slots */
+TEST_CASE(slotres_node_test)
+{
+    const uint8_t demand[SLOTRES_NODE_TEST_NODES] = {1, 2, 1, 3, 1, 4, 2, 1};
+    uint16_t k;
+
+    slotres_map_init(&test.map, SLOTRES_NODE_TEST_FIRST, SLOTRES_NODE_TEST_SLOTS, SLOTRES_NODE_TEST_NODES);
+    ack = SLOTRES_ADDR_NONE;
+    for (uint16_t i = 0; i < SLOTRES_NODE_TEST_NODES; i++){
+        slotres_node_init(&nodes[i], 0x3000 + i, SLOTRES_NODE_TEST_LEASE);
+        nodes[i].demand = demand[i];
+    }
+
+    /* All request in the same superframe, backoff resolves the collisions */
+    k = settle(400);
+    TEST_ASSERT_FATAL(k > 0);
+    superframe(0);
+    check();
+    TEST_ASSERT(test.map.demand == 15);
+    uint16_t sum = 0;
+    for (uint16_t i = 0; i < SLOTRES_NODE_TEST_NODES; i++)
+        sum += nodes[i].granted;
+    TEST_ASSERT(sum == SLOTRES_NODE_TEST_SLOTS);
+
+    /* Renewals keep the leases alive well past their length */
+    for (k = 0; k < 20 * SLOTRES_NODE_TEST_LEASE; k++){
+        superframe(0);
+        check();
+        for (uint16_t i = 0; i < SLOTRES_NODE_TEST_NODES; i++)
+            TEST_ASSERT(nodes[i].acked == demand[i]);
+    }
+
+    /* Releases, the rest get their demand */
+    nodes[5].demand = 0;
+    nodes[3].demand = 0;
+    TEST_ASSERT_FATAL(settle(400) > 0);
+    superframe(0);
+    check();
+    TEST_ASSERT(nodes[5].granted == 0 && nodes[3].granted == 0);
+    for (uint16_t i = 0; i < SLOTRES_NODE_TEST_NODES; i++)
+        TEST_ASSERT(nodes[i].granted == nodes[i].demand);
+
+    /* A node out of range loses its lease and gets it back on return */
+    for (k = 0; k < 2 * SLOTRES_NODE_TEST_LEASE; k++)
+        superframe(1 << 1);
+    TEST_ASSERT(test.map.demand == 8 - 2);
+    TEST_ASSERT(nodes[1].acked == 0);
+    TEST_ASSERT_FATAL(settle(400) > 0);
+    superframe(0);
+    check();
+    TEST_ASSERT(nodes[1].granted == 2);
+
+    /* The master restarts with an empty table */
+    slotres_map_init(&test.map, SLOTRES_NODE_TEST_FIRST, SLOTRES_NODE_TEST_SLOTS, SLOTRES_NODE_TEST_NODES);
+    superframe(0);
+    for (uint16_t i = 0; i < SLOTRES_NODE_TEST_NODES; i++)
+        TEST_ASSERT(nodes[i].acked == 0);
+    TEST_ASSERT_FATAL(settle(400) > 0);
+    superframe(0);
+    check();
+    for (uint16_t i = 0; i < SLOTRES_NODE_TEST_NODES; i++)
+        TEST_ASSERT(nodes[i].granted == nodes[i].demand);
+}
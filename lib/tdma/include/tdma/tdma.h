@@ -45,25 +45,38 @@ extern "C" {
 
 #define TDMA_TASKS_ENABLE
 
+//! Slot timer latency, from the slot start to the timer callback, and its square are summed over slot_timer_cnt, usec;
+//! the slot-start jitter is sqrt(slot_late_sq_usec/n - (slot_late_usec/n)^2)
+STATS_SECT_START(tdma_stat_section)
+    STATS_SECT_ENTRY(superframe_cnt)
+    STATS_SECT_ENTRY(slot_timer_cnt)
+    STATS_SECT_ENTRY(slot_late_usec)
+    STATS_SECT_ENTRY(slot_late_sq_usec)
+    STATS_SECT_ENTRY(slot_late_max_usec)
+STATS_SECT_END
+
 //! Structure of TDMA
 typedef struct _tdma_status_t{
     uint16_t selfmalloc:1;            //!< Internal flag for memory garbage collection
     uint16_t initialized:1;           //!< Instance allocated 
     uint16_t awaiting_superframe:1;   //!< Superframe of tdma
+    uint16_t degraded:1;              //!< Superframe epoch extrapolated by ccp holdover
 }tdma_status_t;
 
 //! Structure of tdma_slot
 typedef struct _tdma_slot_t{
     struct _tdma_instance_t * parent;  //!< Pointer to _tdma_instance_ti
-    struct hal_timer timer;            //!< Timer
     struct os_callout event_cb;        //!< Sturcture of event_cb
     uint16_t idx;                      //!< Slot number
+    uint32_t offset;                   //!< Slot start from the superframe epoch, cputime ticks
+    SLIST_ENTRY(_tdma_slot_t) next;    //!< Next assigned slot, in slot order
     void * arg;                      //!< Optional argument
 }tdma_slot_t; 
 
 //! Structure of tdma instance
 typedef struct _tdma_instance_t{
     struct _dw1000_dev_instance_t * parent;  //!< Pointer to _dw1000_dev_instance_t
+    STATS_SECT_DECL(tdma_stat_section) stat; //!< Stats instance
     tdma_status_t status;                    //!< Status of tdma 
     dw1000_mac_interface_t cbs;              //!< MAC Layer Callbacks
     struct os_mutex mutex;                   //!< Structure of os_mutex  
@@ -71,6 +84,11 @@ typedef struct _tdma_instance_t{
     uint16_t nslots;                         //!< Number of slots 
     uint32_t period;                         //!< Period of each tdma
     uint32_t os_epoch;                          //!< Epoch timestamp
+    uint32_t guard;                          //!< Extra slot lead for the sync uncertainty, usec, non-zero in holdover
+    struct hal_timer timer;                  //!< Slot timer, armed for one slot at a time
+    uint32_t timer_epoch;                    //!< Superframe epoch less the slot lead, cputime ticks
+    SLIST_HEAD(,_tdma_slot_t) slots;         //!< Assigned slots in slot order
+    struct _tdma_slot_t * next_slot;         //!< Slot the timer is armed for, NULL when idle
     struct os_callout event_cb;              //!< Sturcture of event_cb
 #ifdef TDMA_TASKS_ENABLE
     struct os_eventq eventq;                 //!< Structure of os events
@@ -56,10 +56,21 @@
 #define DIAGMSG(s,u)
 #endif
 
+STATS_NAME_START(tdma_stat_section)
+    STATS_NAME(tdma_stat_section, superframe_cnt)
+    STATS_NAME(tdma_stat_section, slot_timer_cnt)
+    STATS_NAME(tdma_stat_section, slot_late_usec)
+    STATS_NAME(tdma_stat_section, slot_late_sq_usec)
+    STATS_NAME(tdma_stat_section, slot_late_max_usec)
+STATS_NAME_END(tdma_stat_section)
+
 static void tdma_superframe_event_cb(struct os_event * ev);
 static void slot_timer_cb(void * arg);
 static bool rx_complete_cb(struct _dw1000_dev_instance_t * inst, dw1000_mac_interface_t *);
 static bool tx_complete_cb(struct _dw1000_dev_instance_t * inst, dw1000_mac_interface_t *);
+#if MYNEWT_VAL(CCP_ENABLED)
+static void holdover_cb(struct _dw1000_dev_instance_t * inst, void * arg);
+#endif
 
 #ifdef TDMA_TASKS_ENABLE
 static void tdma_tasks_init(struct _tdma_instance_t * inst);
@@ -95,7 +106,24 @@ tdma_init(struct _dw1000_dev_instance_t * inst, uint32_t period, uint16_t nslots
 #ifdef TDMA_TASKS_ENABLE
         tdma->task_prio = inst->task_prio + 0x4;
 #endif
+        SLIST_INIT(&tdma->slots);
+        os_cputime_timer_init(&tdma->timer, slot_timer_cb, (void *) tdma);
         inst->tdma = tdma;
+
+        int rc = stats_init(
+            STATS_HDR(tdma->stat),
+            STATS_SIZE_INIT_PARMS(tdma->stat, STATS_SIZE_32),
+            STATS_NAME_INIT_PARMS(tdma_stat_section));
+        assert(rc == 0);
+#if  MYNEWT_VAL(DW1000_DEVICE_0) && !MYNEWT_VAL(DW1000_DEVICE_1)
+        rc = stats_register("tdma", STATS_HDR(tdma->stat));
+#elif  MYNEWT_VAL(DW1000_DEVICE_0) && MYNEWT_VAL(DW1000_DEVICE_1)
+        if (inst->idx == 0)
+            rc |= stats_register("tdma0", STATS_HDR(tdma->stat));
+        else
+            rc |= stats_register("tdma1", STATS_HDR(tdma->stat));
+#endif
+        assert(rc == 0);
     }else{
         tdma = inst->tdma;
     }
@@ -106,6 +134,10 @@ tdma_init(struct _dw1000_dev_instance_t * inst, uint32_t period, uint16_t nslots
         .rx_complete_cb = rx_complete_cb
     };
     dw1000_mac_append_interface(inst, &inst->tdma->cbs);
+#if MYNEWT_VAL(CCP_ENABLED)
+    if (inst->ccp)
+        dw1000_ccp_set_holdover_cb(inst->ccp, holdover_cb, tdma);
+#endif
 
 #ifdef TDMA_TASKS_ENABLE
     os_callout_init(&tdma->event_cb, &tdma->eventq, tdma_superframe_event_cb, (void *) tdma);
@@ -287,8 +319,47 @@ tx_complete_cb(struct _dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cb
 
 
 
+#if MYNEWT_VAL(CCP_ENABLED)
+/**
+ * ccp holdover callback. The ccp epoch has been extrapolated across a missed frame, start the superframe from it.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @param arg   Pointer to tdma_instance_t.
+ * @return void
+ */
+static void
+holdover_cb(struct _dw1000_dev_instance_t * inst, void * arg){
+
+    tdma_instance_t * tdma = (tdma_instance_t *) arg;
+    if (tdma->status.initialized){
+        tdma->os_epoch = inst->ccp->os_epoch;
+#ifdef TDMA_TASKS_ENABLE
+        os_eventq_put(&tdma->eventq, &tdma->event_cb.c_ev);
+#else
+        os_eventq_put(&inst->eventq, &tdma->event_cb.c_ev);
+#endif
+    }
+}
+#endif
+
 /**
- * API to intialise slot instance for the slot.Also initialise a timer and assigns callback for each slot.
+ * Help function to arm the slot timer for tdma->next_slot, or leave it stopped when there is none. Call with
+ * interrupts disabled or from the timer callback.
+ *
+ * @param tdma   Pointer to _tdma_instance_t.
+ *
+ * @return void
+ */
+static void
+tdma_arm_slot_timer(struct _tdma_instance_t * tdma){
+    os_cputime_timer_stop(&tdma->timer);
+    if (tdma->next_slot)
+        hal_timer_start_at(&tdma->timer, tdma->timer_epoch + tdma->next_slot->offset);
+}
+
+/**
+ * API to intialise slot instance for the slot. The slot start is computed here, once, and the slot is linked into the
+ * assigned slots in slot order; it is first scheduled at the next superframe.
  *
  * @param inst       Pointer to _tdma_instance_t.
  * @param callout    Callback for the particular slot.
@@ -306,22 +377,39 @@ tdma_assign_slot(struct _tdma_instance_t * inst, void (* callout )(struct os_eve
     if (inst->status.initialized == false)
        return;
 
-    if (inst->slot[idx] == NULL){
-        inst->slot[idx] = (tdma_slot_t  *) malloc(sizeof(struct _tdma_slot_t)); 
-        assert(inst->slot[idx]);
-        memset(inst->slot[idx], 0, sizeof(struct _tdma_slot_t));
+    tdma_slot_t * slot = inst->slot[idx];
+    if (slot == NULL){
+        slot = (tdma_slot_t  *) malloc(sizeof(struct _tdma_slot_t)); 
+        assert(slot);
+        memset(slot, 0, sizeof(struct _tdma_slot_t));
+        slot->idx = idx;
+        slot->parent = inst;
+        slot->offset = os_cputime_usecs_to_ticks(
+                    (uint32_t) (idx * dw1000_dwt_usecs_to_usecs(inst->period)/inst->nslots));
+
+        tdma_slot_t * prev = NULL, * cur;
+        SLIST_FOREACH(cur, &inst->slots, next){
+            if (cur->idx > idx)
+                break;
+            prev = cur;
+        }
+        os_sr_t sr;
+        OS_ENTER_CRITICAL(sr);
+        if (prev)
+            SLIST_INSERT_AFTER(prev, slot, next);
+        else
+            SLIST_INSERT_HEAD(&inst->slots, slot, next);
+        inst->slot[idx] = slot;
+        OS_EXIT_CRITICAL(sr);
     }else{
-        memset(inst->slot[idx], 0, sizeof(struct _tdma_slot_t));
+        os_callout_stop(&slot->event_cb);
     }
-    inst->slot[idx]->idx = idx;
-    inst->slot[idx]->parent = inst;
-    inst->slot[idx]->arg = arg;
+    slot->arg = arg;
 
-    os_cputime_timer_init(&inst->slot[idx]->timer, slot_timer_cb, (void *) inst->slot[idx]);
 #ifdef TDMA_TASKS_ENABLE
-    os_callout_init(&inst->slot[idx]->event_cb, &inst->eventq, callout, (void *) inst->slot[idx]);
+    os_callout_init(&slot->event_cb, &inst->eventq, callout, (void *) slot);
 #else
-    os_callout_init(&inst->slot[idx]->event_cb, &inst->parent->eventq, callout, (void *) inst->slot[idx]);
+    os_callout_init(&slot->event_cb, &inst->parent->eventq, callout, (void *) slot);
 #endif
 }
 
@@ -336,15 +424,27 @@ tdma_assign_slot(struct _tdma_instance_t * inst, void (* callout )(struct os_eve
 void 
 tdma_release_slot(struct _tdma_instance_t * inst, uint16_t idx){
     assert(idx < inst->nslots);
-    if (inst->slot[idx]) {
-        free(inst->slot[idx]);
+    tdma_slot_t * slot = inst->slot[idx];
+    if (slot) {
+        os_sr_t sr;
+        OS_ENTER_CRITICAL(sr);
+        SLIST_REMOVE(&inst->slots, slot, _tdma_slot_t, next);
+        if (inst->next_slot == slot){
+            inst->next_slot = SLIST_NEXT(slot, next);
+            tdma_arm_slot_timer(inst);
+        }
         inst->slot[idx] =  NULL;
+        OS_EXIT_CRITICAL(sr);
+        os_callout_stop(&slot->event_cb);
+        free(slot);
     }
 }
 
 /** 
  * This event is generated by ccp/clkcal complete event. This event defines the start of an superframe epoch. 
  * The event also schedules a tdma_superframe_timer_cb which turns on the receiver in advance of the next superframe epoch. 
+ * While ccp is in holdover the slots start earlier by the accumulated uncertainty, see dw1000_ccp_holdover_guard.
+ * Only the first assigned slot is scheduled here, slot_timer_cb re-arms the timer for each following one.
  *
  * @param ev   Pointer to os_event.
  *
@@ -358,30 +458,33 @@ tdma_superframe_event_cb(struct os_event * ev){
     DIAGMSG("{\"utime\": %lu,\"msg\": \"tdma_superframe_event_cb\"}\n",os_cputime_ticks_to_usecs(os_cputime_get32()));
 
     tdma_instance_t * tdma = (void *)ev->ev_arg;
-    for (uint16_t i = 0; i < tdma->nslots; i++) {
-        if (tdma->slot[i]){
-            os_cputime_timer_stop(&tdma->slot[i]->timer);
-        }
-    }
-    for (uint16_t i = 0; i < tdma->nslots; i++) {
-        if (tdma->slot[i]){
-            hal_timer_start_at(&tdma->slot[i]->timer, tdma->os_epoch
-                + os_cputime_usecs_to_ticks(
-                    (uint32_t) (i * dw1000_dwt_usecs_to_usecs(tdma->period)/tdma->nslots) 
-                    - (uint32_t)ceilf(dw1000_phy_SHR_duration(&tdma->parent->attrib)) 
-                    - MYNEWT_VAL(OS_LATENCY))
-            );
-        }
+#if MYNEWT_VAL(CCP_ENABLED)
+    if (tdma->parent->ccp){
+        tdma->status.degraded = tdma->parent->ccp->status.holdover;
+        tdma->guard = dw1000_ccp_holdover_guard(tdma->parent->ccp);
     }
+#endif
+    uint32_t lead = os_cputime_usecs_to_ticks(
+                    (uint32_t)ceilf(dw1000_phy_SHR_duration(&tdma->parent->attrib))
+                    + MYNEWT_VAL(OS_LATENCY)
+                    + tdma->guard);
+
+    os_sr_t sr;
+    OS_ENTER_CRITICAL(sr);
+    tdma->timer_epoch = tdma->os_epoch - lead;
+    tdma->next_slot = SLIST_FIRST(&tdma->slots);
+    tdma_arm_slot_timer(tdma);
+    OS_EXIT_CRITICAL(sr);
+    STATS_INC(tdma->stat, superframe_cnt);
 }
 
 
 
 /**
- * API for each slot. This function then puts
- * the callback provided by the user in the tdma event queue.
+ * Slot timer callback. Puts the callback provided by the user for the slot in the tdma event queue, accounts the
+ * latency from the slot start, with its square for the jitter, and re-arms the timer for the next assigned slot.
  *
- * @param arg    A void type argument. 
+ * @param arg    Pointer to _tdma_instance_t.
  *
  * @return void
  */
@@ -390,16 +493,28 @@ slot_timer_cb(void * arg){
 
     assert(arg);
 
-    tdma_slot_t * slot = (tdma_slot_t *) arg;
-    tdma_instance_t * tdma = slot->parent;
+    tdma_instance_t * tdma = (tdma_instance_t *) arg;
+    tdma_slot_t * slot = tdma->next_slot;
+    if (slot == NULL)
+        return;
 
     DIAGMSG("{\"utime\": %lu,\"msg\": \"slot_timer_cb\"}\n",os_cputime_ticks_to_usecs(os_cputime_get32()));
-  
+
+    int32_t late = (int32_t)(os_cputime_get32() - (tdma->timer_epoch + slot->offset));
+    uint32_t late_usec = (late > 0) ? os_cputime_ticks_to_usecs(late) : 0;
+    STATS_INC(tdma->stat, slot_timer_cnt);
+    STATS_INCN(tdma->stat, slot_late_usec, late_usec);
+    STATS_INCN(tdma->stat, slot_late_sq_usec, late_usec * late_usec);
+    if (late_usec > tdma->stat.STATS_SECT_VAR(slot_late_max_usec))
+        STATS_SET(tdma->stat, slot_late_max_usec, late_usec);
+
 #ifdef TDMA_TASKS_ENABLE
     os_eventq_put(&tdma->eventq, &slot->event_cb.c_ev);
 #else
     os_eventq_put(&tdma->parent->eventq, &slot->event_cb.c_ev);
 #endif
+    tdma->next_slot = SLIST_NEXT(slot, next);
+    tdma_arm_slot_timer(tdma);
 }
 
 /**
@@ -412,9 +527,13 @@ slot_timer_cb(void * arg){
 void 
 tdma_stop(struct _tdma_instance_t * tdma)
 {
+    os_sr_t sr;
+    OS_ENTER_CRITICAL(sr);
+    tdma->next_slot = NULL;
+    tdma_arm_slot_timer(tdma);
+    OS_EXIT_CRITICAL(sr);
     for (uint16_t i = 0; i < tdma->nslots; i++) {
         if (tdma->slot[i]){
-            os_cputime_timer_stop(&tdma->slot[i]->timer);
             tdma_release_slot(tdma, i);
         }
     }
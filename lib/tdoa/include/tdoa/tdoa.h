@@ -0,0 +1,136 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file tdoa.h
+ * @author paul kettle
+ * @date 2018
+ * @brief Time difference of arrival service
+ *
+ * @details Tags transmit blinks: a bare IEEE 802.15.4 blink carrying the 64-bit address of the tag, with no response
+ * expected, so each position update costs one 12 byte frame regardless of the number of anchors. Anchors timestamp
+ * each blink, map the timestamp to master time with wcs_local_to_master and keep a compact record in a ring; the
+ * postprocess event is raised for every record. Records from several anchors for the same tag and sequence number
+ * are turned into a position by tdoa_solve.
+ *
+ * Blinks are told apart from other blink frames, e.g. PAN requests, by their length. Periodic blinks are spread by a
+ * random jitter so that tags sharing a period do not collide repeatedly.
+ */
+
+#ifndef _TDOA_H_
+#define _TDOA_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <dw1000/dw1000_dev.h>
+#include <dw1000/dw1000_ftypes.h>
+#include <stats/stats.h>
+
+STATS_SECT_START(tdoa_stat_section)
+    STATS_SECT_ENTRY(blink)
+    STATS_SECT_ENTRY(tx_complete)
+    STATS_SECT_ENTRY(tx_start_error)
+    STATS_SECT_ENTRY(listen)
+    STATS_SECT_ENTRY(rx_complete)
+    STATS_SECT_ENTRY(rx_unsynced)
+    STATS_SECT_ENTRY(rx_lde_error)
+    STATS_SECT_ENTRY(rx_error)
+    STATS_SECT_ENTRY(rx_timeout)
+    STATS_SECT_ENTRY(rx_other)
+    STATS_SECT_ENTRY(reset)
+STATS_SECT_END
+
+//! Roles of the service
+typedef enum _tdoa_role_t{
+    TDOA_ROLE_TAG,                          //!< Transmit blinks
+    TDOA_ROLE_ANCHOR                        //!< Timestamp blinks
+}tdoa_role_t;
+
+//! Arrival of a blink at an anchor
+typedef struct _tdoa_record_t{
+    uint32_t utime;                         //!< CPU time of the reception, usec
+    uint64_t tag;                           //!< Long address of the tag
+    uint16_t anchor;                        //!< Short address of the anchor
+    uint8_t seq_num;                        //!< Sequence number of the blink
+    uint8_t synced;                         //!< Set when toa is in master time, otherwise it is in local time
+    uint64_t toa;                           //!< Time of arrival, DTU (40 bit)
+}__attribute__((__packed__)) tdoa_record_t;
+
+//! Status parameters
+typedef struct _tdoa_status_t{
+    uint16_t selfmalloc:1;                  //!< Internal flag for memory garbage collection
+    uint16_t initialized:1;                 //!< Instance allocated
+    uint16_t start_tx_error:1;              //!< Set for start transmit error
+    uint16_t start_rx_error:1;              //!< Set for start receive error
+    uint16_t blink_pending:1;               //!< Blink in flight
+    uint16_t listening:1;                   //!< Listen window open
+    uint16_t started:1;                     //!< Periodic blinks running
+}tdoa_status_t;
+
+//! Config parameters
+typedef struct _tdoa_config_t{
+    uint16_t postprocess:1;                 //!< Raise the postprocess event for each record
+    uint16_t role:1;                        //!< tdoa_role_t
+    uint32_t period;                        //!< Blink period, usec
+    uint32_t jitter;                        //!< Blink period jitter, usec
+    uint16_t window;                        //!< Listen window, usec, 0 to listen until dw1000_tdoa_stop
+}tdoa_config_t;
+
+//! TDoA instance
+typedef struct _tdoa_instance_t{
+    struct _dw1000_dev_instance_t * parent;     //!< Pointer to _dw1000_dev_instance_t
+    STATS_SECT_DECL(tdoa_stat_section) stat;    //!< Stats instance
+    dw1000_mac_interface_t cbs;                 //!< MAC Layer Callbacks
+    struct os_sem sem;                          //!< Held while a blink or a listen window is in flight
+    tdoa_status_t status;                       //!< Status
+    tdoa_config_t config;                       //!< Config
+    uint8_t seq_num;                            //!< Sequence number of the next blink
+    uint32_t rand;                              //!< Jitter generator state
+    uint64_t deadline;                          //!< End of the listen window, DTU (40 bit)
+    struct os_callout callout_blink;            //!< Periodic blink
+    struct os_callout callout_postprocess;      //!< Postprocess event
+    volatile uint32_t head;                     //!< Records written, free running
+    uint32_t tail;                              //!< Read index of the default postprocess
+    uint16_t mask;                              //!< nrecords - 1
+    tdoa_record_t records[];                    //!< Record ring
+}tdoa_instance_t;
+
+void tdoa_pkg_init(void);
+tdoa_instance_t * dw1000_tdoa_init(dw1000_dev_instance_t * inst, uint16_t nrecords);
+void dw1000_tdoa_free(tdoa_instance_t * tdoa);
+void dw1000_tdoa_set_postprocess(tdoa_instance_t * tdoa, os_event_fn * postprocess);
+dw1000_dev_status_t dw1000_tdoa_blink(dw1000_dev_instance_t * inst, dw1000_dev_modes_t mode);
+dw1000_dev_status_t dw1000_tdoa_listen(dw1000_dev_instance_t * inst, dw1000_dev_modes_t mode);
+void dw1000_tdoa_start(dw1000_dev_instance_t * inst, tdoa_role_t role);
+void dw1000_tdoa_stop(dw1000_dev_instance_t * inst);
+bool dw1000_tdoa_read(tdoa_instance_t * tdoa, uint32_t * tail, tdoa_record_t * record);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _TDOA_H_ */
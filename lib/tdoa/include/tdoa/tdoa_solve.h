@@ -0,0 +1,84 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file tdoa_solve.h
+ * @author paul kettle
+ * @date 2018
+ * @brief TDoA solver
+ *
+ * @details Position of a tag from the times of arrival of one blink at anchors sharing a clock, in master time (see
+ * wcs_local_to_master). The unknowns are the position and the range offset b of the blink, with
+ * c toa_i = |a_i - p| + b, so that each time of arrival is an independent measurement.
+ *
+ * Without an initial estimate, a closed-form fix is taken from the differences of the squared range equations to the
+ * earliest anchor, linear in the position and the range r0 to that anchor. It is then refined by weighted
+ * Gauss-Newton on the arrival time residuals. The covariance of the position is the position block of (J'WJ)^-1 at the
+ * solution, scaled by the residual variance when no variances are given.
+ *
+ * In 2D the height of the tag is fixed at pos.z of the solution on input. In 3D with anchors in a common plane,
+ * the height follows from r0 and the tag is placed below the plane; pass an initial estimate otherwise.
+ *
+ * The closed-form fix needs dim + 2 anchors, Gauss-Newton dim + 1. The solver only depends on libc and lib/dsp, and
+ * builds on the host.
+ */
+
+#ifndef _TDOA_SOLVE_H_
+#define _TDOA_SOLVE_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <dw1000/triad.h>
+
+#define TDOA_ITER_MAX 10                            //!< Gauss-Newton iterations
+#define TDOA_TOL (1e-4f)                            //!< Convergence threshold on the position step, m
+#define TDOA_DTU_TO_M (299792458.0f / (499.2e6f * 128))   //!< Distance light travels in one DTU, m
+
+//! Time of arrival of a blink at one anchor
+typedef struct _tdoa_meas_t{
+    triad_t anchor;                     //!< Anchor position, m
+    uint64_t toa;                       //!< Time of arrival in master time, DTU (40 bit)
+    float variance;                     //!< Variance of c toa, m^2, 0 if unknown
+}tdoa_meas_t;
+
+//! Position solution
+typedef struct _tdoa_solution_t{
+    triad_t pos;                        //!< Position, m; on input the initial estimate, and the height in 2D
+    float cov[3][3];                    //!< Covariance of pos, m^2; zero for z in 2D
+    uint64_t toe;                       //!< Time of emission of the blink in master time, DTU (40 bit)
+    float rms;                          //!< Weighted rms arrival time residual, m
+    uint16_t nmeas;                     //!< Arrival times used
+    uint16_t iterations;                //!< Gauss-Newton iterations run
+}tdoa_solution_t;
+
+bool tdoa_solve(const tdoa_meas_t * meas, uint16_t n, uint16_t dim, bool initial, tdoa_solution_t * sol);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _TDOA_SOLVE_H_ */
@@ -0,0 +1,599 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file tdoa.c
+ * @author paul kettle
+ * @date 2018
+ * @brief Time difference of arrival service
+ *
+ * @details Tag blinks and anchor time of arrival records, see tdoa.h. An anchor opens a listen window of
+ * config.window usec with dw1000_tdoa_listen; the receiver is re-enabled after each blink with the receive timeout
+ * set to what is left of the window, so the window closes at a fixed deadline however many blinks arrive. A frame of
+ * another service ends the window and leaves the receiver to that service. With config.window set to 0 the window
+ * stays open until dw1000_tdoa_stop.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include <os/os.h>
+
+#include <dw1000/dw1000_dev.h>
+#include <dw1000/dw1000_mac.h>
+#include <dw1000/dw1000_ftypes.h>
+#include <dw1000/dw1000_hal.h>
+#include <tdoa/tdoa.h>
+#if MYNEWT_VAL(WCS_ENABLED)
+#include <ccp/ccp.h>
+#include <wcs/wcs.h>
+#endif
+#if MYNEWT_VAL(TELEMETRY_ENABLED)
+#include <telemetry/telemetry.h>
+#endif
+
+#if MYNEWT_VAL(TDOA_ENABLED)
+
+STATS_NAME_START(tdoa_stat_section)
+    STATS_NAME(tdoa_stat_section, blink)
+    STATS_NAME(tdoa_stat_section, tx_complete)
+    STATS_NAME(tdoa_stat_section, tx_start_error)
+    STATS_NAME(tdoa_stat_section, listen)
+    STATS_NAME(tdoa_stat_section, rx_complete)
+    STATS_NAME(tdoa_stat_section, rx_unsynced)
+    STATS_NAME(tdoa_stat_section, rx_lde_error)
+    STATS_NAME(tdoa_stat_section, rx_error)
+    STATS_NAME(tdoa_stat_section, rx_timeout)
+    STATS_NAME(tdoa_stat_section, rx_other)
+    STATS_NAME(tdoa_stat_section, reset)
+STATS_NAME_END(tdoa_stat_section)
+
+static bool tx_complete_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs);
+static bool rx_complete_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs);
+static bool rx_timeout_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs);
+static bool rx_error_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs);
+static bool reset_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs);
+static void tdoa_blink_ev_cb(struct os_event * ev);
+static void tdoa_postprocess(struct os_event * ev);
+
+/**
+ * API to initialise the TDoA service.
+ *
+ * @param inst      Pointer to dw1000_dev_instance_t.
+ * @param nrecords  Depth of the record ring, power of two.
+ *
+ * @return tdoa_instance_t*
+ */
+tdoa_instance_t *
+dw1000_tdoa_init(dw1000_dev_instance_t * inst, uint16_t nrecords){
+
+    assert(inst);
+    assert(nrecords && (nrecords & (nrecords - 1)) == 0);
+
+    if (inst->tdoa == NULL){
+        size_t size = sizeof(tdoa_instance_t) + nrecords * sizeof(tdoa_record_t);
+        inst->tdoa = (tdoa_instance_t *) malloc(size);
+        assert(inst->tdoa);
+        memset(inst->tdoa, 0, size);
+        inst->tdoa->status.selfmalloc = 1;
+    }else{
+        assert(inst->tdoa->mask == nrecords - 1);
+    }
+    tdoa_instance_t * tdoa = inst->tdoa;
+    tdoa->parent = inst;
+    tdoa->mask = nrecords - 1;
+    tdoa->head = tdoa->tail = 0;
+    tdoa->config = (tdoa_config_t){
+        .role = TDOA_ROLE_ANCHOR,
+        .period = MYNEWT_VAL(TDOA_BLINK_PERIOD),
+        .jitter = MYNEWT_VAL(TDOA_BLINK_JITTER),
+        .window = MYNEWT_VAL(TDOA_LISTEN_WINDOW),
+    };
+    tdoa->rand = (uint32_t)(inst->my_long_address ^ (inst->my_long_address >> 32)) | 1;
+
+    os_error_t err = os_sem_init(&tdoa->sem, 0x1);
+    assert(err == OS_OK);
+    os_callout_init(&tdoa->callout_blink, os_eventq_dflt_get(), tdoa_blink_ev_cb, (void *) inst);
+    dw1000_tdoa_set_postprocess(tdoa, &tdoa_postprocess);
+
+    tdoa->cbs = (dw1000_mac_interface_t){
+        .id = DW1000_TDOA,
+        .tx_complete_cb = tx_complete_cb,
+        .rx_complete_cb = rx_complete_cb,
+        .rx_timeout_cb = rx_timeout_cb,
+        .rx_error_cb = rx_error_cb,
+        .reset_cb = reset_cb
+    };
+    dw1000_mac_append_interface(inst, &tdoa->cbs);
+
+    int rc = stats_init(
+        STATS_HDR(tdoa->stat),
+        STATS_SIZE_INIT_PARMS(tdoa->stat, STATS_SIZE_32),
+        STATS_NAME_INIT_PARMS(tdoa_stat_section));
+    assert(rc == 0);
+#if  MYNEWT_VAL(DW1000_DEVICE_0) && !MYNEWT_VAL(DW1000_DEVICE_1)
+    rc = stats_register("tdoa", STATS_HDR(tdoa->stat));
+#elif  MYNEWT_VAL(DW1000_DEVICE_0) && MYNEWT_VAL(DW1000_DEVICE_1)
+    if (inst->idx == 0)
+        rc |= stats_register("tdoa0", STATS_HDR(tdoa->stat));
+    else
+        rc |= stats_register("tdoa1", STATS_HDR(tdoa->stat));
+#endif
+    assert(rc == 0);
+
+    tdoa->status.initialized = 1;
+    return tdoa;
+}
+
+/**
+ * API to free the allocated resources.
+ *
+ * @param tdoa  Pointer to tdoa_instance_t.
+ *
+ * @return void
+ */
+void
+dw1000_tdoa_free(tdoa_instance_t * tdoa){
+    assert(tdoa);
+    dw1000_tdoa_stop(tdoa->parent);
+    dw1000_mac_remove_interface(tdoa->parent, DW1000_TDOA);
+    if (tdoa->status.selfmalloc){
+        tdoa->parent->tdoa = NULL;
+        free(tdoa);
+    }else
+        tdoa->status.initialized = 0;
+}
+
+/**
+ * API to initialise the package.
+ *
+ * @return void
+ */
+void
+tdoa_pkg_init(void){
+
+    printf("{\"utime\": %lu,\"msg\": \"tdoa_pkg_init\"}\n",os_cputime_ticks_to_usecs(os_cputime_get32()));
+
+#if MYNEWT_VAL(DW1000_DEVICE_0)
+    dw1000_tdoa_init(hal_dw1000_inst(0), MYNEWT_VAL(TDOA_NRECORDS));
+#endif
+#if MYNEWT_VAL(DW1000_DEVICE_1)
+    dw1000_tdoa_init(hal_dw1000_inst(1), MYNEWT_VAL(TDOA_NRECORDS));
+#endif
+#if MYNEWT_VAL(DW1000_DEVICE_2)
+    dw1000_tdoa_init(hal_dw1000_inst(2), MYNEWT_VAL(TDOA_NRECORDS));
+#endif
+}
+
+/**
+ * API to override the default postprocess, which prints the records when TDOA_VERBOSE is set. The event is raised
+ * on the default event queue after each record; the postprocess reads the ring with dw1000_tdoa_read.
+ *
+ * @param tdoa         Pointer to tdoa_instance_t.
+ * @param postprocess  Event callback, its argument is the tdoa_instance_t.
+ *
+ * @return void
+ */
+void
+dw1000_tdoa_set_postprocess(tdoa_instance_t * tdoa, os_event_fn * postprocess){
+    os_callout_init(&tdoa->callout_postprocess, os_eventq_dflt_get(), postprocess, (void *) tdoa);
+    tdoa->config.postprocess = true;
+}
+
+/**
+ * API to read the next record of the ring. A reader that falls a full ring behind skips to the oldest record kept.
+ *
+ * @param tdoa    Pointer to tdoa_instance_t.
+ * @param tail    Read index of the caller, free running; start from tdoa->head to only see new records.
+ * @param record  Record read.
+ *
+ * @return true if a record was read
+ */
+bool
+dw1000_tdoa_read(tdoa_instance_t * tdoa, uint32_t * tail, tdoa_record_t * record){
+
+    os_sr_t sr;
+    OS_ENTER_CRITICAL(sr);
+    uint32_t head = tdoa->head;
+    bool valid = *tail != head;
+    if (valid){
+        if (head - *tail > (uint32_t) tdoa->mask + 1)
+            *tail = head - tdoa->mask - 1;
+        memcpy(record, &tdoa->records[*tail & tdoa->mask], sizeof(tdoa_record_t));
+        (*tail)++;
+    }
+    OS_EXIT_CRITICAL(sr);
+    return valid;
+}
+
+/**
+ * Default postprocess, JSON or telemetry output of the new records.
+ *
+ * @param ev  Pointer to os_event, argument tdoa_instance_t.
+ *
+ * @return void
+ */
+static void
+tdoa_postprocess(struct os_event * ev){
+    assert(ev != NULL);
+    assert(ev->ev_arg != NULL);
+
+    tdoa_instance_t * tdoa = (tdoa_instance_t *) ev->ev_arg;
+    tdoa_record_t record;
+    while (dw1000_tdoa_read(tdoa, &tdoa->tail, &record)){
+#if MYNEWT_VAL(TDOA_VERBOSE)
+#if MYNEWT_VAL(TELEMETRY_ENABLED)
+        telemetry_tdoa_t tlv = {
+            .utime = record.utime,
+            .tag = record.tag,
+            .anchor = record.anchor,
+            .seq_num = record.seq_num,
+            .synced = record.synced,
+            .toa = record.toa
+        };
+        telemetry_write(TELEMETRY_TDOA, &tlv, sizeof(tlv));
+#else
+        printf("{\"utime\": %lu,\"tdoa\": [\"%llX\",%u,%u,\"%llX\"],\"synced\": %u}\n",
+            record.utime, record.tag, record.anchor, record.seq_num, record.toa, record.synced);
+#endif
+#endif
+    }
+}
+
+/**
+ * API to transmit a blink. Blinks expect no response.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @param mode  DWT_BLOCKING waits for the end of the transmission.
+ *
+ * @return dw1000_dev_status_t
+ */
+dw1000_dev_status_t
+dw1000_tdoa_blink(dw1000_dev_instance_t * inst, dw1000_dev_modes_t mode){
+
+    tdoa_instance_t * tdoa = inst->tdoa;
+    assert(tdoa);
+    os_error_t err = os_sem_pend(&tdoa->sem, OS_TIMEOUT_NEVER);
+    assert(err == OS_OK);
+    STATS_INC(tdoa->stat, blink);
+
+    ieee_blink_frame_t frame = {
+        .fctrl = FCNTL_IEEE_BLINK_TAG_64,
+        .seq_num = tdoa->seq_num++,
+        .long_address = inst->my_long_address
+    };
+    dw1000_write_tx(inst, frame.array, 0, sizeof(ieee_blink_frame_t));
+    dw1000_write_tx_fctrl(inst, sizeof(ieee_blink_frame_t), 0, true);
+    dw1000_set_wait4resp(inst, false);
+
+    tdoa->status.blink_pending = 1;
+    tdoa->status.start_tx_error = dw1000_start_tx(inst).start_tx_error;
+    if (tdoa->status.start_tx_error){
+        tdoa->status.blink_pending = 0;
+        STATS_INC(tdoa->stat, tx_start_error);
+        err = os_sem_release(&tdoa->sem);
+        assert(err == OS_OK);
+    }else if(mode == DWT_BLOCKING){
+        err = os_sem_pend(&tdoa->sem, OS_TIMEOUT_NEVER); // Wait for completion of transactions
+        assert(err == OS_OK);
+        err = os_sem_release(&tdoa->sem);
+        assert(err == OS_OK);
+    }
+    return inst->status;
+}
+
+/**
+ * API to open a listen window for blinks on an anchor. The window closes config.window usec after it opens, on the
+ * first frame of another service, or with dw1000_tdoa_stop.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @param mode  DWT_BLOCKING waits for the window to close.
+ *
+ * @return dw1000_dev_status_t
+ */
+dw1000_dev_status_t
+dw1000_tdoa_listen(dw1000_dev_instance_t * inst, dw1000_dev_modes_t mode){
+
+    tdoa_instance_t * tdoa = inst->tdoa;
+    assert(tdoa);
+    os_error_t err = os_sem_pend(&tdoa->sem, OS_TIMEOUT_NEVER);
+    assert(err == OS_OK);
+    STATS_INC(tdoa->stat, listen);
+
+    tdoa->status.listening = 1;
+    uint64_t window = (uint64_t)ceilf(dw1000_usecs_to_dwt_usecs(tdoa->config.window)) << 16;
+    tdoa->deadline = (dw1000_read_systime(inst) + window) & 0x0FFFFFFFFFFULL;
+    dw1000_set_rx_timeout(inst, tdoa->config.window);
+    tdoa->status.start_rx_error = dw1000_start_rx(inst).start_rx_error;
+    if (tdoa->status.start_rx_error){
+        tdoa->status.listening = 0;
+        err = os_sem_release(&tdoa->sem);
+        assert(err == OS_OK);
+    }else if(mode == DWT_BLOCKING){
+        err = os_sem_pend(&tdoa->sem, OS_TIMEOUT_NEVER); // Wait for the window to close
+        assert(err == OS_OK);
+        err = os_sem_release(&tdoa->sem);
+        assert(err == OS_OK);
+    }
+    return inst->status;
+}
+
+/**
+ * Help function for the delay to the next periodic blink, the period spread uniformly by the jitter.
+ *
+ * @param tdoa  Pointer to tdoa_instance_t.
+ *
+ * @return Delay in os ticks
+ */
+static os_time_t
+tdoa_blink_delay(tdoa_instance_t * tdoa){
+    uint32_t usec = tdoa->config.period;
+    if (tdoa->config.jitter && tdoa->config.jitter < tdoa->config.period){
+        tdoa->rand ^= tdoa->rand << 13;     // xorshift32
+        tdoa->rand ^= tdoa->rand >> 17;
+        tdoa->rand ^= tdoa->rand << 5;
+        usec = usec - tdoa->config.jitter + tdoa->rand % (2 * tdoa->config.jitter + 1);
+    }
+    return (os_time_t)(((uint64_t) usec * OS_TICKS_PER_SEC) / 1000000);
+}
+
+/**
+ * Periodic blink event. A blink still in flight, or a listen window, defers the blink to the next period.
+ *
+ * @param ev  Pointer to os_event, argument dw1000_dev_instance_t.
+ *
+ * @return void
+ */
+static void
+tdoa_blink_ev_cb(struct os_event * ev){
+    assert(ev->ev_arg != NULL);
+    dw1000_dev_instance_t * inst = (dw1000_dev_instance_t *) ev->ev_arg;
+    tdoa_instance_t * tdoa = inst->tdoa;
+
+    if (!tdoa->status.started)
+        return;
+    if (os_sem_get_count(&tdoa->sem) == 1)
+        dw1000_tdoa_blink(inst, DWT_NONBLOCKING);
+    os_callout_reset(&tdoa->callout_blink, tdoa_blink_delay(tdoa));
+}
+
+/**
+ * API to start the service. Tags start periodic blinks every config.period usec; anchors record blinks received
+ * in the listen windows opened with dw1000_tdoa_listen.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @param role  tdoa_role_t.
+ *
+ * @return void
+ */
+void
+dw1000_tdoa_start(dw1000_dev_instance_t * inst, tdoa_role_t role){
+
+    tdoa_instance_t * tdoa = inst->tdoa;
+    assert(tdoa);
+    tdoa->config.role = role;
+    if (role == TDOA_ROLE_TAG){
+        tdoa->status.started = 1;
+        os_callout_reset(&tdoa->callout_blink, tdoa_blink_delay(tdoa));
+    }
+}
+
+/**
+ * API to stop periodic blinks and close an open listen window.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ *
+ * @return void
+ */
+void
+dw1000_tdoa_stop(dw1000_dev_instance_t * inst){
+
+    tdoa_instance_t * tdoa = inst->tdoa;
+    assert(tdoa);
+    tdoa->status.started = 0;
+    os_callout_stop(&tdoa->callout_blink);
+
+    if (tdoa->status.listening){
+        dw1000_stop_rx(inst);
+        tdoa->status.listening = 0;
+        if (os_sem_get_count(&tdoa->sem) == 0){
+            os_error_t err = os_sem_release(&tdoa->sem);
+            assert(err == OS_OK);
+        }
+    }
+}
+
+/**
+ * API for the transmit complete callback, ends a blink.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @param cbs   Pointer to dw1000_mac_interface_t.
+ *
+ * @return true if a blink was sent
+ */
+static bool
+tx_complete_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs){
+
+    tdoa_instance_t * tdoa = inst->tdoa;
+    if (!tdoa->status.blink_pending)
+        return false;
+
+    tdoa->status.blink_pending = 0;
+    STATS_INC(tdoa->stat, tx_complete);
+    os_error_t err = os_sem_release(&tdoa->sem);
+    assert(err == OS_OK);
+    return true;
+}
+
+/**
+ * Help function to close a listen window.
+ *
+ * @param tdoa  Pointer to tdoa_instance_t.
+ *
+ * @return void
+ */
+static void
+tdoa_close(tdoa_instance_t * tdoa){
+    tdoa->status.listening = 0;
+    os_error_t err = os_sem_release(&tdoa->sem);
+    assert(err == OS_OK);
+}
+
+/**
+ * Help function to re-enable the receiver after a blink, for what is left of the listen window. Past the deadline
+ * the window closes instead.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ *
+ * @return void
+ */
+static void
+tdoa_restart_rx(dw1000_dev_instance_t * inst){
+
+    tdoa_instance_t * tdoa = inst->tdoa;
+    if (tdoa->config.window){
+        int64_t remaining = (int64_t)(((tdoa->deadline - inst->rxtimestamp) & 0x0FFFFFFFFFFULL) << 24) >> 24;
+        uint16_t timeout = (remaining >> 16) > 0 ? (uint16_t)dw1000_dwt_usecs_to_usecs(remaining >> 16) : 0;
+        if (timeout == 0){
+            if (inst->config.dblbuffon_enabled && inst->config.rxauto_enable)
+                dw1000_stop_rx(inst);
+            STATS_INC(tdoa->stat, rx_timeout);
+            tdoa_close(tdoa);
+            return;
+        }
+        dw1000_set_rx_timeout(inst, timeout);
+    }
+    if(!inst->config.dblbuffon_enabled || !inst->config.rxauto_enable)
+        dw1000_start_rx(inst);
+}
+
+/**
+ * API for the receive complete callback. While a listen window is open a blink is recorded with its time of arrival
+ * in master time once wcs is valid, and in local time otherwise, and the receiver is re-enabled until the deadline of
+ * the window. Any other frame ends the window and is left, with the receiver, to its service.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @param cbs   Pointer to dw1000_mac_interface_t.
+ *
+ * @return true if the frame was a blink received in a listen window
+ */
+static bool
+rx_complete_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs){
+
+    tdoa_instance_t * tdoa = inst->tdoa;
+    if (tdoa->config.role != TDOA_ROLE_ANCHOR || !tdoa->status.listening)
+        return false;
+
+    // Other frames are left to their services, which own the receiver from here
+    if (inst->fctrl_array[0] != FCNTL_IEEE_BLINK_TAG_64 || inst->frame_len != sizeof(ieee_blink_frame_t)){
+        STATS_INC(tdoa->stat, rx_other);
+        tdoa_close(tdoa);
+        return false;
+    }
+    tdoa_restart_rx(inst);
+    if (inst->status.lde_error){
+        STATS_INC(tdoa->stat, rx_lde_error);
+        return true;
+    }
+
+    ieee_blink_frame_t * frame = (ieee_blink_frame_t *) inst->rxbuf;
+    tdoa_record_t * record = &tdoa->records[tdoa->head & tdoa->mask];
+    record->utime = os_cputime_ticks_to_usecs(os_cputime_get32());
+    record->tag = frame->long_address;
+    record->anchor = inst->my_short_address;
+    record->seq_num = frame->seq_num;
+#if MYNEWT_VAL(WCS_ENABLED)
+    record->synced = inst->ccp->wcs->status.valid;
+    record->toa = wcs_local_to_master(inst, inst->rxtimestamp);
+#else
+    record->synced = 0;
+    record->toa = inst->rxtimestamp & 0x0FFFFFFFFFFULL;
+#endif
+    tdoa->head++;
+
+    STATS_INC(tdoa->stat, rx_complete);
+    if (!record->synced)
+        STATS_INC(tdoa->stat, rx_unsynced);
+    if (tdoa->config.postprocess)
+        os_eventq_put(os_eventq_dflt_get(), &tdoa->callout_postprocess.c_ev);
+    return true;
+}
+
+/**
+ * API for the receive timeout callback, closes a listen window.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @param cbs   Pointer to dw1000_mac_interface_t.
+ *
+ * @return true if a listen window was closed
+ */
+static bool
+rx_timeout_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs){
+
+    tdoa_instance_t * tdoa = inst->tdoa;
+    if (!tdoa->status.listening)
+        return false;
+
+    STATS_INC(tdoa->stat, rx_timeout);
+    tdoa_close(tdoa);
+    return true;
+}
+
+/**
+ * API for the receive error callback. Blinks collide; the MAC re-enables the receiver and the window stays open.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @param cbs   Pointer to dw1000_mac_interface_t.
+ *
+ * @return false
+ */
+static bool
+rx_error_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs){
+    if (inst->tdoa->status.listening)
+        STATS_INC(inst->tdoa->stat, rx_error);
+    return false;
+}
+
+/**
+ * API for the reset callback, ends a blink or a listen window in flight.
+ *
+ * @param inst  Pointer to dw1000_dev_instance_t.
+ * @param cbs   Pointer to dw1000_mac_interface_t.
+ *
+ * @return true if the service was reset
+ */
+static bool
+reset_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs){
+
+    tdoa_instance_t * tdoa = inst->tdoa;
+    if (os_sem_get_count(&tdoa->sem) == 0){
+        tdoa->status.blink_pending = 0;
+        tdoa->status.listening = 0;
+        os_error_t err = os_sem_release(&tdoa->sem);
+        assert(err == OS_OK);
+        STATS_INC(tdoa->stat, reset);
+        return true;
+    }
+    return false;
+}
+
+#endif // TDOA_ENABLED
@@ -0,0 +1,314 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ * 
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file tdoa_solve.c
+ * @author paul kettle
+ * @date 2018
+ * @brief TDoA solver
+ *
+ * @details Times of arrival are taken relative to the earliest one before conversion to float, so that only the
+ * spread of a blink across the anchors, not the 40-bit master time, has to fit in single precision.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+#include <dsp/mat.h>
+#include <tdoa/tdoa_solve.h>
+
+#define TDOA_PLANAR (1e-2f)             //!< Anchor height spread, as a power ratio to the horizontal, below which they are planar
+#define TDOA_MASK 0x0FFFFFFFFFFULL      //!< 40-bit time
+#define TDOA_ALPHA_MIN (1.0f / 16)      //!< Smallest fraction of a Gauss-Newton step tried
+
+static inline bool
+valid(const tdoa_meas_t * m){
+    return !(m->variance < 0);
+}
+
+static inline float
+weight(const tdoa_meas_t * m){
+    return (m->variance > 0) ? 1.0f / m->variance : 1.0f;
+}
+
+/**
+ * Help function for the range difference of an arrival to a reference arrival time, m.
+ */
+static inline float
+delta(const tdoa_meas_t * m, uint64_t ref){
+    int64_t dt = (int64_t)(((m->toa - ref) & TDOA_MASK) << 24) >> 24;
+    return dt * TDOA_DTU_TO_M;
+}
+
+/**
+ * Help function to find the earliest valid arrival.
+ *
+ * @return Index of the arrival, -1 if there is none
+ */
+static int16_t
+reference(const tdoa_meas_t * meas, uint16_t n){
+    int16_t ref = -1;
+    for (uint16_t i = 0; i < n; i++)
+        if (valid(&meas[i]) && (ref < 0 || delta(&meas[i], meas[ref].toa) < 0))
+            ref = i;
+    return ref;
+}
+
+/**
+ * Closed-form fix from the squared range equations less that of the reference anchor,
+ * 2 (a_i - a_0) p + 2 d_i r0 = |a_i|^2 - |a_0|^2 - d_i^2, solved by linear least squares in p and r0 with the anchors
+ * centred on their mean. In 2D pos->z is held fixed.
+ */
+static bool
+linear_fix(const tdoa_meas_t * meas, uint16_t n, int16_t ref, uint16_t dim, triad_t * pos, float * r0){
+
+    float c[3] = {0};
+    uint16_t m = 0;
+    for (uint16_t i = 0; i < n; i++){
+        if (!valid(&meas[i]))
+            continue;
+        for (uint16_t k = 0; k < 3; k++)
+            c[k] += meas[i].anchor.array[k];
+        m++;
+    }
+    if (m < dim + 2)
+        return false;
+    for (uint16_t k = 0; k < 3; k++)
+        c[k] /= m;
+
+    float a0[3], a[3], A[MAT_N_MAX * MAT_N_MAX], b[MAT_N_MAX] = {0}, v[MAT_N_MAX];
+    float a0_2 = 0;
+    for (uint16_t k = 0; k < 3; k++){
+        a0[k] = meas[ref].anchor.array[k] - c[k];
+        a0_2 += a0[k] * a0[k];
+    }
+    mat_zero(A, dim + 1);
+    for (uint16_t i = 0; i < n; i++){
+        if (i == ref || !valid(&meas[i]))
+            continue;
+        float d = delta(&meas[i], meas[ref].toa);
+        float rhs = - a0_2 - d * d;
+        for (uint16_t k = 0; k < 3; k++){
+            a[k] = meas[i].anchor.array[k] - c[k];
+            rhs += a[k] * a[k];
+        }
+        if (dim == 2)
+            rhs -= 2 * (a[2] - a0[2]) * (pos->z - c[2]);
+        for (uint16_t k = 0; k < dim; k++)
+            v[k] = 2 * (a[k] - a0[k]);
+        v[dim] = 2 * d;
+        for (uint16_t k = 0; k <= dim; k++)
+            b[k] += v[k] * rhs;
+        mat_rank1(A, v, 1.0f, dim + 1);
+    }
+    if (dim == 3 && A[2 * 4 + 2] < TDOA_PLANAR * 0.5f * (A[0] + A[1 * 4 + 1]))
+        return false;   // Height unresolved, see planar_fix
+    if (!mat_chol(A, dim + 1))
+        return false;
+    mat_chol_solve(A, b, dim + 1);
+    for (uint16_t k = 0; k < dim; k++)
+        pos->array[k] = b[k] + c[k];
+    *r0 = b[dim];
+    return true;
+}
+
+/**
+ * Closed-form fix for 3D with the anchors in a horizontal plane. The height terms of the squared range differences
+ * then vanish, and the 2D fix in the plane gives the horizontal position and the slant range r0 to the reference
+ * anchor, from which the height below the plane follows.
+ */
+static bool
+planar_fix(const tdoa_meas_t * meas, uint16_t n, int16_t ref, triad_t * pos){
+
+    float zbar = 0, r0;
+    uint16_t m = 0;
+    for (uint16_t i = 0; i < n; i++)
+        if (valid(&meas[i])){
+            zbar += meas[i].anchor.z;
+            m++;
+        }
+    pos->z = zbar /= m;
+    if (!linear_fix(meas, n, ref, 2, pos, &r0))
+        return false;
+
+    float dx = pos->x - meas[ref].anchor.x, dy = pos->y - meas[ref].anchor.y;
+    pos->z = zbar - sqrtf(fmaxf(r0 * r0 - dx * dx - dy * dy, 0));
+    return true;
+}
+
+/**
+ * Builds the normal equations J'WJ and J'We of the arrival time residuals at pos and range offset b, with the
+ * unknowns ordered position then offset.
+ *
+ * @return Arrival times used
+ */
+static uint16_t
+normal_equations(const tdoa_meas_t * meas, uint16_t n, int16_t ref, uint16_t dim, const triad_t * pos, float b,
+        float * A, float * g, float * wsse, float * wsum){
+
+    uint16_t m = 0;
+    float u[MAT_N_MAX];
+    mat_zero(A, dim + 1);
+    memset(g, 0, (dim + 1) * sizeof(float));
+    *wsse = *wsum = 0;
+
+    for (uint16_t i = 0; i < n; i++){
+        const tdoa_meas_t * r = &meas[i];
+        if (!valid(r))
+            continue;
+        float dx = pos->x - r->anchor.x, dy = pos->y - r->anchor.y, dz = pos->z - r->anchor.z;
+        float rho = sqrtf(dx * dx + dy * dy + dz * dz);
+        if (rho < TDOA_TOL)
+            continue;   // On top of the anchor, no direction
+        u[0] = dx / rho; u[1] = dy / rho; u[2] = dz / rho;
+        u[dim] = 1.0f;
+        float w = weight(r), e = delta(r, meas[ref].toa) - rho - b;
+        mat_rank1(A, u, w, dim + 1);
+        for (uint16_t k = 0; k <= dim; k++)
+            g[k] += w * u[k] * e;
+        *wsse += w * e * e;
+        *wsum += w;
+        m++;
+    }
+    return m;
+}
+
+/**
+ * Help function for the range offset that best fits the arrival times at pos.
+ */
+static float
+range_offset(const tdoa_meas_t * meas, uint16_t n, int16_t ref, const triad_t * pos){
+
+    float b = 0, wsum = 0;
+    for (uint16_t i = 0; i < n; i++){
+        const tdoa_meas_t * r = &meas[i];
+        if (!valid(r))
+            continue;
+        float dx = pos->x - r->anchor.x, dy = pos->y - r->anchor.y, dz = pos->z - r->anchor.z;
+        float w = weight(r);
+        b += w * (delta(r, meas[ref].toa) - sqrtf(dx * dx + dy * dy + dz * dz));
+        wsum += w;
+    }
+    return b / wsum;
+}
+
+/**
+ * Help function for the weighted sum of squared arrival time residuals at pos and range offset b.
+ */
+static float
+cost(const tdoa_meas_t * meas, uint16_t n, int16_t ref, const triad_t * pos, float b){
+
+    float wsse = 0;
+    for (uint16_t i = 0; i < n; i++){
+        const tdoa_meas_t * r = &meas[i];
+        if (!valid(r))
+            continue;
+        float dx = pos->x - r->anchor.x, dy = pos->y - r->anchor.y, dz = pos->z - r->anchor.z;
+        float e = delta(r, meas[ref].toa) - sqrtf(dx * dx + dy * dy + dz * dz) - b;
+        wsse += weight(r) * e * e;
+    }
+    return wsse;
+}
+
+/**
+ * API to compute a position from the arrival times of a blink.
+ *
+ * @param meas     Arrival times; entries with a negative variance are skipped.
+ * @param n        Number of arrival times.
+ * @param dim      2 or 3.
+ * @param initial  Start from sol->pos instead of the closed-form fix.
+ * @param sol      Solution; sol->pos.z is the height of the tag in 2D.
+ *
+ * @return true on success, sol is only written on success
+ */
+bool
+tdoa_solve(const tdoa_meas_t * meas, uint16_t n, uint16_t dim, bool initial, tdoa_solution_t * sol){
+
+    assert(dim == 2 || dim == 3);
+    int16_t ref = reference(meas, n);
+    if (ref < 0)
+        return false;
+
+    triad_t pos = sol->pos;
+    if (!initial){
+        float r0;
+        if (!linear_fix(meas, n, ref, dim, &pos, &r0)
+                && !(dim == 3 && planar_fix(meas, n, ref, &pos)))
+            return false;
+    }
+    float b = range_offset(meas, n, ref, &pos);
+
+    float A[MAT_N_MAX * MAT_N_MAX], g[MAT_N_MAX], wsse, wsum;
+    uint16_t m = 0, it;
+    for (it = 0; it < TDOA_ITER_MAX; it++){
+        m = normal_equations(meas, n, ref, dim, &pos, b, A, g, &wsse, &wsum);
+        if (m < dim + 1 || !mat_chol(A, dim + 1))
+            return false;
+        mat_chol_solve(A, g, dim + 1);
+
+        // Far from the anchors the offset and the range along the line of sight are nearly interchangeable and the
+        // full step can overshoot; halve it until the residual decreases.
+        triad_t next;
+        float alpha = 1.0f, step;
+        while (1){
+            next = pos;
+            step = 0;
+            for (uint16_t k = 0; k < dim; k++){
+                next.array[k] += alpha * g[k];
+                step += alpha * alpha * g[k] * g[k];
+            }
+            if (alpha <= TDOA_ALPHA_MIN || cost(meas, n, ref, &next, b + alpha * g[dim]) <= wsse)
+                break;
+            alpha *= 0.5f;
+        }
+        pos = next;
+        b += alpha * g[dim];
+        if (!isfinite(step) || !isfinite(b))
+            return false;
+        if (step < TDOA_TOL * TDOA_TOL){
+            it++;
+            break;
+        }
+    }
+
+    m = normal_equations(meas, n, ref, dim, &pos, b, A, g, &wsse, &wsum);
+    if (m < dim + 1 || !mat_chol(A, dim + 1))
+        return false;
+
+    float cov[MAT_N_MAX * MAT_N_MAX];
+    mat_chol_inv(A, cov, dim + 1);
+    bool absolute = true;
+    for (uint16_t i = 0; i < n; i++)
+        if (valid(&meas[i]) && !(meas[i].variance > 0))
+            absolute = false;
+    float scale = (!absolute && m > dim + 1) ? wsse / (m - dim - 1) : 1.0f;
+
+    memset(sol->cov, 0, sizeof(sol->cov));
+    for (uint16_t i = 0; i < dim; i++)
+        for (uint16_t j = 0; j < dim; j++)
+            sol->cov[i][j] = scale * cov[i * (dim + 1) + j];
+    sol->pos = pos;
+    sol->toe = (meas[ref].toa + (int64_t) lroundf(b / TDOA_DTU_TO_M)) & TDOA_MASK;
+    sol->rms = sqrtf(wsse / wsum);
+    sol->nmeas = m;
+    sol->iterations = it;
+    return true;
+}
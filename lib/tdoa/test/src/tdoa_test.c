@@ -0,0 +1,59 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "tdoa_test.h"
+
+TEST_CASE_DECL(tdoa_exact_test)
+TEST_CASE_DECL(tdoa_noise_test)
+
+void
+tdoa_test_meas(tdoa_meas_t * meas, const float (*anchors)[3], uint16_t n, const triad_t * tag, uint64_t toe,
+        const float * noise)
+{
+    for (uint16_t i = 0; i < n; i++){
+        float d2 = 0;
+        for (uint16_t c = 0; c < 3; c++){
+            meas[i].anchor.array[c] = anchors[i][c];
+            d2 += (tag->array[c] - anchors[i][c]) * (tag->array[c] - anchors[i][c]);
+        }
+        double range = sqrt(d2) + ((noise) ? noise[i] : 0);
+        meas[i].toa = (toe + (uint64_t) llround(range / TDOA_DTU_TO_M)) & TDOA_TEST_MASK;
+        meas[i].variance = 0;
+    }
+}
+
+TEST_SUITE(tdoa_test_all)
+{
+    tdoa_exact_test();
+    tdoa_noise_test();
+}
+
+#if MYNEWT_VAL(SELFTEST)
+int
+main(int argc, char **argv)
+{
+    sysinit();
+
+    tdoa_test_all();
+
+    return 0;
+}
+#endif
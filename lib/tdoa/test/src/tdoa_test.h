@@ -0,0 +1,41 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _TDOA_TEST_H
+#define _TDOA_TEST_H
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "sysinit/sysinit.h"
+#include "syscfg/syscfg.h"
+#include "os/os.h"
+#include "testutil/testutil.h"
+
+#include "tdoa/tdoa_solve.h"
+
+#define TDOA_TEST_MASK 0x0FFFFFFFFFFULL     /* 40-bit master time */
+
+/* Arrival times of a blink emitted at toe from tag, plus noise in m, rounded to the DTU */
+void tdoa_test_meas(tdoa_meas_t * meas, const float (*anchors)[3], uint16_t n, const triad_t * tag, uint64_t toe,
+        const float * noise);
+
+#endif /* _TDOA_TEST_H */
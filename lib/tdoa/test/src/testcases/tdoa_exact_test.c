@@ -0,0 +1,88 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "tdoa_test.h"
+
+#define TDOA_EXACT_TEST_ANCHORS 6
+
+static const float spread[TDOA_EXACT_TEST_ANCHORS][3] = {
+    {0, 0, 0.5f}, {10.0f, 0, 2.8f}, {10.0f, 8.0f, 0.3f}, {0, 8.0f, 2.2f}, {5.0f, -2.0f, 3.0f}, {5.0f, 10.0f, 1.0f}
+};
+static const float ceiling[TDOA_EXACT_TEST_ANCHORS][3] = {
+    {0, 0, 3.0f}, {10.0f, 0, 3.0f}, {10.0f, 8.0f, 3.0f}, {0, 8.0f, 3.0f}, {4.0f, 5.0f, 3.0f}, {7.0f, -1.0f, 3.0f}
+};
+
+/* Emission time error of the solution, DTU */
+static int64_t
+toe_error(const tdoa_solution_t * sol, uint64_t toe)
+{
+    return (int64_t)(((sol->toe - toe) & TDOA_TEST_MASK) << 24) >> 24;
+}
+
+/* Arrival times rounded to the DTU give back the tag position and the emission time, across the 40-bit wrap */
+TEST_CASE(tdoa_exact_test)
+{
+    tdoa_meas_t meas[TDOA_EXACT_TEST_ANCHORS];
+    tdoa_solution_t sol;
+    const triad_t tag = {.x = 3.7f, .y = 5.2f, .z = 1.1f};
+    /* The blink is emitted just before the master time wraps, so some arrivals wrap and others do not */
+    const uint64_t toe = TDOA_TEST_MASK - 1500;
+
+    /* 3D, anchors at different heights */
+    tdoa_test_meas(meas, spread, TDOA_EXACT_TEST_ANCHORS, &tag, toe, NULL);
+    TEST_ASSERT(meas[0].toa > toe && meas[1].toa < toe);
+    memset(&sol, 0, sizeof(sol));
+    TEST_ASSERT_FATAL(tdoa_solve(meas, TDOA_EXACT_TEST_ANCHORS, 3, false, &sol));
+    for (uint16_t c = 0; c < 3; c++)
+        TEST_ASSERT(fabsf(sol.pos.array[c] - tag.array[c]) < 0.02f);
+    TEST_ASSERT(llabs(toe_error(&sol, toe)) <= 2);
+    TEST_ASSERT(sol.nmeas == TDOA_EXACT_TEST_ANCHORS);
+
+    /* 3D from an initial estimate, dim + 1 arrivals */
+    memset(&sol, 0, sizeof(sol));
+    sol.pos.x = 4.5f; sol.pos.y = 4.5f; sol.pos.z = 1.5f;
+    TEST_ASSERT_FATAL(tdoa_solve(meas, 4, 3, true, &sol));
+    for (uint16_t c = 0; c < 3; c++)
+        TEST_ASSERT(fabsf(sol.pos.array[c] - tag.array[c]) < 0.02f);
+
+    /* 2D, height of the tag given */
+    memset(&sol, 0, sizeof(sol));
+    sol.pos.z = tag.z;
+    TEST_ASSERT_FATAL(tdoa_solve(meas, 4, 2, false, &sol));
+    TEST_ASSERT(fabsf(sol.pos.x - tag.x) < 0.02f);
+    TEST_ASSERT(fabsf(sol.pos.y - tag.y) < 0.02f);
+    TEST_ASSERT(sol.pos.z == tag.z);
+    TEST_ASSERT(sol.cov[2][2] == 0);
+    TEST_ASSERT(llabs(toe_error(&sol, toe)) <= 2);
+
+    /* 3D, coplanar ceiling anchors: the tag is placed below the plane */
+    tdoa_test_meas(meas, ceiling, TDOA_EXACT_TEST_ANCHORS, &tag, toe, NULL);
+    memset(&sol, 0, sizeof(sol));
+    TEST_ASSERT_FATAL(tdoa_solve(meas, TDOA_EXACT_TEST_ANCHORS, 3, false, &sol));
+    for (uint16_t c = 0; c < 3; c++)
+        TEST_ASSERT(fabsf(sol.pos.array[c] - tag.array[c]) < 0.02f);
+
+    /* An arrival marked invalid is skipped, leaving too few for a fix */
+    tdoa_test_meas(meas, spread, TDOA_EXACT_TEST_ANCHORS, &tag, toe, NULL);
+    meas[2].variance = -1;
+    memset(&sol, 0, sizeof(sol));
+    TEST_ASSERT(!tdoa_solve(meas, 4, 3, false, &sol));
+    TEST_ASSERT(!tdoa_solve(meas, 3, 2, false, &sol));
+}
@@ -0,0 +1,144 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file telemetry.h
+ * @author paul kettle
+ * @date 2018
+ * @brief Binary telemetry
+ *
+ * @details Producers append TLV records to a shared byte ring and return immediately; a low priority task drains the
+ * ring to a sink. A full ring drops the new record rather than blocking the producer.
+ *
+ * Wire format, all fields little-endian:
+ *
+ *     | 0xA5 | type (1) | len (2) | payload (len) | crc16 (2) |
+ *
+ * crc16 is CRC-16/CCITT (seed 0) over type, len and payload. Payload layouts are the telemetry_*_t structures below.
+ * The default sink prints the byte stream as base64 lines starting with '#', see scripts/telemetry_decode.py.
+ */
+
+#ifndef _TELEMETRY_H_
+#define _TELEMETRY_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <os/os.h>
+
+#define TELEMETRY_MAGIC 0xA5            //!< Start of record
+#define TELEMETRY_OVERHEAD (1 + 1 + 2 + 2)  //!< Bytes added to each payload
+
+//! Record types
+typedef enum _telemetry_type_t{
+    TELEMETRY_INVALID = 0,              //!< Invalid record
+    TELEMETRY_RNG,                      //!< telemetry_rng_t
+    TELEMETRY_NRNG,                     //!< telemetry_nrng_t
+    TELEMETRY_CCP,                      //!< telemetry_ccp_t
+    TELEMETRY_WCS,                      //!< telemetry_wcs_t
+    TELEMETRY_CIR,                      //!< telemetry_cir_t followed by nsize cir samples
+    TELEMETRY_PMEM,                     //!< telemetry_cir_t followed by nsize preamble samples
+    TELEMETRY_TDOA,                     //!< telemetry_tdoa_t
+}telemetry_type_t;
+
+//! Completed range, as rng_encode
+typedef struct _telemetry_rng_t{
+    uint32_t utime;                     //!< CPU time, usec
+    uint8_t code;                       //!< Ranging mode of the final frame
+    uint8_t seq_num;                    //!< Sequence number
+    float tof;                          //!< Time of flight, DTU
+    float range;                        //!< Range, m
+    uint32_t res_req;                   //!< Response minus request timestamp
+    uint32_t rec_tra;                   //!< Transmission minus reception timestamp
+}__attribute__((__packed__)) telemetry_rng_t;
+
+//! nrng response, as nrng_encode
+typedef struct _telemetry_nrng_t{
+    uint32_t utime;                     //!< CPU time, usec
+    uint16_t slot_id;                   //!< Responder slot
+    uint8_t seq_num;                    //!< Sequence number
+    uint32_t reception_timestamp;       //!< Request reception timestamp
+    uint32_t transmission_timestamp;    //!< Response transmission timestamp
+}__attribute__((__packed__)) telemetry_nrng_t;
+
+//! Clock calibration packet, as ccp_postprocess
+typedef struct _telemetry_ccp_t{
+    uint32_t utime;                     //!< CPU time, usec
+    uint8_t seq_num;                    //!< Sequence number
+    uint64_t transmission_timestamp;    //!< Master transmission timestamp
+    uint64_t delta;                     //!< Interval since previous packet, DTU
+    float clock_offset;                 //!< Clock offset ratio from the carrier integrator
+}__attribute__((__packed__)) telemetry_ccp_t;
+
+//! Clock model update, as wcs_postprocess
+typedef struct _telemetry_wcs_t{
+    uint32_t utime;                     //!< CPU time, usec
+    uint64_t master_epoch;              //!< Master epoch, DTU
+    uint64_t local_epoch;               //!< Local epoch, DTU
+    uint64_t correction;                //!< Correction over one interval, DTU
+    double skew;                        //!< Clock skew
+    int16_t nT;                         //!< Missed packets
+    uint8_t seq_num;                    //!< Sequence number
+    uint8_t previous_seq_num;           //!< Previous sequence number
+}__attribute__((__packed__)) telemetry_wcs_t;
+
+//! Channel impulse response or preamble memory header
+typedef struct _telemetry_cir_t{
+    char name[8];                       //!< Source name, NUL padded
+    uint32_t utime;                     //!< CPU time, usec
+    float fp_idx;                       //!< First path index
+    float fp_power;                     //!< First path power, dBm
+    uint16_t nsize;                     //!< Number of complex int16 samples that follow
+}__attribute__((__packed__)) telemetry_cir_t;
+
+//! Blink arrival at an anchor, as tdoa_postprocess
+typedef struct _telemetry_tdoa_t{
+    uint32_t utime;                     //!< CPU time of the reception, usec
+    uint64_t tag;                       //!< Long address of the tag
+    uint16_t anchor;                    //!< Short address of the anchor
+    uint8_t seq_num;                    //!< Sequence number of the blink
+    uint8_t synced;                     //!< Set when toa is in master time
+    uint64_t toa;                       //!< Time of arrival, DTU
+}__attribute__((__packed__)) telemetry_tdoa_t;
+
+//! Scatter-gather element for telemetry_writev
+typedef struct _telemetry_iov_t{
+    const void * base;                  //!< Segment start
+    uint16_t len;                       //!< Segment length
+}telemetry_iov_t;
+
+//! Sink receiving drained bytes in telemetry task context
+typedef void telemetry_sink_fn(void * arg, const uint8_t * buf, uint16_t len);
+
+void telemetry_pkg_init(void);
+void telemetry_set_sink(telemetry_sink_fn * sink, void * arg);
+os_error_t telemetry_writev(telemetry_type_t type, const telemetry_iov_t * iov, uint16_t niov);
+os_error_t telemetry_write(telemetry_type_t type, const void * payload, uint16_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _TELEMETRY_H_ */
@@ -0,0 +1,210 @@
+#!/usr/bin/env python3
+#
+# Copyright 2018, Decawave Limited, All Rights Reserved
+#
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#  http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+#
+
+"""Decode the lib/telemetry record stream back into the JSON lines the
+firmware prints when TELEMETRY_ENABLED is 0.
+
+Input is either a console log, in which case only lines starting with '#'
+are base64 decoded and everything else is ignored, or (with --raw) the
+binary stream from a custom sink. Floats are printed as their IEEE-754 bit
+pattern, exactly as the firmware JSON does, so existing host tools keep
+working; pass --float to print real values instead. Ranges carry no
+azimuth, which no ranging mode fills in, so the double sided ones print
+without the "azimuth" key of the JSON output.
+
+--stats prints the number of bytes on the wire for the binary stream next
+to the size of the equivalent JSON output.
+"""
+
+import argparse
+import base64
+import json
+import struct
+import sys
+
+MAGIC = 0xA5
+HEADER = struct.Struct('<BBH')
+CRC = struct.Struct('<H')
+
+RNG, NRNG, CCP, WCS, CIR, PMEM, TDOA = range(1, 8)
+
+RNG_T = struct.Struct('<IBBffII')
+NRNG_T = struct.Struct('<IHBII')
+CCP_T = struct.Struct('<IBQQf')
+WCS_T = struct.Struct('<IQQQdhBB')
+CIR_T = struct.Struct('<8sIffH')
+TDOA_T = struct.Struct('<IQHBBQ')
+
+
+def crc16_ccitt(data, crc=0):
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def f32_bits(x):
+    return struct.unpack('<I', struct.pack('<f', x))[0]
+
+
+def f64_bits(x):
+    return struct.unpack('<Q', struct.pack('<d', x))[0]
+
+
+def hexs(x):
+    return '%X' % x
+
+
+def decode_rng(p, real):
+    utime, code, seq, tof, rng, res_req, rec_tra = RNG_T.unpack(p)
+    f = (lambda x: x) if real else f32_bits
+    return {'utime': utime, 'tof': f(tof), 'range': f(rng),
+            'res_req': hexs(res_req), 'rec_tra': hexs(rec_tra)}
+
+
+def decode_nrng(p, real):
+    utime, slot_id, seq, rx, tx = NRNG_T.unpack(p)
+    return {'utime': utime, 'slot_id': [slot_id, seq],
+            'reception': hexs(rx), 'transmission': hexs(tx)}
+
+
+def decode_ccp(p, real):
+    utime, seq, tx, delta, clock_offset = CCP_T.unpack(p)
+    return {'utime': utime, 'ccp': [hexs(tx), hexs(delta)],
+            'clock_offset': clock_offset if real else f32_bits(clock_offset),
+            'seq_num': seq}
+
+
+def decode_wcs(p, real):
+    utime, master, local, correction, skew, nT, seq, prev = WCS_T.unpack(p)
+    return {'utime': utime, 'wcs': [master, local, correction],
+            'skew': skew if real else f64_bits(skew),
+            'nT': [nT, seq, prev]}
+
+
+def decode_cir(p, real):
+    name, utime, fp_idx, fp_power, nsize = CIR_T.unpack_from(p)
+    samples = struct.unpack_from('<%dh' % (2 * nsize), p, CIR_T.size)
+    f = (lambda x: x) if real else f32_bits
+    return {'utime': utime,
+            name.rstrip(b'\0').decode('ascii', 'replace'): {
+                'idx': f(fp_idx), 'power': f(fp_power),
+                'real': list(samples[0::2]), 'imag': list(samples[1::2])}}
+
+
+def decode_pmem(p, real):
+    out = decode_cir(p, real)
+    for v in out.values():
+        if isinstance(v, dict):
+            del v['idx'], v['power']
+    return out
+
+
+def decode_tdoa(p, real):
+    utime, tag, anchor, seq, synced, toa = TDOA_T.unpack(p)
+    return {'utime': utime, 'tdoa': [hexs(tag), anchor, seq, hexs(toa)], 'synced': synced}
+
+
+DECODERS = {RNG: decode_rng, NRNG: decode_nrng, CCP: decode_ccp,
+            WCS: decode_wcs, CIR: decode_cir, PMEM: decode_pmem, TDOA: decode_tdoa}
+
+
+def records(buf, errors):
+    """Yield (type, payload, size) for each valid record, resyncing on the magic byte."""
+    i = 0
+    while True:
+        i = buf.find(bytes([MAGIC]), i)
+        if i < 0 or i + HEADER.size > len(buf):
+            return
+        _, rtype, length = HEADER.unpack_from(buf, i)
+        end = i + HEADER.size + length + CRC.size
+        if end > len(buf):
+            return
+        (crc,) = CRC.unpack_from(buf, end - CRC.size)
+        if crc16_ccitt(buf[i + 1:end - CRC.size]) != crc:
+            errors[0] += 1
+            i += 1
+            continue
+        yield rtype, bytes(buf[i + HEADER.size:end - CRC.size]), end - i
+        i = end
+
+
+def read_input(f, raw):
+    if raw:
+        return f.buffer.read() if hasattr(f, 'buffer') else f.read(), None
+    data = bytearray()
+    wire = 0
+    for line in f:
+        if line.startswith('#'):
+            wire += len(line)
+            data += base64.b64decode(line[1:].strip())
+    return bytes(data), wire
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split('\n\n')[0])
+    ap.add_argument('file', nargs='?', help='input file, stdin when omitted')
+    ap.add_argument('--raw', action='store_true', help='input is the binary stream rather than a console log')
+    ap.add_argument('--float', action='store_true', help='print floats as values rather than bit patterns')
+    ap.add_argument('--stats', action='store_true', help='compare binary and JSON output sizes')
+    args = ap.parse_args()
+
+    if args.file:
+        with open(args.file, 'rb' if args.raw else 'r') as f:
+            buf, wire = read_input(f, args.raw)
+    else:
+        buf, wire = read_input(sys.stdin, args.raw)
+
+    errors = [0]
+    count = {}
+    tlv = 0
+    json_bytes = 0
+    for rtype, payload, size in records(buf, errors):
+        decoder = DECODERS.get(rtype)
+        if decoder is None:
+            continue
+        line = json.dumps(decoder(payload, args.float), separators=(',', ':'))
+        count[rtype] = count.get(rtype, 0) + 1
+        tlv += size
+        json_bytes += len(line) + 1
+        if not args.stats:
+            print(line)
+
+    if args.stats:
+        names = {RNG: 'rng', NRNG: 'nrng', CCP: 'ccp', WCS: 'wcs', CIR: 'cir', PMEM: 'pmem', TDOA: 'tdoa'}
+        for t in sorted(count):
+            print('%-5s %d records' % (names[t], count[t]))
+        print('crc errors     %d' % errors[0])
+        print('binary bytes   %d' % tlv)
+        if wire is not None:
+            print('base64 bytes   %d' % wire)
+        print('json bytes     %d' % json_bytes)
+        if tlv:
+            print('json/binary    %.2f' % (json_bytes / tlv))
+            if wire:
+                print('json/base64    %.2f' % (json_bytes / wire))
+
+
+if __name__ == '__main__':
+    main()
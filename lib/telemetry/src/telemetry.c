@@ -0,0 +1,260 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file telemetry.c
+ * @author paul kettle
+ * @date 2018
+ * @brief Binary telemetry
+ *
+ * @details Producers from any task copy a complete record into the ring inside a short critical section; the CRC is
+ * computed beforehand so the section only covers the copy. The telemetry task is the only consumer and hands contiguous
+ * runs of the ring to the sink.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <os/os.h>
+#include <stats/stats.h>
+#include <crc/crc16.h>
+#include <base64/base64.h>
+
+#include <telemetry/telemetry.h>
+
+#if MYNEWT_VAL(TELEMETRY_ENABLED)
+
+#define TELEMETRY_BUF_MASK (MYNEWT_VAL(TELEMETRY_BUF_SIZE) - 1)
+
+STATS_SECT_START(telemetry_stat_section)
+    STATS_SECT_ENTRY(records)
+    STATS_SECT_ENTRY(bytes)
+    STATS_SECT_ENTRY(drops)
+STATS_SECT_END
+
+STATS_NAME_START(telemetry_stat_section)
+    STATS_NAME(telemetry_stat_section, records)
+    STATS_NAME(telemetry_stat_section, bytes)
+    STATS_NAME(telemetry_stat_section, drops)
+STATS_NAME_END(telemetry_stat_section)
+
+static STATS_SECT_DECL(telemetry_stat_section) g_stat;
+
+static struct {
+    struct os_sem sem;                              //!< Signals data available
+    struct os_task task_str;                        //!< Drain task
+    os_stack_t task_stack[MYNEWT_VAL(TELEMETRY_TASK_STACK_SZ)]
+        __attribute__((aligned(OS_STACK_ALIGNMENT)));
+    telemetry_sink_fn * sink;                       //!< Output sink
+    void * sink_arg;                                //!< Sink argument
+    volatile uint32_t head;                         //!< Bytes written, free running
+    volatile uint32_t tail;                         //!< Bytes drained, free running
+    uint8_t buf[MYNEWT_VAL(TELEMETRY_BUF_SIZE)];    //!< Ring storage
+} g_telemetry;
+
+#if MYNEWT_VAL(TELEMETRY_BASE64_SINK)
+/**
+ * Default sink, base64 lines of at most 48 bytes so the stream can share the console with text output.
+ *
+ * @param arg  Unused.
+ * @param buf  Bytes to output.
+ * @param len  Number of bytes.
+ *
+ * @return void
+ */
+static void
+base64_sink(void * arg, const uint8_t * buf, uint16_t len){
+    char line[BASE64_ENCODE_SIZE(48) + 1];
+
+    while (len){
+        uint16_t n = (len > 48) ? 48 : len;
+        int rc = base64_encode(buf, n, line, 1);
+        printf("#%.*s\n", rc, line);
+        buf += n;
+        len -= n;
+    }
+}
+#endif
+
+/**
+ * Telemetry task, drains the ring whenever producers signal new data.
+ *
+ * @param arg  Unused.
+ *
+ * @return void
+ */
+static void
+telemetry_task(void * arg){
+    while (1) {
+        os_sem_pend(&g_telemetry.sem, OS_TIMEOUT_NEVER);
+        while (g_telemetry.tail != g_telemetry.head){
+            uint32_t tail = g_telemetry.tail;
+            uint32_t offset = tail & TELEMETRY_BUF_MASK;
+            uint32_t len = g_telemetry.head - tail;
+            if (offset + len > MYNEWT_VAL(TELEMETRY_BUF_SIZE))
+                len = MYNEWT_VAL(TELEMETRY_BUF_SIZE) - offset;
+            if (g_telemetry.sink)
+                g_telemetry.sink(g_telemetry.sink_arg, &g_telemetry.buf[offset], len);
+            g_telemetry.tail = tail + len;
+        }
+    }
+}
+
+#endif // TELEMETRY_ENABLED
+
+/**
+ * API to initialise the telemetry package.
+ *
+ * @return void
+ */
+void
+telemetry_pkg_init(void){
+
+#if MYNEWT_VAL(TELEMETRY_ENABLED)
+    printf("{\"utime\": %lu,\"msg\": \"telemetry_pkg_init\"}\n",os_cputime_ticks_to_usecs(os_cputime_get32()));
+
+    assert((MYNEWT_VAL(TELEMETRY_BUF_SIZE) & TELEMETRY_BUF_MASK) == 0);
+
+    os_error_t err = os_sem_init(&g_telemetry.sem, 0);
+    assert(err == OS_OK);
+#if MYNEWT_VAL(TELEMETRY_BASE64_SINK)
+    g_telemetry.sink = base64_sink;
+#endif
+
+    int rc = stats_init(
+                    STATS_HDR(g_stat),
+                    STATS_SIZE_INIT_PARMS(g_stat, STATS_SIZE_32),
+                    STATS_NAME_INIT_PARMS(telemetry_stat_section)
+            );
+    rc |= stats_register("telemetry", STATS_HDR(g_stat));
+    assert(rc == 0);
+
+    os_task_init(&g_telemetry.task_str, "telemetry",
+                 telemetry_task,
+                 NULL,
+                 MYNEWT_VAL(TELEMETRY_TASK_PRIO), OS_WAIT_FOREVER,
+                 g_telemetry.task_stack,
+                 MYNEWT_VAL(TELEMETRY_TASK_STACK_SZ));
+#endif
+}
+
+#if MYNEWT_VAL(TELEMETRY_ENABLED)
+
+/**
+ * API to replace the output sink, e.g. with a raw uart or a BLE characteristic. A NULL sink discards the stream.
+ *
+ * @param sink  Sink function, called from the telemetry task.
+ * @param arg   Sink argument.
+ *
+ * @return void
+ */
+void
+telemetry_set_sink(telemetry_sink_fn * sink, void * arg){
+    os_sr_t sr;
+    OS_ENTER_CRITICAL(sr);
+    g_telemetry.sink = sink;
+    g_telemetry.sink_arg = arg;
+    OS_EXIT_CRITICAL(sr);
+}
+
+/**
+ * Copies len bytes into the ring at head, wrapping as needed. Caller holds the critical section.
+ */
+static inline uint32_t
+ring_put(uint32_t head, const void * data, uint16_t len){
+    uint32_t offset = head & TELEMETRY_BUF_MASK;
+    uint32_t first = MYNEWT_VAL(TELEMETRY_BUF_SIZE) - offset;
+
+    if (len <= first){
+        memcpy(&g_telemetry.buf[offset], data, len);
+    }else{
+        memcpy(&g_telemetry.buf[offset], data, first);
+        memcpy(g_telemetry.buf, (const uint8_t *)data + first, len - first);
+    }
+    return head + len;
+}
+
+/**
+ * API to append a record assembled from several segments. Safe to call from any task.
+ *
+ * @param type  Record type.
+ * @param iov   Payload segments.
+ * @param niov  Number of segments.
+ *
+ * @return OS_OK, or OS_ENOMEM when the record was dropped
+ */
+os_error_t
+telemetry_writev(telemetry_type_t type, const telemetry_iov_t * iov, uint16_t niov){
+
+    uint8_t hdr[4] = {TELEMETRY_MAGIC, type, 0, 0};
+    uint32_t len = 0;
+
+    for (uint16_t i = 0; i < niov; i++)
+        len += iov[i].len;
+    if (len > UINT16_MAX)
+        return OS_EINVAL;
+    hdr[2] = len & 0xFF;
+    hdr[3] = len >> 8;
+
+    uint16_t crc = crc16_ccitt(0, &hdr[1], 3);
+    for (uint16_t i = 0; i < niov; i++)
+        crc = crc16_ccitt(crc, iov[i].base, iov[i].len);
+    uint8_t trailer[2] = {crc & 0xFF, crc >> 8};
+
+    uint32_t total = len + TELEMETRY_OVERHEAD;
+    os_sr_t sr;
+    OS_ENTER_CRITICAL(sr);
+    uint32_t head = g_telemetry.head;
+    if (MYNEWT_VAL(TELEMETRY_BUF_SIZE) - (head - g_telemetry.tail) < total){
+        OS_EXIT_CRITICAL(sr);
+        STATS_INC(g_stat, drops);
+        return OS_ENOMEM;
+    }
+    head = ring_put(head, hdr, sizeof(hdr));
+    for (uint16_t i = 0; i < niov; i++)
+        head = ring_put(head, iov[i].base, iov[i].len);
+    head = ring_put(head, trailer, sizeof(trailer));
+    g_telemetry.head = head;
+    OS_EXIT_CRITICAL(sr);
+
+    STATS_INC(g_stat, records);
+    STATS_INCN(g_stat, bytes, total);
+    if (os_sem_get_count(&g_telemetry.sem) == 0)
+        os_sem_release(&g_telemetry.sem);
+    return OS_OK;
+}
+
+/**
+ * API to append a single segment record. Safe to call from any task.
+ *
+ * @param type     Record type.
+ * @param payload  Payload.
+ * @param len      Payload length.
+ *
+ * @return OS_OK, or OS_ENOMEM when the record was dropped
+ */
+os_error_t
+telemetry_write(telemetry_type_t type, const void * payload, uint16_t len){
+    telemetry_iov_t iov = {.base = payload, .len = len};
+    return telemetry_writev(type, &iov, 1);
+}
+
+#endif // TELEMETRY_ENABLED
@@ -0,0 +1,104 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file tof.h
+ * @author paul kettle
+ * @date 2018
+ * @brief Time-of-flight kernels
+ *
+ * @details Integer time-of-flight kernels shared by all TWR modes. Intervals are formed modulo the timestamp width so that
+ * counter wraparound between request and response is handled, products are bounded so that nothing overflows 64-bit
+ * arithmetic, and results are returned in picoseconds. The package has no dependencies and builds on the host.
+ */
+
+#ifndef _TOF_H_
+#define _TOF_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TOF_TIMESTAMP_MASK_40   0x0FFFFFFFFFFULL    //!< Full DW1000 system time, 40-bit
+#define TOF_TIMESTAMP_MASK_32   0x0FFFFFFFFULL      //!< Lower 32-bit timestamps as carried in ranging frames
+#define TOF_PS_PER_DTU_Q16      1025641LL           //!< 1/(499.2e6*128) s = 15.650040 ps, Q16
+#define TOF_MM_PER_PS_Q24       5028210LL           //!< c/1.000293 = 0.2997046 mm/ps, Q24
+#define TOF_PS_PER_DTU          (15.650040064f)     //!< Float equivalent of TOF_PS_PER_DTU_Q16
+#define TOF_SKEW_Q31_MAX        ((int32_t)1 << 20)  //!< Skew clamp, ~488 ppm in Q31
+#define TOF_DIFF_MAX            ((int64_t)1 << 21)  //!< Bound on round-minus-reply, ~33 usec or ~10 km of flight
+
+//! Time intervals of one request/response exchange, in DTU.
+typedef struct _tof_exchange_t{
+    uint64_t round;         //!< Round trip time measured by the side that sent the request
+    uint64_t reply;         //!< Turnaround time measured by the side that sent the response
+}tof_exchange_t;
+
+/**
+ * Interval between two 40-bit timestamps, modulo 2^40.
+ *
+ * @param end    Later timestamp.
+ * @param start  Earlier timestamp.
+ * @return Interval in DTU
+ */
+static inline uint64_t
+tof_interval(uint64_t end, uint64_t start){
+    return (end - start) & TOF_TIMESTAMP_MASK_40;
+}
+
+/**
+ * Interval between two truncated 32-bit timestamps, modulo 2^32.
+ *
+ * @param end    Later timestamp.
+ * @param start  Earlier timestamp.
+ * @return Interval in DTU
+ */
+static inline uint64_t
+tof_interval32(uint32_t end, uint32_t start){
+    return (uint32_t)(end - start);
+}
+
+/**
+ * Converts a clock offset ratio into the Q31 representation used by tof_ss_ps, clamped to TOF_SKEW_Q31_MAX.
+ *
+ * @param skew  Clock offset ratio of the remote clock relative to the local clock.
+ * @return Skew in Q31
+ */
+static inline int32_t
+tof_skew_to_q31(float skew){
+    float q = skew * 2147483648.0f;
+    if (q > TOF_SKEW_Q31_MAX) return TOF_SKEW_Q31_MAX;
+    if (q < -TOF_SKEW_Q31_MAX) return -TOF_SKEW_Q31_MAX;
+    return (int32_t) q;
+}
+
+int32_t tof_ss_ps(const tof_exchange_t * ex, int32_t skew_q31);
+int32_t tof_ds_ps(const tof_exchange_t * first, const tof_exchange_t * second);
+int32_t tof_ds_sym_ps(const tof_exchange_t * first, const tof_exchange_t * second);
+int32_t tof_ps_to_mm(int32_t ps);
+int32_t tof_ps_to_dtu(int32_t ps);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _TOF_H_ */
@@ -0,0 +1,148 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file tof.c
+ * @author paul kettle
+ * @date 2018
+ * @brief Time-of-flight kernels
+ *
+ * @details All kernels work on intervals rather than raw timestamps. The DS-TWR product Ra*Rb - Da*Db is expanded as
+ * Ra*(Rb-Db) + Db*(Ra-Da); the bracketed terms are small (twice the flight time plus clock drift over the turnaround),
+ * so once they are bounded by TOF_DIFF_MAX the numerator fits comfortably in int64 for any 40-bit interval.
+ */
+
+#include <stdint.h>
+#include <tof/tof.h>
+
+static inline int64_t
+sat_diff(uint64_t a, uint64_t b){
+    int64_t d = (int64_t)(a & TOF_TIMESTAMP_MASK_40) - (int64_t)(b & TOF_TIMESTAMP_MASK_40);
+    if (d > TOF_DIFF_MAX) return TOF_DIFF_MAX;
+    if (d < -TOF_DIFF_MAX) return -TOF_DIFF_MAX;
+    return d;
+}
+
+static inline int32_t
+sat32(int64_t x){
+    if (x > INT32_MAX) return INT32_MAX;
+    if (x < INT32_MIN) return INT32_MIN;
+    return (int32_t) x;
+}
+
+/**
+ * Converts a DTU value in Q16 to rounded picoseconds without overflowing for any input produced by the kernels.
+ *
+ * @param x  Time in DTU, Q16.
+ * @return Time in picoseconds
+ */
+static inline int64_t
+dtu_q16_to_ps(int64_t x){
+    int64_t q = x >> 16;
+    int64_t f = x & 0xFFFF;
+    int64_t ps_q16 = q * TOF_PS_PER_DTU_Q16 + ((f * TOF_PS_PER_DTU_Q16) >> 16);
+    return (ps_q16 + 0x8000) >> 16;
+}
+
+/**
+ * Single-sided TWR. ToF = (Tround - Treply * (1 - skew)) / 2, where skew is the clock offset ratio of the responder
+ * relative to the initiator.
+ *
+ * @param ex        Round and reply intervals of the exchange.
+ * @param skew_q31  Clock offset ratio in Q31, see tof_skew_to_q31(). Zero when timestamps are already in a common timebase.
+ * @return Time of flight in picoseconds
+ */
+int32_t
+tof_ss_ps(const tof_exchange_t * ex, int32_t skew_q31){
+
+    int64_t reply = (int64_t)(ex->reply & TOF_TIMESTAMP_MASK_40);
+
+    if (skew_q31 > TOF_SKEW_Q31_MAX) skew_q31 = TOF_SKEW_Q31_MAX;
+    if (skew_q31 < -TOF_SKEW_Q31_MAX) skew_q31 = -TOF_SKEW_Q31_MAX;
+
+    int64_t tof_q16 = (sat_diff(ex->round, ex->reply) << 16) + ((reply * skew_q31) >> 15);
+    return sat32(dtu_q16_to_ps(tof_q16 / 2));
+}
+
+/**
+ * Asymmetric double-sided TWR. ToF = (Ra * Rb - Da * Db) / (Ra + Rb + Da + Db), which cancels first order clock
+ * offset without requiring equal turnaround times.
+ *
+ * @param first   Exchange initiated by the initiator (Ra, Da).
+ * @param second  Exchange initiated by the responder (Rb, Db).
+ * @return Time of flight in picoseconds, 0 if all intervals are zero
+ */
+int32_t
+tof_ds_ps(const tof_exchange_t * first, const tof_exchange_t * second){
+
+    int64_t Ra = (int64_t)(first->round & TOF_TIMESTAMP_MASK_40);
+    int64_t Da = (int64_t)(first->reply & TOF_TIMESTAMP_MASK_40);
+    int64_t Rb = (int64_t)(second->round & TOF_TIMESTAMP_MASK_40);
+    int64_t Db = (int64_t)(second->reply & TOF_TIMESTAMP_MASK_40);
+
+    int64_t nom = Ra * sat_diff(Rb, Db) + Db * sat_diff(Ra, Da);
+    int64_t denom = Ra + Rb + Da + Db;
+
+    if (denom == 0)
+        return 0;
+
+    int64_t q = nom / denom;
+    int64_t r = nom % denom;
+    int64_t ps_q16 = q * TOF_PS_PER_DTU_Q16 + (r * TOF_PS_PER_DTU_Q16) / denom;
+    return sat32((ps_q16 + 0x8000) >> 16);
+}
+
+/**
+ * Symmetric double-sided TWR. ToF = ((Ra - Da) + (Rb - Db)) / 4, only accurate when Da and Db are about equal.
+ *
+ * @param first   Exchange initiated by the initiator (Ra, Da).
+ * @param second  Exchange initiated by the responder (Rb, Db).
+ * @return Time of flight in picoseconds
+ */
+int32_t
+tof_ds_sym_ps(const tof_exchange_t * first, const tof_exchange_t * second){
+    int64_t sum = sat_diff(first->round, first->reply) + sat_diff(second->round, second->reply);
+    return sat32(dtu_q16_to_ps(sum << 14));
+}
+
+/**
+ * Converts a time of flight to distance.
+ *
+ * @param ps  Time of flight in picoseconds.
+ * @return Distance in millimeters
+ */
+int32_t
+tof_ps_to_mm(int32_t ps){
+    return (int32_t)(((int64_t)ps * TOF_MM_PER_PS_Q24 + (1 << 23)) >> 24);
+}
+
+/**
+ * Converts picoseconds to the nearest whole DTU.
+ *
+ * @param ps  Time in picoseconds.
+ * @return Time in DTU
+ */
+int32_t
+tof_ps_to_dtu(int32_t ps){
+    int64_t n = (int64_t)ps << 16;
+    n += (n < 0) ? -TOF_PS_PER_DTU_Q16/2 : TOF_PS_PER_DTU_Q16/2;
+    return (int32_t)(n / TOF_PS_PER_DTU_Q16);
+}
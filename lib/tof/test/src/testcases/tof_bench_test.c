@@ -0,0 +1,59 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "tof_test.h"
+
+#define TOF_BENCH_N 100000
+
+/* Reports the cost of each kernel; timings are informational and not asserted */
+TEST_CASE(tof_bench_test)
+{
+    tof_exchange_t first, second;
+    volatile int32_t sink = 0;
+    uint32_t t0, t1;
+
+    tof_test_exchange(640.0, 7.0, 6.4e6, 1.28e7, 0, &first, &second);
+
+    t0 = os_cputime_get32();
+    for (int i = 0; i < TOF_BENCH_N; i++){
+        first.round ^= i & 1;
+        sink += tof_ss_ps(&first, 15032);
+    }
+    t1 = os_cputime_get32();
+    printf("tof_ss_ps: %lu ns/call\n", os_cputime_ticks_to_usecs(t1 - t0) * 1000UL / TOF_BENCH_N);
+
+    t0 = os_cputime_get32();
+    for (int i = 0; i < TOF_BENCH_N; i++){
+        first.round ^= i & 1;
+        sink += tof_ds_ps(&first, &second);
+    }
+    t1 = os_cputime_get32();
+    printf("tof_ds_ps: %lu ns/call\n", os_cputime_ticks_to_usecs(t1 - t0) * 1000UL / TOF_BENCH_N);
+
+    t0 = os_cputime_get32();
+    for (int i = 0; i < TOF_BENCH_N; i++){
+        first.round ^= i & 1;
+        sink += (int32_t)tof_test_ref_ds(&first, &second);
+    }
+    t1 = os_cputime_get32();
+    printf("double reference: %lu ns/call\n", os_cputime_ticks_to_usecs(t1 - t0) * 1000UL / TOF_BENCH_N);
+
+    TEST_ASSERT(sink != 0);
+}
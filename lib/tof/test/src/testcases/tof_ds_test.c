@@ -0,0 +1,57 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "tof_test.h"
+
+TEST_CASE(tof_ds_test)
+{
+    static const double ppm[] = {-40.0, -5.0, 0.0, 3.3, 20.0, 40.0};
+    static const double tof[] = {0.0, 1.0, 64.0, 213.0, 6390.0, 63898.0};
+    static const double Da[] = {2e5, 6.4e6, 6.4e7};
+    static const double Db[] = {3e5, 6.4e6, 1.9e8};
+    tof_exchange_t first, second;
+
+    for (int i = 0; i < sizeof(ppm)/sizeof(ppm[0]); i++)
+    for (int j = 0; j < sizeof(tof)/sizeof(tof[0]); j++)
+    for (int k = 0; k < sizeof(Da)/sizeof(Da[0]); k++)
+    for (int l = 0; l < sizeof(Db)/sizeof(Db[0]); l++){
+        tof_test_exchange(tof[j], ppm[i], Da[k], Db[l], 0x123456789ULL, &first, &second);
+        double ref = tof_test_ref_ds(&first, &second);
+        int32_t ps = tof_ds_ps(&first, &second);
+        /* Within rounding of the double reference */
+        TEST_ASSERT(fabs(ps - ref) <= 1.0);
+        /* And within a couple of DTU of truth, asymmetric turnaround notwithstanding */
+        TEST_ASSERT(fabs(ps - tof[j] * TOF_TEST_DTU_PS) < 2 * TOF_TEST_DTU_PS);
+    }
+
+    /* Symmetric variant agrees when turnarounds match and skew is zero */
+    tof_test_exchange(640.0, 0.0, 6.4e6, 6.4e6, 0, &first, &second);
+    TEST_ASSERT(abs(tof_ds_sym_ps(&first, &second) - tof_ds_ps(&first, &second)) <= 1);
+
+    /* Degenerate input */
+    first = second = (tof_exchange_t){0};
+    TEST_ASSERT(tof_ds_ps(&first, &second) == 0);
+
+    /* Corrupt timestamps saturate rather than overflow */
+    first = (tof_exchange_t){.round = TOF_TIMESTAMP_MASK_40, .reply = 0};
+    second = (tof_exchange_t){.round = TOF_TIMESTAMP_MASK_40, .reply = 0};
+    TEST_ASSERT(tof_ds_ps(&first, &second) > 0);
+    TEST_ASSERT(tof_ds_sym_ps(&first, &second) > 0);
+}
@@ -0,0 +1,46 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "tof_test.h"
+
+TEST_CASE(tof_ss_test)
+{
+    /* Zero skew, 100 DTU of flight (1565 ps) with a 1 ms turnaround */
+    tof_exchange_t ex = {.round = 200 + 63898000, .reply = 63898000};
+    TEST_ASSERT(tof_ss_ps(&ex, 0) == 1565);
+
+    /* Responder running fast by 10 ppm: compensating removes the Treply * skew error */
+    double ppm = 10.0, tof = 1000.0, Da = 63898000.0;
+    tof_exchange_t first, second;
+    tof_test_exchange(tof, ppm, Da, Da, 0x1000, &first, &second);
+    int32_t raw = tof_ss_ps(&first, 0);
+    int32_t comp = tof_ss_ps(&first, tof_skew_to_q31(ppm * 1e-6));
+    TEST_ASSERT(fabs(raw - tof * TOF_TEST_DTU_PS) > 1000);
+    TEST_ASSERT(fabs(comp - tof * TOF_TEST_DTU_PS) < 2 * TOF_TEST_DTU_PS);
+
+    /* Negative flight time (over-calibrated antenna delay) keeps its sign */
+    ex = (tof_exchange_t){.round = 1000, .reply = 1100};
+    TEST_ASSERT(tof_ss_ps(&ex, 0) == -783);
+
+    /* Distance conversion */
+    TEST_ASSERT(tof_ps_to_mm(3335641) == 999707);
+    TEST_ASSERT(tof_ps_to_dtu(1565) == 100);
+    TEST_ASSERT(tof_ps_to_dtu(-1565) == -100);
+}
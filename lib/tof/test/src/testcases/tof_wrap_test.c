@@ -0,0 +1,39 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "tof_test.h"
+
+TEST_CASE(tof_wrap_test)
+{
+    tof_exchange_t first, second, first_w, second_w;
+
+    /* The same exchange placed away from and straddling the 40-bit rollover gives identical results */
+    tof_test_exchange(500.0, 12.0, 6.4e6, 1.28e7, 0x10000, &first, &second);
+    tof_test_exchange(500.0, 12.0, 6.4e6, 1.28e7, TOF_TIMESTAMP_MASK_40 - 0x1000, &first_w, &second_w);
+
+    TEST_ASSERT(first_w.round < TOF_TIMESTAMP_MASK_40);
+    TEST_ASSERT(abs((int32_t)(first.round - first_w.round)) <= 1);
+    TEST_ASSERT(abs(tof_ds_ps(&first, &second) - tof_ds_ps(&first_w, &second_w)) <= 1);
+    TEST_ASSERT(abs(tof_ss_ps(&first, 0) - tof_ss_ps(&first_w, 0)) <= 1);
+
+    /* 32-bit truncated frame timestamps wrap modulo 2^32 */
+    TEST_ASSERT(tof_interval32(0x10, 0xFFFFFFF0UL) == 0x20);
+    TEST_ASSERT(tof_interval(0x10, TOF_TIMESTAMP_MASK_40 - 0xF) == 0x20);
+}
@@ -0,0 +1,77 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "tof_test.h"
+
+TEST_CASE_DECL(tof_ss_test)
+TEST_CASE_DECL(tof_ds_test)
+TEST_CASE_DECL(tof_wrap_test)
+TEST_CASE_DECL(tof_bench_test)
+
+/**
+ * Timestamps are generated in a shared true timebase, quantised to DTU and truncated to 40-bit as the DW1000
+ * would report them; intervals are then formed with the wrap-aware helpers.
+ */
+void
+tof_test_exchange(double tof, double ppm, double Da, double Db, uint64_t t0,
+        tof_exchange_t * first, tof_exchange_t * second)
+{
+    double k = 1.0 + ppm * 1e-6;
+    uint64_t poll_tx = t0;
+    uint64_t poll_rx = (uint64_t)llround(t0 * k + tof * k);
+    uint64_t resp_tx = poll_rx + (uint64_t)llround(Da * k);
+    uint64_t resp_rx = t0 + (uint64_t)llround(tof + Da + tof);
+    uint64_t final_tx = resp_rx + (uint64_t)llround(Db);
+    uint64_t final_rx = resp_tx + (uint64_t)llround((Db + tof + tof) * k);
+
+    first->round = tof_interval(resp_rx & TOF_TIMESTAMP_MASK_40, poll_tx & TOF_TIMESTAMP_MASK_40);
+    first->reply = tof_interval(resp_tx & TOF_TIMESTAMP_MASK_40, poll_rx & TOF_TIMESTAMP_MASK_40);
+    second->round = tof_interval(final_rx & TOF_TIMESTAMP_MASK_40, resp_tx & TOF_TIMESTAMP_MASK_40);
+    second->reply = tof_interval(final_tx & TOF_TIMESTAMP_MASK_40, resp_rx & TOF_TIMESTAMP_MASK_40);
+}
+
+/* Double precision reference of the asymmetric DS-TWR formula, in picoseconds */
+double
+tof_test_ref_ds(const tof_exchange_t * first, const tof_exchange_t * second)
+{
+    double Ra = first->round, Da = first->reply, Rb = second->round, Db = second->reply;
+    return (Ra * Rb - Da * Db) / (Ra + Rb + Da + Db) * TOF_TEST_DTU_PS;
+}
+
+TEST_SUITE(tof_test_all)
+{
+    tof_ss_test();
+    tof_ds_test();
+    tof_wrap_test();
+    tof_bench_test();
+}
+
+#if MYNEWT_VAL(SELFTEST)
+int
+main(int argc, char **argv)
+{
+    sysinit();
+
+    tof_test_all();
+
+    return 0;
+}
+#endif
@@ -0,0 +1,42 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _TOF_TEST_H
+#define _TOF_TEST_H
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "sysinit/sysinit.h"
+#include "syscfg/syscfg.h"
+#include "os/os.h"
+#include "testutil/testutil.h"
+
+#include "tof/tof.h"
+
+#define TOF_TEST_DTU_PS  (1e12/(499.2e6*128.0))
+
+/* Builds both exchanges of a DS-TWR between an initiator and a responder whose clock runs at (1 + ppm*1e-6) */
+void tof_test_exchange(double tof, double ppm, double Da, double Db, uint64_t t0,
+        tof_exchange_t * first, tof_exchange_t * second);
+double tof_test_ref_ds(const tof_exchange_t * first, const tof_exchange_t * second);
+
+#endif /* _TOF_TEST_H */
@@ -46,7 +46,7 @@
 #include <dw1000/dw1000_phy.h>
 #include <dw1000/dw1000_ftypes.h>
 #include <rng/rng.h>
-#include <dsp/polyval.h>
+#include <tof/tof.h>
 
 //#define DIAGMSG(s,u) printf(s,u)
 #ifndef DIAGMSG
@@ -180,24 +180,17 @@ tx_final_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs){
     frame->cartesian.y = MYNEWT_VAL(LOCAL_COORDINATE_Y);
     frame->cartesian.z = MYNEWT_VAL(LOCAL_COORDINATE_Z);
   
+    int32_t range = tof_ps_to_mm(dw1000_rng_twr_to_tof_ps(rng, rng->idx));
 #if MYNEWT_VAL(DW1000_BIAS_CORRECTION_ENABLED)
-    if (inst->config.bias_correction_enable){ 
-        float range = dw1000_rng_tof_to_meters(dw1000_rng_twr_to_tof(rng,rng->idx)); 
-        float bias = 2 * dw1000_rng_bias_correction(inst, 
-                    dw1000_rng_path_loss(
-                        MYNEWT_VAL(DW1000_DEVICE_TX_PWR),
-                        MYNEWT_VAL(DW1000_DEVICE_ANT_GAIN),
-                        MYNEWT_VAL(DW1000_DEVICE_FREQ),
-                        range)
-                    );
-        frame->spherical.range = range - bias;
-    }
-#else
-    frame->spherical.range = dw1000_rng_tof_to_meters(dw1000_rng_twr_to_tof(rng,rng->idx));
+    if (inst->config.bias_correction_enable)
+        range -= 2 * dw1000_rng_bias_mm(inst, dw1000_rng_rx_level(inst, range));
 #endif
+    frame->spherical.range = range * 1e-3f;
     frame->spherical_variance.range = MYNEWT_VAL(RANGE_VARIANCE);
     frame->spherical_variance.azimuth = -1;
     frame->spherical_variance.zenith = -1;
+    frame->filtered_range = 0;
+    frame->filtered_variance = -1;
     frame->utime = os_cputime_ticks_to_usecs(os_cputime_get32());
 
     return true;
@@ -280,8 +273,7 @@ rx_complete_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs)
 #endif
                 frame->code = DWT_DS_TWR_EXT_T1;
 
-                dw1000_write_tx(inst, frame->array, 0, sizeof(ieee_rng_response_frame_t));
-                dw1000_write_tx_fctrl(inst, sizeof(ieee_rng_response_frame_t), 0, true); 
+                dw1000_rng_write_tx(inst, frame, sizeof(ieee_rng_response_frame_t));
                 dw1000_set_wait4resp(inst, true);    
 
                 dw1000_set_delay_start(inst, response_tx_delay);   
@@ -342,8 +334,7 @@ rx_complete_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs)
                 if (cbs!=NULL && cbs->final_cb) 
                     cbs->final_cb(inst, cbs);
 
-                dw1000_write_tx(inst, frame->array, 0, sizeof(twr_frame_t));
-                dw1000_write_tx_fctrl(inst, sizeof(twr_frame_t), 0, true); 
+                dw1000_rng_write_tx(inst, frame, sizeof(twr_frame_t));
                 dw1000_set_wait4resp(inst, true);    
                 dw1000_set_delay_start(inst, response_tx_delay);   
 
@@ -389,8 +380,7 @@ rx_complete_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs)
                     cbs->final_cb(inst, cbs);    
               
                 // Transmit timestamp final report
-                dw1000_write_tx(inst, frame->array, 0, sizeof(twr_frame_t));
-                dw1000_write_tx_fctrl(inst, sizeof(twr_frame_t), 0, true); 
+                dw1000_rng_write_tx(inst, frame, sizeof(twr_frame_t));
                          
                 if (dw1000_start_tx(inst).start_tx_error){
                     os_sem_release(&rng->sem);  
@@ -69,6 +69,10 @@ STATS_SECT_START(twr_ds_nrng_stat_section)
     STATS_SECT_ENTRY(rx_timeout)
     STATS_SECT_ENTRY(rx_error)
     STATS_SECT_ENTRY(rx_unsolicited)
+#if MYNEWT_VAL(NRNG_TURNAROUND_BENCH)
+    STATS_SECT_ENTRY(turnaround)
+    STATS_SECT_ENTRY(turnaround_usec)
+#endif
 STATS_SECT_END
 
 STATS_NAME_START(twr_ds_nrng_stat_section)
@@ -76,6 +80,10 @@ STATS_NAME_START(twr_ds_nrng_stat_section)
     STATS_NAME(twr_ds_nrng_stat_section, rx_timeout)
     STATS_NAME(twr_ds_nrng_stat_section, rx_error)
     STATS_NAME(twr_ds_nrng_stat_section, rx_unsolicited)
+#if MYNEWT_VAL(NRNG_TURNAROUND_BENCH)
+    STATS_NAME(twr_ds_nrng_stat_section, turnaround)
+    STATS_NAME(twr_ds_nrng_stat_section, turnaround_usec)
+#endif
 STATS_NAME_END(twr_ds_nrng_stat_section)
 
 static STATS_SECT_DECL(twr_ds_nrng_stat_section) g_stat;
@@ -217,6 +225,9 @@ rx_error_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs){
 static bool 
 rx_complete_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs)
 {
+#if MYNEWT_VAL(NRNG_TURNAROUND_BENCH)
+    uint32_t t0 = os_cputime_get32();   // Responder processing time, entry to the response being scheduled
+#endif
     if(inst->fctrl != FCNTL_IEEE_N_RANGES_16){
         return false;
     }
@@ -238,7 +249,7 @@ rx_complete_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs)
                 nrng_frame_t * frame = nrng->frames[(++nrng->idx)%(nrng->nframes/FRAMES_PER_RANGE)][FIRST_FRAME_IDX];
                 uint16_t slot_id = inst->slot_id;
                 if (inst->frame_len >= sizeof(nrng_request_frame_t))
-                    dw1000_read_rx(inst, frame->array, 0, sizeof(nrng_request_frame_t));
+                    memcpy(frame->array, inst->rxbuf, sizeof(nrng_request_frame_t));
                 else
                     break;
                 if(!(slot_id >= frame->start_slot_id && slot_id <= frame->end_slot_id)){
@@ -248,7 +259,7 @@ rx_complete_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs)
                     break;
                 }
 
-                uint64_t request_timestamp = dw1000_read_rxtime(inst);
+                uint64_t request_timestamp = inst->rxtimestamp;
                 uint64_t response_tx_delay = request_timestamp + (((uint64_t)config->tx_holdoff_delay
                             + (uint64_t)((slot_id - frame->start_slot_id) * ((uint64_t)config->tx_guard_delay
                             + (dw1000_usecs_to_dwt_usecs(dw1000_phy_frame_duration(&inst->attrib, sizeof(nrng_response_frame_t)))))))<< 16);
@@ -265,7 +276,7 @@ rx_complete_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs)
 #if MYNEWT_VAL(WCS_ENABLED)
                 frame->carrier_integrator  = 0.0l;
 #else
-                frame->carrier_integrator  = -dw1000_read_carrier_integrator(inst);
+                frame->carrier_integrator  = -dw1000_nrng_carrier_integrator(inst);
 #endif
                 dw1000_write_tx(inst, frame->array, 0, sizeof(nrng_response_frame_t));
                 dw1000_write_tx_fctrl(inst, sizeof(nrng_response_frame_t), 0, true);
@@ -276,6 +287,10 @@ rx_complete_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs)
                                     
                 dw1000_set_rx_timeout(inst, timeout);
                 dw1000_set_delay_start(inst, response_tx_delay);
+#if MYNEWT_VAL(NRNG_TURNAROUND_BENCH)
+                STATS_INC(g_stat, turnaround);
+                STATS_INCN(g_stat, turnaround_usec, os_cputime_ticks_to_usecs(os_cputime_get32() - t0));
+#endif
                 if (dw1000_start_tx(inst).start_tx_error){
                     os_sem_release(&nrng->sem);
                     if (cbs!=NULL && cbs->start_tx_error_cb)
@@ -293,7 +308,7 @@ rx_complete_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs)
                 uint16_t idx = 0;
                 nrng_frame_t temp_frame;
                 if (inst->frame_len >= sizeof(nrng_response_frame_t))
-                    dw1000_read_rx(inst, temp_frame.array, 0, sizeof(nrng_response_frame_t));
+                    memcpy(temp_frame.array, inst->rxbuf, sizeof(nrng_response_frame_t));
                 else
                     break;
                 uint16_t node_slot_id = temp_frame.slot_id;
@@ -317,8 +332,8 @@ rx_complete_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs)
                 nrng_frame_t * next_frame = nrng->frames[idx][SECOND_FRAME_IDX];
                 memcpy(frame, &temp_frame, sizeof(nrng_response_frame_t));
 
-                frame->request_timestamp = next_frame->request_timestamp = dw1000_read_txtime_lo(inst);    // This corresponds to when the original request was actually sent
-                frame->response_timestamp = next_frame->response_timestamp = dw1000_read_rxtime_lo(inst);  // This corresponds to the response just received
+                frame->request_timestamp = next_frame->request_timestamp = (uint32_t)inst->txtimestamp;    // This corresponds to when the original request was actually sent
+                frame->response_timestamp = next_frame->response_timestamp = (uint32_t)inst->rxtimestamp;  // This corresponds to the response just received
 
                 uint8_t seq_num = frame->seq_num;
                 frame->dst_address = frame->src_address;
@@ -336,9 +351,9 @@ rx_complete_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs)
 #if MYNEWT_VAL(WCS_ENABLED)
                 frame->carrier_integrator  = 0.0l;
 #else
-                frame->carrier_integrator  = dw1000_read_carrier_integrator(inst);
+                frame->carrier_integrator  = dw1000_nrng_carrier_integrator(inst);
 #endif
-                uint64_t request_timestamp = dw1000_read_rxtime(inst);
+                uint64_t request_timestamp = inst->rxtimestamp;
                 uint64_t response_timestamp = (request_timestamp & 0xFFFFFFFE00UL) + inst->tx_antenna_delay;
                 frame->reception_timestamp = request_timestamp;
                 frame->transmission_timestamp = response_timestamp;
@@ -372,7 +387,7 @@ rx_complete_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs)
                 nrng_frame_t * frame = nrng->frames[(++nrng->idx)%(nrng->nframes/FRAMES_PER_RANGE)][SECOND_FRAME_IDX];
 
                 if (inst->frame_len >= sizeof(nrng_request_frame_t))
-                    dw1000_read_rx(inst,  frame->array, 0, sizeof(nrng_request_frame_t));
+                    memcpy(frame->array, inst->rxbuf, sizeof(nrng_request_frame_t));
                 else
                     break;
                 if(!(slot_id >= frame->start_slot_id && slot_id <= frame->end_slot_id)){
@@ -381,12 +396,12 @@ rx_complete_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs)
                     os_sem_release(&nrng->sem);
                     break;
                 }
-                uint64_t request_timestamp = dw1000_read_rxtime(inst);
+                uint64_t request_timestamp = inst->rxtimestamp;
                 uint64_t response_tx_delay = request_timestamp + (((uint64_t)config->tx_holdoff_delay
                             + (uint64_t)((slot_id - frame->start_slot_id) * ((uint64_t)config->tx_guard_delay 
                                     + dw1000_usecs_to_dwt_usecs(dw1000_phy_frame_duration(&inst->attrib, sizeof(nrng_final_frame_t))))))<< 16);
-                frame->request_timestamp = dw1000_read_txtime_lo(inst); // This corresponds to when the original request was actually sent
-                frame->response_timestamp = dw1000_read_rxtime_lo(inst);  // This corresponds to the response just received
+                frame->request_timestamp = (uint32_t)inst->txtimestamp; // This corresponds to when the original request was actually sent
+                frame->response_timestamp = (uint32_t)inst->rxtimestamp;  // This corresponds to the response just received
                 frame->dst_address = frame->src_address;
                 frame->src_address = inst->my_short_address;
                 frame->code = DWT_DS_TWR_NRNG_FINAL;
@@ -394,11 +409,15 @@ rx_complete_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs)
 #if MYNEWT_VAL(WCS_ENABLED)
                 frame->carrier_integrator  = 0.0l;
 #else
-                frame->carrier_integrator  = -dw1000_read_carrier_integrator(inst);
+                frame->carrier_integrator  = -dw1000_nrng_carrier_integrator(inst);
 #endif
                 dw1000_write_tx(inst, frame->array, 0, sizeof(nrng_final_frame_t));
                 dw1000_write_tx_fctrl(inst, sizeof(nrng_final_frame_t), 0, true);
                 dw1000_set_delay_start(inst, response_tx_delay);
+#if MYNEWT_VAL(NRNG_TURNAROUND_BENCH)
+                STATS_INC(g_stat, turnaround);
+                STATS_INCN(g_stat, turnaround_usec, os_cputime_ticks_to_usecs(os_cputime_get32() - t0));
+#endif
                 if (dw1000_start_tx(inst).start_tx_error){
                     if (cbs!=NULL && cbs->start_tx_error_cb)
                         cbs->start_tx_error_cb(inst, cbs);
@@ -425,7 +444,7 @@ rx_complete_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs)
                 uint16_t idx = 0;
                 nrng_frame_t temp;
                 if (inst->frame_len >= sizeof(nrng_final_frame_t))
-                    dw1000_read_rx(inst, (uint8_t *)&temp, 0, sizeof(nrng_final_frame_t));
+                    memcpy((uint8_t *)&temp, inst->rxbuf, sizeof(nrng_final_frame_t));
 
                 uint16_t node_slot_id = temp.slot_id;
                 uint16_t end_slot_id = temp.end_slot_id;
@@ -449,7 +468,7 @@ rx_complete_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs)
                 frame->response_timestamp = temp.response_timestamp;
                 frame->code = temp.code;
                 frame->dst_address = temp.src_address;
-                frame->transmission_timestamp = dw1000_read_txtime_lo(inst);
+                frame->transmission_timestamp = (uint32_t)inst->txtimestamp;
                 if(idx == nnodes -1)
                 {
                     STATS_INC(g_stat, complete);
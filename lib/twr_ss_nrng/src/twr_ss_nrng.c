@@ -224,26 +224,36 @@ rx_complete_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs)
             {
                 // This code executes on the device that is responding to a request
                 DIAGMSG("{\"utime\": %lu,\"msg\": \"DWT_SS_TWR_NRNG\"}\n",os_cputime_ticks_to_usecs(os_cputime_get32()));
-                if (inst->frame_len != sizeof(nrng_request_frame_t))
+                if (inst->frame_len < sizeof(nrng_request_frame_t))
                     break;
                     
                 nrng_request_frame_t * _frame = (nrng_request_frame_t * )inst->rxbuf;
                 
-#if MYNEWT_VAL(CELL_ENABLED)
-                if (_frame->ptype != PTYPE_CELL) 
-                    break;
-                if (_frame->cell_id != inst->cell_id)
-                    break; 
-                if (_frame->slot_mask & (1UL << inst->slot_id))
-                    slot_idx = calc_nslots(_frame->slot_mask, 1UL << inst->slot_id, SLOT_POSITION);
-                else
+                if (_frame->ptype == PTYPE_MAP){
+                    // Slot map following the request, see dw1000_nrng_request_map
+                    slot_idx = slot_map_position(inst->rxbuf + sizeof(nrng_request_frame_t),
+                                    inst->frame_len - sizeof(nrng_request_frame_t), inst->slot_id);
+                    if (slot_idx == 0)
+                        break;
+                }else if (inst->frame_len != sizeof(nrng_request_frame_t)){
                     break;
+                }else{
+#if MYNEWT_VAL(CELL_ENABLED)
+                    if (_frame->ptype != PTYPE_CELL) 
+                        break;
+                    if (_frame->cell_id != inst->cell_id)
+                        break; 
+                    if (_frame->slot_mask & (1UL << inst->slot_id))
+                        slot_idx = calc_nslots(_frame->slot_mask, 1UL << inst->slot_id, SLOT_POSITION);
+                    else
+                        break;
 #else
-                if (_frame->bitfield & (1UL << inst->slot_id))
-                    slot_idx = calc_nslots(_frame->bitfield, 1UL << inst->slot_id, SLOT_POSITION);
-                else
-                    break;
+                    if (_frame->bitfield & (1UL << inst->slot_id))
+                        slot_idx = calc_nslots(_frame->bitfield, 1UL << inst->slot_id, SLOT_POSITION);
+                    else
+                        break;
 #endif
+                }
                 nrng_final_frame_t * frame = (nrng_final_frame_t *) nrng->frames[(++nrng->idx)%(nrng->nframes/FRAMES_PER_RANGE)][FIRST_FRAME_IDX];
                 memset(frame->array, 0, sizeof(nrng_final_frame_t));
                 memcpy(frame->array, inst->rxbuf, sizeof(nrng_request_frame_t));
@@ -326,10 +336,10 @@ rx_complete_cb(dw1000_dev_instance_t * inst, dw1000_mac_interface_t * cbs)
                    response_timestamp = inst->rxtimestamp;
 
 #if MYNEWT_VAL(WCS_ENABLED)           
-                frame->request_timestamp = wcs_local_to_master(inst, dw1000_read_txtime(inst)) & 0xFFFFFFFFUL;
+                frame->request_timestamp = wcs_local_to_master(inst, inst->txtimestamp) & 0xFFFFFFFFUL;
                 frame->response_timestamp = wcs_local_to_master(inst, response_timestamp) & 0xFFFFFFFFUL;
 #else
-                frame->request_timestamp = dw1000_read_txtime_lo(inst) & 0xFFFFFFFFUL;
+                frame->request_timestamp = inst->txtimestamp & 0xFFFFFFFFUL;
                 frame->response_timestamp  = (uint32_t)(response_timestamp & 0xFFFFFFFFUL);
 #endif    
                 frame->dst_address = frame->src_address;
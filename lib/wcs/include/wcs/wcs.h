@@ -27,12 +27,36 @@
 #include <os/os.h>
 #include <dw1000/dw1000_dev.h>
 #include <ccp/ccp.h>
+#if MYNEWT_VAL(WCS_TIMESCALE)
 #include <timescale/timescale.h>        
+#endif
+#include <wcs/wcs_model.h>
+#include <wcs/wcs_est.h>
+#if MYNEWT_VAL(WCS_METRICS)
+#include <stats/stats.h>
+#include <wcs/wcs_metrics.h>
+#endif
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#if MYNEWT_VAL(WCS_METRICS)
+//! Sync quality gauges set on each CCP update, see wcs_metrics.h: jitter in ps, skew in ppb (int32), skew
+//! standard deviation and Allan deviation at tau = 1, 2, 4 and 8 CCP periods in parts per trillion
+STATS_SECT_START(wcs_stat_section)
+    STATS_SECT_ENTRY(updates)
+    STATS_SECT_ENTRY(gaps)
+    STATS_SECT_ENTRY(jitter_ps)
+    STATS_SECT_ENTRY(skew_ppb)
+    STATS_SECT_ENTRY(skew_sd_ppt)
+    STATS_SECT_ENTRY(adev1_ppt)
+    STATS_SECT_ENTRY(adev2_ppt)
+    STATS_SECT_ENTRY(adev4_ppt)
+    STATS_SECT_ENTRY(adev8_ppt)
+STATS_SECT_END
+#endif
+
 typedef struct _wcs_status_t{
     uint16_t selfmalloc:1;
     uint16_t initialized:1;
@@ -55,15 +79,26 @@ typedef struct _wcs_instance_t{
     uint64_t master_epoch;
     uint64_t local_epoch;
     double skew;
+    wcs_model_t model[2];           //!< Published clock models, see wcs_update_cb
+    volatile uint8_t model_idx;     //!< Index of the current model
     struct os_event postprocess_ev;
     struct _dw1000_ccp_instance_t * ccp;
+#if MYNEWT_VAL(WCS_TIMESCALE)
     struct _timescale_instance_t * timescale;
+#else
+    wcs_est_t est;                  //!< Fixed-point clock estimator
+#endif
+#if MYNEWT_VAL(WCS_METRICS)
+    STATS_SECT_DECL(wcs_stat_section) stat; //!< Stats instance
+    wcs_metrics_t metrics;          //!< Sync quality metrics
+#endif
 }wcs_instance_t; 
 
 wcs_instance_t * wcs_init(wcs_instance_t * inst, dw1000_ccp_instance_t * ccp);
 void wcs_free(wcs_instance_t * inst);
 void wcs_update_cb(struct os_event * ev);
 void wcs_set_postprocess(wcs_instance_t * inst, os_event_fn * postprocess);
+int wcs_cli_register(void);
 
 uint64_t wcs_read_systime(struct _dw1000_dev_instance_t * inst);
 uint32_t wcs_read_systime_lo(struct _dw1000_dev_instance_t * inst);
@@ -81,6 +116,8 @@ uint32_t wcs_read_txtime_lo_master(struct _dw1000_dev_instance_t * inst);
 double wcs_dtu_time_correction(struct _dw1000_dev_instance_t * inst);
 uint64_t wcs_dtu_time_adjust(struct _dw1000_dev_instance_t * inst, uint64_t dtu_time);
 uint64_t wcs_local_to_master(struct _dw1000_dev_instance_t * inst, uint64_t dtu_time);
+void wcs_local_to_master_n(struct _dw1000_dev_instance_t * inst, const uint64_t * dtu_time, uint64_t * master, uint16_t n);
+const wcs_model_t * wcs_model(struct _dw1000_dev_instance_t * inst);
 
 #ifdef __cplusplus
 }
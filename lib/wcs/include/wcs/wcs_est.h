@@ -0,0 +1,73 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file wcs_est.h
+ * @author paul kettle
+ * @date 2018
+ * @brief Fixed-point clock estimator
+ *
+ * @details Three-state filter of the local time of each master epoch, the local over master frequency offset and the
+ * rate of the offset, an alternative to the timescale EKF selected with WCS_TIMESCALE. The gains are those of a least
+ * squares quadratic fit over the epochs received so far, which is the recursive least squares solution, until the
+ * window is reached; from then on they stay at the g-h-k gains of a fit over the window. The published model is
+ * anchored on the filtered local time rather than the jittered epoch. An update costs a few 64-bit multiplies and
+ * three divides, with no floating point, and depends only on libc so it also builds on the host.
+ */
+
+#ifndef _WCS_EST_H_
+#define _WCS_EST_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <wcs/wcs_model.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WCS_EST_Q               16                      //!< Fraction bits of the local time state and residual
+#define WCS_EST_OFFSET_MAX      ((int64_t)5497558)      //!< Frequency offset of a valid estimate, 10 ppm in Q39
+#define WCS_EST_RESIDUAL_MAX    ((int64_t)1 << 36)      //!< Residual, 2^20 DTU in Q16, beyond which the filter restarts
+#define WCS_EST_RATE_T          36                      //!< Log2 of the time base of wcs_est_t.rate, DTU
+
+//! Fixed-point clock estimator
+typedef struct _wcs_est_t{
+    uint64_t local;         //!< Local time of the last master epoch, DTU Q16, modulo 2^56
+    uint64_t master;        //!< Last master epoch, DTU
+    int64_t offset;         //!< Local over master frequency ratio less one, Q39
+    int64_t rate;           //!< Offset change per 2^WCS_EST_RATE_T DTU of master time, Q(39 + WCS_EST_Q)
+    int64_t interval;       //!< Last master interval, DTU
+    int64_t residual;       //!< Last measured less predicted local time, DTU Q16
+    uint16_t n;             //!< Epochs in the fit, saturates at window
+    uint16_t window;        //!< Epochs in the fit at steady state
+}wcs_est_t;
+
+void wcs_est_init(wcs_est_t * est, uint16_t window);
+bool wcs_est_update(wcs_est_t * est, uint64_t master_epoch, uint64_t local_epoch);
+uint64_t wcs_est_local(const wcs_est_t * est);
+int32_t wcs_est_drift(const wcs_est_t * est);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _WCS_EST_H_ */
@@ -0,0 +1,86 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file wcs_metrics.h
+ * @author paul kettle
+ * @date 2018
+ * @brief Clock synchronization quality metrics
+ *
+ * @details Updated once per CCP frame from its epoch pair and the clock model in use when it arrived:
+ *  - residual, the error of the model converting the local epoch to master time, whose spread is the sync jitter;
+ *  - skew, the frequency offset of the model, whose spread is the skew stability;
+ *  - overlapping Allan deviation of the local clock against the master at tau = 1, 2, 4 ... 2^(WCS_METRICS_NTAU - 1)
+ *    CCP periods, from the second differences of the phase x(i + 2m) - 2x(i + m) + x(i).
+ * Each is an exponentially weighted mean, with weight 1/n until n reaches the window, so the memory is one
+ * accumulator per metric and per tau, plus the phase history of the longest tau shared by all. A frame arriving
+ * off the CCP period, after a missed frame or a new clock master, restarts the phase history.
+ */
+
+#ifndef _WCS_METRICS_H_
+#define _WCS_METRICS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <wcs/wcs_model.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WCS_METRICS_NTAU    4                               //!< Allan deviation taus
+#define WCS_METRICS_NX      ((2 << (WCS_METRICS_NTAU - 1)) + 1) //!< Phase history of the longest tau
+#define WCS_METRICS_DTU_PS  (1e12f / (499.2e6f * 128))       //!< DW1000 time unit, ps
+
+//! Exponentially weighted mean
+typedef struct _wcs_metrics_mean_t{
+    float mean;                 //!< Mean
+    float ms;                   //!< Mean square
+    uint32_t n;                 //!< Samples, saturates at the window
+}wcs_metrics_mean_t;
+
+//! Clock synchronization quality metrics
+typedef struct _wcs_metrics_t{
+    uint64_t master;                        //!< Last master epoch, DTU
+    uint64_t local;                         //!< Last local epoch, DTU
+    uint64_t interval;                      //!< CCP period, master DTU
+    int64_t x[WCS_METRICS_NX];              //!< Phase history, local less master time, DTU
+    uint16_t idx;                           //!< Latest phase in x
+    uint16_t nx;                            //!< Phases in x since the last restart
+    uint32_t window;                        //!< Samples in the exponentially weighted means
+    uint32_t updates;                       //!< Frames
+    uint32_t gaps;                          //!< Phase history restarts
+    wcs_metrics_mean_t residual;            //!< Model residual, DTU
+    wcs_metrics_mean_t skew;                //!< Model frequency offset, ppb
+    wcs_metrics_mean_t d2[WCS_METRICS_NTAU];//!< Phase second differences, DTU
+}wcs_metrics_t;
+
+void wcs_metrics_init(wcs_metrics_t * metrics, uint32_t window);
+void wcs_metrics_update(wcs_metrics_t * metrics, uint64_t master_epoch, uint64_t local_epoch, const wcs_model_t * model);
+float wcs_metrics_jitter(const wcs_metrics_t * metrics);
+float wcs_metrics_skew_sd(const wcs_metrics_t * metrics);
+float wcs_metrics_adev(const wcs_metrics_t * metrics, uint16_t j);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _WCS_METRICS_H_ */
@@ -0,0 +1,145 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file wcs_model.h
+ * @author paul kettle
+ * @date 2018
+ * @brief Fixed-point linear clock model
+ *
+ * @details The clock estimator, the timescale EKF or wcs_est.c, is evaluated once per CCP frame, in wcs_update_cb, and
+ * its result published as an epoch pair and the master over local frequency ratio less one in Q39. A local timestamp then maps to master time
+ * with one 64-bit multiply and shift:
+ *
+ *     master = master_epoch + delta + (delta * drift) >> 39,  delta = (local - local_epoch) mod 2^40
+ *
+ * The product fits 64-bit for any 40-bit delta while |drift| < 2^23, about 15 ppm, which covers the 10 ppm limit
+ * on a valid model. Rounding of the drift adds at most 2^-40 relative error, under 1 DTU across the full 40-bit range.
+ * The model, with the batch conversions in wcs_model.c, depends only on libc so it also builds on the host.
+ */
+
+#ifndef _WCS_MODEL_H_
+#define _WCS_MODEL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WCS_TIMESTAMP_MASK  0x0FFFFFFFFFFULL        //!< DW1000 system time, 40-bit
+#define WCS_DRIFT_Q         39                      //!< Fraction bits of wcs_model_t.drift
+#define WCS_DRIFT_MAX       ((int32_t)1 << 23)      //!< Drift bound keeping delta * drift within 64-bit
+
+//! Linear clock model
+typedef struct _wcs_model_t{
+    uint64_t master_epoch;      //!< Master time of the epoch, DTU
+    uint64_t local_epoch;       //!< Local time of the epoch, DTU
+    int32_t drift;              //!< Master over local frequency ratio less one, Q39
+    uint32_t correction;        //!< Local over master frequency ratio rounded to an integer, see wcs_dtu_time_correction
+    bool valid;                 //!< Conversions are identities, masked to 40-bit, when false
+}wcs_model_t;
+
+/**
+ * API to build the model from an epoch pair and the drift.
+ *
+ * @param model         Pointer to wcs_model_t.
+ * @param master_epoch  Master time of the epoch, DTU.
+ * @param local_epoch   Local time of the epoch, DTU.
+ * @param drift         Master over local frequency ratio less one, Q39.
+ * @param valid         Whether the drift comes from a converged estimate.
+ *
+ * @return true if the model is valid
+ */
+static inline bool
+wcs_model_set_drift(wcs_model_t * model, uint64_t master_epoch, uint64_t local_epoch, int32_t drift, bool valid){
+
+    model->master_epoch = master_epoch & WCS_TIMESTAMP_MASK;
+    model->local_epoch = local_epoch & WCS_TIMESTAMP_MASK;
+    model->valid = valid && drift < WCS_DRIFT_MAX && drift > -WCS_DRIFT_MAX;
+    model->drift = model->valid ? drift : 0;
+    model->correction = 1;      // The ratio rounds to 1 within the drift bound
+    return model->valid;
+}
+
+/**
+ * API to build the model from an epoch pair and the local over master frequency ratio.
+ *
+ * @param model         Pointer to wcs_model_t.
+ * @param master_epoch  Master time of the epoch, DTU.
+ * @param local_epoch   Local time of the epoch, DTU.
+ * @param ratio         Local over master frequency ratio.
+ * @param valid         Whether the ratio comes from a converged estimate.
+ *
+ * @return true if the model is valid
+ */
+static inline bool
+wcs_model_set(wcs_model_t * model, uint64_t master_epoch, uint64_t local_epoch, double ratio, bool valid){
+
+    double drift = (ratio > 0) ? ldexp(1.0 / ratio - 1.0, WCS_DRIFT_Q) : NAN;
+    if (!valid || !(fabs(drift) < WCS_DRIFT_MAX))
+        return wcs_model_set_drift(model, master_epoch, local_epoch, 0, false);
+    return wcs_model_set_drift(model, master_epoch, local_epoch, (int32_t) lround(drift), true);
+}
+
+/**
+ * API to convert a local timestamp to master time.
+ *
+ * @param model     Pointer to wcs_model_t.
+ * @param dtu_time  Local time, DTU.
+ *
+ * @return Master time, DTU, 40-bit
+ */
+static inline uint64_t
+wcs_model_local_to_master(const wcs_model_t * model, uint64_t dtu_time){
+
+    if (!model->valid)
+        return dtu_time & WCS_TIMESTAMP_MASK;
+
+    int64_t delta = (int64_t)((dtu_time - model->local_epoch) & WCS_TIMESTAMP_MASK);
+    int64_t offset = (delta * model->drift + ((int64_t)1 << (WCS_DRIFT_Q - 1))) >> WCS_DRIFT_Q;
+    return (model->master_epoch + (uint64_t)(delta + offset)) & WCS_TIMESTAMP_MASK;
+}
+
+/**
+ * API to scale a local time by the rounded frequency ratio, see wcs_dtu_time_adjust.
+ *
+ * @param model     Pointer to wcs_model_t.
+ * @param dtu_time  Local time, DTU.
+ *
+ * @return Adjusted time, DTU, 40-bit
+ */
+static inline uint64_t
+wcs_model_adjust(const wcs_model_t * model, uint64_t dtu_time){
+    if (model->valid)
+        dtu_time *= model->correction;
+    return dtu_time & WCS_TIMESTAMP_MASK;
+}
+
+void wcs_model_local_to_master_n(const wcs_model_t * model, const uint64_t * in, uint64_t * out, uint16_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _WCS_MODEL_H_ */
@@ -51,7 +51,12 @@
 #include <dw1000/dw1000_ftypes.h>
 #include <ccp/ccp.h>
 #include <wcs/wcs.h>
+#if MYNEWT_VAL(WCS_TIMESCALE)
 #include <timescale/timescale.h>
+#endif
+#if MYNEWT_VAL(TELEMETRY_ENABLED)
+#include <telemetry/telemetry.h>
+#endif
 
 //#define DIAGMSG(s,u) printf(s,u)
 #ifndef DIAGMSG
@@ -62,6 +67,70 @@
 
 static void wcs_postprocess(struct os_event * ev);
 
+#if MYNEWT_VAL(WCS_METRICS)
+STATS_NAME_START(wcs_stat_section)
+    STATS_NAME(wcs_stat_section, updates)
+    STATS_NAME(wcs_stat_section, gaps)
+    STATS_NAME(wcs_stat_section, jitter_ps)
+    STATS_NAME(wcs_stat_section, skew_ppb)
+    STATS_NAME(wcs_stat_section, skew_sd_ppt)
+    STATS_NAME(wcs_stat_section, adev1_ppt)
+    STATS_NAME(wcs_stat_section, adev2_ppt)
+    STATS_NAME(wcs_stat_section, adev4_ppt)
+    STATS_NAME(wcs_stat_section, adev8_ppt)
+STATS_NAME_END(wcs_stat_section)
+
+/**
+ * Help function to update the sync quality metrics with the latest epoch, against the model in use when it arrived,
+ * and set the stats gauges. Runs in the default eventq, off the MAC context.
+ *
+ * @param inst   Pointer to wcs_instance_t.
+ *
+ * @return void
+ */
+static void
+wcs_metrics_publish(wcs_instance_t * inst){
+    wcs_metrics_t * metrics = &inst->metrics;
+
+    wcs_metrics_update(metrics, inst->master_epoch, inst->local_epoch, &inst->model[inst->model_idx]);
+    STATS_SET(inst->stat, updates, metrics->updates);
+    STATS_SET(inst->stat, gaps, metrics->gaps);
+    STATS_SET(inst->stat, jitter_ps, (uint32_t)(wcs_metrics_jitter(metrics) * WCS_METRICS_DTU_PS));
+    STATS_SET(inst->stat, skew_ppb, (uint32_t)(int32_t)metrics->skew.mean);
+    STATS_SET(inst->stat, skew_sd_ppt, (uint32_t)(wcs_metrics_skew_sd(metrics) * 1e3f));
+    STATS_SET(inst->stat, adev1_ppt, (uint32_t)(wcs_metrics_adev(metrics, 0) * 1e12f));
+    STATS_SET(inst->stat, adev2_ppt, (uint32_t)(wcs_metrics_adev(metrics, 1) * 1e12f));
+    STATS_SET(inst->stat, adev4_ppt, (uint32_t)(wcs_metrics_adev(metrics, 2) * 1e12f));
+    STATS_SET(inst->stat, adev8_ppt, (uint32_t)(wcs_metrics_adev(metrics, 3) * 1e12f));
+}
+#endif
+
+/**
+ * Help function to publish the clock model of the latest estimate. The model is built in the spare buffer and swapped
+ * in with a single store, so conversions in the MAC context never see a partial update.
+ *
+ * @param inst   Pointer to wcs_instance_t.
+ *
+ * @return void
+ */
+static void
+wcs_publish(wcs_instance_t * inst){
+    uint8_t idx = inst->model_idx ^ 1;
+#if MYNEWT_VAL(WCS_TIMESCALE)
+    timescale_states_t * states = (timescale_states_t *) (inst->timescale->eke->x); 
+    wcs_model_set(&inst->model[idx], inst->master_epoch, (uint64_t)llround(states->time) & WCS_TIMESTAMP_MASK,
+        states->skew * (1e-6l/((uint64_t)1UL << 16)), inst->status.valid);
+#else
+    wcs_model_set_drift(&inst->model[idx], inst->est.master, wcs_est_local(&inst->est), wcs_est_drift(&inst->est),
+        inst->status.valid);
+#endif
+
+    os_sr_t sr;
+    OS_ENTER_CRITICAL(sr);
+    inst->model_idx = idx;
+    OS_EXIT_CRITICAL(sr);
+}
+
 /*! 
  * @fn wcs_init(wcs_instance_t * inst,  dw1000_ccp_instance_t * ccp)
  *
@@ -87,19 +156,54 @@ wcs_init(wcs_instance_t * inst, dw1000_ccp_instance_t * ccp){
         inst->status.selfmalloc = 1;
     }
     inst->ccp = ccp;    
+#if MYNEWT_VAL(WCS_TIMESCALE)
     double x0[TIMESCALE_N] = {0};
     double q[] = {MYNEWT_VAL(TIMESCALE_QVAR) * 1.0, MYNEWT_VAL(TIMESCALE_QVAR) * 0.1, MYNEWT_VAL(TIMESCALE_QVAR) * 0.01};
     double T = 1e-6l * MYNEWT_VAL(CCP_PERIOD);  // peroid in sec
 
     inst->timescale = timescale_init(NULL, x0, q, T); 
     inst->timescale->status.initialized = 0; //Ignore X0 values, until we get first event
+#else
+    wcs_est_init(&inst->est, MYNEWT_VAL(WCS_EST_WINDOW));
+#endif
     inst->status.initialized = 0;
+    wcs_model_set(&inst->model[0], 0, 0, 1.0, false);
+    inst->model_idx = 0;
+
+#if MYNEWT_VAL(WCS_METRICS)
+    wcs_metrics_init(&inst->metrics, MYNEWT_VAL(WCS_METRICS_WINDOW));
+    int rc = stats_init(
+        STATS_HDR(inst->stat),
+        STATS_SIZE_INIT_PARMS(inst->stat, STATS_SIZE_32),
+        STATS_NAME_INIT_PARMS(wcs_stat_section));
+    assert(rc == 0);
+#if  MYNEWT_VAL(DW1000_DEVICE_0) && !MYNEWT_VAL(DW1000_DEVICE_1)
+    rc = stats_register("wcs", STATS_HDR(inst->stat));
+#elif  MYNEWT_VAL(DW1000_DEVICE_0) && MYNEWT_VAL(DW1000_DEVICE_1)
+    if (ccp->parent->idx == 0)
+        rc |= stats_register("wcs0", STATS_HDR(inst->stat));
+    else
+        rc |= stats_register("wcs1", STATS_HDR(inst->stat));
+#endif
+    assert(rc == 0);
+#endif
 
     wcs_set_postprocess(inst, &wcs_postprocess);      // Using default process
     
     return inst;
 }
 
+/**
+ * Package init, registers the wcs shell command.
+ *
+ * @return void
+ */
+void
+wcs_pkg_init(void){
+    int rc = wcs_cli_register();
+    assert(rc == 0);
+}
+
 /*! 
  * @fn wcs_free(wcs_instance_t * inst)
  *
@@ -115,7 +219,9 @@ wcs_init(wcs_instance_t * inst, dw1000_ccp_instance_t * ccp){
 void 
 wcs_free(wcs_instance_t * inst){
     assert(inst);  
+#if MYNEWT_VAL(WCS_TIMESCALE)
     timescale_free(inst->timescale);
+#endif
     if (inst->status.selfmalloc)
         free(inst);
     else
@@ -144,18 +250,23 @@ void wcs_update_cb(struct os_event * ev){
 
     DIAGMSG("{\"utime\": %lu,\"msg\": \"wcs_update_cb\"}\n",os_cputime_ticks_to_usecs(os_cputime_get32()));
 
-    if(ccp->status.valid){ 
+    // An elected backup keeps the model of the lost master frozen, its own frames carry no skew to track
+    if(ccp->status.valid && !ccp->status.elected){ 
         ccp_frame_t * previous_frame = ccp->frames[(uint16_t)(ccp->idx-1)%ccp->nframes]; 
         ccp_frame_t * frame = ccp->frames[(ccp->idx)%ccp->nframes]; 
         inst->nT = (int16_t)frame->seq_num - (int16_t)previous_frame->seq_num;
         inst->nT = (inst->nT < 0)?0x100+inst->nT:inst->nT;
        
+        inst->master_epoch = ccp->epoch_master; //->transmission_timestamp;
+        inst->local_epoch = ccp->epoch;//frame->reception_timestamp;
+#if MYNEWT_VAL(WCS_METRICS)
+        wcs_metrics_publish(inst);
+#endif
+
+#if MYNEWT_VAL(WCS_TIMESCALE)
         timescale_instance_t * timescale = inst->timescale; 
         timescale_states_t * states = (timescale_states_t *) (inst->timescale->eke->x); 
 
-        inst->master_epoch = ccp->epoch_master; //->transmission_timestamp;
-        inst->local_epoch = ccp->epoch;//frame->reception_timestamp;
-        
         if (inst->status.initialized == 0 ){
             double skew = (double ) dw1000_calc_clock_offset_ratio(ccp->parent, frame->carrier_integrator);
             states->time = (double)inst->local_epoch;
@@ -185,6 +296,12 @@ void wcs_update_cb(struct os_event * ev){
         else {
             inst->skew = 0.0l;
         }
+#else
+        inst->status.initialized = 1;
+        inst->status.valid = wcs_est_update(&inst->est, inst->master_epoch, inst->local_epoch);
+        inst->skew = inst->status.valid ? -ldexp((double)inst->est.offset, -WCS_DRIFT_Q) : 0.0l;
+#endif
+        wcs_publish(inst);
 
     if(inst->config.postprocess == true)
         os_eventq_put(os_eventq_dflt_get(), &inst->postprocess_ev);
@@ -216,6 +333,19 @@ wcs_postprocess(struct os_event * ev){
     ccp_frame_t * frame = ccp->frames[(ccp->idx)%ccp->nframes]; 
 //    wcs_instance_t * wcs = ccp->wcs;
 //    timescale_states_t * states = (timescale_states_t *) (wcs->timescale->eke->x); 
+#if MYNEWT_VAL(TELEMETRY_ENABLED)
+    telemetry_wcs_t record = {
+        .utime = os_cputime_ticks_to_usecs(os_cputime_get32()),
+        .master_epoch = inst->master_epoch,
+        .local_epoch = inst->local_epoch,
+        .correction = wcs_local_to_master(ccp->parent,  inst->local_epoch + frame->transmission_interval) - inst->master_epoch - frame->transmission_interval,
+        .skew = inst->skew,
+        .nT = inst->nT,
+        .seq_num = frame->seq_num,
+        .previous_seq_num = previous_frame->seq_num
+    };
+    telemetry_write(TELEMETRY_WCS, &record, sizeof(record));
+#else
     printf("{\"utime\": %lu,\"wcs\": [%llu,%llu,%llu],\"skew\": %llu,\"nT\": [%d,%d,%d]}\n", 
         os_cputime_ticks_to_usecs(os_cputime_get32()),
         (uint64_t) inst->master_epoch,
@@ -227,6 +357,7 @@ wcs_postprocess(struct os_event * ev){
         previous_frame->seq_num
     );
 #endif
+#endif
 }
 
 /*! 
@@ -247,6 +378,19 @@ wcs_set_postprocess(wcs_instance_t * inst, os_event_fn * postprocess){
     inst->config.postprocess = true;
 }
 
+/**
+ * API to get the current clock model, see wcs_model.h. The model stays usable until the next CCP update.
+ *
+ * @param inst  Pointer to _dw1000_dev_instance_t.
+ *
+ * @return Pointer to wcs_model_t
+ */
+inline const wcs_model_t * wcs_model(struct _dw1000_dev_instance_t * inst){
+    wcs_instance_t * wcs = inst->ccp->wcs;
+    assert(wcs);
+    return &wcs->model[wcs->model_idx];
+}
+
 /**
  * API to compensate for local frequency to reference frequency clock skew
  *
@@ -257,26 +401,11 @@ wcs_set_postprocess(wcs_instance_t * inst, os_event_fn * postprocess){
  * 
  */
 inline uint64_t wcs_dtu_time_adjust(struct _dw1000_dev_instance_t * inst, uint64_t dtu_time){
-    wcs_instance_t * wcs = inst->ccp->wcs;
-    assert(wcs);
-    
-    if (wcs->status.valid)
-       dtu_time = (uint64_t) roundl(dtu_time * wcs_dtu_time_correction(inst));
-
-    return dtu_time & 0x00FFFFFFFFFFUL;
+    return wcs_model_adjust(wcs_model(inst), dtu_time);
 }
 
 inline double wcs_dtu_time_correction(struct _dw1000_dev_instance_t * inst){
-    wcs_instance_t * wcs = inst->ccp->wcs;
-    assert(wcs);
-    
-    timescale_states_t * states = (timescale_states_t *) (wcs->timescale->eke->x); 
-
-    double correction = 1.0l;
-    if (wcs->status.valid)
-       correction = (double) roundl(states->skew * (1e-6l/(1UL << 16)));
-
-    return correction;
+    return (double) wcs_model(inst)->correction;
 }
 
 
@@ -290,15 +419,23 @@ inline double wcs_dtu_time_correction(struct _dw1000_dev_instance_t * inst){
  */
 
 inline uint64_t wcs_local_to_master(struct _dw1000_dev_instance_t * inst, uint64_t dtu_time){
-    wcs_instance_t * wcs = inst->ccp->wcs;
-    assert(wcs);
-    timescale_states_t * states = (timescale_states_t *) (wcs->timescale->eke->x); 
-    uint64_t delta = (dtu_time - wcs->local_epoch) & 0x0FFFFFFFFFFUL;
-
-    if (wcs->status.valid)
-        dtu_time = wcs->master_epoch + (uint64_t) round(delta / (states->skew * (1e-6l/(1UL << 16))));    
+    return wcs_model_local_to_master(wcs_model(inst), dtu_time);
+}
 
-    return dtu_time & 0x0FFFFFFFFFFUL;
+/**
+ * API to convert an array of local timestamps to master time. All timestamps are converted with the same model even
+ * if a CCP update lands during the call.
+ *
+ * @param inst      Pointer to _dw1000_dev_instance_t.
+ * @param dtu_time  Local times, DTU.
+ * @param master    Master times, DTU, 40-bit; may be the same array as dtu_time.
+ * @param n         Number of timestamps.
+ *
+ * @return void
+ */
+void wcs_local_to_master_n(struct _dw1000_dev_instance_t * inst, const uint64_t * dtu_time, uint64_t * master, uint16_t n){
+    wcs_model_t model = *wcs_model(inst);
+    wcs_model_local_to_master_n(&model, dtu_time, master, n);
 }
 
 
@@ -0,0 +1,115 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file wcs_cli.c
+ * @author paul kettle
+ * @date 2018
+ * @brief Wireless clock synchronization shell command
+ *
+ * @details Prints the sync quality metrics as a JSON line, in the units of the wcs stats: jitter in ps, skew mean in
+ * ppb and standard deviation in ppt, CCP period tau0 in usec and the Allan deviation at tau0, 2 tau0, 4 tau0 ... in ppt.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <os/os.h>
+#include <dw1000/dw1000_hal.h>
+#include <dw1000/dw1000_dev.h>
+#include <ccp/ccp.h>
+#include <wcs/wcs.h>
+
+#if MYNEWT_VAL(WCS_METRICS) && MYNEWT_VAL(WCS_METRICS_CLI)
+
+#include <shell/shell.h>
+#include <console/console.h>
+
+static int wcs_cli_cmd(int argc, char **argv);
+
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+const struct shell_param cmd_wcs_param[] = {
+    {"metrics", "[instance] print sync quality metrics"},
+    {"clear", "[instance] restart sync quality metrics"},
+    {NULL,NULL},
+};
+
+const struct shell_cmd_help cmd_wcs_help = {
+	"wcs", "clock synchronization quality", cmd_wcs_param
+};
+#endif
+
+static struct shell_cmd shell_wcs_cmd = {
+    .sc_cmd = "wcs",
+    .sc_cmd_func = wcs_cli_cmd,
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+    &cmd_wcs_help
+#endif
+};
+
+static void
+wcs_cli_metrics(wcs_instance_t * wcs){
+    wcs_metrics_t metrics = wcs->metrics;
+
+    console_printf("{\"utime\":%lu,\"valid\":%d,\"updates\":%lu,\"gaps\":%lu,\"jitter\":%lu,\"skew\":[%ld,%lu],"
+        "\"tau0\":%lu,\"adev\":[",
+        os_cputime_ticks_to_usecs(os_cputime_get32()), wcs->status.valid, metrics.updates, metrics.gaps,
+        (uint32_t)(wcs_metrics_jitter(&metrics) * WCS_METRICS_DTU_PS), (int32_t)metrics.skew.mean,
+        (uint32_t)(wcs_metrics_skew_sd(&metrics) * 1e3f), (uint32_t)(metrics.interval >> 16));
+    for (uint16_t j = 0; j < WCS_METRICS_NTAU; j++)
+        console_printf("%s%lu", j ? "," : "", (uint32_t)(wcs_metrics_adev(&metrics, j) * 1e12f));
+    console_printf("]}\n");
+}
+
+static int
+wcs_cli_cmd(int argc, char **argv)
+{
+    if (argc < 2) {
+        console_printf("Too few args\n");
+        return 0;
+    }
+    dw1000_dev_instance_t * inst = hal_dw1000_inst((argc < 3) ? 0 : strtol(argv[2], NULL, 0));
+    if (inst->ccp == NULL || inst->ccp->wcs == NULL) {
+        console_printf("No wcs instance\n");
+        return 0;
+    }
+
+    if (!strcmp(argv[1], "metrics")) {
+        wcs_cli_metrics(inst->ccp->wcs);
+    } else if (!strcmp(argv[1], "clear")) {
+        wcs_metrics_init(&inst->ccp->wcs->metrics, MYNEWT_VAL(WCS_METRICS_WINDOW));
+    } else {
+        console_printf("Unknown cmd\n");
+    }
+    return 0;
+}
+
+#endif
+
+int
+wcs_cli_register(void)
+{
+#if MYNEWT_VAL(WCS_METRICS) && MYNEWT_VAL(WCS_METRICS_CLI)
+    return shell_cmd_register(&shell_wcs_cmd);
+#else
+    return 0;
+#endif
+}
@@ -0,0 +1,182 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file wcs_est.c
+ * @author paul kettle
+ * @date 2018
+ * @brief Fixed-point clock estimator
+ *
+ * @details A growing-memory g-h-k filter, the recursive form of a quadratic fit, tracks the local time, the frequency
+ * offset and its rate so that a warming crystal does not lag behind the fit. With n epochs in the fit the gains
+ * are g = 3(3n^2 - 3n + 2)/d, h = 18(2n - 1)/d and 2k = 60/d, d = n(n + 1)(n + 2); the second epoch is the
+ * two-point estimate and the third, g = 2k = 1, h = 3/2, the parabola through three. The local time state is kept
+ * modulo 2^56 in Q16 so that it wraps with the 40-bit counter.
+ */
+
+#include <wcs/wcs_est.h>
+
+#define WCS_EST_MASK ((1ULL << (40 + WCS_EST_Q)) - 1)
+#define WCS_EST_OFFSET_LIMIT ((int64_t)WCS_DRIFT_MAX << 2)     //!< Offset step, 61 ppm, beyond which the filter restarts
+#define WCS_EST_RATE_LIMIT (WCS_EST_OFFSET_LIMIT << WCS_EST_Q)  //!< Rate bound keeping interval * rate within 64-bit
+
+static inline int64_t
+sext(uint64_t x){
+    return (int64_t)(x << (64 - 40 - WCS_EST_Q)) >> (64 - 40 - WCS_EST_Q);
+}
+
+/* Offset change over the interval at the rate, Q39, split so the products stay within 64-bit */
+static inline int64_t
+rate_step(int64_t rate, int64_t interval){
+    return (((interval >> 20) * rate) >> (WCS_EST_RATE_T + WCS_EST_Q - 20))
+            + (((interval & 0xfffff) * rate) >> (WCS_EST_RATE_T + WCS_EST_Q));
+}
+
+/**
+ * API to reset the estimator.
+ *
+ * @param est     Pointer to wcs_est_t.
+ * @param window  Epochs in the fit at steady state, at least 3.
+ *
+ * @return void
+ */
+void
+wcs_est_init(wcs_est_t * est, uint16_t window){
+    est->local = 0;
+    est->master = 0;
+    est->offset = 0;
+    est->rate = 0;
+    est->interval = 0;
+    est->residual = 0;
+    est->n = 0;
+    est->window = (window < 3) ? 3 : window;
+}
+
+/**
+ * API to update the estimate with the epoch pair of a CCP frame. The filter restarts from this epoch when the
+ * residual exceeds WCS_EST_RESIDUAL_MAX or implies an offset beyond any crystal, as when the clock master restarts.
+ *
+ * @param est           Pointer to wcs_est_t.
+ * @param master_epoch  Master time of the frame, DTU.
+ * @param local_epoch   Local time of the frame, DTU.
+ *
+ * @return true if the estimate is valid
+ */
+bool
+wcs_est_update(wcs_est_t * est, uint64_t master_epoch, uint64_t local_epoch){
+
+    master_epoch &= WCS_TIMESTAMP_MASK;
+    uint64_t measured = (local_epoch << WCS_EST_Q) & WCS_EST_MASK;
+    int64_t interval = (int64_t)((master_epoch - est->master) & WCS_TIMESTAMP_MASK);
+
+    if (est->n == 0){
+        est->local = measured;
+        est->master = master_epoch;
+        est->offset = 0;
+        est->rate = 0;
+        est->interval = 0;
+        est->residual = 0;
+        est->n = 1;
+        return false;
+    }
+    if (interval < ((int64_t)1 << 16))
+        return false;   // Repeated epoch
+
+    // Predicted local time, interval * (1 + mean offset over the interval) split so the products stay within 64-bit
+    int64_t change = rate_step(est->rate, interval);
+    int64_t mean = est->offset + change / 2;
+    int64_t step = (interval << WCS_EST_Q)
+            + (((interval >> 16) * mean) >> (WCS_DRIFT_Q - WCS_EST_Q - 16))
+            + (((interval & 0xffff) * mean) >> (WCS_DRIFT_Q - WCS_EST_Q));
+    uint64_t predicted = (est->local + (uint64_t)step) & WCS_EST_MASK;
+    int64_t residual = sext(measured - predicted);
+
+    int64_t correction;
+    if (est->n == 1)
+        correction = residual * ((int64_t)1 << (WCS_DRIFT_Q - WCS_EST_Q - 16)) / (interval >> 16);
+    else if (residual < WCS_EST_RESIDUAL_MAX && residual > -WCS_EST_RESIDUAL_MAX)
+        correction = residual * ((int64_t)1 << (WCS_DRIFT_Q - WCS_EST_Q)) / interval;
+    else
+        correction = WCS_EST_OFFSET_LIMIT;
+    if (correction >= WCS_EST_OFFSET_LIMIT || correction <= -WCS_EST_OFFSET_LIMIT){
+        est->n = 0;
+        return wcs_est_update(est, master_epoch, local_epoch);
+    }
+
+    if (est->n < est->window)
+        est->n++;
+    if (est->n == 2){
+        // Two-point estimate
+        est->local = measured;
+        est->offset += correction;
+    }else{
+        int64_t d = (int64_t)est->n * (est->n + 1) * (est->n + 2);
+        int64_t g = ((int64_t)(3 * (3 * est->n * est->n - 3 * est->n + 2)) << 16) / d;
+        int64_t h = ((int64_t)(18 * (2 * est->n - 1)) << 16) / d;
+        int64_t k2 = ((int64_t)60 << 16) / d;
+        // Rate correction, correction / interval per 2^WCS_EST_RATE_T DTU in Q(39 + WCS_EST_Q)
+        int64_t accel = correction * ((int64_t)1 << (WCS_EST_RATE_T + WCS_EST_Q - 16)) / (interval >> 16);
+        est->local = (predicted + (uint64_t)((residual * g) >> 16)) & WCS_EST_MASK;
+        est->offset += change + ((correction * h) >> 16);
+        est->rate += (accel >> 16) * k2;
+        if (est->rate > WCS_EST_RATE_LIMIT)
+            est->rate = WCS_EST_RATE_LIMIT;
+        else if (est->rate < -WCS_EST_RATE_LIMIT)
+            est->rate = -WCS_EST_RATE_LIMIT;
+    }
+    est->master = master_epoch;
+    est->interval = interval;
+    est->residual = residual;
+
+    return est->n > 2 && est->offset < WCS_EST_OFFSET_MAX && est->offset > -WCS_EST_OFFSET_MAX;
+}
+
+/**
+ * API to get the filtered local time of the last master epoch, the anchor of the published model.
+ *
+ * @param est  Pointer to wcs_est_t.
+ *
+ * @return Local time, DTU, rounded
+ */
+uint64_t
+wcs_est_local(const wcs_est_t * est){
+    return ((est->local + ((uint64_t)1 << (WCS_EST_Q - 1))) >> WCS_EST_Q) & WCS_TIMESTAMP_MASK;
+}
+
+/**
+ * API to get the drift of wcs_model_t from the estimate, master over local frequency ratio less one. The offset is
+ * taken half an interval ahead, its mean until the next epoch if the interval repeats.
+ *
+ * @param est  Pointer to wcs_est_t.
+ *
+ * @return Drift, Q39, saturated at +-WCS_DRIFT_MAX
+ */
+int32_t
+wcs_est_drift(const wcs_est_t * est){
+
+    int64_t offset = est->offset + rate_step(est->rate, est->interval) / 2;
+    if (offset >= WCS_DRIFT_MAX)
+        return -WCS_DRIFT_MAX;
+    if (offset <= -WCS_DRIFT_MAX)
+        return WCS_DRIFT_MAX;
+    // 1/(1 + y) - 1 = -y + y^2 - ..., the cubic term is below 2^-39 for |y| < 2^-16
+    return (int32_t)(-offset + ((offset * offset + ((int64_t)1 << (WCS_DRIFT_Q - 1))) >> WCS_DRIFT_Q));
+}
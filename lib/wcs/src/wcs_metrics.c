@@ -0,0 +1,164 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file wcs_metrics.c
+ * @author paul kettle
+ * @date 2018
+ * @brief Clock synchronization quality metrics
+ *
+ * @details The overlapping Allan variance at tau = m tau0 is the mean of the squared phase second differences over
+ * 2 tau^2, so the Allan deviation is sqrt(ms / 2) / (m tau0). The phase is accumulated from the 40-bit epoch
+ * deltas and kept in 64-bit, so it does not wrap with the counter.
+ */
+
+#include <string.h>
+#include <math.h>
+#include <wcs/wcs_metrics.h>
+
+static inline int64_t
+sext(uint64_t x){
+    return (int64_t)(x << (64 - 40)) >> (64 - 40);
+}
+
+static void
+mean_update(wcs_metrics_mean_t * m, float x, uint32_t window){
+    if (m->n < window)
+        m->n++;
+    float w = 1.0f / m->n;
+    m->mean += w * (x - m->mean);
+    m->ms += w * (x * x - m->ms);
+}
+
+/**
+ * API to reset the metrics.
+ *
+ * @param metrics  Pointer to wcs_metrics_t.
+ * @param window   Samples in the exponentially weighted means at steady state.
+ *
+ * @return void
+ */
+void
+wcs_metrics_init(wcs_metrics_t * metrics, uint32_t window){
+    memset(metrics, 0, sizeof(wcs_metrics_t));
+    metrics->window = (window < 1) ? 1 : window;
+}
+
+/**
+ * API to update the metrics with the epoch pair of a CCP frame. Call before the model is updated with the same frame,
+ * so the residual measures the model in use when it arrived.
+ *
+ * @param metrics       Pointer to wcs_metrics_t.
+ * @param master_epoch  Master time of the frame, DTU.
+ * @param local_epoch   Local time of the frame, DTU.
+ * @param model         Clock model in use when the frame arrived.
+ *
+ * @return void
+ */
+void
+wcs_metrics_update(wcs_metrics_t * metrics, uint64_t master_epoch, uint64_t local_epoch, const wcs_model_t * model){
+
+    master_epoch &= WCS_TIMESTAMP_MASK;
+    local_epoch &= WCS_TIMESTAMP_MASK;
+    uint64_t interval = (master_epoch - metrics->master) & WCS_TIMESTAMP_MASK;
+    uint64_t local_interval = (local_epoch - metrics->local) & WCS_TIMESTAMP_MASK;
+    metrics->master = master_epoch;
+    metrics->local = local_epoch;
+
+    if (metrics->updates++ == 0){
+        metrics->nx = 1;
+        return;
+    }
+    if (metrics->interval == 0)
+        metrics->interval = interval;
+
+    bool gap = interval > metrics->interval + (metrics->interval >> 1) || interval < (metrics->interval >> 1);
+    int64_t phase = metrics->x[metrics->idx] + (int64_t)local_interval - (int64_t)interval;
+    if (gap){
+        metrics->gaps++;
+        metrics->nx = 0;
+    }
+    metrics->idx = (metrics->idx + 1) % WCS_METRICS_NX;
+    metrics->x[metrics->idx] = phase;
+    if (metrics->nx < WCS_METRICS_NX)
+        metrics->nx++;
+
+    for (uint16_t j = 0; j < WCS_METRICS_NTAU; j++){
+        uint16_t m = 1 << j;
+        if (metrics->nx < 2 * m + 1)
+            break;
+        int64_t x1 = metrics->x[(metrics->idx + WCS_METRICS_NX - m) % WCS_METRICS_NX];
+        int64_t x0 = metrics->x[(metrics->idx + WCS_METRICS_NX - 2 * m) % WCS_METRICS_NX];
+        mean_update(&metrics->d2[j], (float)(phase - 2 * x1 + x0), metrics->window);
+    }
+
+    // A gap may be a new clock master, whose timebase the model does not convert to
+    if (!gap && model->valid){
+        int64_t residual = sext(wcs_model_local_to_master(model, local_epoch) - master_epoch);
+        mean_update(&metrics->residual, (float)residual, metrics->window);
+        mean_update(&metrics->skew, (float)ldexp(-(double)model->drift, -WCS_DRIFT_Q) * 1e9f, metrics->window);
+    }
+}
+
+static float
+sd(const wcs_metrics_mean_t * m){
+    float var = m->ms - m->mean * m->mean;
+    return (var > 0) ? sqrtf(var) : 0;
+}
+
+/**
+ * API to get the sync jitter, the standard deviation of the model residual.
+ *
+ * @param metrics  Pointer to wcs_metrics_t.
+ *
+ * @return Jitter, DTU
+ */
+float
+wcs_metrics_jitter(const wcs_metrics_t * metrics){
+    return sd(&metrics->residual);
+}
+
+/**
+ * API to get the skew stability, the standard deviation of the model frequency offset.
+ *
+ * @param metrics  Pointer to wcs_metrics_t.
+ *
+ * @return Skew standard deviation, ppb
+ */
+float
+wcs_metrics_skew_sd(const wcs_metrics_t * metrics){
+    return sd(&metrics->skew);
+}
+
+/**
+ * API to get the overlapping Allan deviation at tau = 2^j CCP periods.
+ *
+ * @param metrics  Pointer to wcs_metrics_t.
+ * @param j        Tau index, below WCS_METRICS_NTAU.
+ *
+ * @return Allan deviation, 0 before the first sample at this tau
+ */
+float
+wcs_metrics_adev(const wcs_metrics_t * metrics, uint16_t j){
+    if (j >= WCS_METRICS_NTAU || metrics->d2[j].n == 0 || metrics->interval == 0)
+        return 0;
+    return sqrtf(metrics->d2[j].ms / 2) / ((float)(1 << j) * (float)metrics->interval);
+}
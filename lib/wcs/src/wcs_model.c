@@ -0,0 +1,63 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file wcs_model.c
+ * @author paul kettle
+ * @date 2018
+ * @brief Fixed-point linear clock model, batch conversions
+ *
+ * @details The loops carry no branches or calls so the compiler can vectorize them where the target has 64-bit lanes.
+ */
+
+#include <wcs/wcs_model.h>
+
+/**
+ * API to convert an array of local timestamps to master time with one model. Each timestamp is converted as by
+ * wcs_model_local_to_master, wraparound of the 40-bit counter included.
+ *
+ * @param model  Pointer to wcs_model_t.
+ * @param in     Local times, DTU.
+ * @param out    Master times, DTU, 40-bit; may be the same array as in.
+ * @param n      Number of timestamps.
+ *
+ * @return void
+ */
+void
+wcs_model_local_to_master_n(const wcs_model_t * model, const uint64_t * in, uint64_t * out, uint16_t n){
+
+    if (!model->valid){
+        for (uint16_t i = 0; i < n; i++)
+            out[i] = in[i] & WCS_TIMESTAMP_MASK;
+        return;
+    }
+
+    const uint64_t master_epoch = model->master_epoch;
+    const uint64_t local_epoch = model->local_epoch;
+    const int64_t drift = model->drift;
+    const int64_t half = (int64_t)1 << (WCS_DRIFT_Q - 1);
+
+    for (uint16_t i = 0; i < n; i++){
+        int64_t delta = (int64_t)((in[i] - local_epoch) & WCS_TIMESTAMP_MASK);
+        int64_t offset = (delta * drift + half) >> WCS_DRIFT_Q;
+        out[i] = (master_epoch + (uint64_t)(delta + offset)) & WCS_TIMESTAMP_MASK;
+    }
+}
@@ -0,0 +1,51 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "wcs_test.h"
+
+#define WCS_BATCH_N 257
+
+/* The batch conversion matches the scalar one element for element, across the wrap of the counter and in place */
+TEST_CASE(wcs_batch_test)
+{
+    static uint64_t in[WCS_BATCH_N], out[WCS_BATCH_N];
+    wcs_model_t model;
+
+    for (uint16_t i = 0; i < WCS_BATCH_N; i++)
+        in[i] = (WCS_TIMESTAMP_MASK - 128 * 6400000ULL) + i * 6400000ULL;    // Wraps half way through
+
+    for (int16_t ppm = -10; ppm <= 10; ppm += 5){
+        wcs_model_set(&model, 0xABCDEF0123ULL, in[3], 1.0 + ppm * 1e-6, true);
+        wcs_model_local_to_master_n(&model, in, out, WCS_BATCH_N);
+        for (uint16_t i = 0; i < WCS_BATCH_N; i++)
+            TEST_ASSERT(out[i] == wcs_model_local_to_master(&model, in[i]));
+    }
+
+    wcs_model_set(&model, 0, 0, 1.0, false);
+    wcs_model_local_to_master_n(&model, in, out, WCS_BATCH_N);
+    for (uint16_t i = 0; i < WCS_BATCH_N; i++)
+        TEST_ASSERT(out[i] == (in[i] & WCS_TIMESTAMP_MASK));
+
+    wcs_model_set(&model, 0x0123456789ULL, in[0], 1.0 - 7e-6, true);
+    memcpy(out, in, sizeof(in));
+    wcs_model_local_to_master_n(&model, out, out, WCS_BATCH_N);
+    for (uint16_t i = 0; i < WCS_BATCH_N; i++)
+        TEST_ASSERT(out[i] == wcs_model_local_to_master(&model, in[i]));
+}
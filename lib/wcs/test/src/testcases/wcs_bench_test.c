@@ -0,0 +1,62 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "wcs_test.h"
+
+#define WCS_BENCH_N 100000
+#define WCS_BENCH_BATCH 64
+
+/* Reports the cost of the scalar, batch and double conversions; timings are informational and not asserted */
+TEST_CASE(wcs_bench_test)
+{
+    double ratio = 1.0 + 4.2e-6;
+    wcs_model_t model;
+    volatile uint64_t sink = 0;
+    static uint64_t batch[WCS_BENCH_BATCH];
+    uint32_t t0, t1;
+
+    wcs_model_set(&model, 0x0123456789ULL, 0xFEDCBA9876ULL, ratio, true);
+
+    t0 = os_cputime_get32();
+    for (int i = 0; i < WCS_BENCH_N; i++)
+        sink += wcs_model_local_to_master(&model, 0xFEDCBA9876ULL + (uint64_t)i * 640001);
+    t1 = os_cputime_get32();
+    printf("wcs_model_local_to_master: %lu ns/call\n", os_cputime_ticks_to_usecs(t1 - t0) * 1000UL / WCS_BENCH_N);
+
+    for (int i = 0; i < WCS_BENCH_BATCH; i++)
+        batch[i] = 0xFEDCBA9876ULL + (uint64_t)i * 640001;
+    t0 = os_cputime_get32();
+    for (int i = 0; i < WCS_BENCH_N / WCS_BENCH_BATCH; i++){
+        batch[i % WCS_BENCH_BATCH] ^= i & 1;
+        wcs_model_local_to_master_n(&model, batch, batch, WCS_BENCH_BATCH);
+    }
+    t1 = os_cputime_get32();
+    sink += batch[0];
+    printf("wcs_model_local_to_master_n: %lu ns/timestamp\n",
+        os_cputime_ticks_to_usecs(t1 - t0) * 1000UL / (WCS_BENCH_N / WCS_BENCH_BATCH * WCS_BENCH_BATCH));
+
+    t0 = os_cputime_get32();
+    for (int i = 0; i < WCS_BENCH_N; i++)
+        sink += wcs_test_ref(0x0123456789ULL, 0xFEDCBA9876ULL, ratio, 0xFEDCBA9876ULL + (uint64_t)i * 640001);
+    t1 = os_cputime_get32();
+    printf("double reference: %lu ns/call\n", os_cputime_ticks_to_usecs(t1 - t0) * 1000UL / WCS_BENCH_N);
+
+    TEST_ASSERT(sink != 0);
+}
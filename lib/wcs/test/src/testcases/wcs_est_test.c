@@ -0,0 +1,79 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "wcs_test.h"
+
+#define WCS_EST_TEST_N 400
+#define WCS_EST_TEST_WINDOW 4
+
+/* Offset error of the estimate against the true ratio, ppb */
+static double
+offset_error(const wcs_est_t * est, const wcs_test_epoch_t * epoch)
+{
+    return (ldexp((double)est->offset, -WCS_DRIFT_Q) - (epoch->ratio - 1.0)) * 1e9;
+}
+
+/* Convergence of the fixed-point estimator on synthetic traces, restart and the drift of the model */
+TEST_CASE(wcs_est_test)
+{
+    static const double ppm[] = {-9.5, -2.0, 0.0, 0.7, 6.3};
+    static wcs_test_epoch_t trace[WCS_EST_TEST_N];
+    wcs_est_t est;
+
+    for (uint16_t p = 0; p < sizeof(ppm)/sizeof(ppm[0]); p++){
+        wcs_test_trace(trace, WCS_EST_TEST_N, ppm[p], 0.05, 15.0);
+        wcs_est_init(&est, WCS_EST_TEST_WINDOW);
+
+        /* A line needs three epochs before it is trusted */
+        TEST_ASSERT(!wcs_est_update(&est, trace[0].master_epoch, trace[0].local_epoch));
+        TEST_ASSERT(!wcs_est_update(&est, trace[1].master_epoch, trace[1].local_epoch));
+        TEST_ASSERT(fabs(offset_error(&est, &trace[1])) < 1.0);
+        for (uint16_t i = 2; i < WCS_EST_TEST_N; i++){
+            TEST_ASSERT_FATAL(wcs_est_update(&est, trace[i].master_epoch, trace[i].local_epoch));
+            TEST_ASSERT(fabs(offset_error(&est, &trace[i])) < 10.0);
+        }
+        TEST_ASSERT(est.n == WCS_EST_TEST_WINDOW);
+        TEST_ASSERT(llabs(est.residual) < (128 << WCS_EST_Q));
+
+        /* Drift of the model, master over local at the offset half an interval ahead, within one LSB of the double */
+        double ahead = ldexp((double)est.rate * est.interval, -(WCS_EST_RATE_T + WCS_EST_Q)) / 2;
+        double drift = ldexp(1.0 / (1.0 + ldexp((double)est.offset + ahead, -WCS_DRIFT_Q)) - 1.0, WCS_DRIFT_Q);
+        TEST_ASSERT(fabs(wcs_est_drift(&est) - drift) <= 1.0);
+    }
+
+    /* A new clock master restarts the filter */
+    wcs_est_update(&est, trace[0].master_epoch + 0x1234567, trace[0].local_epoch);
+    TEST_ASSERT(est.n == 1);
+    TEST_ASSERT(!wcs_est_update(&est, trace[0].master_epoch + 0x1234567 + WCS_TEST_PERIOD,
+        trace[0].local_epoch + WCS_TEST_PERIOD));
+    TEST_ASSERT(est.n == 2 && est.offset == 0);
+
+    /* A repeated epoch is ignored */
+    wcs_est_t copy = est;
+    TEST_ASSERT(!wcs_est_update(&est, est.master, trace[0].local_epoch));
+    TEST_ASSERT(memcmp(&copy, &est, sizeof(est)) == 0);
+
+    /* Offsets beyond any crystal are not valid */
+    wcs_est_init(&est, WCS_EST_TEST_WINDOW);
+    wcs_test_trace(trace, 8, 12.0, 0, 0);
+    for (uint16_t i = 0; i < 8; i++)
+        TEST_ASSERT(!wcs_est_update(&est, trace[i].master_epoch, trace[i].local_epoch));
+    TEST_ASSERT(wcs_est_drift(&est) < -WCS_DRIFT_MAX / 2);
+}
@@ -0,0 +1,95 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "wcs_test.h"
+
+#define WCS_METRICS_TEST_N 400
+
+/* Overlapping Allan deviation at tau = m periods, computed over the whole trace */
+static double
+adev_batch(const wcs_test_epoch_t * trace, uint16_t n, uint16_t m)
+{
+    double sum = 0;
+    for (uint16_t i = 0; i + 2 * m < n; i++){
+        double x[3];
+        for (uint16_t k = 0; k < 3; k++){
+            const wcs_test_epoch_t * e = &trace[i + k * m];
+            x[k] = (double)(int64_t)((e->local_epoch - trace[0].local_epoch) & WCS_TIMESTAMP_MASK)
+                - (double)(int64_t)((e->master_epoch - trace[0].master_epoch) & WCS_TIMESTAMP_MASK);
+        }
+        double d = x[2] - 2 * x[1] + x[0];
+        sum += d * d;
+    }
+    return sqrt(sum / (n - 2 * m) / 2) / ((double)m * WCS_TEST_PERIOD);
+}
+
+/* Metrics on a white phase noise trace against the batch computation and theory, and phase history restarts */
+TEST_CASE(wcs_metrics_test)
+{
+    static wcs_test_epoch_t trace[WCS_METRICS_TEST_N];
+    const double jitter = 15.0;
+    wcs_metrics_t metrics;
+    wcs_est_t est;
+    wcs_model_t model;
+
+    wcs_test_trace(trace, WCS_METRICS_TEST_N, 4.2, 0, jitter);
+    wcs_metrics_init(&metrics, WCS_METRICS_TEST_N);
+    wcs_est_init(&est, MYNEWT_VAL(WCS_EST_WINDOW));
+    wcs_model_set_drift(&model, 0, 0, 0, false);
+    for (uint16_t i = 0; i < WCS_METRICS_TEST_N; i++){
+        wcs_metrics_update(&metrics, trace[i].master_epoch, trace[i].local_epoch, &model);
+        bool valid = wcs_est_update(&est, trace[i].master_epoch, trace[i].local_epoch);
+        wcs_model_set_drift(&model, est.master, wcs_est_local(&est), wcs_est_drift(&est), valid);
+    }
+    TEST_ASSERT(metrics.updates == WCS_METRICS_TEST_N && metrics.gaps == 0);
+    TEST_ASSERT(metrics.interval == WCS_TEST_PERIOD);
+
+    /* With the window over the whole trace the means are those of the batch */
+    for (uint16_t j = 0; j < WCS_METRICS_NTAU; j++){
+        double adev = adev_batch(trace, WCS_METRICS_TEST_N, 1 << j);
+        TEST_ASSERT(fabs(wcs_metrics_adev(&metrics, j) / adev - 1.0) < 1e-3);
+        /* White phase noise, sigma_y(tau) = sqrt(3) sigma_x / tau */
+        TEST_ASSERT(fabs(adev * (1 << j) * WCS_TEST_PERIOD / (sqrt(3.0) * jitter) - 1.0) < 0.2);
+    }
+    TEST_ASSERT(wcs_metrics_adev(&metrics, WCS_METRICS_NTAU) == 0);
+
+    /* The residual carries the jitter of the frame and of the epoch of the model */
+    TEST_ASSERT(wcs_metrics_jitter(&metrics) > jitter && wcs_metrics_jitter(&metrics) < 2 * jitter);
+    TEST_ASSERT(fabsf(metrics.skew.mean - 4200.0f) < 10.0f);
+    TEST_ASSERT(wcs_metrics_skew_sd(&metrics) < 10.0f);
+
+    /* A missed frame restarts the phase history, the second differences resume after 2m + 1 frames */
+    wcs_metrics_t copy = metrics;
+    wcs_test_trace(trace, 8, 4.2, 0, 0);
+    wcs_metrics_update(&metrics, trace[2].master_epoch, trace[2].local_epoch, &model);
+    TEST_ASSERT(metrics.gaps == 1 && metrics.nx == 1);
+    TEST_ASSERT(memcmp(metrics.d2, copy.d2, sizeof(copy.d2)) == 0);
+    TEST_ASSERT(memcmp(&metrics.residual, &copy.residual, sizeof(copy.residual)) == 0);
+    wcs_metrics_update(&metrics, trace[3].master_epoch, trace[3].local_epoch, &model);
+    TEST_ASSERT(metrics.d2[0].n == copy.d2[0].n);
+    wcs_metrics_update(&metrics, trace[4].master_epoch, trace[4].local_epoch, &model);
+    TEST_ASSERT(metrics.d2[0].n == copy.d2[0].n + 1 && metrics.d2[1].n == copy.d2[1].n);
+
+    /* The exponential window forgets */
+    wcs_metrics_init(&metrics, 8);
+    for (uint16_t i = 0; i < 8; i++)
+        wcs_metrics_update(&metrics, trace[i].master_epoch, trace[i].local_epoch, &model);
+    TEST_ASSERT(metrics.d2[0].n == 6 && metrics.d2[0].ms < 1.0f);
+}
@@ -0,0 +1,54 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "wcs_test.h"
+
+#define WCS_TEST_N 1000
+
+/* Compares the fixed-point model against the double path across drifts, epochs and the full 40-bit delta range */
+TEST_CASE(wcs_model_test)
+{
+    static const double ppm[] = {-10.0, -3.7, -0.01, 0.0, 0.01, 1.3, 5.0, 9.99};
+    wcs_model_t model;
+    uint64_t x = 0x9E3779B97F4A7C15ULL;
+
+    /* Invalid models are identities */
+    TEST_ASSERT(!wcs_model_set(&model, 1000, 2000, 1.0 + 5e-6, false));
+    TEST_ASSERT(wcs_model_local_to_master(&model, 0x1234567890ABULL) == (0x1234567890ABULL & WCS_TIMESTAMP_MASK));
+    TEST_ASSERT(wcs_model_adjust(&model, 0x1234567890ABULL) == (0x1234567890ABULL & WCS_TIMESTAMP_MASK));
+    TEST_ASSERT(!wcs_model_set(&model, 1000, 2000, 1.0 + 20e-6, true));
+
+    for (uint16_t p = 0; p < sizeof(ppm)/sizeof(ppm[0]); p++){
+        double ratio = 1.0 + ppm[p] * 1e-6;
+        for (uint16_t i = 0; i < WCS_TEST_N; i++){
+            x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+            uint64_t master_epoch = x & WCS_TIMESTAMP_MASK;
+            uint64_t local_epoch = (x >> 20) & WCS_TIMESTAMP_MASK;
+            uint64_t dtu_time = (i < 4) ? local_epoch + i - 2 : (x >> 3);   // Includes the wrap just before the epoch
+            TEST_ASSERT_FATAL(wcs_model_set(&model, master_epoch, local_epoch, ratio, true));
+
+            uint64_t ref = wcs_test_ref(master_epoch, local_epoch, ratio, dtu_time);
+            uint64_t fix = wcs_model_local_to_master(&model, dtu_time);
+            int64_t err = (int64_t)(((fix - ref) + (1ULL << 39)) & WCS_TIMESTAMP_MASK) - (1LL << 39);
+            TEST_ASSERT(err >= -1 && err <= 1);
+            TEST_ASSERT(wcs_model_adjust(&model, dtu_time) == (dtu_time & WCS_TIMESTAMP_MASK));
+        }
+    }
+}
@@ -0,0 +1,164 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "wcs_test.h"
+#if MYNEWT_VAL(WCS_TIMESCALE)
+#include "timescale/timescale.h"
+#endif
+
+#define WCS_REPLAY_N 1000
+#define WCS_REPLAY_REPEAT 20
+#define WCS_REPLAY_WINDOW MYNEWT_VAL(WCS_EST_WINDOW)
+
+/*
+ * Replays a CCP trace through the estimators and reports, for each, the error of the published model converting the
+ * local epoch of the next frame to master time, as the MAC uses it, and the CPU time of an update. Each model is
+ * anchored, as wcs_publish does, on the filtered local time of the estimator rather than the jittered epoch. The trace is the
+ * file named by the WCS_TRACE environment variable when set, see wcs_test_trace_read, otherwise a synthetic one.
+ */
+
+typedef struct _wcs_replay_t{
+    const char * name;
+    double sse;             /* Model error, DTU^2 */
+    double max;             /* Largest model error, DTU */
+    uint16_t nvalid;        /* Frames converted with a valid model */
+    uint32_t usecs;         /* CPU time of all updates */
+}wcs_replay_t;
+
+/* Model error on the frame, DTU, against the model published on the previous frame */
+static void
+replay_error(wcs_replay_t * r, const wcs_model_t * model, const wcs_test_epoch_t * epoch)
+{
+    if (!model->valid)
+        return;
+    uint64_t master = wcs_model_local_to_master(model, epoch->local_epoch);
+    double err = (double)((int64_t)(((master - epoch->master_epoch) + (1ULL << 39)) & WCS_TIMESTAMP_MASK) - (1LL << 39));
+    r->sse += err * err;
+    r->max = fmax(r->max, fabs(err));
+    r->nvalid++;
+}
+
+static void
+replay_report(const wcs_replay_t * r, uint16_t n)
+{
+    printf("%s: %u/%u valid, rms %.1f DTU, max %.0f DTU, %lu ns/update\n", r->name, r->nvalid, n,
+        r->nvalid ? sqrt(r->sse / r->nvalid) : 0.0, r->max,
+        (unsigned long)((uint64_t)r->usecs * 1000 / ((uint32_t)n * WCS_REPLAY_REPEAT)));
+}
+
+static void
+replay_est(wcs_replay_t * r, const wcs_test_epoch_t * trace, uint16_t n)
+{
+    wcs_est_t est;
+    wcs_model_t model;
+    bool valid;
+
+    wcs_est_init(&est, WCS_REPLAY_WINDOW);
+    wcs_model_set_drift(&model, 0, 0, 0, false);
+    for (uint16_t i = 0; i < n; i++){
+        replay_error(r, &model, &trace[i]);
+        valid = wcs_est_update(&est, trace[i].master_epoch, trace[i].local_epoch);
+        wcs_model_set_drift(&model, est.master, wcs_est_local(&est), wcs_est_drift(&est), valid);
+    }
+
+    uint32_t t0 = os_cputime_get32();
+    for (uint16_t k = 0; k < WCS_REPLAY_REPEAT; k++){
+        wcs_est_init(&est, WCS_REPLAY_WINDOW);
+        for (uint16_t i = 0; i < n; i++)
+            wcs_est_update(&est, trace[i].master_epoch, trace[i].local_epoch);
+    }
+    r->usecs = os_cputime_ticks_to_usecs(os_cputime_get32() - t0);
+}
+
+#if MYNEWT_VAL(WCS_TIMESCALE)
+/* As wcs_update_cb, with the ratio of consecutive epochs standing in for the carrier integrator */
+static bool
+replay_ekf_update(timescale_instance_t * timescale, const wcs_test_epoch_t * trace, uint16_t i, double * ratio)
+{
+    timescale_states_t * states = (timescale_states_t *) (timescale->eke->x);
+
+    if (i == 0){
+        states->time = (double)trace[i].local_epoch;
+        states->skew = 1.0 * ((uint64_t)1 << 16)/1e-6l;
+    }else{
+        uint64_t dm = (trace[i].master_epoch - trace[i - 1].master_epoch) & WCS_TIMESTAMP_MASK;
+        uint64_t dl = (trace[i].local_epoch - trace[i - 1].local_epoch) & WCS_TIMESTAMP_MASK;
+        double T = 1e-6l * dm / ((uint64_t)1 << 16);
+        double q[] = {MYNEWT_VAL(TIMESCALE_QVAR) * 1.0, MYNEWT_VAL(TIMESCALE_QVAR) * 0.1, MYNEWT_VAL(TIMESCALE_QVAR) * 0.01};
+        double r[] = {MYNEWT_VAL(TIMESCALE_RVAR), MYNEWT_VAL(TIMESCALE_RVAR) * 1e10};
+        double z[] = {(double)trace[i].local_epoch, (double)dl / dm};
+        timescale_main(timescale, z, q, r, T);
+    }
+    *ratio = states->skew * (1e-6l/((uint64_t)1UL << 16));
+    return fabs(1.0l - *ratio) < 1e-5;
+}
+
+static void
+replay_ekf(wcs_replay_t * r, const wcs_test_epoch_t * trace, uint16_t n)
+{
+    double x0[TIMESCALE_N] = {0};
+    double q[] = {MYNEWT_VAL(TIMESCALE_QVAR) * 1.0, MYNEWT_VAL(TIMESCALE_QVAR) * 0.1, MYNEWT_VAL(TIMESCALE_QVAR) * 0.01};
+    double T = 1e-6l * MYNEWT_VAL(CCP_PERIOD);
+    wcs_model_t model;
+    double ratio;
+
+    timescale_instance_t * timescale = timescale_init(NULL, x0, q, T);
+    timescale_states_t * states = (timescale_states_t *) (timescale->eke->x);
+    wcs_model_set_drift(&model, 0, 0, 0, false);
+    for (uint16_t i = 0; i < n; i++){
+        replay_error(r, &model, &trace[i]);
+        bool valid = replay_ekf_update(timescale, trace, i, &ratio);
+        wcs_model_set(&model, trace[i].master_epoch, (uint64_t)llround(states->time) & WCS_TIMESTAMP_MASK, ratio, valid);
+    }
+    timescale_free(timescale);
+
+    uint32_t t0 = os_cputime_get32();
+    for (uint16_t k = 0; k < WCS_REPLAY_REPEAT; k++){
+        timescale = timescale_init(NULL, x0, q, T);
+        for (uint16_t i = 0; i < n; i++)
+            replay_ekf_update(timescale, trace, i, &ratio);
+        timescale_free(timescale);
+    }
+    r->usecs = os_cputime_ticks_to_usecs(os_cputime_get32() - t0);
+}
+#endif
+
+TEST_CASE(wcs_replay_test)
+{
+    static wcs_test_epoch_t trace[WCS_REPLAY_N];
+    const char * path = getenv("WCS_TRACE");
+    uint16_t n = 0;
+
+    if (path)
+        n = wcs_test_trace_read(path, trace, WCS_REPLAY_N);
+    if (n < 3)
+        n = wcs_test_trace(trace, WCS_REPLAY_N, 4.2, 0.5, 15.0);
+
+    wcs_replay_t est = {.name = "wcs_est"};
+    replay_est(&est, trace, n);
+    replay_report(&est, n);
+    TEST_ASSERT(est.nvalid > 0);
+
+#if MYNEWT_VAL(WCS_TIMESCALE)
+    wcs_replay_t ekf = {.name = "timescale"};
+    replay_ekf(&ekf, trace, n);
+    replay_report(&ekf, n);
+#endif
+}
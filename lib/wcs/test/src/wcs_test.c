@@ -0,0 +1,104 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "wcs_test.h"
+
+TEST_CASE_DECL(wcs_model_test)
+TEST_CASE_DECL(wcs_batch_test)
+TEST_CASE_DECL(wcs_bench_test)
+TEST_CASE_DECL(wcs_est_test)
+TEST_CASE_DECL(wcs_replay_test)
+TEST_CASE_DECL(wcs_metrics_test)
+
+uint64_t
+wcs_test_ref(uint64_t master_epoch, uint64_t local_epoch, double ratio, uint64_t dtu_time)
+{
+    uint64_t delta = (dtu_time - local_epoch) & WCS_TIMESTAMP_MASK;
+    return (master_epoch + (uint64_t) round(delta / ratio)) & WCS_TIMESTAMP_MASK;
+}
+
+uint16_t
+wcs_test_trace(wcs_test_epoch_t * trace, uint16_t n, double ppm, double ppb_per_sec, double jitter)
+{
+    uint64_t x = 0x2545F4914F6CDD1DULL;
+    uint64_t master = WCS_TIMESTAMP_MASK - 3 * WCS_TEST_PERIOD;     /* Wraps within the first frames */
+    double local = 0x0123456789ULL;
+    double y = ppm * 1e-6;
+
+    for (uint16_t i = 0; i < n; i++){
+        double noise = 0;
+        for (uint16_t j = 0; j < 4; j++){
+            x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+            noise += (double)(x >> 11) / (1ULL << 53) - 0.5;
+        }
+        trace[i].master_epoch = master & WCS_TIMESTAMP_MASK;
+        trace[i].local_epoch = (uint64_t) llround(local + noise * jitter * sqrt(3.0)) & WCS_TIMESTAMP_MASK;
+        trace[i].ratio = 1.0 + y;
+        master += WCS_TEST_PERIOD;
+        local += WCS_TEST_PERIOD * (1.0 + y);
+        y += ppb_per_sec * 1e-9 * WCS_TEST_PERIOD / (1e6 * 65536);
+    }
+    return n;
+}
+
+uint16_t
+wcs_test_trace_read(const char * path, wcs_test_epoch_t * trace, uint16_t n)
+{
+    char line[256];
+    uint16_t i = 0;
+    FILE * fp = fopen(path, "r");
+    if (fp == NULL)
+        return 0;
+    while (i < n && fgets(line, sizeof(line), fp)){
+        unsigned long long master, local;
+        char * p = strstr(line, "\"wcs\": [");
+        if (p && sscanf(p, "\"wcs\": [%llu,%llu", &master, &local) == 2){
+            trace[i].master_epoch = master & WCS_TIMESTAMP_MASK;
+            trace[i].local_epoch = local & WCS_TIMESTAMP_MASK;
+            trace[i].ratio = NAN;
+            i++;
+        }
+    }
+    fclose(fp);
+    return i;
+}
+
+TEST_SUITE(wcs_test_all)
+{
+    wcs_model_test();
+    wcs_batch_test();
+    wcs_bench_test();
+    wcs_est_test();
+    wcs_replay_test();
+    wcs_metrics_test();
+}
+
+#if MYNEWT_VAL(SELFTEST)
+int
+main(int argc, char **argv)
+{
+    sysinit();
+
+    wcs_test_all();
+
+    return 0;
+}
+#endif
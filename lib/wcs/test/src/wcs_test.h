@@ -0,0 +1,53 @@
+/**
+ * Copyright 2018, Decawave Limited, All Rights Reserved
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _WCS_TEST_H
+#define _WCS_TEST_H
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "sysinit/sysinit.h"
+#include "syscfg/syscfg.h"
+#include "os/os.h"
+#include "testutil/testutil.h"
+
+#include "wcs/wcs_model.h"
+#include "wcs/wcs_est.h"
+#include "wcs/wcs_metrics.h"
+
+#define WCS_TEST_PERIOD ((uint64_t)0x100000 << 16)     /* Default CCP period, DTU */
+
+/* Epoch pair of a CCP frame; ratio is the true local over master frequency ratio, NAN for recorded traces */
+typedef struct _wcs_test_epoch_t{
+    uint64_t master_epoch;
+    uint64_t local_epoch;
+    double ratio;
+}wcs_test_epoch_t;
+
+/* Double precision reference of the conversion, as computed before the fixed-point model */
+uint64_t wcs_test_ref(uint64_t master_epoch, uint64_t local_epoch, double ratio, uint64_t dtu_time);
+/* Synthetic trace: frequency offset in ppm, its rate of change in ppb/s and Gaussian timestamp jitter in DTU */
+uint16_t wcs_test_trace(wcs_test_epoch_t * trace, uint16_t n, double ppm, double ppb_per_sec, double jitter);
+/* Recorded trace: the "wcs" lines of the WCS_VERBOSE output, or of telemetry_decode.py */
+uint16_t wcs_test_trace_read(const char * path, wcs_test_epoch_t * trace, uint16_t n);
+
+#endif /* _WCS_TEST_H */
@@ -48,6 +48,7 @@ SLIST_HEAD(uwbcfg_cbs_head, uwbcfg_cbs);
     
 int uwbcfg_register(struct uwbcfg_cbs *handler);
 int uwbcfg_apply(void);
+int uwbcfg_set_antenna_delays(uint16_t rx_antdly, uint16_t tx_antdly);
     
 #ifdef __cplusplus
 }
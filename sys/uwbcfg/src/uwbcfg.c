@@ -293,6 +293,20 @@ uwbcfg_apply(void)
 {
     return uwbcfg_commit(); 
 }
+
+/* Sets and persists the antenna delays, e.g. after calibration */
+int
+uwbcfg_set_antenna_delays(uint16_t rx_antdly, uint16_t tx_antdly)
+{
+    int rc;
+    snprintf(uwb_config.rx_antenna_dly, sizeof(uwb_config.rx_antenna_dly), "0x%04X", rx_antdly);
+    snprintf(uwb_config.tx_antenna_dly, sizeof(uwb_config.tx_antenna_dly), "0x%04X", tx_antdly);
+
+    rc = conf_save_one("uwb/rx_antdly", uwb_config.rx_antenna_dly);
+    rc |= conf_save_one("uwb/tx_antdly", uwb_config.tx_antenna_dly);
+    uwbcfg_commit();
+    return rc;
+}
     
 int
 uwbcfg_pkg_init()